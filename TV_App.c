@@ -1,7 +1,7 @@
 #include "remote_controller.h"
 #include "stream_controller.h"
 #include "osd_graphics.h"
-#include <signal.h>
+#include "timer_service.h"
 
 
 static inline void textColor(int32_t attr, int32_t fg, int32_t bg)
@@ -27,6 +27,7 @@ static inline void textColor(int32_t attr, int32_t fg, int32_t bg)
 
 static void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value);
 static void registerProgramType(int16_t type);
+static void registerScrambling(uint8_t scrambled);
 
 static pthread_cond_t deinitCond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t deinitMutex = PTHREAD_MUTEX_INITIALIZER;
@@ -46,15 +47,23 @@ int configFileRead(char fileName[]);
 /**
  * @brief - multiple numpad key timer trigger function.
  */
-void timeOutChannelTrigger();
+void timeOutChannelTrigger(void* arg);
 
+/**
+ * @brief - Channel info timer function, shows info of channel that was changed to.
+ */
+void channelInfoTrigger(void* arg);
+
+#define KEY_TIMEOUT_MS          2000        /* Channel is changed 2 seconds after first numpad key */
+#define CHANNEL_INFO_DELAY_MS   900         /* Tables of new channel are parsed before its info is shown */
+#define EPG_GRID_STEP_S         1800        /* LEFT and RIGHT move EPG grid by half an hour */
+#define EPG_GRID_DAYS           7           /* EPG grid does not move past last day of EIT schedule */
 
 /* Remote controller key change timeout timer */
-static timer_t keyTimer;
-static struct itimerspec timerSpec;
-static struct itimerspec timerSpecOld;
-static struct sigevent signalEvent;
-static int32_t timerFlags = 0;
+static TimerId keyTimer = TIMER_SERVICE_INVALID_ID;
+
+/* Shows channel info after channel change without blocking caller */
+static TimerId channelInfoTimer = TIMER_SERVICE_INVALID_ID;
 
 /* Numpad input holder */
 static int32_t pressedKeys[3];
@@ -91,18 +100,10 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	/* Timer init */
-	signalEvent.sigev_notify = SIGEV_THREAD;
-	signalEvent.sigev_notify_function = timeOutChannelTrigger;
-	signalEvent.sigev_value.sival_ptr = NULL;
-	signalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &signalEvent, &keyTimer);
-	//printf("\nTimer init!\n");
-
-	/* Set timer to 2 sec */
-	memset(&timerSpec, 0, sizeof(timerSpec));
-	timerSpec.it_value.tv_sec = 2;
-	timerSpec.it_value.tv_nsec = 0;
+	/* initialize timer service, all timers of application run on its thread */
+	ERRORCHECK(timerServiceInit());
+	keyTimer = timerCreate(timeOutChannelTrigger, NULL);
+	channelInfoTimer = timerCreate(channelInfoTrigger, NULL);
 
 	/* initialize remote controller module */
 	ERRORCHECK(remoteControllerInit());
@@ -119,6 +120,9 @@ int main(int argc, char *argv[])
 	/* register program type callback */
 	ERRORCHECK(registerProgramTypeCallback(registerProgramType));
 
+	/* register scrambling callback */
+	ERRORCHECK(registerScramblingCallback(registerScrambling));
+
 	/* wait for a EXIT remote controller key press event */
 	pthread_mutex_lock(&deinitMutex);
 	if (ETIMEDOUT == pthread_cond_wait(&deinitCond, &deinitMutex))
@@ -139,20 +143,28 @@ int main(int argc, char *argv[])
 	/* deinitialize stream controller module */
 	ERRORCHECK(streamControllerDeinit());
 
+	/* deinitialize timer service */
+	timerServiceDeinit();
+	printTimerServiceStats();
+
 
 	return 0;
 }
 
 void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 {
-	OsdGraphicsInfo* osd = getOsdInfo();
-	eitBufferElement *eitTable = eitTableGet();
+	OsdGraphicsInfo* osd;
+	int16_t newVolume = -1;
+	eitBufferElement eitInfo;
+
+	/* refreshes present event name shown by info banner */
+	eitTableGet(&eitInfo);
 
 	if(code >= KEYCODE_1 && code <= KEYCODE_0)
 	{
 		if(pressedKeysCounter == 0)
 		{
-			timer_settime(keyTimer, timerFlags, &timerSpec, &timerSpecOld);
+			timerStart(keyTimer, KEY_TIMEOUT_MS, 0);
 			pressedKeys[0] = 0;
 			pressedKeys[1] = 0;
 			pressedKeys[2] = 0;
@@ -191,14 +203,17 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 				printf("Teletext status: %d\n", channelInfo.hasTeletext);
 				printf("Total number of channels:%d\n", getNumberOfChannels());
 				printf("**********************************************************\n");
+				printTsMonitorStats();
+				printChannelMap();
 
+				osd = OsdInfoWriteBegin();
 				osd->audioPid = channelInfo.audioPid;
 				osd->videoPid = channelInfo.videoPid;
 				osd->channelNumber = channelInfo.programNumber;
 				osd->hasTeletext = channelInfo.hasTeletext;
 
-				strcpy(osd->eventName, channelInfo.eventName);
-				strcpy(osd->eventGenre, "Genre not implemented yet!");
+				osd->eventName = channelInfo.eventName;
+				osd->eventGenre = channelInfo.eventGenre;
 
 				/* Reset timer */
 				if(osd->timerSetProgram == 1 && osd->draw == 1)
@@ -210,70 +225,111 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 				{
 					osd->draw = 1;
 				}
+				OsdInfoWriteEnd();
 			}
 			break;
 		case KEYCODE_P_PLUS:
 			printf("\nCH+ pressed\n");
 			channelUp();
-			/* TODO: Could be done without usleep */
-			usleep(900000);
-			if (getChannelInfo(&channelInfo) == SC_NO_ERROR)
-			{
-				osd->audioPid = channelInfo.audioPid;
-				osd->videoPid = channelInfo.videoPid;
-				osd->channelNumber = channelInfo.programNumber;
-				osd->hasTeletext = channelInfo.hasTeletext;
-				osd->draw = 1;
-			}
+			timerStart(channelInfoTimer, CHANNEL_INFO_DELAY_MS, 0);
 			break;
 		case KEYCODE_P_MINUS:
 			printf("\nCH- pressed\n");
 			channelDown();
-			/* TODO: Could be done without usleep */
-			usleep(900000);
-			if (getChannelInfo(&channelInfo) == SC_NO_ERROR)
-			{
-				osd->audioPid = channelInfo.audioPid;
-				osd->videoPid = channelInfo.videoPid;
-				osd->channelNumber = channelInfo.programNumber;
-				osd->hasTeletext = channelInfo.hasTeletext;
-				osd->draw = 1;
-			}
+			timerStart(channelInfoTimer, CHANNEL_INFO_DELAY_MS, 0);
 			break;
 		case KEYCODE_VOL_UP:
 			printf("\nVOL+ pressed\n");
+			osd = OsdInfoWriteBegin();
 			osd->drawVolume = 1;
+			osd->timerSetVolume = 0;
 			if(osd->volume >=0 && osd->volume < 10)
 			{
 				osd->volume++;
-				setVolume(osd->volume);
+				newVolume = osd->volume;
 			}
+			OsdInfoWriteEnd();
 			break;
 		case KEYCODE_VOL_DOWN:
 			printf("\nVOL- pressed\n");
+			osd = OsdInfoWriteBegin();
 			osd->drawVolume = 1;
+			osd->timerSetVolume = 0;
 			if(osd->volume > 0 && osd->volume <= 10)
 			{
 				osd->volume--;
-				setVolume(osd->volume);
+				newVolume = osd->volume;
 			}
+			OsdInfoWriteEnd();
 			break;
 		case KEYCODE_MUTE:
 			printf("\nMUTE pressed\n");
+			osd = OsdInfoWriteBegin();
 			if(mutePressed == 0)
 			{
 				mutedVolume = osd->volume;
 				osd->volume = 0;
 				mutePressed = 1;
-				setVolume(osd->volume);
+				newVolume = osd->volume;
 			}
 			else if(mutePressed == 1)
 			{
 				osd->volume = mutedVolume;
-				setVolume(mutedVolume);
+				newVolume = mutedVolume;
 				mutePressed = 0;
 			}
 			osd->drawVolume = 1;
+			osd->timerSetVolume = 0;
+			OsdInfoWriteEnd();
+			break;
+		case KEYCODE_OK:
+			printf("\nOK pressed\n");
+			osd = OsdInfoWriteBegin();
+			if (osd->drawEpg == 0)
+			{
+				/* grid opens at current half hour, rows stay where they were left */
+				osd->epgStartTime = epgCacheGetBroadcastTime();
+				osd->epgStartTime -= osd->epgStartTime % EPG_GRID_STEP_S;
+				osd->drawEpg = 1;
+			}
+			else
+			{
+				osd->drawEpg = 0;
+			}
+			OsdInfoWriteEnd();
+			break;
+		case KEYCODE_UP:
+			osd = OsdInfoWriteBegin();
+			if (osd->drawEpg == 1 && osd->epgFirstService > 0)
+			{
+				osd->epgFirstService--;
+			}
+			OsdInfoWriteEnd();
+			break;
+		case KEYCODE_DOWN:
+			osd = OsdInfoWriteBegin();
+			if (osd->drawEpg == 1 && osd->epgFirstService + 1 < epgCacheGetServiceCount())
+			{
+				osd->epgFirstService++;
+			}
+			OsdInfoWriteEnd();
+			break;
+		case KEYCODE_LEFT:
+			osd = OsdInfoWriteBegin();
+			/* ended events are not cached, grid does not move before current half hour */
+			if (osd->drawEpg == 1 && osd->epgStartTime > epgCacheGetBroadcastTime())
+			{
+				osd->epgStartTime -= EPG_GRID_STEP_S;
+			}
+			OsdInfoWriteEnd();
+			break;
+		case KEYCODE_RIGHT:
+			osd = OsdInfoWriteBegin();
+			if (osd->drawEpg == 1 && osd->epgStartTime < epgCacheGetBroadcastTime() + EPG_GRID_DAYS * 24 * 3600)
+			{
+				osd->epgStartTime += EPG_GRID_STEP_S;
+			}
+			OsdInfoWriteEnd();
 			break;
 		case KEYCODE_EXIT:
 			printf("\nExit pressed\n");
@@ -282,7 +338,13 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 			pthread_mutex_unlock(&deinitMutex);
 			break;
 		default:
-			printf("\nPress P+, P-, VOL+, VOL-, info or exit! \n\n");
+			printf("\nPress P+, P-, VOL+, VOL-, info, OK for EPG or exit! \n\n");
+		}
+
+		/* player call is made after OSD info is published, OSD thread never waits for it */
+		if (newVolume >= 0)
+		{
+			setVolume(newVolume);
 		}
 	}
 }
@@ -406,16 +468,75 @@ int configFileRead(char fileName[])
 				configInputConfig.programNumber = paramValueInt;
 				printf("\nParam Value[ProgramNumber]:%d", paramValueInt);
 			}
+			else if(strstr(lineBuffer, "FilterSlots") != NULL)
+			{
+				paramValueCounter = 0;
+				memset(paramValue,'\0',sizeof(paramValue));
+				while(lineBuffer[paramValueCounter] != '"')
+				{
+					paramValueCounter++;
+				}
+				paramValueCounter += 1;
+				paramValueCounterAux = 0;
+				while(lineBuffer[paramValueCounter] != '"')
+				{
+					paramValue[paramValueCounterAux] = lineBuffer[paramValueCounter];
+					paramValueCounter++;
+					paramValueCounterAux++;
+				}
+				paramValueInt = atoi(paramValue);
+				configInputConfig.filterSlots = paramValueInt;
+				printf("\nParam Value[FilterSlots]:%d", paramValueInt);
+			}
+			else if(strstr(lineBuffer, "SkipDeadServices") != NULL)
+			{
+				paramValueCounter = 0;
+				memset(paramValue,'\0',sizeof(paramValue));
+				while(lineBuffer[paramValueCounter] != '"')
+				{
+					paramValueCounter++;
+				}
+				paramValueCounter += 1;
+				paramValueCounterAux = 0;
+				while(lineBuffer[paramValueCounter] != '"')
+				{
+					paramValue[paramValueCounterAux] = lineBuffer[paramValueCounter];
+					paramValueCounter++;
+					paramValueCounterAux++;
+				}
+				paramValueInt = atoi(paramValue);
+				configInputConfig.skipDeadServices = paramValueInt;
+				printf("\nParam Value[SkipDeadServices]:%d", paramValueInt);
+			}
+			else if(strstr(lineBuffer, "SpeculativeStart") != NULL)
+			{
+				paramValueCounter = 0;
+				memset(paramValue,'\0',sizeof(paramValue));
+				while(lineBuffer[paramValueCounter] != '"')
+				{
+					paramValueCounter++;
+				}
+				paramValueCounter += 1;
+				paramValueCounterAux = 0;
+				while(lineBuffer[paramValueCounter] != '"')
+				{
+					paramValue[paramValueCounterAux] = lineBuffer[paramValueCounter];
+					paramValueCounter++;
+					paramValueCounterAux++;
+				}
+				paramValueInt = atoi(paramValue);
+				configInputConfig.speculativeStart = paramValueInt;
+				printf("\nParam Value[SpeculativeStart]:%d", paramValueInt);
+			}
 		}
 	}
 
 	fclose(filePtr);
 }
 
-void timeOutChannelTrigger()
+void timeOutChannelTrigger(void* arg)
 {
 	int convertedKey = 0;
-	OsdGraphicsInfo* osd = getOsdInfo();
 
 	anyKeyPressedFlag = 0;
 	pressedKeysCounter = 0;
@@ -460,22 +581,29 @@ void timeOutChannelTrigger()
 	printf("\nRemote controller key input choice:%d\n", convertedKey);
 	fflush(stdout);
 	changeChannelExtern(convertedKey);
+	timerStart(channelInfoTimer, CHANNEL_INFO_DELAY_MS, 0);
+}
+
+void channelInfoTrigger(void* arg)
+{
+	OsdGraphicsInfo* osd;
 
-	/* TODO: Could be done without usleep */
-	usleep(900000);
 	if (getChannelInfo(&channelInfo) == SC_NO_ERROR)
 	{
+		osd = OsdInfoWriteBegin();
 		osd->audioPid = channelInfo.audioPid;
 		osd->videoPid = channelInfo.videoPid;
 		osd->channelNumber = channelInfo.programNumber;
 		osd->hasTeletext = channelInfo.hasTeletext;
 		osd->draw = 1;
+		OsdInfoWriteEnd();
 	}
 }
 
 void registerProgramType(int16_t type)
 {
-	OsdGraphicsInfo* osd = getOsdInfo();
+	OsdGraphicsInfo* osd = OsdInfoWriteBegin();
+
 	if (type == -1)
 	{
 		//printf("Radio stream found!");
@@ -488,6 +616,23 @@ void registerProgramType(int16_t type)
 		osd->drawBlack = 0;
 		osd->drawRadio = 0;
 	}
+	OsdInfoWriteEnd();
+}
+
+void registerScrambling(uint8_t scrambled)
+{
+	OsdGraphicsInfo* osd = OsdInfoWriteBegin();
+
+	if (scrambled)
+	{
+		osd->drawBlack = 1;
+		osd->drawScrambled = 1;
+	}
+	else
+	{
+		osd->drawScrambled = 0;
+	}
+	OsdInfoWriteEnd();
 }
 
 
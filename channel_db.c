@@ -0,0 +1,424 @@
+#include "channel_db.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static ChannelDbFile* dbFile = NULL;        /* Mapped file, NULL for empty database */
+static char dbPath[256];
+static uint32_t writeCount = 0;
+static ChannelDbLastService storedLastService;  /* Last written or read content */
+static ChannelDbFile storeImage;                /* Built by every channelDbStore(), kept off the heap */
+
+/**
+ * @brief - FNV-1a checksum.
+ */
+static uint32_t channelDbChecksum(const uint8_t* data, uint32_t size);
+
+/**
+ * @brief - Maps database file if it is valid.
+ */
+static ChannelDbError channelDbMap(void);
+
+/**
+ * @brief - Writes data to temporary file and renames it over file on path.
+ */
+static ChannelDbError channelDbWrite(const char* path, const void* data, uint32_t size);
+
+ChannelDbError channelDbOpen(const char* path)
+{
+	if (path == NULL || strlen(path) >= sizeof(dbPath))
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CDB_ERROR;
+	}
+
+	channelDbClose();
+	strcpy(dbPath, path);
+
+	return channelDbMap();
+}
+
+void channelDbClose(void)
+{
+	if (dbFile != NULL)
+	{
+		munmap(dbFile, sizeof(ChannelDbFile));
+		dbFile = NULL;
+	}
+}
+
+const ChannelDbTransportStream* channelDbFindByFrequency(uint32_t frequency)
+{
+	uint16_t i;
+
+	if (dbFile == NULL)
+	{
+		return NULL;
+	}
+
+	for (i = 0; i < dbFile->header.transportStreamCount; i++)
+	{
+		if (dbFile->transportStreams[i].frequency == frequency)
+		{
+			return &dbFile->transportStreams[i];
+		}
+	}
+
+	return NULL;
+}
+
+const ChannelDbTransportStream* channelDbFindByTransportStreamId(uint16_t transportStreamId)
+{
+	uint16_t i;
+
+	if (dbFile == NULL)
+	{
+		return NULL;
+	}
+
+	for (i = 0; i < dbFile->header.transportStreamCount; i++)
+	{
+		if (dbFile->transportStreams[i].transportStreamId == transportStreamId)
+		{
+			return &dbFile->transportStreams[i];
+		}
+	}
+
+	return NULL;
+}
+
+void channelDbToPatTable(const ChannelDbTransportStream* transportStream, PatTable* patTable)
+{
+	uint8_t i;
+
+	memset(&patTable->patHeader, 0x0, sizeof(PatHeader));
+	patTable->patHeader.tableId = 0x00;
+	patTable->patHeader.transportStreamId = transportStream->transportStreamId;
+	patTable->patHeader.versionNumber = transportStream->patVersion;
+	patTable->patHeader.currentNextIndicator = 1;
+
+	for (i = 0; i < transportStream->serviceCount && i < patTable->serviceInfoCapacity; i++)
+	{
+		patTable->patServiceInfoArray[i].programNumber = transportStream->services[i].programNumber;
+		patTable->patServiceInfoArray[i].pid = transportStream->services[i].pmtPid;
+	}
+	patTable->serviceInfoCount = i;
+}
+
+ChannelDbError channelDbToPmtTable(const ChannelDbTransportStream* transportStream, uint16_t index, PmtTable* pmtTable)
+{
+	const ChannelDbService* service;
+	uint8_t j;
+
+	if (index >= transportStream->serviceCount || !transportStream->services[index].pmtValid)
+	{
+		return CDB_NOT_FOUND;
+	}
+	service = &transportStream->services[index];
+
+	memset(&pmtTable->pmtHeader, 0x0, sizeof(PmtTableHeader));
+	pmtTable->pmtHeader.tableId = 0x02;
+	pmtTable->pmtHeader.programNumber = service->programNumber;
+	pmtTable->pmtHeader.versionNumber = service->pmtVersion;
+	pmtTable->pmtHeader.currentNextIndicator = 1;
+	pmtTable->pmtHeader.pcrPid = service->pcrPid;
+	pmtTable->pmtHeader.hasCaDescriptor = service->hasCaDescriptor;
+	pmtTable->pmtHeader.caSystemId = service->caSystemId;
+
+	for (j = 0; j < service->esCount && j < pmtTable->elementaryInfoCapacity; j++)
+	{
+		pmtTable->pmtElementaryInfoArray[j].streamType = service->esArray[j].streamType;
+		pmtTable->pmtElementaryInfoArray[j].elementaryPid = service->esArray[j].elementaryPid;
+		pmtTable->pmtElementaryInfoArray[j].teletext = (service->esArray[j].flags & CHANNEL_DB_ES_TELETEXT) ? 1 : 0;
+		pmtTable->pmtElementaryInfoArray[j].hasCaDescriptor = (service->esArray[j].flags & CHANNEL_DB_ES_CA) ? 1 : 0;
+	}
+	pmtTable->elementaryInfoCount = j;
+
+	return CDB_NO_ERROR;
+}
+
+ChannelDbError channelDbStore(uint32_t frequency, const PatTable* patTable)
+{
+	ChannelDbFile* image = &storeImage;
+	ChannelDbTransportStream* record;
+	const ChannelDbTransportStream* oldRecord = NULL;
+	const ChannelMapEntry* entry;
+	ChannelDbService* service;
+	ChannelDbError error = CDB_NO_ERROR;
+	uint16_t count;
+	uint16_t i;
+	uint8_t j;
+	uint16_t k;
+
+	if (patTable == NULL || dbPath[0] == '\0')
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CDB_ERROR;
+	}
+
+	if (dbFile != NULL)
+	{
+		memcpy(image, dbFile, sizeof(ChannelDbFile));
+		oldRecord = channelDbFindByTransportStreamId(patTable->patHeader.transportStreamId);
+	}
+	else
+	{
+		memset(image, 0x0, sizeof(ChannelDbFile));
+	}
+
+	/* same transport stream is updated in place, new one is appended or replaces the first (oldest) one */
+	if (oldRecord != NULL)
+	{
+		record = &image->transportStreams[oldRecord - dbFile->transportStreams];
+	}
+	else
+	{
+		count = image->header.transportStreamCount;
+		if (count == CHANNEL_DB_MAX_TRANSPORT_STREAMS)
+		{
+			memmove(&image->transportStreams[0], &image->transportStreams[1],
+			        (CHANNEL_DB_MAX_TRANSPORT_STREAMS - 1) * sizeof(ChannelDbTransportStream));
+			count--;
+		}
+		record = &image->transportStreams[count];
+		image->header.transportStreamCount = count + 1;
+	}
+
+	memset(record, 0x0, sizeof(ChannelDbTransportStream));
+	record->frequency = frequency;
+	record->transportStreamId = patTable->patHeader.transportStreamId;
+	record->patVersion = patTable->patHeader.versionNumber;
+
+	for (i = 0; i < patTable->serviceInfoCount && i < CHANNEL_DB_MAX_SERVICES; i++)
+	{
+		service = &record->services[i];
+		service->programNumber = patTable->patServiceInfoArray[i].programNumber;
+		service->pmtPid = patTable->patServiceInfoArray[i].pid;
+
+		/* names are not carried by PAT/PMT, previous ones are kept */
+		for (k = 0; oldRecord != NULL && k < oldRecord->serviceCount; k++)
+		{
+			if (oldRecord->services[k].programNumber == service->programNumber)
+			{
+				memcpy(service->name, oldRecord->services[k].name, CHANNEL_DB_NAME_LENGTH);
+				break;
+			}
+		}
+
+		/* channel map is indexed same as PAT */
+		entry = channelMapGetEntry(i);
+		if (entry == NULL || !entry->pmtValid || entry->programNumber != service->programNumber)
+		{
+			continue;
+		}
+
+		service->pcrPid = entry->pcrPid;
+		service->pmtVersion = entry->pmtVersion;
+		service->hasCaDescriptor = entry->hasCaDescriptor;
+		service->caSystemId = entry->caSystemId;
+		for (j = 0; j < entry->esCount && j < CHANNEL_DB_MAX_ES; j++)
+		{
+			service->esArray[j].elementaryPid = entry->esArray[j].elementaryPid;
+			service->esArray[j].streamType = entry->esArray[j].streamType;
+			service->esArray[j].flags = (entry->esArray[j].teletext ? CHANNEL_DB_ES_TELETEXT : 0) |
+			                            (entry->esArray[j].hasCaDescriptor ? CHANNEL_DB_ES_CA : 0);
+		}
+		service->esCount = j;
+		service->pmtValid = 1;
+	}
+	record->serviceCount = i;
+
+	image->header.magic = CHANNEL_DB_MAGIC;
+	image->header.version = CHANNEL_DB_VERSION;
+	image->header.recordSize = sizeof(ChannelDbTransportStream);
+	image->header.checksum = channelDbChecksum((const uint8_t*)image->transportStreams,
+	                                           image->header.transportStreamCount * sizeof(ChannelDbTransportStream));
+
+	/* flash is written only when tables really changed */
+	if (dbFile == NULL || memcmp(image, dbFile, sizeof(ChannelDbFile)) != 0)
+	{
+		error = channelDbWrite(dbPath, image, sizeof(ChannelDbFile));
+		if (error == CDB_NO_ERROR)
+		{
+			/* old mapping still refers to replaced file */
+			channelDbClose();
+			error = channelDbMap();
+		}
+	}
+
+	return error;
+}
+
+ChannelDbError channelDbLoadLastService(ChannelDbLastService* lastService)
+{
+	FILE* filePtr;
+	size_t readCount;
+
+	if (lastService == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CDB_ERROR;
+	}
+
+	filePtr = fopen(CHANNEL_DB_LAST_SERVICE_PATH, "rb");
+	if (filePtr == NULL)
+	{
+		return CDB_NOT_FOUND;
+	}
+	readCount = fread(lastService, sizeof(ChannelDbLastService), 1, filePtr);
+	fclose(filePtr);
+
+	if (readCount != 1 || lastService->magic != CHANNEL_DB_LAST_SERVICE_MAGIC ||
+	    lastService->checksum != channelDbChecksum((const uint8_t*)lastService, offsetof(ChannelDbLastService, checksum)))
+	{
+		printf("\n%s : last service record is invalid, ignored\n", __FUNCTION__);
+		return CDB_NOT_FOUND;
+	}
+	storedLastService = *lastService;
+
+	return CDB_NO_ERROR;
+}
+
+ChannelDbError channelDbStoreLastService(ChannelDbLastService* lastService)
+{
+	ChannelDbError error;
+
+	if (lastService == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CDB_ERROR;
+	}
+
+	lastService->magic = CHANNEL_DB_LAST_SERVICE_MAGIC;
+	lastService->checksum = channelDbChecksum((const uint8_t*)lastService, offsetof(ChannelDbLastService, checksum));
+	if (memcmp(lastService, &storedLastService, sizeof(ChannelDbLastService)) == 0)
+	{
+		return CDB_NO_ERROR;
+	}
+
+	error = channelDbWrite(CHANNEL_DB_LAST_SERVICE_PATH, lastService, sizeof(ChannelDbLastService));
+	if (error == CDB_NO_ERROR)
+	{
+		storedLastService = *lastService;
+	}
+
+	return error;
+}
+
+uint32_t channelDbChecksum(const uint8_t* data, uint32_t size)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+ChannelDbError channelDbMap(void)
+{
+	struct stat fileStat;
+	ChannelDbFile* file;
+	int fd;
+
+	fd = open(dbPath, O_RDONLY);
+	if (fd < 0)
+	{
+		return CDB_NOT_FOUND;
+	}
+
+	if (fstat(fd, &fileStat) || fileStat.st_size != sizeof(ChannelDbFile))
+	{
+		printf("\n%s : channel database %s has wrong size, ignored\n", __FUNCTION__, dbPath);
+		close(fd);
+		return CDB_NOT_FOUND;
+	}
+
+	file = (ChannelDbFile*)mmap(NULL, sizeof(ChannelDbFile), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (file == MAP_FAILED)
+	{
+		printf("\n%s : ERROR mmap() fail\n", __FUNCTION__);
+		return CDB_ERROR;
+	}
+
+	if (file->header.magic != CHANNEL_DB_MAGIC || file->header.version != CHANNEL_DB_VERSION ||
+	    file->header.recordSize != sizeof(ChannelDbTransportStream) ||
+	    file->header.transportStreamCount > CHANNEL_DB_MAX_TRANSPORT_STREAMS ||
+	    file->header.checksum != channelDbChecksum((const uint8_t*)file->transportStreams,
+	                                               file->header.transportStreamCount * sizeof(ChannelDbTransportStream)))
+	{
+		printf("\n%s : channel database %s is invalid, ignored\n", __FUNCTION__, dbPath);
+		munmap(file, sizeof(ChannelDbFile));
+		return CDB_NOT_FOUND;
+	}
+
+	dbFile = file;
+
+	return CDB_NO_ERROR;
+}
+
+ChannelDbError channelDbWrite(const char* path, const void* data, uint32_t size)
+{
+	char tmpPath[sizeof(dbPath) + 4];
+	size_t written = 0;
+	ssize_t result;
+	int fd;
+
+	if (strlen(path) >= sizeof(dbPath))
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CDB_ERROR;
+	}
+	sprintf(tmpPath, "%s.tmp", path);
+
+	fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		printf("\n%s : ERROR Cannot open %s\n", __FUNCTION__, tmpPath);
+		return CDB_ERROR;
+	}
+
+	while (written < size)
+	{
+		result = write(fd, (const uint8_t*)data + written, size - written);
+		if (result < 0)
+		{
+			printf("\n%s : ERROR Cannot write %s\n", __FUNCTION__, tmpPath);
+			close(fd);
+			unlink(tmpPath);
+			return CDB_ERROR;
+		}
+		written += result;
+	}
+
+	/* data must reach storage before rename makes it the database */
+	if (fsync(fd))
+	{
+		printf("\n%s : ERROR fsync() fail\n", __FUNCTION__);
+		close(fd);
+		unlink(tmpPath);
+		return CDB_ERROR;
+	}
+	close(fd);
+
+	/* rename replaces file atomically, a power cut leaves old or new file */
+	if (rename(tmpPath, path))
+	{
+		printf("\n%s : ERROR rename() fail\n", __FUNCTION__);
+		unlink(tmpPath);
+		return CDB_ERROR;
+	}
+
+	writeCount++;
+	printf("\n%s : %s written (%u)\n", __FUNCTION__, path, writeCount);
+
+	return CDB_NO_ERROR;
+}
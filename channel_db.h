@@ -0,0 +1,193 @@
+#ifndef __CHANNEL_DB_H__
+#define __CHANNEL_DB_H__
+
+#include "tables.h"
+#include "channel_map.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNEL_DB_PATH                     "/home/galois/channels.db"
+#define CHANNEL_DB_LAST_SERVICE_PATH        "/home/galois/last_service.db"
+#define CHANNEL_DB_MAGIC                    0x42444843      /* "CHDB" */
+#define CHANNEL_DB_VERSION                  1               /* Incremented on every layout change */
+#define CHANNEL_DB_LAST_SERVICE_MAGIC       0x5653414C      /* "LASV" */
+#define CHANNEL_DB_MAX_TRANSPORT_STREAMS    8               /* Max number of remembered transport streams */
+#define CHANNEL_DB_MAX_SERVICES             20              /* Services of larger transport streams are not stored */
+#define CHANNEL_DB_MAX_ES                   20
+#define CHANNEL_DB_NAME_LENGTH              32
+
+#define CHANNEL_DB_ES_TELETEXT              0x01            /* Elementary stream flags */
+#define CHANNEL_DB_ES_CA                    0x02
+
+/**
+ * @brief Enumeration of channel database error codes
+ */
+typedef enum _ChannelDbError
+{
+	CDB_NO_ERROR = 0,
+	CDB_ERROR,
+	CDB_NOT_FOUND
+}ChannelDbError;
+
+/**
+ * @brief Structure that defines stored elementary stream
+ */
+typedef struct _ChannelDbEs
+{
+	uint16_t elementaryPid;
+	uint8_t streamType;
+	uint8_t flags;                              /* CHANNEL_DB_ES_* */
+}ChannelDbEs;
+
+/**
+ * @brief Structure that defines stored service, one per PAT entry
+ */
+typedef struct _ChannelDbService
+{
+	uint16_t programNumber;
+	uint16_t pmtPid;
+	uint16_t pcrPid;
+	uint16_t caSystemId;
+	uint8_t pmtValid;                           /* Elementary streams below are valid */
+	uint8_t pmtVersion;
+	uint8_t esCount;
+	uint8_t hasCaDescriptor;
+	char name[CHANNEL_DB_NAME_LENGTH];          /* Service name, empty until known */
+	ChannelDbEs esArray[CHANNEL_DB_MAX_ES];
+}ChannelDbService;
+
+/**
+ * @brief Structure that defines stored transport stream
+ */
+typedef struct _ChannelDbTransportStream
+{
+	uint32_t frequency;                         /* Tuner frequency the transport stream was received on */
+	uint16_t transportStreamId;
+	uint8_t patVersion;
+	uint8_t serviceCount;
+	ChannelDbService services[CHANNEL_DB_MAX_SERVICES]; /* Same order as PAT */
+}ChannelDbTransportStream;
+
+/**
+ * @brief Structure that defines database file header
+ */
+typedef struct _ChannelDbHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t transportStreamCount;
+	uint32_t recordSize;                        /* sizeof(ChannelDbTransportStream), guards against layout changes */
+	uint32_t checksum;                          /* Over all transport stream records */
+}ChannelDbHeader;
+
+/**
+ * @brief Database file layout
+ *
+ * Fixed size records in host byte order, file is mapped and used in place.
+ */
+typedef struct _ChannelDbFile
+{
+	ChannelDbHeader header;
+	ChannelDbTransportStream transportStreams[CHANNEL_DB_MAX_TRANSPORT_STREAMS];
+}ChannelDbFile;
+
+/**
+ * @brief Structure that defines last watched service, stored on every zap
+ */
+typedef struct _ChannelDbLastService
+{
+	uint32_t magic;
+	uint32_t frequency;
+	uint16_t transportStreamId;
+	uint16_t channelNumber;
+	uint16_t programNumber;
+	int16_t videoPid;                           /* -1 if none */
+	int16_t audioPid;                           /* -1 if none */
+	uint8_t videoStreamType;
+	uint8_t audioStreamType;
+	uint32_t checksum;
+}ChannelDbLastService;
+
+/**
+ * @brief Maps database file, missing or invalid file gives an empty database
+ *
+ * @param [in] path - Database file path
+ * @return channel database error code, CDB_NOT_FOUND if file is missing or invalid
+ */
+ChannelDbError channelDbOpen(const char* path);
+
+/**
+ * @brief Unmaps database file
+ */
+void channelDbClose(void);
+
+/**
+ * @brief Finds transport stream received on frequency
+ *
+ * Returned pointer is valid until next channelDbStore() or channelDbClose().
+ *
+ * @param [in] frequency - Tuner frequency
+ * @return pointer to transport stream or NULL
+ */
+const ChannelDbTransportStream* channelDbFindByFrequency(uint32_t frequency);
+
+/**
+ * @brief Finds transport stream by transport_stream_id
+ *
+ * Returned pointer is valid until next channelDbStore() or channelDbClose().
+ *
+ * @param [in] transportStreamId - transport_stream_id from PAT
+ * @return pointer to transport stream or NULL
+ */
+const ChannelDbTransportStream* channelDbFindByTransportStreamId(uint16_t transportStreamId);
+
+/**
+ * @brief Rebuilds PAT table from stored transport stream
+ *
+ * @param [in]  transportStream - Stored transport stream
+ * @param [out] patTable - PAT table with service info array set, at most serviceInfoCapacity services are filled
+ */
+void channelDbToPatTable(const ChannelDbTransportStream* transportStream, PatTable* patTable);
+
+/**
+ * @brief Rebuilds PMT table of one service from stored transport stream
+ *
+ * @param [in]  transportStream - Stored transport stream
+ * @param [in]  index - PAT index
+ * @param [out] pmtTable - PMT table with elementary info array set, at most elementaryInfoCapacity streams are filled
+ * @return channel database error code, CDB_NOT_FOUND if PMT of service was never stored
+ */
+ChannelDbError channelDbToPmtTable(const ChannelDbTransportStream* transportStream, uint16_t index, PmtTable* pmtTable);
+
+/**
+ * @brief Stores PAT and channel map as transport stream of frequency
+ *
+ * File is rewritten only if stored content changes, through a temporary file
+ * and rename so a power cut leaves either the old or the new database.
+ *
+ * @param [in] frequency - Tuner frequency
+ * @param [in] patTable - Live PAT table
+ * @return channel database error code
+ */
+ChannelDbError channelDbStore(uint32_t frequency, const PatTable* patTable);
+
+/**
+ * @brief Reads last watched service
+ *
+ * @param [out] lastService - Last watched service
+ * @return channel database error code, CDB_NOT_FOUND if file is missing or invalid
+ */
+ChannelDbError channelDbLoadLastService(ChannelDbLastService* lastService);
+
+/**
+ * @brief Stores last watched service, file is rewritten only if content changes
+ *
+ * @param [in] lastService - Last watched service, magic and checksum are filled in
+ * @return channel database error code
+ */
+ChannelDbError channelDbStoreLastService(ChannelDbLastService* lastService);
+
+#endif /* __CHANNEL_DB_H__ */
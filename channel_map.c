@@ -0,0 +1,383 @@
+#include "channel_map.h"
+#include "ts_monitor.h"
+
+#include <pthread.h>
+
+static ChannelMapEntry* entries = NULL;
+static ChannelMapEntry* spareEntries = NULL;            /* Next PAT version is built here, then arrays are swapped */
+static uint16_t entryCount = 0;
+static uint16_t entryCapacity = 0;                      /* Number of allocated entries of both arrays */
+
+/* Stream controller thread changes map, application thread reads service states and prints it */
+static pthread_mutex_t mapMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief - Allocates both entry arrays with given capacity, called with mapMutex held.
+ */
+static ChannelMapError allocateEntries(uint16_t capacity);
+
+/**
+ * @brief - Derives per elementary stream and per service scrambling from CA descriptors and packet bits.
+ */
+static void updateScrambling(ChannelMapEntry* entry, uint8_t activityValid);
+
+ChannelMapError channelMapInit(const PatTable* patTable)
+{
+	uint16_t capacity;
+	uint16_t i;
+
+	if (patTable == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CM_ERROR;
+	}
+
+	channelMapDeinit();
+
+	/* later PAT versions fit without allocation */
+	capacity = (patTable->serviceInfoCount > CHANNEL_MAP_MAX_SERVICES) ? patTable->serviceInfoCount : CHANNEL_MAP_MAX_SERVICES;
+
+	pthread_mutex_lock(&mapMutex);
+	if (allocateEntries(capacity) != CM_NO_ERROR)
+	{
+		pthread_mutex_unlock(&mapMutex);
+		return CM_ERROR;
+	}
+	memset(entries, 0x0, patTable->serviceInfoCount * sizeof(ChannelMapEntry));
+
+	for (i = 0; i < patTable->serviceInfoCount; i++)
+	{
+		entries[i].programNumber = patTable->patServiceInfoArray[i].programNumber;
+		entries[i].pmtPid = patTable->patServiceInfoArray[i].pid;
+	}
+	entryCount = patTable->serviceInfoCount;
+	pthread_mutex_unlock(&mapMutex);
+
+	return CM_NO_ERROR;
+}
+
+ChannelMapError channelMapUpdatePat(const PatTable* patTable)
+{
+	ChannelMapEntry* updated;
+	uint16_t i;
+	uint16_t j;
+
+	if (patTable == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CM_ERROR;
+	}
+
+	pthread_mutex_lock(&mapMutex);
+
+	/* both arrays grow only when PAT grows past their size, current entries are copied over */
+	if (patTable->serviceInfoCount > entryCapacity)
+	{
+		updated = entries;
+		entries = NULL;
+		if (allocateEntries(patTable->serviceInfoCount) != CM_NO_ERROR)
+		{
+			entries = updated;
+			pthread_mutex_unlock(&mapMutex);
+			return CM_ERROR;
+		}
+		if (updated != NULL)
+		{
+			memcpy(entries, updated, entryCount * sizeof(ChannelMapEntry));
+			free(updated);
+		}
+	}
+
+	updated = spareEntries;
+	memset(updated, 0x0, patTable->serviceInfoCount * sizeof(ChannelMapEntry));
+
+	for (i = 0; i < patTable->serviceInfoCount; i++)
+	{
+		updated[i].programNumber = patTable->patServiceInfoArray[i].programNumber;
+		updated[i].pmtPid = patTable->patServiceInfoArray[i].pid;
+
+		/* PMT moved to other pid is acquired again */
+		for (j = 0; j < entryCount; j++)
+		{
+			if (entries[j].programNumber == updated[i].programNumber && entries[j].pmtPid == updated[i].pmtPid)
+			{
+				updated[i] = entries[j];
+				break;
+			}
+		}
+	}
+
+	spareEntries = entries;
+	entries = updated;
+	entryCount = patTable->serviceInfoCount;
+	pthread_mutex_unlock(&mapMutex);
+
+	return CM_NO_ERROR;
+}
+
+void channelMapDeinit(void)
+{
+	pthread_mutex_lock(&mapMutex);
+	entryCount = 0;
+	entryCapacity = 0;
+	free(entries);
+	free(spareEntries);
+	entries = NULL;
+	spareEntries = NULL;
+	pthread_mutex_unlock(&mapMutex);
+}
+
+ChannelMapError allocateEntries(uint16_t capacity)
+{
+	free(spareEntries);
+	entries = (ChannelMapEntry*)malloc(capacity * sizeof(ChannelMapEntry));
+	spareEntries = (ChannelMapEntry*)malloc(capacity * sizeof(ChannelMapEntry));
+	if (entries == NULL || spareEntries == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		free(entries);
+		free(spareEntries);
+		entries = NULL;
+		spareEntries = NULL;
+		entryCapacity = 0;
+		return CM_ERROR;
+	}
+	entryCapacity = capacity;
+
+	return CM_NO_ERROR;
+}
+
+ChannelMapError channelMapSetPmt(const PmtTable* pmtTable)
+{
+	ChannelMapEntry* entry = NULL;
+	uint16_t i;
+	uint8_t j;
+
+	if (pmtTable == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return CM_ERROR;
+	}
+
+	pthread_mutex_lock(&mapMutex);
+	for (i = 0; i < entryCount; i++)
+	{
+		if (entries[i].programNumber == pmtTable->pmtHeader.programNumber)
+		{
+			entry = &entries[i];
+			break;
+		}
+	}
+	if (entry == NULL)
+	{
+		pthread_mutex_unlock(&mapMutex);
+		return CM_ERROR;
+	}
+
+	entry->pmtVersion = pmtTable->pmtHeader.versionNumber;
+	entry->pcrPid = pmtTable->pmtHeader.pcrPid;
+	entry->hasCaDescriptor = pmtTable->pmtHeader.hasCaDescriptor;
+	entry->caSystemId = pmtTable->pmtHeader.caSystemId;
+	entry->esCount = 0;
+	for (j = 0; j < pmtTable->elementaryInfoCount && j < CHANNEL_MAP_MAX_ES; j++)
+	{
+		entry->esArray[j].streamType = pmtTable->pmtElementaryInfoArray[j].streamType;
+		entry->esArray[j].elementaryPid = pmtTable->pmtElementaryInfoArray[j].elementaryPid;
+		entry->esArray[j].teletext = pmtTable->pmtElementaryInfoArray[j].teletext;
+		entry->esArray[j].hasCaDescriptor = pmtTable->pmtElementaryInfoArray[j].hasCaDescriptor;
+		entry->esCount++;
+	}
+	entry->pmtValid = 1;
+
+	/* PMT level information only, packet bits are joined on next state update */
+	updateScrambling(entry, 0);
+	pthread_mutex_unlock(&mapMutex);
+
+	return CM_NO_ERROR;
+}
+
+uint16_t channelMapGetCount(void)
+{
+	uint16_t count;
+
+	pthread_mutex_lock(&mapMutex);
+	count = entryCount;
+	pthread_mutex_unlock(&mapMutex);
+
+	return count;
+}
+
+const ChannelMapEntry* channelMapGetEntry(uint16_t index)
+{
+	if (index >= entryCount)
+	{
+		return NULL;
+	}
+
+	return &entries[index];
+}
+
+ServiceState channelMapGetServiceState(uint16_t index)
+{
+	ServiceState serviceState = SERVICE_STATE_UNKNOWN;
+
+	pthread_mutex_lock(&mapMutex);
+	if (index < entryCount)
+	{
+		serviceState = entries[index].serviceState;
+	}
+	pthread_mutex_unlock(&mapMutex);
+
+	return serviceState;
+}
+
+ScramblingState channelMapGetScrambling(uint16_t index)
+{
+	ScramblingState scrambling = SCRAMBLING_UNKNOWN;
+
+	pthread_mutex_lock(&mapMutex);
+	if (index < entryCount)
+	{
+		scrambling = entries[index].scrambling;
+	}
+	pthread_mutex_unlock(&mapMutex);
+
+	return scrambling;
+}
+
+uint8_t channelMapIsAvStream(uint8_t streamType)
+{
+	/* MPEG-1/2 video, H.264 video, MPEG-1/2 audio */
+	return streamType == 0x01 || streamType == 0x02 || streamType == 0x1B || streamType == 0x03 || streamType == 0x04;
+}
+
+void updateScrambling(ChannelMapEntry* entry, uint8_t activityValid)
+{
+	uint8_t avCount = 0;
+	uint8_t clearCount = 0;
+	uint8_t scrambledCount = 0;
+	uint8_t j;
+	ChannelMapEs* es;
+
+	for (j = 0; j < entry->esCount; j++)
+	{
+		es = &entry->esArray[j];
+
+		if (activityValid && tsMonitorIsPidActive(es->elementaryPid))
+		{
+			/* live packet bits win over PMT signalling */
+			es->scrambling = tsMonitorIsPidScrambled(es->elementaryPid) ? SCRAMBLING_SCRAMBLED : SCRAMBLING_CLEAR;
+		}
+		else if (es->hasCaDescriptor || entry->hasCaDescriptor)
+		{
+			es->scrambling = SCRAMBLING_CA_SIGNALLED;
+		}
+		else
+		{
+			es->scrambling = SCRAMBLING_CLEAR;
+		}
+
+		if (!channelMapIsAvStream(es->streamType))
+		{
+			continue;
+		}
+		avCount++;
+		if (es->scrambling == SCRAMBLING_CLEAR)
+		{
+			clearCount++;
+		}
+		else if (es->scrambling == SCRAMBLING_SCRAMBLED)
+		{
+			scrambledCount++;
+		}
+	}
+
+	if (avCount == 0 || clearCount > 0)
+	{
+		entry->scrambling = SCRAMBLING_CLEAR;
+	}
+	else if (scrambledCount > 0)
+	{
+		entry->scrambling = SCRAMBLING_SCRAMBLED;
+	}
+	else
+	{
+		entry->scrambling = SCRAMBLING_CA_SIGNALLED;
+	}
+}
+
+void channelMapUpdateServiceStates(uint64_t nowUs)
+{
+	uint8_t activityValid = tsMonitorIsActivityValid(nowUs);
+	uint8_t activeCount;
+	uint8_t clearCount;
+	uint16_t i;
+	uint8_t j;
+
+	pthread_mutex_lock(&mapMutex);
+	for (i = 0; i < entryCount; i++)
+	{
+		if (entries[i].pmtValid)
+		{
+			updateScrambling(&entries[i], activityValid);
+		}
+
+		if (!activityValid || !entries[i].pmtValid || entries[i].esCount == 0)
+		{
+			entries[i].serviceState = SERVICE_STATE_UNKNOWN;
+			continue;
+		}
+
+		activeCount = 0;
+		clearCount = 0;
+		for (j = 0; j < entries[i].esCount; j++)
+		{
+			if (tsMonitorIsPidActive(entries[i].esArray[j].elementaryPid))
+			{
+				activeCount++;
+				if (!tsMonitorIsPidScrambled(entries[i].esArray[j].elementaryPid))
+				{
+					clearCount++;
+				}
+			}
+		}
+
+		if (activeCount == 0)
+		{
+			entries[i].serviceState = SERVICE_STATE_OFF_AIR;
+		}
+		else if (clearCount == 0)
+		{
+			entries[i].serviceState = SERVICE_STATE_SCRAMBLED;
+		}
+		else
+		{
+			entries[i].serviceState = SERVICE_STATE_LIVE;
+		}
+	}
+	pthread_mutex_unlock(&mapMutex);
+}
+
+void printChannelMap(void)
+{
+	const char* stateNames[] = {"unknown", "live", "off-air", "scrambled"};
+	const char* scramblingNames[] = {"unknown", "clear", "ca", "scrambled"};
+	uint16_t i;
+	uint8_t j;
+
+	printf("\n********************CHANNEL MAP********************\n");
+	pthread_mutex_lock(&mapMutex);
+	for (i = 0; i < entryCount; i++)
+	{
+		printf("program_number %5d | pmt pid %4d | %-9s | %-9s |", entries[i].programNumber, entries[i].pmtPid,
+		       stateNames[entries[i].serviceState], scramblingNames[entries[i].scrambling]);
+		for (j = 0; j < entries[i].esCount; j++)
+		{
+			printf(" 0x%02X:%d(%s)", entries[i].esArray[j].streamType, entries[i].esArray[j].elementaryPid,
+			       scramblingNames[entries[i].esArray[j].scrambling]);
+		}
+		printf("\n");
+	}
+	pthread_mutex_unlock(&mapMutex);
+	printf("\n********************CHANNEL MAP********************\n");
+}
@@ -0,0 +1,160 @@
+#ifndef __CHANNEL_MAP_H__
+#define __CHANNEL_MAP_H__
+
+#include "tables.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNEL_MAP_MAX_ES 20     /* Max number of elementary streams per service, further ones are not tracked */
+#define CHANNEL_MAP_MAX_SERVICES 253   /* Programs of one 1024 byte PAT section, entry arrays are allocated for them at init */
+
+/**
+ * @brief Enumeration of channel map error codes
+ */
+typedef enum _ChannelMapError
+{
+	CM_NO_ERROR = 0,
+	CM_ERROR
+}ChannelMapError;
+
+/**
+ * @brief Enumeration of service states derived from pid activity
+ */
+typedef enum _ServiceState
+{
+	SERVICE_STATE_UNKNOWN = 0,                  /* No PMT yet or no packet level information */
+	SERVICE_STATE_LIVE,                         /* At least one elementary stream carries clear packets */
+	SERVICE_STATE_OFF_AIR,                      /* No elementary stream carries packets */
+	SERVICE_STATE_SCRAMBLED                     /* Elementary streams carry only scrambled packets */
+}ServiceState;
+
+/**
+ * @brief Enumeration of scrambling states of a service or an elementary stream
+ */
+typedef enum _ScramblingState
+{
+	SCRAMBLING_UNKNOWN = 0,                     /* No PMT yet */
+	SCRAMBLING_CLEAR,                           /* No CA descriptor or clear packets seen */
+	SCRAMBLING_CA_SIGNALLED,                    /* CA descriptor present, no packet level information */
+	SCRAMBLING_SCRAMBLED                        /* Packets with transport_scrambling_control set */
+}ScramblingState;
+
+/**
+ * @brief Structure that defines elementary stream of a service
+ */
+typedef struct _ChannelMapEs
+{
+	uint8_t streamType;
+	uint16_t elementaryPid;
+	uint8_t teletext;
+	uint8_t hasCaDescriptor;
+	ScramblingState scrambling;
+}ChannelMapEs;
+
+/**
+ * @brief Structure that defines one service of the channel map
+ */
+typedef struct _ChannelMapEntry
+{
+	uint16_t programNumber;
+	uint16_t pmtPid;
+	uint8_t pmtValid;
+	uint8_t pmtVersion;
+	uint16_t pcrPid;
+	uint8_t esCount;
+	uint8_t hasCaDescriptor;                    /* Program level CA descriptor */
+	uint16_t caSystemId;
+	ChannelMapEs esArray[CHANNEL_MAP_MAX_ES];
+	ServiceState serviceState;
+	ScramblingState scrambling;                 /* Scrambling of audio and video streams */
+}ChannelMapEntry;
+
+/**
+ * @brief Builds channel map with one entry per PAT service
+ *
+ * @param [in] patTable - PAT table
+ * @return channel map error code
+ */
+ChannelMapError channelMapInit(const PatTable* patTable);
+
+/**
+ * @brief Follows new PAT version, entries of services still in PAT keep their PMT and states
+ *
+ * New order is built in a spare array that is swapped with the current one,
+ * both arrays are reallocated only when PAT grows past their size.
+ *
+ * @param [in] patTable - New PAT table
+ * @return channel map error code
+ */
+ChannelMapError channelMapUpdatePat(const PatTable* patTable);
+
+/**
+ * @brief Frees channel map
+ */
+void channelMapDeinit(void);
+
+/**
+ * @brief Stores elementary streams of PMT into entry with the same program number
+ *
+ * @param [in] pmtTable - PMT table
+ * @return channel map error code
+ */
+ChannelMapError channelMapSetPmt(const PmtTable* pmtTable);
+
+/**
+ * @brief Returns number of entries, same as number of PAT services
+ *
+ * @return number of entries
+ */
+uint16_t channelMapGetCount(void);
+
+/**
+ * @brief Returns entry on PAT index
+ *
+ * Pointer is valid until next PAT update, only stream controller thread may use it.
+ *
+ * @param [in] index - PAT index
+ * @return pointer to entry or NULL
+ */
+const ChannelMapEntry* channelMapGetEntry(uint16_t index);
+
+/**
+ * @brief Returns service state of entry on PAT index
+ *
+ * @param [in] index - PAT index
+ * @return service state
+ */
+ServiceState channelMapGetServiceState(uint16_t index);
+
+/**
+ * @brief Returns scrambling state of entry on PAT index
+ *
+ * @param [in] index - PAT index
+ * @return scrambling state
+ */
+ScramblingState channelMapGetScrambling(uint16_t index);
+
+/**
+ * @brief Checks if stream type is audio or video
+ *
+ * @param [in] streamType - PMT stream type
+ * @return 1 for audio or video stream type, 0 otherwise
+ */
+uint8_t channelMapIsAvStream(uint8_t streamType);
+
+/**
+ * @brief Joins PMT elementary pids with packet level pid activity into service and scrambling states
+ *
+ * @param [in] nowUs - Current monotonic time
+ */
+void channelMapUpdateServiceStates(uint64_t nowUs);
+
+/**
+ * @brief Prints all channel map entries
+ */
+void printChannelMap(void);
+
+#endif /* __CHANNEL_MAP_H__ */
@@ -0,0 +1,744 @@
+#include "epg_cache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static EpgCacheFile* cacheFile = NULL;      /* Mapped file */
+static size_t pageSize = 4096;
+
+/* Pool compaction copies live strings here, allocated with the mapping so compaction does not allocate */
+static char* compactionPool = NULL;
+
+/* Held while events, services or pool change and while other threads copy them */
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Byte range of mapped file changed since last sync */
+static size_t dirtyStart = 0;
+static size_t dirtyEnd = 0;
+
+/* Broadcast clock of this run */
+static uint32_t clockUtc = 0;
+static uint64_t clockSetUs = 0;
+
+/* Statistics */
+static uint64_t loadTimeUs = 0;
+static uint8_t loadedFromFile = 0;
+static uint32_t agedOutCount = 0;
+static uint32_t compactionCount = 0;
+static uint32_t syncCount = 0;
+static uint64_t syncedBytes = 0;
+
+/**
+ * @brief - Returns monotonic time in microseconds.
+ */
+static uint64_t epgCacheTimeUs(void);
+
+/**
+ * @brief - Creates empty cache in mapped file.
+ */
+static void epgCacheReset(void);
+
+/**
+ * @brief - Checks event count of every service in loaded file against EPG_CACHE_MAX_EVENTS
+ *          and name offsets of its events against used pool.
+ *
+ * @return - 1 if all counts and offsets are in range
+ */
+static uint8_t epgCacheEventCountsValid(void);
+
+/**
+ * @brief - Marks range of mapped file as changed, first change after sync marks whole file dirty on storage.
+ */
+static void epgCacheMarkDirty(const void* address, size_t size);
+
+/**
+ * @brief - Returns service with service_id, creates it if create is set.
+ */
+static EpgCacheService* epgCacheFindService(uint16_t serviceId, uint8_t create);
+
+/**
+ * @brief - Copies string to pool, compacts pool if it is full.
+ */
+static uint32_t epgCachePoolAdd(const char* string);
+
+/**
+ * @brief - Rebuilds pool with strings of cached events only.
+ */
+static void epgCachePoolCompact(void);
+
+/**
+ * @brief - Removes events in range [first, first + count) of service.
+ */
+static void epgCacheRemoveEvents(EpgCacheService* service, uint16_t first, uint16_t count);
+
+/**
+ * @brief - Adds or updates event, cache mutex is held by caller.
+ */
+static EpgCacheError epgCacheInsertEvent(uint16_t serviceId, uint16_t eventId, uint32_t startTime, uint32_t duration,
+                                         uint8_t runningStatus, const char* name);
+
+EpgCacheError epgCacheOpen(const char* path)
+{
+	struct stat fileStat;
+	uint64_t startUs = epgCacheTimeUs();
+	uint8_t valid;
+	int fd;
+
+	if (path == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return EPG_CACHE_ERROR;
+	}
+
+	epgCacheClose();
+	pageSize = sysconf(_SC_PAGESIZE);
+
+	compactionPool = (char*)malloc(EPG_CACHE_POOL_SIZE);
+	if (compactionPool == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		return EPG_CACHE_ERROR;
+	}
+
+	fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		printf("\n%s : ERROR Cannot open %s\n", __FUNCTION__, path);
+		epgCacheClose();
+		return EPG_CACHE_ERROR;
+	}
+
+	if (fstat(fd, &fileStat))
+	{
+		printf("\n%s : ERROR fstat() fail\n", __FUNCTION__);
+		close(fd);
+		epgCacheClose();
+		return EPG_CACHE_ERROR;
+	}
+	valid = (fileStat.st_size == sizeof(EpgCacheFile));
+
+	/* new file is sparse, untouched event and pool pages take no space */
+	if (!valid && ftruncate(fd, sizeof(EpgCacheFile)))
+	{
+		printf("\n%s : ERROR ftruncate() fail\n", __FUNCTION__);
+		close(fd);
+		epgCacheClose();
+		return EPG_CACHE_ERROR;
+	}
+
+	/* other threads see the cache only after it was checked */
+	pthread_mutex_lock(&cacheMutex);
+	cacheFile = (EpgCacheFile*)mmap(NULL, sizeof(EpgCacheFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (cacheFile == MAP_FAILED)
+	{
+		printf("\n%s : ERROR mmap() fail\n", __FUNCTION__);
+		cacheFile = NULL;
+		pthread_mutex_unlock(&cacheMutex);
+		epgCacheClose();
+		return EPG_CACHE_ERROR;
+	}
+
+	/* header and event counts are checked, events are used in place */
+	if (!valid || cacheFile->header.magic != EPG_CACHE_MAGIC || cacheFile->header.version != EPG_CACHE_VERSION ||
+	    cacheFile->header.maxServices != EPG_CACHE_MAX_SERVICES || cacheFile->header.maxEvents != EPG_CACHE_MAX_EVENTS ||
+	    cacheFile->header.poolSize != EPG_CACHE_POOL_SIZE || cacheFile->header.poolUsed > EPG_CACHE_POOL_SIZE ||
+	    cacheFile->header.serviceCount > EPG_CACHE_MAX_SERVICES || cacheFile->header.dirty || !epgCacheEventCountsValid())
+	{
+		printf("\n%s : EPG cache %s is empty or invalid, starting empty cache\n", __FUNCTION__, path);
+		epgCacheReset();
+		loadedFromFile = 0;
+	}
+	else
+	{
+		loadedFromFile = 1;
+	}
+	pthread_mutex_unlock(&cacheMutex);
+
+	loadTimeUs = epgCacheTimeUs() - startUs;
+
+	return EPG_CACHE_NO_ERROR;
+}
+
+uint8_t epgCacheEventCountsValid(void)
+{
+	uint16_t i;
+	uint16_t j;
+
+	/* counts index fixed event arrays, a bad one would read and write past them */
+	for (i = 0; i < cacheFile->header.serviceCount; i++)
+	{
+		if (cacheFile->services[i].eventCount > EPG_CACHE_MAX_EVENTS)
+		{
+			printf("\n%s : ERROR service %d has %u events\n", __FUNCTION__, cacheFile->services[i].serviceId,
+			       cacheFile->services[i].eventCount);
+			return 0;
+		}
+		for (j = 0; j < cacheFile->services[i].eventCount; j++)
+		{
+			if (cacheFile->events[i][j].nameOffset >= cacheFile->header.poolUsed && cacheFile->events[i][j].nameOffset != 0)
+			{
+				printf("\n%s : ERROR event %d of service %d has name outside pool\n", __FUNCTION__,
+				       cacheFile->events[i][j].eventId, cacheFile->services[i].serviceId);
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+void epgCacheClose(void)
+{
+	free(compactionPool);
+	compactionPool = NULL;
+
+	if (cacheFile == NULL)
+	{
+		return;
+	}
+
+	epgCacheSync();
+	pthread_mutex_lock(&cacheMutex);
+	munmap(cacheFile, sizeof(EpgCacheFile));
+	cacheFile = NULL;
+	pthread_mutex_unlock(&cacheMutex);
+}
+
+EpgCacheError epgCacheAddEvent(uint16_t serviceId, uint16_t eventId, uint32_t startTime, uint32_t duration,
+                               uint8_t runningStatus, const char* name)
+{
+	EpgCacheError result;
+
+	pthread_mutex_lock(&cacheMutex);
+	result = epgCacheInsertEvent(serviceId, eventId, startTime, duration, runningStatus, name);
+	pthread_mutex_unlock(&cacheMutex);
+
+	return result;
+}
+
+EpgCacheError epgCacheInsertEvent(uint16_t serviceId, uint16_t eventId, uint32_t startTime, uint32_t duration,
+                                  uint8_t runningStatus, const char* name)
+{
+	EpgCacheService* service;
+	EpgCacheEvent* events;
+	EpgCacheEvent* event = NULL;
+	uint32_t nameOffset;
+	uint16_t position;
+	uint16_t low;
+	uint16_t high;
+	uint16_t i;
+
+	if (cacheFile == NULL || name == NULL)
+	{
+		return EPG_CACHE_ERROR;
+	}
+
+	/* event that already ended is not cached */
+	if (clockUtc != 0 && startTime + duration <= epgCacheGetBroadcastTime())
+	{
+		return EPG_CACHE_NO_ERROR;
+	}
+
+	service = epgCacheFindService(serviceId, 1);
+	if (service == NULL)
+	{
+		return EPG_CACHE_FULL;
+	}
+	events = cacheFile->events[service - cacheFile->services];
+
+	for (i = 0; i < service->eventCount; i++)
+	{
+		if (events[i].eventId == eventId)
+		{
+			event = &events[i];
+			break;
+		}
+	}
+
+	/* same event again, only running status and name can change in place */
+	if (event != NULL && event->startTime == startTime && event->duration == duration)
+	{
+		if (event->runningStatus != runningStatus)
+		{
+			event->runningStatus = runningStatus;
+			epgCacheMarkDirty(event, sizeof(EpgCacheEvent));
+		}
+		if (strcmp(epgCacheGetString(event->nameOffset), name) != 0)
+		{
+			nameOffset = epgCachePoolAdd(name);
+			if (nameOffset == 0 && name[0] != '\0')
+			{
+				return EPG_CACHE_FULL;
+			}
+			event->nameOffset = nameOffset;
+			epgCacheMarkDirty(event, sizeof(EpgCacheEvent));
+		}
+		return EPG_CACHE_NO_ERROR;
+	}
+
+	/* rescheduled event is inserted again, other events it overlaps are replaced */
+	if (event != NULL)
+	{
+		epgCacheRemoveEvents(service, event - events, 1);
+	}
+	for (i = 0; i < service->eventCount; )
+	{
+		if (events[i].startTime < startTime + duration && events[i].startTime + events[i].duration > startTime)
+		{
+			epgCacheRemoveEvents(service, i, 1);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	nameOffset = epgCachePoolAdd(name);
+	if (nameOffset == 0 && name[0] != '\0')
+	{
+		return EPG_CACHE_FULL;
+	}
+
+	/* binary search for insert position, events stay sorted by start time */
+	low = 0;
+	high = service->eventCount;
+	while (low < high)
+	{
+		position = (low + high) / 2;
+		if (events[position].startTime < startTime)
+		{
+			low = position + 1;
+		}
+		else
+		{
+			high = position;
+		}
+	}
+	position = low;
+
+	/* full service drops its furthest event */
+	if (service->eventCount == EPG_CACHE_MAX_EVENTS)
+	{
+		if (position == EPG_CACHE_MAX_EVENTS)
+		{
+			return EPG_CACHE_NO_ERROR;
+		}
+		service->eventCount--;
+	}
+
+	memmove(&events[position + 1], &events[position], (service->eventCount - position) * sizeof(EpgCacheEvent));
+	events[position].startTime = startTime;
+	events[position].duration = duration;
+	events[position].nameOffset = nameOffset;
+	events[position].eventId = eventId;
+	events[position].runningStatus = runningStatus;
+	events[position].reserved = 0;
+	service->eventCount++;
+
+	epgCacheMarkDirty(&events[position], (service->eventCount - position) * sizeof(EpgCacheEvent));
+	epgCacheMarkDirty(service, sizeof(EpgCacheService));
+
+	return EPG_CACHE_NO_ERROR;
+}
+
+void epgCacheSetBroadcastTime(uint32_t utcTime)
+{
+	EpgCacheService* service;
+	EpgCacheEvent* events;
+	uint16_t ended;
+	uint16_t i;
+
+	clockUtc = utcTime;
+	clockSetUs = epgCacheTimeUs();
+
+	if (cacheFile == NULL)
+	{
+		return;
+	}
+
+	cacheFile->header.broadcastTime = utcTime;
+	epgCacheMarkDirty(&cacheFile->header, sizeof(EpgCacheHeader));
+
+	/* events are sorted by start time, ended ones are at the beginning */
+	pthread_mutex_lock(&cacheMutex);
+	for (i = 0; i < cacheFile->header.serviceCount; i++)
+	{
+		service = &cacheFile->services[i];
+		events = cacheFile->events[i];
+		for (ended = 0; ended < service->eventCount; ended++)
+		{
+			if (events[ended].startTime + events[ended].duration > utcTime)
+			{
+				break;
+			}
+		}
+		if (ended > 0)
+		{
+			epgCacheRemoveEvents(service, 0, ended);
+			agedOutCount += ended;
+		}
+	}
+	pthread_mutex_unlock(&cacheMutex);
+}
+
+uint32_t epgCacheGetBroadcastTime(void)
+{
+	uint32_t systemTime = (uint32_t)time(NULL);
+
+	if (clockSetUs != 0)
+	{
+		return clockUtc + (uint32_t)((epgCacheTimeUs() - clockSetUs) / 1000000);
+	}
+
+	/* before first TDT system clock is used if it is not behind last stored broadcast time */
+	if (cacheFile != NULL && systemTime < cacheFile->header.broadcastTime)
+	{
+		return cacheFile->header.broadcastTime;
+	}
+
+	return systemTime;
+}
+
+const char* epgCacheGetPresentName(uint16_t serviceId, uint32_t utcTime)
+{
+	EpgCacheService* service = epgCacheFindService(serviceId, 0);
+	EpgCacheEvent* events;
+	uint16_t i;
+
+	if (service == NULL)
+	{
+		return NULL;
+	}
+	events = cacheFile->events[service - cacheFile->services];
+
+	for (i = 0; i < service->eventCount && events[i].startTime <= utcTime; i++)
+	{
+		if (utcTime < events[i].startTime + events[i].duration)
+		{
+			return epgCacheGetString(events[i].nameOffset);
+		}
+	}
+
+	return NULL;
+}
+
+uint16_t epgCacheGetEventCount(uint16_t serviceId)
+{
+	EpgCacheService* service = epgCacheFindService(serviceId, 0);
+
+	return service == NULL ? 0 : service->eventCount;
+}
+
+const EpgCacheEvent* epgCacheGetEvent(uint16_t serviceId, uint16_t index)
+{
+	EpgCacheService* service = epgCacheFindService(serviceId, 0);
+
+	if (service == NULL || index >= service->eventCount)
+	{
+		return NULL;
+	}
+
+	return &cacheFile->events[service - cacheFile->services][index];
+}
+
+const char* epgCacheGetString(uint32_t offset)
+{
+	if (cacheFile == NULL || offset >= cacheFile->header.poolUsed)
+	{
+		return "";
+	}
+
+	return &cacheFile->pool[offset];
+}
+
+uint16_t epgCacheGetServiceCount(void)
+{
+	uint16_t count = 0;
+
+	pthread_mutex_lock(&cacheMutex);
+	if (cacheFile != NULL)
+	{
+		count = cacheFile->header.serviceCount;
+	}
+	pthread_mutex_unlock(&cacheMutex);
+
+	return count;
+}
+
+uint16_t epgCacheCopyEvents(uint16_t serviceIndex, uint16_t* serviceId, uint32_t startTime, uint32_t endTime,
+                            EpgCacheEvent* events, uint16_t maxEvents)
+{
+	const EpgCacheService* service;
+	const EpgCacheEvent* serviceEvents;
+	uint16_t count = 0;
+	uint16_t position;
+	uint16_t low;
+	uint16_t high;
+
+	pthread_mutex_lock(&cacheMutex);
+	if (cacheFile == NULL || serviceIndex >= cacheFile->header.serviceCount)
+	{
+		pthread_mutex_unlock(&cacheMutex);
+		return 0;
+	}
+	service = &cacheFile->services[serviceIndex];
+	serviceEvents = cacheFile->events[serviceIndex];
+	*serviceId = service->serviceId;
+
+	/* events do not overlap, so end times are sorted too, first one that ends after window start is searched */
+	low = 0;
+	high = service->eventCount;
+	while (low < high)
+	{
+		position = (low + high) / 2;
+		if (serviceEvents[position].startTime + serviceEvents[position].duration <= startTime)
+		{
+			low = position + 1;
+		}
+		else
+		{
+			high = position;
+		}
+	}
+
+	for (position = low; position < service->eventCount && count < maxEvents; position++)
+	{
+		if (serviceEvents[position].startTime >= endTime)
+		{
+			break;
+		}
+		events[count++] = serviceEvents[position];
+	}
+	pthread_mutex_unlock(&cacheMutex);
+
+	return count;
+}
+
+void epgCacheCopyString(uint32_t offset, char* buffer, uint32_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&cacheMutex);
+	strncpy(buffer, epgCacheGetString(offset), size - 1);
+	pthread_mutex_unlock(&cacheMutex);
+	buffer[size - 1] = '\0';
+}
+
+void epgCacheSync(void)
+{
+	size_t start;
+
+	if (cacheFile == NULL || dirtyEnd == 0)
+	{
+		return;
+	}
+
+	/* changed pages first, then clean header, a crash in between leaves a dirty file */
+	start = dirtyStart & ~(pageSize - 1);
+	msync((uint8_t*)cacheFile + start, dirtyEnd - start, MS_SYNC);
+	syncedBytes += dirtyEnd - start;
+
+	cacheFile->header.dirty = 0;
+	msync(cacheFile, pageSize, MS_SYNC);
+
+	dirtyStart = 0;
+	dirtyEnd = 0;
+	syncCount++;
+}
+
+void printEpgCacheStats(void)
+{
+	uint32_t eventCount = 0;
+	uint16_t i;
+
+	if (cacheFile == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < cacheFile->header.serviceCount; i++)
+	{
+		eventCount += cacheFile->services[i].eventCount;
+	}
+
+	printf("\n********************EPG CACHE********************\n");
+	printf("loaded from file         |      %s\n", loadedFromFile ? "yes" : "no");
+	printf("load time                |      %llu us\n", (unsigned long long)loadTimeUs);
+	printf("services                 |      %u / %d\n", cacheFile->header.serviceCount, EPG_CACHE_MAX_SERVICES);
+	printf("events                   |      %u\n", eventCount);
+	printf("string pool              |      %u / %d bytes\n", cacheFile->header.poolUsed, EPG_CACHE_POOL_SIZE);
+	printf("aged out events          |      %u\n", agedOutCount);
+	printf("pool compactions         |      %u\n", compactionCount);
+	printf("syncs                    |      %u (%llu bytes synced range)\n", syncCount, (unsigned long long)syncedBytes);
+	printf("\n********************EPG CACHE********************\n");
+}
+
+uint64_t epgCacheTimeUs(void)
+{
+	struct timespec timeSpec;
+
+	clock_gettime(CLOCK_MONOTONIC, &timeSpec);
+
+	return (uint64_t)timeSpec.tv_sec * 1000000 + timeSpec.tv_nsec / 1000;
+}
+
+void epgCacheReset(void)
+{
+	memset(&cacheFile->header, 0x0, sizeof(EpgCacheHeader));
+	memset(cacheFile->services, 0x0, sizeof(cacheFile->services));
+	cacheFile->header.magic = EPG_CACHE_MAGIC;
+	cacheFile->header.version = EPG_CACHE_VERSION;
+	cacheFile->header.maxServices = EPG_CACHE_MAX_SERVICES;
+	cacheFile->header.maxEvents = EPG_CACHE_MAX_EVENTS;
+	cacheFile->header.poolSize = EPG_CACHE_POOL_SIZE;
+
+	/* offset 0 is empty string */
+	cacheFile->pool[0] = '\0';
+	cacheFile->header.poolUsed = 1;
+
+	epgCacheMarkDirty(cacheFile, (uint8_t*)cacheFile->events - (uint8_t*)cacheFile);
+	epgCacheMarkDirty(cacheFile->pool, 1);
+}
+
+void epgCacheMarkDirty(const void* address, size_t size)
+{
+	size_t start = (const uint8_t*)address - (const uint8_t*)cacheFile;
+
+	if (dirtyEnd == 0)
+	{
+		cacheFile->header.dirty = 1;
+		msync(cacheFile, pageSize, MS_SYNC);
+		dirtyStart = start;
+		dirtyEnd = start + size;
+		return;
+	}
+
+	if (start < dirtyStart)
+	{
+		dirtyStart = start;
+	}
+	if (start + size > dirtyEnd)
+	{
+		dirtyEnd = start + size;
+	}
+}
+
+EpgCacheService* epgCacheFindService(uint16_t serviceId, uint8_t create)
+{
+	EpgCacheService* service;
+	uint16_t i;
+
+	if (cacheFile == NULL)
+	{
+		return NULL;
+	}
+
+	for (i = 0; i < cacheFile->header.serviceCount; i++)
+	{
+		if (cacheFile->services[i].serviceId == serviceId)
+		{
+			return &cacheFile->services[i];
+		}
+	}
+
+	if (!create || cacheFile->header.serviceCount == EPG_CACHE_MAX_SERVICES)
+	{
+		return NULL;
+	}
+
+	service = &cacheFile->services[cacheFile->header.serviceCount];
+	service->serviceId = serviceId;
+	service->eventCount = 0;
+	cacheFile->header.serviceCount++;
+	epgCacheMarkDirty(service, sizeof(EpgCacheService));
+	epgCacheMarkDirty(&cacheFile->header, sizeof(EpgCacheHeader));
+
+	return service;
+}
+
+uint32_t epgCachePoolAdd(const char* string)
+{
+	uint32_t length = strlen(string) + 1;
+	uint32_t offset;
+
+	if (length == 1)
+	{
+		return 0;
+	}
+
+	if (cacheFile->header.poolUsed + length > EPG_CACHE_POOL_SIZE)
+	{
+		epgCachePoolCompact();
+		if (cacheFile->header.poolUsed + length > EPG_CACHE_POOL_SIZE)
+		{
+			return 0;
+		}
+	}
+
+	offset = cacheFile->header.poolUsed;
+	memcpy(&cacheFile->pool[offset], string, length);
+	cacheFile->header.poolUsed += length;
+	epgCacheMarkDirty(&cacheFile->pool[offset], length);
+	epgCacheMarkDirty(&cacheFile->header, sizeof(EpgCacheHeader));
+
+	return offset;
+}
+
+void epgCachePoolCompact(void)
+{
+	char* pool = compactionPool;
+	uint32_t used = 1;
+	uint32_t length;
+	EpgCacheEvent* event;
+	uint16_t i;
+	uint16_t j;
+
+	if (pool == NULL)
+	{
+		return;
+	}
+	pool[0] = '\0';
+
+	/* strings of aged out and replaced events are dropped */
+	for (i = 0; i < cacheFile->header.serviceCount; i++)
+	{
+		for (j = 0; j < cacheFile->services[i].eventCount; j++)
+		{
+			event = &cacheFile->events[i][j];
+			if (event->nameOffset == 0)
+			{
+				continue;
+			}
+			length = strlen(&cacheFile->pool[event->nameOffset]) + 1;
+			memcpy(&pool[used], &cacheFile->pool[event->nameOffset], length);
+			event->nameOffset = used;
+			used += length;
+		}
+		epgCacheMarkDirty(cacheFile->events[i], cacheFile->services[i].eventCount * sizeof(EpgCacheEvent));
+	}
+
+	memcpy(cacheFile->pool, pool, used);
+	cacheFile->header.poolUsed = used;
+	epgCacheMarkDirty(cacheFile->pool, used);
+	epgCacheMarkDirty(&cacheFile->header, sizeof(EpgCacheHeader));
+	compactionCount++;
+}
+
+void epgCacheRemoveEvents(EpgCacheService* service, uint16_t first, uint16_t count)
+{
+	EpgCacheEvent* events = cacheFile->events[service - cacheFile->services];
+
+	memmove(&events[first], &events[first + count], (service->eventCount - first - count) * sizeof(EpgCacheEvent));
+	service->eventCount -= count;
+
+	epgCacheMarkDirty(&events[first], (service->eventCount - first) * sizeof(EpgCacheEvent));
+	epgCacheMarkDirty(service, sizeof(EpgCacheService));
+}
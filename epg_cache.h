@@ -0,0 +1,196 @@
+#ifndef __EPG_CACHE_H__
+#define __EPG_CACHE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EPG_CACHE_PATH                  "/home/galois/epg.db"
+#define EPG_CACHE_MAGIC                 0x43475045      /* "EPGC" */
+#define EPG_CACHE_VERSION               2               /* Incremented on every layout change */
+#define EPG_CACHE_MAX_SERVICES          512             /* Max number of services with events */
+#define EPG_CACHE_MAX_EVENTS            384             /* Max number of events per service, 7 days of half hour events */
+#define EPG_CACHE_POOL_SIZE             (4 * 1024 * 1024) /* Size of event name string pool, 16 bytes per event of full cache */
+#define EPG_CACHE_CLOCK_REFRESH_S       60              /* Period of broadcast clock (TDT) acquisition */
+#define EPG_CACHE_SYNC_PERIOD_S         10              /* Period of writing changed parts of cache */
+
+/**
+ * @brief Enumeration of EPG cache error codes
+ */
+typedef enum _EpgCacheError
+{
+	EPG_CACHE_NO_ERROR = 0,
+	EPG_CACHE_ERROR,
+	EPG_CACHE_FULL
+}EpgCacheError;
+
+/**
+ * @brief Structure that defines cached event
+ */
+typedef struct _EpgCacheEvent
+{
+	uint32_t startTime;                         /* UTC seconds since 1970 */
+	uint32_t duration;                          /* Seconds */
+	uint32_t nameOffset;                        /* Offset of event name in string pool, 0 is empty string */
+	uint16_t eventId;
+	uint8_t runningStatus;
+	uint8_t reserved;
+}EpgCacheEvent;
+
+/**
+ * @brief Structure that defines cached service
+ */
+typedef struct _EpgCacheService
+{
+	uint16_t serviceId;
+	uint16_t eventCount;                        /* Events are sorted by start time */
+}EpgCacheService;
+
+/**
+ * @brief Structure that defines EPG cache file header
+ */
+typedef struct _EpgCacheHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t serviceCount;
+	uint32_t maxServices;                       /* Layout guards */
+	uint32_t maxEvents;
+	uint32_t poolSize;
+	uint32_t poolUsed;
+	uint32_t broadcastTime;                     /* Last broadcast clock (TDT) value */
+	uint32_t dirty;                             /* Set while file is being changed, dirty file is discarded on load */
+}EpgCacheHeader;
+
+/**
+ * @brief EPG cache file layout
+ *
+ * Fixed size arrays in host byte order, file is mapped and changed in place.
+ */
+typedef struct _EpgCacheFile
+{
+	EpgCacheHeader header;
+	EpgCacheService services[EPG_CACHE_MAX_SERVICES];
+	EpgCacheEvent events[EPG_CACHE_MAX_SERVICES][EPG_CACHE_MAX_EVENTS];
+	char pool[EPG_CACHE_POOL_SIZE];
+}EpgCacheFile;
+
+/**
+ * @brief Maps EPG cache file, missing, invalid or dirty file is replaced by an empty cache
+ *
+ * @param [in] path - Cache file path
+ * @return EPG cache error code
+ */
+EpgCacheError epgCacheOpen(const char* path);
+
+/**
+ * @brief Writes changed parts and unmaps EPG cache file
+ */
+void epgCacheClose(void);
+
+/**
+ * @brief Adds or updates event of service
+ *
+ * @param [in] serviceId - service_id from EIT
+ * @param [in] eventId - event_id
+ * @param [in] startTime - UTC start time
+ * @param [in] duration - Duration in seconds
+ * @param [in] runningStatus - running_status
+ * @param [in] name - Event name
+ * @return EPG cache error code, EPG_CACHE_FULL if there is no space for service or name
+ */
+EpgCacheError epgCacheAddEvent(uint16_t serviceId, uint16_t eventId, uint32_t startTime, uint32_t duration,
+                               uint8_t runningStatus, const char* name);
+
+/**
+ * @brief Sets broadcast clock and removes events that ended before it
+ *
+ * @param [in] utcTime - UTC time from TDT
+ */
+void epgCacheSetBroadcastTime(uint32_t utcTime);
+
+/**
+ * @brief Returns current broadcast time estimate
+ *
+ * @return UTC seconds, last TDT plus elapsed time, or system time before first TDT
+ */
+uint32_t epgCacheGetBroadcastTime(void);
+
+/**
+ * @brief Returns name of event that runs at given time
+ *
+ * @param [in] serviceId - service_id
+ * @param [in] utcTime - UTC time
+ * @return event name or NULL
+ */
+const char* epgCacheGetPresentName(uint16_t serviceId, uint32_t utcTime);
+
+/**
+ * @brief Returns number of cached events of service
+ *
+ * @param [in] serviceId - service_id
+ * @return number of events
+ */
+uint16_t epgCacheGetEventCount(uint16_t serviceId);
+
+/**
+ * @brief Returns cached event of service
+ *
+ * @param [in] serviceId - service_id
+ * @param [in] index - Event index, events are sorted by start time
+ * @return pointer to event or NULL
+ */
+const EpgCacheEvent* epgCacheGetEvent(uint16_t serviceId, uint16_t index);
+
+/**
+ * @brief Returns string from string pool
+ *
+ * @param [in] offset - String offset
+ * @return string
+ */
+const char* epgCacheGetString(uint32_t offset);
+
+/**
+ * @brief Returns number of cached services
+ *
+ * @return number of services, services are kept in order they were first seen
+ */
+uint16_t epgCacheGetServiceCount(void);
+
+/**
+ * @brief Copies events of service that overlap time window, safe to call from any thread
+ *
+ * Other getters return pointers into the cache and are used only by the thread that adds events.
+ *
+ * @param [in] serviceIndex - Service index, 0 to epgCacheGetServiceCount() - 1
+ * @param [out] serviceId - service_id of service
+ * @param [in] startTime - UTC start of window
+ * @param [in] endTime - UTC end of window
+ * @param [out] events - Copied events, sorted by start time
+ * @param [in] maxEvents - Size of events array
+ * @return number of copied events
+ */
+uint16_t epgCacheCopyEvents(uint16_t serviceIndex, uint16_t* serviceId, uint32_t startTime, uint32_t endTime,
+                            EpgCacheEvent* events, uint16_t maxEvents);
+
+/**
+ * @brief Copies string from string pool, safe to call from any thread
+ *
+ * @param [in] offset - String offset, nameOffset of copied event
+ * @param [out] buffer - Copied string, always terminated
+ * @param [in] size - Size of buffer
+ */
+void epgCacheCopyString(uint32_t offset, char* buffer, uint32_t size);
+
+/**
+ * @brief Writes changed parts of cache to storage
+ */
+void epgCacheSync(void);
+
+/**
+ * @brief Prints cache statistics
+ */
+void printEpgCacheStats(void);
+
+#endif /* __EPG_CACHE_H__ */
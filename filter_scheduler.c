@@ -0,0 +1,303 @@
+#include "filter_scheduler.h"
+
+/**
+ * @brief Structure that defines one filter request
+ */
+typedef struct _FilterRequest
+{
+	uint8_t used;
+	uint8_t hasSlot;
+	uint16_t pid;
+	uint8_t tableId;
+	FilterPriority priority;
+	uint32_t filterHandle;
+	uint64_t waitStartMs;                       /* Time when request started waiting for a slot */
+	uint64_t grantTimeMs;                       /* Time when request got its slot */
+}FilterRequest;
+
+static DemuxFilterOps ops;
+static uint8_t slotCount = 0;
+static uint8_t usedSlots = 0;
+static uint32_t quantum = FILTER_SCHEDULER_QUANTUM_MS;
+static FilterRequest requests[FILTER_SCHEDULER_MAX_REQUESTS];
+
+static FilterWaitStats priorityStats[FILTER_PRIORITY_COUNT];
+static FilterWaitStats tableStats[256];
+
+/**
+ * @brief - Takes slot away from request and puts it back to waiting.
+ */
+static void releaseSlot(FilterRequest* request, uint64_t nowMs);
+
+/**
+ * @brief - Grants slots to waiting requests by priority, preempting lower priorities if needed.
+ */
+static void schedule(void);
+
+FilterSchedulerError filterSchedulerInit(const DemuxFilterOps* demuxFilterOps, uint8_t slots, uint32_t quantumMs)
+{
+	if (demuxFilterOps == NULL || demuxFilterOps->setFilter == NULL || demuxFilterOps->freeFilter == NULL ||
+	    demuxFilterOps->getTimeMs == NULL || slots == 0 || slots > FILTER_SCHEDULER_MAX_SLOTS)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return FS_ERROR;
+	}
+
+	ops = *demuxFilterOps;
+	slotCount = slots;
+	usedSlots = 0;
+	quantum = quantumMs;
+	memset(requests, 0x0, sizeof(requests));
+	memset(priorityStats, 0x0, sizeof(priorityStats));
+	memset(tableStats, 0x0, sizeof(tableStats));
+
+	return FS_NO_ERROR;
+}
+
+void filterSchedulerDeinit(void)
+{
+	int32_t i;
+
+	for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+	{
+		if (requests[i].used && requests[i].hasSlot)
+		{
+			ops.freeFilter(requests[i].filterHandle);
+		}
+	}
+	memset(requests, 0x0, sizeof(requests));
+	usedSlots = 0;
+}
+
+FilterSchedulerError filterSchedulerAdd(uint16_t pid, uint8_t tableId, FilterPriority priority, int32_t* requestId)
+{
+	int32_t i;
+
+	if (requestId == NULL || priority >= FILTER_PRIORITY_COUNT || slotCount == 0)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return FS_ERROR;
+	}
+
+	for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+	{
+		if (!requests[i].used)
+		{
+			break;
+		}
+	}
+	if (i == FILTER_SCHEDULER_MAX_REQUESTS)
+	{
+		printf("\n%s : ERROR there is no space for filter request\n", __FUNCTION__);
+		return FS_NO_SPACE;
+	}
+
+	memset(&requests[i], 0x0, sizeof(FilterRequest));
+	requests[i].used = 1;
+	requests[i].pid = pid;
+	requests[i].tableId = tableId;
+	requests[i].priority = priority;
+	requests[i].waitStartMs = ops.getTimeMs();
+	*requestId = i;
+
+	schedule();
+
+	return FS_NO_ERROR;
+}
+
+FilterSchedulerError filterSchedulerRemove(int32_t requestId)
+{
+	if (requestId < 0 || requestId >= FILTER_SCHEDULER_MAX_REQUESTS || !requests[requestId].used)
+	{
+		return FS_ERROR;
+	}
+
+	if (requests[requestId].hasSlot)
+	{
+		ops.freeFilter(requests[requestId].filterHandle);
+		usedSlots--;
+	}
+	requests[requestId].used = 0;
+	requests[requestId].hasSlot = 0;
+
+	schedule();
+
+	return FS_NO_ERROR;
+}
+
+void filterSchedulerTick(void)
+{
+	int32_t i;
+	int32_t waiting = 0;
+	uint64_t nowMs = ops.getTimeMs();
+
+	for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+	{
+		if (requests[i].used && !requests[i].hasSlot)
+		{
+			waiting++;
+		}
+	}
+
+	/* rotate background requests whose quantum expired, at most one per waiting request */
+	for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS && waiting > 0; i++)
+	{
+		if (!requests[i].used || !requests[i].hasSlot || requests[i].priority != FILTER_PRIORITY_BACKGROUND ||
+		    nowMs - requests[i].grantTimeMs < quantum)
+		{
+			continue;
+		}
+
+		releaseSlot(&requests[i], nowMs);
+		waiting--;
+	}
+
+	schedule();
+}
+
+uint8_t filterSchedulerIsActive(int32_t requestId)
+{
+	if (requestId < 0 || requestId >= FILTER_SCHEDULER_MAX_REQUESTS || !requests[requestId].used)
+	{
+		return 0;
+	}
+
+	return requests[requestId].hasSlot;
+}
+
+void filterSchedulerGetStats(uint8_t tableId, FilterWaitStats* filterWaitStats)
+{
+	if (filterWaitStats != NULL)
+	{
+		*filterWaitStats = tableStats[tableId];
+	}
+}
+
+void releaseSlot(FilterRequest* request, uint64_t nowMs)
+{
+	ops.freeFilter(request->filterHandle);
+	usedSlots--;
+	request->hasSlot = 0;
+	request->waitStartMs = nowMs;
+
+	priorityStats[request->priority].preemptCount++;
+	tableStats[request->tableId].preemptCount++;
+}
+
+void schedule(void)
+{
+	int32_t i;
+	int32_t best;
+	int32_t victim;
+	uint64_t nowMs;
+	uint64_t waitMs;
+	FilterWaitStats* stats[2];
+	uint8_t k;
+
+	while (1)
+	{
+		/* find waiting request with highest priority, oldest first */
+		best = -1;
+		for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+		{
+			if (!requests[i].used || requests[i].hasSlot)
+			{
+				continue;
+			}
+			if (best == -1 || requests[i].priority < requests[best].priority ||
+			    (requests[i].priority == requests[best].priority && requests[i].waitStartMs < requests[best].waitStartMs))
+			{
+				best = i;
+			}
+		}
+		if (best == -1)
+		{
+			return;
+		}
+
+		nowMs = ops.getTimeMs();
+		victim = -1;
+
+		if (usedSlots >= slotCount)
+		{
+			/* take the slot from the lowest priority, most recently granted request */
+			for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+			{
+				if (!requests[i].used || !requests[i].hasSlot || requests[i].priority <= requests[best].priority)
+				{
+					continue;
+				}
+				if (victim == -1 || requests[i].priority > requests[victim].priority ||
+				    (requests[i].priority == requests[victim].priority && requests[i].grantTimeMs > requests[victim].grantTimeMs))
+				{
+					victim = i;
+				}
+			}
+			if (victim == -1)
+			{
+				return;
+			}
+			releaseSlot(&requests[victim], nowMs);
+		}
+
+		if (ops.setFilter(requests[best].pid, requests[best].tableId, &requests[best].filterHandle))
+		{
+			printf("\n%s : ERROR setting filter for pid %d table id %d\n", __FUNCTION__, requests[best].pid, requests[best].tableId);
+
+			/* preempted request gets its slot back, its quantum goes on from the original grant */
+			if (victim != -1 && !ops.setFilter(requests[victim].pid, requests[victim].tableId, &requests[victim].filterHandle))
+			{
+				usedSlots++;
+				requests[victim].hasSlot = 1;
+				priorityStats[requests[victim].priority].preemptCount--;
+				tableStats[requests[victim].tableId].preemptCount--;
+			}
+			return;
+		}
+
+		usedSlots++;
+		requests[best].hasSlot = 1;
+		requests[best].grantTimeMs = nowMs;
+
+		waitMs = nowMs - requests[best].waitStartMs;
+		stats[0] = &priorityStats[requests[best].priority];
+		stats[1] = &tableStats[requests[best].tableId];
+		for (k = 0; k < 2; k++)
+		{
+			stats[k]->grantCount++;
+			stats[k]->totalWaitMs += waitMs;
+			if (waitMs > stats[k]->maxWaitMs)
+			{
+				stats[k]->maxWaitMs = waitMs;
+			}
+		}
+	}
+}
+
+void printFilterSchedulerStats(void)
+{
+	const char* priorityNames[FILTER_PRIORITY_COUNT] = {"LIVE", "P/F", "BACKGROUND"};
+	uint32_t i;
+
+	printf("\n********************FILTER SLOTS********************\n");
+	printf("slots                    |      %d\n", slotCount);
+	for (i = 0; i < FILTER_PRIORITY_COUNT; i++)
+	{
+		printf("%-10s | grants: %u | preempted: %u | avg wait: %llu ms | max wait: %llu ms\n", priorityNames[i],
+		       priorityStats[i].grantCount, priorityStats[i].preemptCount,
+		       priorityStats[i].grantCount ? (unsigned long long)(priorityStats[i].totalWaitMs / priorityStats[i].grantCount) : 0ULL,
+		       (unsigned long long)priorityStats[i].maxWaitMs);
+	}
+	for (i = 0; i < 256; i++)
+	{
+		if (tableStats[i].grantCount == 0)
+		{
+			continue;
+		}
+		printf("table 0x%02X | grants: %u | preempted: %u | avg wait: %llu ms | max wait: %llu ms\n", i,
+		       tableStats[i].grantCount, tableStats[i].preemptCount,
+		       (unsigned long long)(tableStats[i].totalWaitMs / tableStats[i].grantCount),
+		       (unsigned long long)tableStats[i].maxWaitMs);
+	}
+	printf("\n********************FILTER SLOTS********************\n");
+}
@@ -0,0 +1,114 @@
+#ifndef __FILTER_SCHEDULER_H__
+#define __FILTER_SCHEDULER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FILTER_SCHEDULER_MAX_SLOTS      16      /* Max number of demux section filters that can be managed */
+#define FILTER_SCHEDULER_MAX_REQUESTS   64      /* Max number of filter requests (active and waiting) */
+#define FILTER_SCHEDULER_QUANTUM_MS     500     /* Default time a background request may hold a slot */
+
+/**
+ * @brief Enumeration of filter scheduler error codes
+ */
+typedef enum _FilterSchedulerError
+{
+	FS_NO_ERROR = 0,
+	FS_ERROR,
+	FS_NO_SPACE
+}FilterSchedulerError;
+
+/**
+ * @brief Filter request priorities, lower value wins a slot first
+ */
+typedef enum _FilterPriority
+{
+	FILTER_PRIORITY_LIVE = 0,                   /* PAT monitor and PMT of the watched service */
+	FILTER_PRIORITY_PRESENT_FOLLOWING,          /* EIT present/following */
+	FILTER_PRIORITY_BACKGROUND,                 /* Background acquisition, rotated on quantum */
+	FILTER_PRIORITY_COUNT
+}FilterPriority;
+
+/**
+ * @brief Demux operations used by scheduler, real demux or local stand-in
+ */
+typedef struct _DemuxFilterOps
+{
+	int32_t (*setFilter)(uint16_t pid, uint8_t tableId, uint32_t* filterHandle);   /* Returns 0 on success */
+	int32_t (*freeFilter)(uint32_t filterHandle);                                  /* Returns 0 on success */
+	uint64_t (*getTimeMs)(void);                                                   /* Monotonic time in ms */
+}DemuxFilterOps;
+
+/**
+ * @brief Structure that defines slot wait statistics
+ */
+typedef struct _FilterWaitStats
+{
+	uint32_t grantCount;                        /* Number of times a slot was granted */
+	uint32_t preemptCount;                      /* Number of times a slot was taken away */
+	uint64_t totalWaitMs;                       /* Sum of times spent waiting for a slot */
+	uint64_t maxWaitMs;                         /* Longest time spent waiting for a slot */
+}FilterWaitStats;
+
+/**
+ * @brief Initializes filter scheduler
+ *
+ * @param [in] demuxFilterOps - Demux operations
+ * @param [in] slotCount - Number of available demux section filters
+ * @param [in] quantumMs - Time a background request holds a slot before rotation
+ * @return filter scheduler error code
+ */
+FilterSchedulerError filterSchedulerInit(const DemuxFilterOps* demuxFilterOps, uint8_t slotCount, uint32_t quantumMs);
+
+/**
+ * @brief Frees all set filters and removes all requests
+ */
+void filterSchedulerDeinit(void);
+
+/**
+ * @brief Adds filter request, slot is granted immediately if available
+ *
+ * @param [in]  pid - Pid of the table
+ * @param [in]  tableId - Table id
+ * @param [in]  priority - Request priority
+ * @param [out] requestId - Request identifier
+ * @return filter scheduler error code
+ */
+FilterSchedulerError filterSchedulerAdd(uint16_t pid, uint8_t tableId, FilterPriority priority, int32_t* requestId);
+
+/**
+ * @brief Removes filter request and frees its slot
+ *
+ * @param [in] requestId - Request identifier
+ * @return filter scheduler error code
+ */
+FilterSchedulerError filterSchedulerRemove(int32_t requestId);
+
+/**
+ * @brief Rotates background requests whose quantum expired and grants free slots
+ */
+void filterSchedulerTick(void);
+
+/**
+ * @brief Checks if request currently holds a slot
+ *
+ * @param [in] requestId - Request identifier
+ * @return 1 if request holds a slot, 0 otherwise
+ */
+uint8_t filterSchedulerIsActive(int32_t requestId);
+
+/**
+ * @brief Returns slot wait statistics for table id
+ *
+ * @param [in]  tableId - Table id
+ * @param [out] filterWaitStats - Wait statistics
+ */
+void filterSchedulerGetStats(uint8_t tableId, FilterWaitStats* filterWaitStats);
+
+/**
+ * @brief Prints slot wait statistics per priority and per table id
+ */
+void printFilterSchedulerStats(void);
+
+#endif /* __FILTER_SCHEDULER_H__ */
@@ -0,0 +1,98 @@
+#include "heap_stats.h"
+
+static HeapStats heapStats;
+
+/**
+ * @brief - Allocator functions of libc, called by wrappers.
+ */
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+/**
+ * @brief - Counting wrappers, linker redirects calls of application code to them.
+ */
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* pointer, size_t size);
+void __wrap_free(void* pointer);
+
+void heapStatsGet(HeapStats* stats)
+{
+	stats->allocations = __atomic_load_n(&heapStats.allocations, __ATOMIC_RELAXED);
+	stats->frees = __atomic_load_n(&heapStats.frees, __ATOMIC_RELAXED);
+	stats->reallocations = __atomic_load_n(&heapStats.reallocations, __ATOMIC_RELAXED);
+	stats->allocatedBytes = __atomic_load_n(&heapStats.allocatedBytes, __ATOMIC_RELAXED);
+}
+
+uint64_t heapStatsAllocationsSince(const HeapStats* mark)
+{
+	HeapStats stats;
+
+	heapStatsGet(&stats);
+
+	return stats.allocations + stats.reallocations - mark->allocations - mark->reallocations;
+}
+
+void printHeapStats(const char* name, const HeapStats* mark)
+{
+	HeapStats stats;
+	char label[64];
+
+	heapStatsGet(&stats);
+
+	printf("\n********************HEAP********************\n");
+	printf("allocations              |      %llu\n", (unsigned long long)stats.allocations);
+	printf("reallocations            |      %llu\n", (unsigned long long)stats.reallocations);
+	printf("frees                    |      %llu\n", (unsigned long long)stats.frees);
+	printf("allocated bytes          |      %llu\n", (unsigned long long)stats.allocatedBytes);
+	if (mark != NULL)
+	{
+		snprintf(label, sizeof(label), "allocations in %s", name);
+		printf("%-25s|      %llu\n", label, (unsigned long long)heapStatsAllocationsSince(mark));
+	}
+	printf("blocks not freed         |      %lld\n", (long long)(stats.allocations - stats.frees));
+	printf("\n********************HEAP********************\n");
+}
+
+void* __wrap_malloc(size_t size)
+{
+	__atomic_fetch_add(&heapStats.allocations, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&heapStats.allocatedBytes, size, __ATOMIC_RELAXED);
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+	__atomic_fetch_add(&heapStats.allocations, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&heapStats.allocatedBytes, count * size, __ATOMIC_RELAXED);
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size)
+{
+	if (pointer == NULL)
+	{
+		__atomic_fetch_add(&heapStats.allocations, 1, __ATOMIC_RELAXED);
+	}
+	else if (size == 0)
+	{
+		__atomic_fetch_add(&heapStats.frees, 1, __ATOMIC_RELAXED);
+	}
+	else
+	{
+		__atomic_fetch_add(&heapStats.reallocations, 1, __ATOMIC_RELAXED);
+	}
+	__atomic_fetch_add(&heapStats.allocatedBytes, size, __ATOMIC_RELAXED);
+	return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void* pointer)
+{
+	if (pointer != NULL)
+	{
+		__atomic_fetch_add(&heapStats.frees, 1, __ATOMIC_RELAXED);
+	}
+	__real_free(pointer);
+}
@@ -0,0 +1,47 @@
+#ifndef __HEAP_STATS_H__
+#define __HEAP_STATS_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Structure that defines heap allocation counters
+ *
+ * Counted are malloc, calloc, realloc and free calls of application code, linked with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free. Allocations done inside
+ * libraries (libc, tdp, DirectFB) are not counted.
+ */
+typedef struct _HeapStats
+{
+	uint64_t allocations;                       /* malloc, calloc and realloc of NULL */
+	uint64_t frees;                             /* free of non NULL pointer and realloc to size 0 */
+	uint64_t reallocations;                     /* realloc of existing block */
+	uint64_t allocatedBytes;                    /* Requested bytes of all allocations */
+}HeapStats;
+
+/**
+ * @brief Returns current counters
+ *
+ * @param [out] stats - Heap allocation counters
+ */
+void heapStatsGet(HeapStats* stats);
+
+/**
+ * @brief Returns number of allocations and reallocations done after mark
+ *
+ * @param [in] mark - Counters taken with heapStatsGet()
+ * @return number of allocations
+ */
+uint64_t heapStatsAllocationsSince(const HeapStats* mark);
+
+/**
+ * @brief Prints counters, allocations done after mark and blocks never freed
+ *
+ * @param [in] name - Name of mark, e.g. "steady state"
+ * @param [in] mark - Counters taken with heapStatsGet(), NULL for none
+ */
+void printHeapStats(const char* name, const HeapStats* mark);
+
+#endif /* __HEAP_STATS_H__ */
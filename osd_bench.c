@@ -0,0 +1,705 @@
+#include "osd_graphics.h"
+#include "string_pool.h"
+#include "osd_pixel.h"
+#include "timer_service.h"
+#include "epg_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+
+#define OSD_BENCH_DEFAULT_FRAMES    1000
+#define OSD_BENCH_DUMP_FRAMES       8           /* First frames written to PNG files when dump directory is given */
+#define OSD_BENCH_FILE_NAME_LENGTH  256
+#define OSD_BENCH_STRESS_SECONDS    5
+#define OSD_BENCH_STRESS_WRITERS    3           /* Remote control, stream controller and timer threads of TV_App */
+#define OSD_BENCH_STRESS_READERS    2
+#define OSD_BENCH_TIMERS_SECONDS    5           /* Long enough for OSD hide timers to fire */
+#define OSD_BENCH_TIMER_COUNT       5
+#define OSD_BENCH_POSIX_PERIOD_MS   20
+#define OSD_BENCH_EPG_PATH          "/tmp/osd_bench_epg.db"
+#define OSD_BENCH_EPG_SERVICES      500
+#define OSD_BENCH_EPG_DAYS          7
+#define OSD_BENCH_EPG_STEPS         480
+#define OSD_BENCH_EPG_JUMP          100         /* Services skipped at once, farther than grid shows */
+
+/**
+ * @brief - Shared state of torn frame stress test.
+ */
+typedef struct _BenchStress
+{
+	const StringHandle* eventNames;
+	uint32_t stop;
+	uint64_t writes;
+	uint64_t snapshots;
+	uint64_t tornSnapshots;
+}BenchStress;
+
+/**
+ * @brief - Expiry statistics of one periodic timer, lateness is counted from start time plus whole periods.
+ */
+typedef struct _BenchTimer
+{
+	uint32_t periodMs;
+	uint64_t startUs;
+	uint64_t expiries;
+	uint64_t latenessSumUs;
+	uint64_t latenessMaxUs;
+	int32_t lastThread;
+	uint32_t threads;                           /* Distinct threads that ran callback */
+}BenchTimer;
+
+/**
+ * @brief - Frame times of one kind of EPG grid move.
+ */
+typedef struct _BenchMove
+{
+	uint32_t count;
+	uint64_t sumUs;
+	uint64_t maxUs;
+}BenchMove;
+
+/**
+ * @brief - Renders frames one by one and optionally dumps the first ones.
+ *
+ * @return - 0 on success
+ */
+static int32_t benchFrames(uint32_t frames, const char* dumpDirectory, const StringHandle* eventNames);
+
+/**
+ * @brief - Writers change OSD info as fast as they can while readers check every snapshot for mixed writes.
+ *
+ * @return - 0 if no torn snapshot was seen
+ */
+static int32_t benchStress(uint32_t seconds, const StringHandle* eventNames);
+
+/**
+ * @brief - Runs periodic timers on timer service next to one SIGEV_THREAD POSIX timer and compares threads and lateness.
+ *
+ * @return - 0 on success
+ */
+static int32_t benchTimers(uint32_t seconds);
+
+/**
+ * @brief - Periodic timer callback, shared by timer service and POSIX timer.
+ */
+static void benchTimerExpired(BenchTimer* timer);
+
+/**
+ * @brief - Timer service callback.
+ */
+static void benchWheelTimer(void* arg);
+
+/**
+ * @brief - POSIX SIGEV_THREAD timer callback.
+ */
+static void benchPosixTimer(union sigval value);
+
+/**
+ * @brief - Fills EPG cache with a week of events of hundreds of services and moves EPG grid around it.
+ *
+ * @return - 0 if scrolled grid looks the same as grid drawn at once
+ */
+static int32_t benchEpg(uint32_t steps, const char* dumpDirectory);
+
+/**
+ * @brief - Publishes EPG grid position, waits until it is on screen and adds frame time to move.
+ */
+static void benchEpgMove(BenchMove* move, uint16_t firstService, uint32_t startTime);
+
+/**
+ * @brief - Compares two files.
+ *
+ * @return - 1 if both files exist and are equal
+ */
+static uint8_t benchFilesEqual(const char* first, const char* second);
+
+/**
+ * @brief - Stress writer, every write is one channel whose fields all derive from channel number.
+ */
+static void* benchStressWriter(void* params);
+
+/**
+ * @brief - Stress reader, checks that fields of snapshot belong to one write.
+ */
+static void* benchStressReader(void* params);
+
+/**
+ * @brief - Changes OSD info the way remote control keys do, state depends only on frame number.
+ */
+static void benchChangeInfo(OsdGraphicsInfo* osd, uint32_t frame, const StringHandle* eventNames);
+
+/**
+ * @brief - Returns monotonic time in microseconds.
+ */
+static uint64_t benchTimeUs(void);
+
+/*
+ * Headless OSD benchmark, built with software backend (make osd_bench).
+ *
+ * Usage: osd_bench [frames] [dump_directory]
+ *        osd_bench stress [seconds]
+ *        osd_bench timers [seconds]
+ *        osd_bench epg [steps] [dump_directory]
+ */
+int main(int argc, char *argv[])
+{
+	StringHandle eventNames[3];
+	uint8_t stress = 0;
+	uint8_t timers = 0;
+	uint8_t epg = 0;
+	uint32_t count = OSD_BENCH_DEFAULT_FRAMES;
+	int32_t result;
+
+	if (argc > 1 && strcmp(argv[1], "stress") == 0)
+	{
+		stress = 1;
+		count = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : OSD_BENCH_STRESS_SECONDS;
+	}
+	else if (argc > 1 && strcmp(argv[1], "timers") == 0)
+	{
+		timers = 1;
+		count = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : OSD_BENCH_TIMERS_SECONDS;
+	}
+	else if (argc > 1 && strcmp(argv[1], "epg") == 0)
+	{
+		epg = 1;
+		count = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : OSD_BENCH_EPG_STEPS;
+	}
+	else if (argc > 1)
+	{
+		count = (uint32_t)strtoul(argv[1], NULL, 10);
+	}
+
+	if (!stress && !timers && !epg)
+	{
+		/* raw fill and blend throughput first, then whole OSD frames */
+		printOsdPixelBenchmark();
+	}
+
+	if (stringPoolInit() != STRING_POOL_NO_ERROR)
+	{
+		printf("\n%s : ERROR stringPoolInit() failed\n", __FUNCTION__);
+		return -1;
+	}
+	/* first byte of DVB event names selects character table, OSD skips it */
+	eventNames[0] = stringPoolIntern("\x15News", strlen("\x15News"));
+	eventNames[1] = stringPoolIntern("\x15Movie of the week", strlen("\x15Movie of the week"));
+	eventNames[2] = STRING_HANDLE_EMPTY;
+
+	/* OSD hide timers run on timer service, as in TV_App */
+	if (timerServiceInit() != TIMER_SERVICE_NO_ERROR)
+	{
+		printf("\n%s : ERROR timerServiceInit() failed\n", __FUNCTION__);
+		stringPoolDeinit();
+		return -1;
+	}
+
+	if (OsdInit() != OSD_NO_ERROR)
+	{
+		printf("\n%s : ERROR OsdInit() failed\n", __FUNCTION__);
+		timerServiceDeinit();
+		stringPoolDeinit();
+		return -1;
+	}
+	OsdWaitIdle();
+
+	if (stress)
+	{
+		result = benchStress(count, eventNames);
+	}
+	else if (timers)
+	{
+		result = benchTimers(count);
+	}
+	else if (epg)
+	{
+		result = benchEpg(count, (argc > 3) ? argv[3] : "/tmp");
+	}
+	else
+	{
+		result = benchFrames(count, (argc > 2) ? argv[2] : NULL, eventNames);
+	}
+
+	OsdDeinit();
+	timerServiceDeinit();
+	printTimerServiceStats();
+	stringPoolDeinit();
+
+	return result;
+}
+
+int32_t benchFrames(uint32_t frames, const char* dumpDirectory, const StringHandle* eventNames)
+{
+	OsdGraphicsInfo* osd;
+	char fileName[OSD_BENCH_FILE_NAME_LENGTH];
+	uint32_t frame;
+	uint64_t startUs;
+	uint64_t totalUs;
+
+	osd = OsdInfoWriteBegin();
+	osd->eventGenre = stringPoolIntern("Drama", strlen("Drama"));
+	OsdInfoWriteEnd();
+	OsdWaitIdle();
+
+	startUs = benchTimeUs();
+	for (frame = 0; frame < frames; frame++)
+	{
+		benchChangeInfo(OsdInfoWriteBegin(), frame, eventNames);
+		OsdInfoWriteEnd();
+		OsdWaitIdle();
+
+		if (dumpDirectory != NULL && frame < OSD_BENCH_DUMP_FRAMES)
+		{
+			snprintf(fileName, sizeof(fileName), "%s/osd_%03u.png", dumpDirectory, frame);
+			if (OsdDumpFrame(fileName) != OSD_NO_ERROR)
+			{
+				printf("\n%s : ERROR cannot write %s\n", __FUNCTION__, fileName);
+			}
+		}
+	}
+	totalUs = benchTimeUs() - startUs;
+
+	printf("\n********************OSD BENCH********************\n");
+	printf("frames requested         |      %u\n", frames);
+	printf("total time               |      %llu us\n", (unsigned long long)totalUs);
+	printf("avg notify to idle       |      %llu us\n", (unsigned long long)(frames ? totalUs / frames : 0));
+	printf("\n********************OSD BENCH********************\n");
+
+	return 0;
+}
+
+int32_t benchStress(uint32_t seconds, const StringHandle* eventNames)
+{
+	pthread_t writers[OSD_BENCH_STRESS_WRITERS];
+	pthread_t readers[OSD_BENCH_STRESS_READERS];
+	BenchStress stress;
+	int32_t i;
+
+	memset(&stress, 0x0, sizeof(stress));
+	stress.eventNames = eventNames;
+
+	/* OSD thread renders during the whole test, it is one more reader */
+	for (i = 0; i < OSD_BENCH_STRESS_WRITERS; i++)
+	{
+		pthread_create(&writers[i], NULL, benchStressWriter, &stress);
+	}
+	for (i = 0; i < OSD_BENCH_STRESS_READERS; i++)
+	{
+		pthread_create(&readers[i], NULL, benchStressReader, &stress);
+	}
+
+	sleep(seconds);
+	__atomic_store_n(&stress.stop, 1, __ATOMIC_RELAXED);
+
+	for (i = 0; i < OSD_BENCH_STRESS_WRITERS; i++)
+	{
+		pthread_join(writers[i], NULL);
+	}
+	for (i = 0; i < OSD_BENCH_STRESS_READERS; i++)
+	{
+		pthread_join(readers[i], NULL);
+	}
+	OsdWaitIdle();
+
+	printf("\n********************OSD STRESS********************\n");
+	printf("duration                 |      %u s\n", seconds);
+	printf("writes                   |      %llu\n", (unsigned long long)stress.writes);
+	printf("snapshots checked        |      %llu\n", (unsigned long long)stress.snapshots);
+	printf("torn snapshots           |      %llu\n", (unsigned long long)stress.tornSnapshots);
+	printf("\n********************OSD STRESS********************\n");
+
+	return (stress.tornSnapshots == 0) ? 0 : 1;
+}
+
+int32_t benchTimers(uint32_t seconds)
+{
+	static const uint32_t periodsMs[OSD_BENCH_TIMER_COUNT] = {10, 20, 50, 100, 1000};
+	BenchTimer wheelTimers[OSD_BENCH_TIMER_COUNT];
+	BenchTimer posixTimer;
+	TimerId timerIds[OSD_BENCH_TIMER_COUNT];
+	OsdGraphicsInfo* osd;
+	struct sigevent signalEvent;
+	struct itimerspec timerSpec;
+	timer_t posixTimerId;
+	uint64_t sumUs = 0;
+	uint64_t maxUs = 0;
+	uint64_t expiries = 0;
+	uint32_t threads = 0;
+	int32_t i;
+
+	memset(wheelTimers, 0x0, sizeof(wheelTimers));
+	memset(&posixTimer, 0x0, sizeof(posixTimer));
+
+	/* banner and volume logo start OSD hide timers */
+	osd = OsdInfoWriteBegin();
+	osd->channelNumber = 1;
+	osd->draw = 1;
+	osd->drawVolume = 1;
+	OsdInfoWriteEnd();
+
+	for (i = 0; i < OSD_BENCH_TIMER_COUNT; i++)
+	{
+		wheelTimers[i].periodMs = periodsMs[i];
+		timerIds[i] = timerCreate(benchWheelTimer, &wheelTimers[i]);
+		wheelTimers[i].startUs = benchTimeUs();
+		timerStart(timerIds[i], periodsMs[i], periodsMs[i]);
+	}
+
+	/* the way hide timers were made before timer service */
+	memset(&signalEvent, 0x0, sizeof(signalEvent));
+	signalEvent.sigev_notify = SIGEV_THREAD;
+	signalEvent.sigev_notify_function = benchPosixTimer;
+	signalEvent.sigev_value.sival_ptr = &posixTimer;
+	timer_create(CLOCK_MONOTONIC, &signalEvent, &posixTimerId);
+	memset(&timerSpec, 0x0, sizeof(timerSpec));
+	timerSpec.it_value.tv_nsec = OSD_BENCH_POSIX_PERIOD_MS * 1000000L;
+	timerSpec.it_interval.tv_nsec = OSD_BENCH_POSIX_PERIOD_MS * 1000000L;
+	posixTimer.periodMs = OSD_BENCH_POSIX_PERIOD_MS;
+	posixTimer.startUs = benchTimeUs();
+	timer_settime(posixTimerId, 0, &timerSpec, NULL);
+
+	sleep(seconds);
+
+	timer_delete(posixTimerId);
+	for (i = 0; i < OSD_BENCH_TIMER_COUNT; i++)
+	{
+		timerDelete(timerIds[i]);
+		expiries += wheelTimers[i].expiries;
+		sumUs += wheelTimers[i].latenessSumUs;
+		threads = (wheelTimers[i].threads > threads) ? wheelTimers[i].threads : threads;
+		if (wheelTimers[i].latenessMaxUs > maxUs)
+		{
+			maxUs = wheelTimers[i].latenessMaxUs;
+		}
+	}
+	OsdWaitIdle();
+
+	printf("\n********************TIMER BENCH********************\n");
+	printf("duration                 |      %u s\n", seconds);
+	printf("wheel timers             |      %d\n", OSD_BENCH_TIMER_COUNT);
+	printf("wheel expiries           |      %llu\n", (unsigned long long)expiries);
+	printf("wheel callback threads   |      %u\n", threads);
+	printf("wheel avg lateness       |      %llu us\n", (unsigned long long)(expiries ? sumUs / expiries : 0));
+	printf("wheel max lateness       |      %llu us\n", (unsigned long long)maxUs);
+	printf("posix expiries           |      %llu\n", (unsigned long long)posixTimer.expiries);
+	printf("posix callback threads   |      %u\n", posixTimer.threads);
+	printf("posix avg lateness       |      %llu us\n", (unsigned long long)(posixTimer.expiries ? posixTimer.latenessSumUs / posixTimer.expiries : 0));
+	printf("posix max lateness       |      %llu us\n", (unsigned long long)posixTimer.latenessMaxUs);
+	printf("OSD hidden               |      %s\n", (!OsdInfoWriteBegin()->draw) ? "yes" : "no");
+	OsdInfoWriteEnd();
+	printf("\n********************TIMER BENCH********************\n");
+
+	return 0;
+}
+
+int32_t benchEpg(uint32_t steps, const char* dumpDirectory)
+{
+	static const char* titles[] =
+	{
+		"\x15News", "Weather", "Movie of the week", "Football", "Cooking show", "Documentary",
+		"Late night talk", "Cartoons", "Quiz", "Series", "Concert", "Tennis", "Travel", "Kids club"
+	};
+	BenchMove rowMoves;
+	BenchMove timeMoves;
+	BenchMove jumpMoves;
+	BenchMove openMove;
+	char scrolledFile[OSD_BENCH_FILE_NAME_LENGTH];
+	char drawnFile[OSD_BENCH_FILE_NAME_LENGTH];
+	uint64_t startUs;
+	uint64_t fillUs;
+	uint32_t baseTime;
+	uint32_t startTime;
+	uint32_t eventTime;
+	uint32_t duration;
+	uint32_t events = 0;
+	uint16_t firstService = 0;
+	uint16_t service;
+	uint16_t eventId;
+	uint32_t step;
+	uint8_t equal;
+
+	memset(&rowMoves, 0x0, sizeof(rowMoves));
+	memset(&timeMoves, 0x0, sizeof(timeMoves));
+	memset(&jumpMoves, 0x0, sizeof(jumpMoves));
+	memset(&openMove, 0x0, sizeof(openMove));
+
+	unlink(OSD_BENCH_EPG_PATH);
+	if (epgCacheOpen(OSD_BENCH_EPG_PATH) != EPG_CACHE_NO_ERROR)
+	{
+		printf("\n%s : ERROR epgCacheOpen() failed\n", __FUNCTION__);
+		return -1;
+	}
+
+	/* half hour and hour long events, each service starts a few minutes off so names are cut at left edge */
+	baseTime = (uint32_t)time(NULL);
+	baseTime -= baseTime % 1800;
+	startUs = benchTimeUs();
+	for (service = 0; service < OSD_BENCH_EPG_SERVICES; service++)
+	{
+		eventTime = baseTime - (service % 4) * 300;
+		for (eventId = 0; eventTime < baseTime + OSD_BENCH_EPG_DAYS * 24 * 3600; eventId++)
+		{
+			duration = ((service * 7 + eventId) % 3 == 0) ? 3600 : 1800;
+			if (epgCacheAddEvent(service + 1, eventId, eventTime, duration, 0,
+			                     titles[(service * 13 + eventId) % (sizeof(titles) / sizeof(titles[0]))]) == EPG_CACHE_NO_ERROR)
+			{
+				events++;
+			}
+			eventTime += duration;
+		}
+	}
+	fillUs = benchTimeUs() - startUs;
+
+	benchEpgMove(&openMove, firstService, baseTime);
+
+	/* rows down and up, time right and back, now and then a jump farther than the grid shows */
+	startTime = baseTime;
+	for (step = 0; step < steps; step++)
+	{
+		if (step % 48 == 47)
+		{
+			firstService = (firstService + OSD_BENCH_EPG_JUMP) % (OSD_BENCH_EPG_SERVICES - OSD_BENCH_EPG_JUMP);
+			benchEpgMove(&jumpMoves, firstService, startTime);
+		}
+		else if (step % 24 < 10)
+		{
+			benchEpgMove(&rowMoves, ++firstService, startTime);
+		}
+		else if (step % 24 < 14)
+		{
+			startTime += 1800;
+			benchEpgMove(&timeMoves, firstService, startTime);
+		}
+		else if (step % 24 < 20)
+		{
+			benchEpgMove(&rowMoves, --firstService, startTime);
+		}
+		else
+		{
+			startTime -= 1800;
+			benchEpgMove(&timeMoves, firstService, startTime);
+		}
+	}
+
+	/* grid built by scrolling has to look like grid drawn at once at the same place */
+	snprintf(scrolledFile, sizeof(scrolledFile), "%s/epg_scrolled.png", dumpDirectory);
+	snprintf(drawnFile, sizeof(drawnFile), "%s/epg_drawn.png", dumpDirectory);
+	OsdDumpFrame(scrolledFile);
+	OsdInfoWriteBegin()->drawEpg = 0;
+	OsdInfoWriteEnd();
+	OsdWaitIdle();
+	benchEpgMove(&openMove, firstService, startTime);
+	OsdDumpFrame(drawnFile);
+	equal = benchFilesEqual(scrolledFile, drawnFile);
+
+	printf("\n********************EPG BENCH********************\n");
+	printf("services                 |      %u\n", OSD_BENCH_EPG_SERVICES);
+	printf("events                   |      %u\n", events);
+	printf("cache fill time          |      %llu us\n", (unsigned long long)fillUs);
+	printf("grid open avg            |      %llu us\n", (unsigned long long)(openMove.sumUs / openMove.count));
+	printf("row scrolls              |      %u\n", rowMoves.count);
+	printf("row scroll avg           |      %llu us\n", (unsigned long long)(rowMoves.count ? rowMoves.sumUs / rowMoves.count : 0));
+	printf("row scroll max           |      %llu us\n", (unsigned long long)rowMoves.maxUs);
+	printf("time scrolls             |      %u\n", timeMoves.count);
+	printf("time scroll avg          |      %llu us\n", (unsigned long long)(timeMoves.count ? timeMoves.sumUs / timeMoves.count : 0));
+	printf("time scroll max          |      %llu us\n", (unsigned long long)timeMoves.maxUs);
+	printf("jumps                    |      %u\n", jumpMoves.count);
+	printf("jump avg                 |      %llu us\n", (unsigned long long)(jumpMoves.count ? jumpMoves.sumUs / jumpMoves.count : 0));
+	printf("jump max                 |      %llu us\n", (unsigned long long)jumpMoves.maxUs);
+	printf("scrolled equals drawn    |      %s\n", equal ? "yes" : "no");
+	printf("\n********************EPG BENCH********************\n");
+
+	printEpgCacheStats();
+	epgCacheClose();
+	unlink(OSD_BENCH_EPG_PATH);
+
+	return equal ? 0 : 1;
+}
+
+void benchEpgMove(BenchMove* move, uint16_t firstService, uint32_t startTime)
+{
+	OsdGraphicsInfo* osd;
+	uint64_t startUs = benchTimeUs();
+	uint64_t frameUs;
+
+	osd = OsdInfoWriteBegin();
+	osd->drawEpg = 1;
+	osd->epgFirstService = firstService;
+	osd->epgStartTime = startTime;
+	OsdInfoWriteEnd();
+	OsdWaitIdle();
+
+	frameUs = benchTimeUs() - startUs;
+	move->count++;
+	move->sumUs += frameUs;
+	if (frameUs > move->maxUs)
+	{
+		move->maxUs = frameUs;
+	}
+}
+
+uint8_t benchFilesEqual(const char* first, const char* second)
+{
+	FILE* files[2];
+	int32_t a;
+	int32_t b;
+	uint8_t equal = 1;
+
+	files[0] = fopen(first, "rb");
+	files[1] = fopen(second, "rb");
+	if (files[0] == NULL || files[1] == NULL)
+	{
+		equal = 0;
+	}
+	while (equal)
+	{
+		a = fgetc(files[0]);
+		b = fgetc(files[1]);
+		if (a != b)
+		{
+			equal = 0;
+		}
+		if (a == EOF)
+		{
+			break;
+		}
+	}
+
+	if (files[0] != NULL)
+	{
+		fclose(files[0]);
+	}
+	if (files[1] != NULL)
+	{
+		fclose(files[1]);
+	}
+
+	return equal;
+}
+
+void benchTimerExpired(BenchTimer* timer)
+{
+	int32_t thread = (int32_t)syscall(SYS_gettid);
+	uint64_t nowUs = benchTimeUs();
+	uint64_t dueUs;
+
+	timer->expiries++;
+	dueUs = timer->startUs + timer->expiries * timer->periodMs * 1000;
+	if (nowUs > dueUs)
+	{
+		timer->latenessSumUs += nowUs - dueUs;
+		if (nowUs - dueUs > timer->latenessMaxUs)
+		{
+			timer->latenessMaxUs = nowUs - dueUs;
+		}
+	}
+
+	/* thread ids grow, a new thread always has a larger one */
+	if (thread > timer->lastThread)
+	{
+		timer->lastThread = thread;
+		timer->threads++;
+	}
+}
+
+void benchWheelTimer(void* arg)
+{
+	benchTimerExpired((BenchTimer*)arg);
+}
+
+void benchPosixTimer(union sigval value)
+{
+	benchTimerExpired((BenchTimer*)value.sival_ptr);
+}
+
+void* benchStressWriter(void* params)
+{
+	BenchStress* stress = (BenchStress*)params;
+	OsdGraphicsInfo* osd;
+	uint16_t channel;
+
+	while (!__atomic_load_n(&stress->stop, __ATOMIC_RELAXED))
+	{
+		channel = (uint16_t)__atomic_add_fetch(&stress->writes, 1, __ATOMIC_RELAXED);
+
+		osd = OsdInfoWriteBegin();
+		osd->channelNumber = channel;
+		osd->audioPid = channel * 3;
+		osd->videoPid = channel * 5;
+		osd->hasTeletext = channel & 1;
+		osd->eventName = stress->eventNames[channel & 1];
+		osd->volume = channel % 11;
+		osd->draw = 1;
+		osd->drawVolume = 1;
+		OsdInfoWriteEnd();
+	}
+
+	return NULL;
+}
+
+void* benchStressReader(void* params)
+{
+	BenchStress* stress = (BenchStress*)params;
+	OsdGraphicsInfo info;
+	uint16_t channel;
+
+	while (!__atomic_load_n(&stress->stop, __ATOMIC_RELAXED))
+	{
+		OsdInfoSnapshot(&info);
+		__atomic_add_fetch(&stress->snapshots, 1, __ATOMIC_RELAXED);
+
+		/* before first write every field is zero, which passes the check too */
+		channel = info.channelNumber;
+		if (info.audioPid != channel * 3 || info.videoPid != channel * 5 || info.hasTeletext != (channel & 1) ||
+		    info.volume != channel % 11 || (channel != 0 && info.eventName != stress->eventNames[channel & 1]))
+		{
+			__atomic_add_fetch(&stress->tornSnapshots, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+void benchChangeInfo(OsdGraphicsInfo* osd, uint32_t frame, const StringHandle* eventNames)
+{
+	/* every fourth frame a channel change brings the banner, the rest are volume key presses */
+	switch (frame % 4)
+	{
+		case 0:
+			osd->channelNumber = (uint16_t)(1 + (frame / 4) % 9);
+			osd->audioPid = 101 + osd->channelNumber;
+			osd->videoPid = 201 + osd->channelNumber;
+			osd->hasTeletext = (uint8_t)(frame / 4) % 2;
+			osd->eventName = eventNames[(frame / 4) % 3];
+			osd->drawRadio = (uint8_t)((frame / 4) % 5 == 4);
+			osd->videoPid = osd->drawRadio ? -1 : osd->videoPid;
+			osd->drawScrambled = 0;
+			osd->draw = 1;
+			break;
+		case 1:
+		case 2:
+			osd->volume = (uint8_t)((frame / 2) % 11);
+			osd->isMuted = 0;
+			osd->drawVolume = 1;
+			break;
+		default:
+			osd->isMuted = 1;
+			osd->drawVolume = 1;
+			break;
+	}
+}
+
+uint64_t benchTimeUs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -1,14 +1,19 @@
 #include "osd_graphics.h"
+#include "timer_service.h"
+#include "epg_cache.h"
+#ifdef OSD_BACKEND_SOFT
+#include "osd_soft.h"
+#endif
 
 #include <directfb.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <linux/input.h>
 #include <fcntl.h>
-#include <signal.h>
 #include <unistd.h>
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 
 #define DFBCHECK(x ...)                                      		\
@@ -22,6 +27,130 @@
 		}                                                         	\
 	}
 
+#define DFBTRY(x ...)                                               \
+	{                                                               \
+		DFBResult result = x;                                       \
+		if (result != DFB_OK)                                       \
+		{                                                           \
+			fprintf(stderr, "%s <%d>:\n\t%s\n", __FILE__, __LINE__, #x); \
+			return result;                                          \
+		}                                                           \
+	}
+
+#define OSD_FONT_PATH           "/home/galois/fonts/DejaVuSans.ttf"
+#define OSD_GLYPH_DIGITS        "0123456789-"       /* Glyphs of channel numbers and pids, minus for pid -1 */
+#define OSD_GLYPH_DIGIT_COUNT   11
+#define OSD_VOLUME_LEVELS       11                  /* volume_0.png to volume_10.png */
+#define OSD_HIDE_DELAY_MS       3000                /* Info banner and volume logo are hidden after 3 seconds */
+
+#define OSD_EPG_NAME_WIDTH      160                 /* Service column of EPG grid */
+#define OSD_EPG_HEADER_HEIGHT   40                  /* Time ruler above rows */
+#define OSD_EPG_ROW_HEIGHT      40
+#define OSD_EPG_SECOND_PIXELS   5                   /* Seconds per pixel, half an hour is 360 pixels */
+#define OSD_EPG_WINDOW_SECONDS  (2 * 3600)          /* Time shown at once on a wide enough screen */
+#define OSD_EPG_RULER_SECONDS   1800                /* Time between ruler labels */
+#define OSD_EPG_ROW_EVENTS      64                  /* Events drawn in one row at most */
+#define OSD_EPG_NAME_LENGTH     128
+#define OSD_EPG_CELL_SLOTS      160                 /* Pre-rendered event names, least recently used one is replaced */
+#define OSD_EPG_CELL_COLUMNS    5                   /* Slots side by side in cell atlas */
+#define OSD_EPG_CELL_WIDTH      352                 /* Longer names are cut */
+#define OSD_EPG_CELL_BUCKETS    256                 /* Hash buckets of cell cache, power of two */
+
+/**
+ * @brief - Font sizes used by OSD.
+ */
+typedef enum _OsdFontSize
+{
+	OSD_FONT_SMALL = 0,
+	OSD_FONT_LARGE,
+	OSD_FONT_COUNT
+}OsdFontSize;
+
+/**
+ * @brief - Fixed strings pre-rendered into glyph atlas.
+ */
+typedef enum _OsdText
+{
+	OSD_TEXT_RADIO = 0,
+	OSD_TEXT_SCRAMBLED,
+	OSD_TEXT_AUDIO_PID,
+	OSD_TEXT_VIDEO_PID,
+	OSD_TEXT_TELETEXT,
+	OSD_TEXT_NO_TELETEXT,
+	OSD_TEXT_COUNT
+}OsdText;
+
+/**
+ * @brief - OSD elements, each one is redrawn only when its content or visibility changes.
+ */
+typedef enum _OsdElement
+{
+	OSD_ELEMENT_EPG = 0,                        /* EPG grid, banners are composited over it */
+	OSD_ELEMENT_CHANNEL,                        /* Channel number box */
+	OSD_ELEMENT_INFO,                           /* Pids and teletext banner */
+	OSD_ELEMENT_EVENT,                          /* Event name and genre banner */
+	OSD_ELEMENT_VOLUME,
+	OSD_ELEMENT_RADIO,
+	OSD_ELEMENT_SCRAMBLED,
+	OSD_ELEMENT_COUNT
+}OsdElement;
+
+/**
+ * @brief - Font of one size with atlas of its digits and fixed strings.
+ */
+typedef struct _OsdFont
+{
+	int32_t height;
+	IDirectFBFont* font;                        /* Used only for strings that are not in atlas */
+	IDirectFBSurface* atlas;
+	int32_t ascender;                           /* Atlas is drawn from top, strings from baseline */
+	DFBRectangle digits[OSD_GLYPH_DIGIT_COUNT];
+}OsdFont;
+
+/**
+ * @brief - Fixed string with its color and place in atlas.
+ */
+typedef struct _OsdTextEntry
+{
+	OsdFontSize size;
+	const char* text;
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	DFBRectangle rect;
+}OsdTextEntry;
+
+/**
+ * @brief - Off-screen layer of one element, rendered when its inputs change and blitted to primary surface.
+ */
+typedef struct _OsdLayer
+{
+	const char* name;
+	uint8_t ownsSurface;                        /* Text layers are drawn, fixed images are picked from their atlas */
+	IDirectFBSurface* surface;
+	DFBRectangle source;                        /* Layer content inside surface */
+	OsdGraphicsInfo renderedInfo;               /* Inputs of current layer content */
+	uint8_t valid;
+	uint32_t renderCount;
+	uint32_t compositeCount;
+}OsdLayer;
+
+/**
+ * @brief - Event name pre-rendered into a slot of EPG cell atlas, slots are reused least recently used first.
+ */
+typedef struct _OsdEpgCell
+{
+	uint16_t serviceId;
+	uint16_t eventId;
+	uint32_t startTime;
+	uint32_t nameOffset;                        /* Renamed event gets new offset and is rendered again */
+	int32_t width;                              /* Width of rendered name */
+	int16_t newer;                              /* Least recently used list, -1 at its ends */
+	int16_t older;
+	int16_t hashNext;                           /* Next cell of same hash bucket, -1 at end */
+	uint8_t used;
+}OsdEpgCell;
+
 /* DirectFB variables */
 static IDirectFBSurface* primary = NULL;
 static IDirectFB* dfbInterface = NULL;
@@ -31,31 +160,99 @@ static DFBSurfaceDescription surfaceDesc;
 static int screenWidth;
 static int screenHeight;
 
-/* Volume logo parameters */
-static IDirectFBImageProvider* provider = NULL;
-static IDirectFBSurface* logoSurface = NULL;
-static int32_t logoWidth;
-static int32_t logoHeight;
+/* Volume logos, all levels decoded once side by side into one atlas */
+static IDirectFBSurface* volumeAtlas = NULL;
+static DFBRectangle volumeRects[OSD_VOLUME_LEVELS];
 
-/* Program timer variables */
-static struct itimerspec timerSpecProgram;
-static struct itimerspec timerSpecOldProgram;
-int32_t timerFlagsProgram;
-timer_t timerIdProgram;
-
-/* Volume timer variables */
-static struct itimerspec timerSpecVolume;
-static struct itimerspec timerSpecOldVolume;
-int32_t timerFlagsVolume;
-timer_t timerIdVolume;
+/* Hide timers, both run on timer service thread */
+static TimerId timerIdProgram = TIMER_SERVICE_INVALID_ID;
+static TimerId timerIdVolume = TIMER_SERVICE_INVALID_ID;
 
 /* OSD thread  variables */
 static pthread_t osdThread;
 static int32_t threadExit;
 
+/* OSD thread sleeps until OSD info changes or hide timer fires */
+static pthread_mutex_t osdMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t osdCond = PTHREAD_COND_INITIALIZER;
+static uint8_t osdChanged = 0;
+static uint64_t changeTimeUs = 0;                       /* First change not yet on screen */
+static pthread_cond_t osdIdleCond = PTHREAD_COND_INITIALIZER;
+static uint8_t osdIdle = 0;                             /* Thread waits for changes, every change is on screen */
+
 /* OsdGraphicsInfo structure - local instance */
 static OsdGraphicsInfo OsdInfo;
 
+/* OsdInfo is published with a sequence lock, sequence is odd while a writer changes it */
+static pthread_mutex_t osdInfoWriteMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t osdInfoSequence = 0;
+
+/* Fonts are created once, digits and fixed strings are rasterized once into atlases */
+static OsdFont fonts[OSD_FONT_COUNT] =
+{
+	{28, NULL, NULL, 0, {{0}}},
+	{48, NULL, NULL, 0, {{0}}}
+};
+static OsdTextEntry texts[OSD_TEXT_COUNT] =
+{
+	{OSD_FONT_LARGE, "RADIO", 0x00, 0xa6, 0x51, {0}},
+	{OSD_FONT_LARGE, "SCRAMBLED", 0xff, 0x00, 0x00, {0}},
+	{OSD_FONT_SMALL, "Audio PID: ", 0x00, 0x00, 0x00, {0}},
+	{OSD_FONT_SMALL, "Video PID: ", 0x00, 0x00, 0x00, {0}},
+	{OSD_FONT_SMALL, "Teletext available", 0x00, 0x00, 0x00, {0}},
+	{OSD_FONT_SMALL, "Teletext not available", 0x00, 0x00, 0x00, {0}}
+};
+
+/* Render statistics, time from frame start to flip */
+static uint32_t frameCount = 0;
+static uint64_t renderTimeSumUs = 0;
+static uint64_t renderTimeMaxUs = 0;
+static uint32_t fontCreateCount = 0;
+static uint32_t imageDecodeCount = 0;
+static uint64_t startRssKb = 0;                         /* Resident set size when OSD started */
+static uint64_t startTimeUs = 0;
+static uint32_t frameSkipCount = 0;                     /* Frames without changes, nothing drawn or flipped */
+static uint64_t pixelsTouched = 0;                      /* Pixels of redrawn regions */
+static uint32_t wakeupCount = 0;
+static uint32_t latencyCount = 0;                       /* Changes that reached the screen */
+static uint64_t latencySumUs = 0;                       /* Change of OSD info to flip */
+static uint64_t latencyMaxUs = 0;
+static uint32_t snapshotCount = 0;                      /* Consistent copies of OsdInfo taken */
+static uint32_t snapshotRetryCount = 0;                 /* Copies thrown away because a writer was inside */
+
+/* Compositor state, what the screen shows now */
+static DFBRectangle elementRects[OSD_ELEMENT_COUNT];
+static OsdLayer layers[OSD_ELEMENT_COUNT] =
+{
+	{"EPG grid layer", 0, NULL, {0}, {0}, 0, 0, 0},
+	{"channel layer", 1, NULL, {0}, {0}, 0, 0, 0},
+	{"info layer", 1, NULL, {0}, {0}, 0, 0, 0},
+	{"event layer", 1, NULL, {0}, {0}, 0, 0, 0},
+	{"volume layer", 0, NULL, {0}, {0}, 0, 0, 0},
+	{"radio layer", 0, NULL, {0}, {0}, 0, 0, 0},
+	{"scrambled layer", 0, NULL, {0}, {0}, 0, 0, 0}
+};
+static OsdGraphicsInfo drawnInfo;
+static uint8_t drawnValid = 0;                          /* Screen content is unknown before first frame */
+
+/* EPG grid, surfaces are created when grid is opened first time, grid keeps content between frames */
+static IDirectFBSurface* epgSurface = NULL;
+static IDirectFBSurface* epgCellAtlas = NULL;
+static int32_t epgRows = 0;
+static uint32_t epgWindowSeconds = 0;
+static OsdEpgCell epgCells[OSD_EPG_CELL_SLOTS];
+static int16_t epgCellBuckets[OSD_EPG_CELL_BUCKETS];
+static int16_t epgCellNewest = -1;
+static int16_t epgCellOldest = -1;
+
+/* EPG statistics */
+static uint32_t epgFullRenderCount = 0;
+static uint32_t epgScrollCount = 0;
+static uint32_t epgRowDrawCount = 0;
+static uint32_t epgCellHitCount = 0;
+static uint32_t epgCellMissCount = 0;
+static uint32_t epgCellEvictCount = 0;
+
 /**
  * @brief - OSD thread.
  *
@@ -73,7 +270,7 @@ static void timerInitProgram(void);
 /**
  * @brief - Program timer callback which removes everything related to program info from the screen.
  */
-static void clearScreenProgram(void);
+static void clearScreenProgram(void* arg);
 
 /**
  * @brief - Initialize volume timer.
@@ -83,11 +280,223 @@ static void timerInitVolume(void);
 /**
  * @brief - Volume timer callback which removes everything related to volume info from the screen.
  */
-static void clearScreenVolume(void);
+static void clearScreenVolume(void* arg);
+
+/**
+ * @brief - Creates fonts and rasterizes digits and fixed strings into one atlas per font.
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdFontsInit(void);
+
+/**
+ * @brief - Releases fonts and atlases.
+ */
+static void osdFontsDeinit(void);
+
+/**
+ * @brief - Decodes all volume logos into one atlas surface.
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdVolumeAtlasInit(void);
+
+/**
+ * @brief - Releases volume logo atlas.
+ */
+static void osdVolumeAtlasDeinit(void);
+
+/**
+ * @brief - Returns resident set size of the process.
+ *
+ * @return - Resident set size in kB, 0 if not available
+ */
+static uint64_t osdRssKb(void);
+
+/**
+ * @brief - Sets screen rectangles of OSD elements, fonts and atlases have to exist.
+ */
+static void osdElementsInit(void);
+
+/**
+ * @brief - Creates off-screen surfaces of text layers, element rectangles have to be set.
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdLayersInit(void);
+
+/**
+ * @brief - Releases off-screen surfaces of layers.
+ */
+static void osdLayersDeinit(void);
+
+/**
+ * @brief - Checks if element is shown with given OSD info.
+ *
+ * @param element - OSD element
+ * @param info - OSD info
+ *
+ * @return - 1 if element is shown
+ */
+static uint8_t osdElementVisible(OsdElement element, const OsdGraphicsInfo* info);
+
+/**
+ * @brief - Checks if content of shown element differs between two OSD infos.
+ *
+ * @param element - OSD element
+ * @param info - OSD info of new frame
+ * @param drawn - OSD info of screen content
+ *
+ * @return - 1 if content changed
+ */
+static uint8_t osdElementChanged(OsdElement element, const OsdGraphicsInfo* info, const OsdGraphicsInfo* drawn);
+
+/**
+ * @brief - Computes union of elements that changed since last drawn frame.
+ *
+ * @param info - OSD info of new frame
+ * @param region - Union of changed regions
+ *
+ * @return - 1 if anything has to be redrawn
+ */
+static uint8_t osdDirtyRegion(const OsdGraphicsInfo* info, DFBRegion* region);
+
+/**
+ * @brief - Clears region to background and composites layers that overlap it, stale layers are rendered first.
+ *
+ * @param info - OSD info of new frame
+ * @param region - Region to redraw
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdRenderRegion(const OsdGraphicsInfo* info, const DFBRegion* region);
+
+/**
+ * @brief - Renders layer of one element from OSD info, layer coordinates start at element rectangle.
+ *
+ * @param element - OSD element
+ * @param info - OSD info of new frame
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdRenderLayer(OsdElement element, const OsdGraphicsInfo* info);
+
+/**
+ * @brief - Renders EPG grid layer, a grid moved by less than it shows is scrolled and only uncovered strip is drawn.
+ *
+ * @param layer - EPG layer, renderedInfo is what the grid shows now
+ * @param info - OSD info of new frame
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdEpgRender(OsdLayer* layer, const OsdGraphicsInfo* info);
+
+/**
+ * @brief - Creates EPG grid surface and cell atlas.
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdEpgInit(void);
+
+/**
+ * @brief - Releases EPG grid surface and cell atlas.
+ */
+static void osdEpgDeinit(void);
+
+/**
+ * @brief - Draws time ruler of EPG grid.
+ *
+ * @param info - OSD info of new frame
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdEpgDrawRuler(const OsdGraphicsInfo* info);
+
+/**
+ * @brief - Draws columns x1 to x2 of one EPG grid row, cells are drawn clipped to them.
+ *
+ * @param info - OSD info of new frame
+ * @param row - Visible row
+ * @param x1 - First column
+ * @param x2 - Last column
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdEpgDrawRow(const OsdGraphicsInfo* info, int32_t row, int32_t x1, int32_t x2);
+
+/**
+ * @brief - Returns last column of event that runs at given time in row, name of such event is placed at left edge.
+ *
+ * @param info - OSD info of new frame
+ * @param row - Visible row
+ * @param utcTime - UTC time
+ *
+ * @return - Last column, less than OSD_EPG_NAME_WIDTH if no event runs at that time
+ */
+static int32_t osdEpgEdgeCell(const OsdGraphicsInfo* info, int32_t row, uint32_t utcTime);
+
+/**
+ * @brief - Returns cell atlas slot with name of event, name is rendered if it is not cached.
+ *
+ * @param serviceId - service_id of event
+ * @param event - Event
+ *
+ * @return - Slot
+ */
+static int16_t osdEpgCell(uint16_t serviceId, const EpgCacheEvent* event);
+
+/**
+ * @brief - Returns grid column of time, columns follow UTC time so scrolled content stays in place.
+ */
+static int32_t osdEpgX(uint32_t utcTime, uint32_t startTime);
+
+/**
+ * @brief - Draws fixed string from atlas.
+ *
+ * @param surface - Destination surface
+ * @param text - Fixed string
+ * @param x - Left edge
+ * @param y - Baseline
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdDrawText(IDirectFBSurface* surface, OsdText text, int32_t x, int32_t y);
+
+/**
+ * @brief - Draws number from digit atlas.
+ *
+ * @param surface - Destination surface
+ * @param size - Font size
+ * @param value - Number
+ * @param x - Left edge
+ * @param y - Baseline
+ *
+ * @return - DirectFB result
+ */
+static DFBResult osdDrawNumber(IDirectFBSurface* surface, OsdFontSize size, int32_t value, int32_t x, int32_t y);
+
+/**
+ * @brief - Returns monotonic time in microseconds.
+ */
+static uint64_t osdTimeUs(void);
+
+/**
+ * @brief - Ends change of OSD info without waking OSD thread.
+ */
+static void osdInfoWriteFinish(void);
+
+/**
+ * @brief - Prints frame count and render times.
+ */
+static void printOsdRenderStats(void);
 
 
 OsdGraphicsError OsdInit(void)
 {
+	/* first frame is drawn right away */
+	osdChanged = 1;
+	changeTimeUs = osdTimeUs();
+
 	/* Create OSD thread */
 	if (pthread_create(&osdThread, NULL, &OSDTask, NULL))
 	{
@@ -100,37 +509,22 @@ OsdGraphicsError OsdInit(void)
 
 void timerInitProgram(void)
 {
-	struct sigevent signalEvent;
-
-	/* set sigevent callback */
-	signalEvent.sigev_notify = SIGEV_THREAD;
-	signalEvent.sigev_notify_function = (void*)clearScreenProgram;
-	signalEvent.sigev_value.sival_ptr = NULL;
-	signalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &signalEvent, &timerIdProgram);
+	timerIdProgram = timerCreate(clearScreenProgram, NULL);
 }
 
 void timerInitVolume(void)
 {
-	struct sigevent signalEvent;
-
-	/* set sigevent callback */
-	signalEvent.sigev_notify = SIGEV_THREAD;
-	signalEvent.sigev_notify_function = (void*)clearScreenVolume;
-	signalEvent.sigev_value.sival_ptr = NULL;
-	signalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &signalEvent, &timerIdVolume);
+	timerIdVolume = timerCreate(clearScreenVolume, NULL);
 }
 
 void* OSDTask(void* params)
 {
-	IDirectFBFont* fontInterface = NULL;
-	DFBFontDescription fontDesc;
-	char channelString[4];
-	char audioPidString[50];
-	char videoPidString[50];
-	char teletext[] = "Teletext available";
-	char noTeletext[] = "Teletext not available";
+	OsdGraphicsInfo frameInfo;
+	DFBRegion dirtyRegion;
+	uint64_t frameStartUs;
+	uint64_t frameChangeUs;
+	uint64_t renderTimeUs;
+	uint64_t latencyUs;
 
 	//memset(&OsdInfo, 0, sizeof(OsdInfo));
 
@@ -138,11 +532,16 @@ void* OSDTask(void* params)
 	timerInitProgram();
 	timerInitVolume();
 
+#ifdef OSD_BACKEND_SOFT
+	/* Headless build draws into memory, no display is needed */
+	DFBCHECK(osdSoftCreate(&dfbInterface));
+#else
 	/* Initialize directFB */
 	DFBCHECK(DirectFBInit(NULL, NULL));
 
 	/* Fetch the directFB interface */
 	DFBCHECK(DirectFBCreate(&dfbInterface));
+#endif
 
 	/* Set full screen */
 	DFBCHECK(dfbInterface->SetCooperativeLevel(dfbInterface, DFSCL_FULLSCREEN));
@@ -155,176 +554,1238 @@ void* OSDTask(void* params)
 	/* Fetch the screen size */
 	DFBCHECK(primary->GetSize(primary, &screenWidth, &screenHeight));
 
-	while (threadExit == 0)
+	/* Fonts and glyph atlases live as long as the OSD */
+	DFBCHECK(osdFontsInit());
+
+	/* PNG decoding is done only here, frames blit from atlas */
+	DFBCHECK(osdVolumeAtlasInit());
+	startRssKb = osdRssKb();
+	startTimeUs = osdTimeUs();
+
+	/* Atlases keep alpha of rasterized glyphs */
+	DFBCHECK(primary->SetBlittingFlags(primary, DSBLIT_BLEND_ALPHACHANNEL));
+
+	/* Screen regions of OSD elements, everything else is background */
+	osdElementsInit();
+	DFBCHECK(osdLayersInit());
+
+	while (1)
 	{
-		/* Check whether the screen should be black */
-		if (OsdInfo.drawBlack == 1)
+		/* nothing is rendered while OSD info stays the same */
+		pthread_mutex_lock(&osdMutex);
+		while (!osdChanged && threadExit == 0)
 		{
-			DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0xff));
-			DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth, screenHeight));
+			osdIdle = 1;
+			pthread_cond_broadcast(&osdIdleCond);
+			pthread_cond_wait(&osdCond, &osdMutex);
 		}
-		else
+		osdIdle = 0;
+		osdChanged = 0;
+		frameChangeUs = changeTimeUs;
+		pthread_mutex_unlock(&osdMutex);
+
+		if (threadExit != 0)
 		{
-			DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0x00));
-			DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth, screenHeight));
+			break;
 		}
+		wakeupCount++;
 
+		/* writers are never blocked, a copy taken while one was inside is taken again */
+		frameStartUs = osdTimeUs();
+		OsdInfoSnapshot(&frameInfo);
 
-		if(OsdInfo.drawRadio == 1)
+		/* Info banner is hidden 3 seconds after it was shown */
+		if (frameInfo.draw == 1 && frameInfo.timerSetProgram == 0)
 		{
-			/* Specify the height of the font by raising the appropriate flag and setting the height value */
-			fontDesc.flags = DFDESC_HEIGHT;
-			fontDesc.height = 48;
+			timerStart(timerIdProgram, OSD_HIDE_DELAY_MS, 0);
 
-			/* Create the font and set the created font for primary surface text drawing */
-			DFBCHECK(dfbInterface->CreateFont(dfbInterface, "/home/galois/fonts/DejaVuSans.ttf", &fontDesc, &fontInterface));
-			DFBCHECK(primary->SetFont(primary, fontInterface));
-
-			/* Seting text color */
-			DFBCHECK(primary->SetColor(primary, 0x00, 0xa6, 0x51, 0xff));
+			OsdInfoWriteBegin()->timerSetProgram = 1;
+			osdInfoWriteFinish();
+			frameInfo.timerSetProgram = 1;
+		}
 
-			/* draw the text */
-			DFBCHECK(primary->DrawString(primary, "RADIO", -1, screenWidth / 2 - 15, screenHeight / 2, DSTF_LEFT));
+		/* Volume logo is hidden 3 seconds after last change, every volume key clears timerSetVolume */
+		if (frameInfo.drawVolume == 1 && frameInfo.timerSetVolume == 0)
+		{
+			timerStart(timerIdVolume, OSD_HIDE_DELAY_MS, 0);
 
+			OsdInfoWriteBegin()->timerSetVolume = 1;
+			osdInfoWriteFinish();
+			frameInfo.timerSetVolume = 1;
 		}
 
-		/* Drawing the info banner if set */
-		if (OsdInfo.draw == 1)
+		/* nothing changed on screen, frame is skipped */
+		if (!osdDirtyRegion(&frameInfo, &dirtyRegion))
 		{
-			usleep(300000);
+			frameSkipCount++;
+			continue;
+		}
 
-			/* set the timer to 3 seconds */
-			if (OsdInfo.timerSetProgram == 0)
-			{
-				memset(&timerSpecProgram, 0, sizeof(timerSpecProgram));
-				timerSpecProgram.it_value.tv_sec = 3;
-				timerSpecProgram.it_value.tv_nsec = 0;
-				timer_settime(timerIdProgram, timerFlagsProgram, &timerSpecProgram, &timerSpecOldProgram);
+		DFBCHECK(osdRenderRegion(&frameInfo, &dirtyRegion));
 
-				OsdInfo.timerSetProgram = 1;
-			}
+		/* render time does not include waiting for vertical sync in flip */
+		renderTimeUs = osdTimeUs() - frameStartUs;
+		renderTimeSumUs += renderTimeUs;
+		if (renderTimeUs > renderTimeMaxUs)
+		{
+			renderTimeMaxUs = renderTimeUs;
+		}
+		frameCount++;
+		pixelsTouched += (uint64_t)(dirtyRegion.x2 - dirtyRegion.x1 + 1) * (dirtyRegion.y2 - dirtyRegion.y1 + 1);
 
-			/* draw channel rectangle */
-			DFBCHECK(primary->SetColor(primary, 0x00, 0x8c, 0x44, 0xff));
-			DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth / 10, screenHeight / 8));
+		/* flip of a region copies it from back to front buffer, back buffer stays complete */
+		DFBCHECK(primary->Flip(primary, &dirtyRegion, 0));
+		drawnInfo = frameInfo;
+		drawnValid = 1;
 
-			DFBCHECK(primary->SetColor(primary, 0x00, 0xa6, 0x51, 0xff));
-			DFBCHECK(primary->FillRectangle(primary, 10, 10, screenWidth / 10 - 20, screenHeight / 8 - 20));
+		latencyUs = osdTimeUs() - frameChangeUs;
+		latencySumUs += latencyUs;
+		if (latencyUs > latencyMaxUs)
+		{
+			latencyMaxUs = latencyUs;
+		}
+		latencyCount++;
+	}
 
-			/* draw channel number */
-			fontDesc.flags = DFDESC_HEIGHT;
-			fontDesc.height = 48;
-			sprintf(channelString, "%d", OsdInfo.channelNumber);
-			DFBCHECK(dfbInterface->CreateFont(dfbInterface, "/home/galois/fonts/DejaVuSans.ttf", &fontDesc, &fontInterface));
-			DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0xff));
-			DFBCHECK(primary->SetFont(primary, fontInterface));
-			DFBCHECK(primary->DrawString(primary, channelString, -1, screenWidth / 10 - 110, screenHeight / 8 - 50, DSTF_LEFT));
+	return (void*)OSD_NO_ERROR;
+}
 
-			/* draw info rectangle */
-			DFBCHECK(primary->SetColor(primary, 0x00, 0xa6, 0x51, 0xff));
-			DFBCHECK(primary->FillRectangle(primary, screenWidth / 2 - 500, screenHeight * 6 / 8, 1000, screenHeight / 8));
+void osdElementsInit(void)
+{
+	int32_t i;
 
-			/* draw audio and video pid */
-			sprintf(audioPidString, "Audio PID: %d", OsdInfo.audioPid);
-			sprintf(videoPidString, "Video PID: %d", OsdInfo.videoPid);
-			fontDesc.height = 28;
-			DFBCHECK(dfbInterface->CreateFont(dfbInterface, "/home/galois/fonts/DejaVuSans.ttf", &fontDesc, &fontInterface));
-			DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0xff));
-			DFBCHECK(primary->DrawString(primary, audioPidString, -1, screenWidth / 2 - 470, screenHeight * 6 / 8 + 50, DSTF_LEFT));
-			DFBCHECK(primary->DrawString(primary, videoPidString, -1, screenWidth / 2 - 470, screenHeight * 6 / 8 + 100, DSTF_LEFT));
+	elementRects[OSD_ELEMENT_CHANNEL].x = 0;
+	elementRects[OSD_ELEMENT_CHANNEL].y = 0;
+	elementRects[OSD_ELEMENT_CHANNEL].w = screenWidth / 10;
+	elementRects[OSD_ELEMENT_CHANNEL].h = screenHeight / 8;
 
-			/* draw teletext if the channel has it */
-			if (OsdInfo.hasTeletext == 1)
-			{
-				DFBCHECK(primary->DrawString(primary, teletext, -1, screenWidth / 2 - 50, screenHeight * 6 / 8 + 50, DSTF_LEFT));
-			}
-			else
-			{
-				DFBCHECK(primary->DrawString(primary, noTeletext, -1, screenWidth / 2 - 50, screenHeight * 6 / 8 + 50, DSTF_LEFT));
-			}
+	elementRects[OSD_ELEMENT_INFO].x = screenWidth / 2 - 500;
+	elementRects[OSD_ELEMENT_INFO].y = screenHeight * 6 / 8;
+	elementRects[OSD_ELEMENT_INFO].w = 1000;
+	elementRects[OSD_ELEMENT_INFO].h = screenHeight / 8;
 
-			if (strlen(OsdInfo.eventName) > 1 && strlen(OsdInfo.eventGenre) > 1)
-			{
-				/* draw name and genre rectangle */
-				DFBCHECK(primary->SetColor(primary, 0x00, 0xa6, 0x51, 0xff));
-				DFBCHECK(primary->FillRectangle(primary, screenWidth / 2 - 500, screenHeight * 5 / 8, 1000, screenHeight / 8 - 20));
-
-				/* draw text for name and genre */
-				DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0xff));
-				DFBCHECK(primary->DrawString(primary, OsdInfo.eventName+1, -1, screenWidth / 2 - 470, screenHeight * 5 / 8 + 50, DSTF_LEFT));
-				DFBCHECK(primary->DrawString(primary, OsdInfo.eventGenre, -1, screenWidth / 2 - 470, screenHeight * 5 / 8 + 100, DSTF_LEFT));
-			}
-		}
+	elementRects[OSD_ELEMENT_EVENT].x = screenWidth / 2 - 500;
+	elementRects[OSD_ELEMENT_EVENT].y = screenHeight * 5 / 8;
+	elementRects[OSD_ELEMENT_EVENT].w = 1000;
+	elementRects[OSD_ELEMENT_EVENT].h = screenHeight / 8 - 20;
 
-		/* Drawing volume logo if set */
-		if (OsdInfo.drawVolume == 1)
+	elementRects[OSD_ELEMENT_VOLUME].x = screenWidth - 200;
+	elementRects[OSD_ELEMENT_VOLUME].y = 0;
+	elementRects[OSD_ELEMENT_VOLUME].w = 0;
+	elementRects[OSD_ELEMENT_VOLUME].h = 0;
+	for (i = 0; i < OSD_VOLUME_LEVELS; i++)
+	{
+		if (volumeRects[i].w > elementRects[OSD_ELEMENT_VOLUME].w)
+		{
+			elementRects[OSD_ELEMENT_VOLUME].w = volumeRects[i].w;
+		}
+		if (volumeRects[i].h > elementRects[OSD_ELEMENT_VOLUME].h)
 		{
-			char volumePicture[50];
+			elementRects[OSD_ELEMENT_VOLUME].h = volumeRects[i].h;
+		}
+	}
 
-			/* set the picture file */
-			sprintf(volumePicture, "volume_%d.png", OsdInfo.volume);
+	/* text elements are as big as their atlas entries, drawn from baseline */
+	elementRects[OSD_ELEMENT_RADIO] = texts[OSD_TEXT_RADIO].rect;
+	elementRects[OSD_ELEMENT_RADIO].x = screenWidth / 2 - 15;
+	elementRects[OSD_ELEMENT_RADIO].y = screenHeight / 2 - fonts[OSD_FONT_LARGE].ascender;
 
-			/* create image provider */
-			DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, volumePicture, &provider));
-			DFBCHECK(provider->GetSurfaceDescription(provider, &surfaceDesc));
-			DFBCHECK(dfbInterface->CreateSurface(dfbInterface, &surfaceDesc, &logoSurface));
-			DFBCHECK(provider->RenderTo(provider, logoSurface, NULL));
+	elementRects[OSD_ELEMENT_SCRAMBLED] = texts[OSD_TEXT_SCRAMBLED].rect;
+	elementRects[OSD_ELEMENT_SCRAMBLED].x = screenWidth / 2 - 130;
+	elementRects[OSD_ELEMENT_SCRAMBLED].y = screenHeight / 2 + 60 - fonts[OSD_FONT_LARGE].ascender;
+
+	/* EPG grid shows two hours on a full HD screen, less on a narrower one */
+	elementRects[OSD_ELEMENT_EPG].w = OSD_EPG_NAME_WIDTH + OSD_EPG_WINDOW_SECONDS / OSD_EPG_SECOND_PIXELS;
+	if (elementRects[OSD_ELEMENT_EPG].w > screenWidth - 80)
+	{
+		elementRects[OSD_ELEMENT_EPG].w = screenWidth - 80;
+	}
+	elementRects[OSD_ELEMENT_EPG].x = (screenWidth - elementRects[OSD_ELEMENT_EPG].w) / 2;
+	elementRects[OSD_ELEMENT_EPG].y = screenHeight / 16;
+	epgRows = (screenHeight * 7 / 8 - elementRects[OSD_ELEMENT_EPG].y - OSD_EPG_HEADER_HEIGHT) / OSD_EPG_ROW_HEIGHT;
+	elementRects[OSD_ELEMENT_EPG].h = OSD_EPG_HEADER_HEIGHT + epgRows * OSD_EPG_ROW_HEIGHT;
+	epgWindowSeconds = (elementRects[OSD_ELEMENT_EPG].w - OSD_EPG_NAME_WIDTH) * OSD_EPG_SECOND_PIXELS;
 
-			provider->Release(provider);
+	drawnValid = 0;
+}
 
-			/* fetch the logo size and blit it to the screen */
-			DFBCHECK(logoSurface->GetSize(logoSurface, &logoWidth, &logoHeight));
-			DFBCHECK(primary->Blit(primary, logoSurface, NULL, screenWidth - 200, 0));
+DFBResult osdLayersInit(void)
+{
+	DFBSurfaceDescription layerDesc;
+	DFBResult result;
+	int32_t i;
 
-			/* set the timer to 3 seconds */
-			if (OsdInfo.timerSetVolume == 0)
-			{
-				memset(&timerSpecVolume, 0, sizeof(timerSpecVolume));
-				timerSpecVolume.it_value.tv_sec = 3;
-				timerSpecVolume.it_value.tv_nsec = 0;
-				timer_settime(timerIdVolume, timerFlagsVolume, &timerSpecVolume, &timerSpecOldVolume);
+	for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+	{
+		layers[i].valid = 0;
+		if (!layers[i].ownsSurface)
+		{
+			continue;
+		}
 
-				OsdInfo.timerSetVolume = 1;
-			}
+		layerDesc.flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+		layerDesc.width = elementRects[i].w;
+		layerDesc.height = elementRects[i].h;
+		layerDesc.pixelformat = DSPF_ARGB;
+		result = dfbInterface->CreateSurface(dfbInterface, &layerDesc, &layers[i].surface);
+		if (result != DFB_OK)
+		{
+			printf("\n%s : ERROR Cannot create %s\n", __FUNCTION__, layers[i].name);
+			layers[i].surface = NULL;
+			return result;
 		}
+		layers[i].source.x = 0;
+		layers[i].source.y = 0;
+		layers[i].source.w = elementRects[i].w;
+		layers[i].source.h = elementRects[i].h;
 
-		DFBCHECK(primary->Flip(primary, NULL, 0));
-		usleep(100000);
+		/* glyphs are blended onto layer background */
+		DFBTRY(layers[i].surface->SetBlittingFlags(layers[i].surface, DSBLIT_BLEND_ALPHACHANNEL));
 	}
+
+	return DFB_OK;
 }
 
-OsdGraphicsError OsdDeinit(void)
+void osdLayersDeinit(void)
 {
-	/* Thread join */
-	threadExit = 1;
-	if (pthread_join(osdThread, NULL))
+	int32_t i;
+
+	for (i = 0; i < OSD_ELEMENT_COUNT; i++)
 	{
-		printf("\n%s : Error! Pthread join failed!\n", __FUNCTION__);
-		return OSD_ERROR;
+		if (layers[i].ownsSurface && layers[i].surface != NULL)
+		{
+			layers[i].surface->Release(layers[i].surface);
+		}
+		layers[i].surface = NULL;
+		layers[i].valid = 0;
 	}
+}
 
-	/* Release allocated DirectFB memory */
-	primary->Release(primary);
-	dfbInterface->Release(dfbInterface);
-
-	return OSD_NO_ERROR;
+uint8_t osdElementVisible(OsdElement element, const OsdGraphicsInfo* info)
+{
+	switch (element)
+	{
+		case OSD_ELEMENT_EPG:
+			return info->drawEpg == 1;
+		case OSD_ELEMENT_CHANNEL:
+		case OSD_ELEMENT_INFO:
+			return info->draw == 1;
+		case OSD_ELEMENT_EVENT:
+			return info->draw == 1 && strlen(stringPoolGet(info->eventName)) > 1 && strlen(stringPoolGet(info->eventGenre)) > 1;
+		case OSD_ELEMENT_VOLUME:
+			return info->drawVolume == 1 && info->volume < OSD_VOLUME_LEVELS;
+		case OSD_ELEMENT_RADIO:
+			return info->drawRadio == 1;
+		case OSD_ELEMENT_SCRAMBLED:
+			return info->drawScrambled == 1;
+		default:
+			return 0;
+	}
 }
 
-OsdGraphicsInfo* getOsdInfo(void)
+uint8_t osdElementChanged(OsdElement element, const OsdGraphicsInfo* info, const OsdGraphicsInfo* drawn)
 {
-	return &OsdInfo;
+	switch (element)
+	{
+		case OSD_ELEMENT_EPG:
+			return info->epgFirstService != drawn->epgFirstService || info->epgStartTime != drawn->epgStartTime;
+		case OSD_ELEMENT_CHANNEL:
+			return info->channelNumber != drawn->channelNumber;
+		case OSD_ELEMENT_INFO:
+			return info->audioPid != drawn->audioPid || info->videoPid != drawn->videoPid || info->hasTeletext != drawn->hasTeletext;
+		case OSD_ELEMENT_EVENT:
+			return info->eventName != drawn->eventName || info->eventGenre != drawn->eventGenre;
+		case OSD_ELEMENT_VOLUME:
+			return info->volume != drawn->volume;
+		default:
+			/* fixed strings */
+			return 0;
+	}
 }
 
-void clearScreenProgram(void)
+uint8_t osdDirtyRegion(const OsdGraphicsInfo* info, DFBRegion* region)
 {
-	/* Reset the timer and clear the info banner from the screen */
-	OsdInfo.draw = 0;
-	OsdInfo.timerSetProgram = 0;
+	const DFBRectangle* rect;
+	uint8_t visible;
+	uint8_t dirty = 0;
+	int32_t i;
+
+	/* background change and first frame repaint whole screen */
+	if (!drawnValid || info->drawBlack != drawnInfo.drawBlack)
+	{
+		region->x1 = 0;
+		region->y1 = 0;
+		region->x2 = screenWidth - 1;
+		region->y2 = screenHeight - 1;
+		return 1;
+	}
+
+	for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+	{
+		visible = osdElementVisible(i, info);
+		if (visible == osdElementVisible(i, &drawnInfo) && (!visible || !osdElementChanged(i, info, &drawnInfo)))
+		{
+			continue;
+		}
+
+		rect = &elementRects[i];
+		if (!dirty)
+		{
+			region->x1 = rect->x;
+			region->y1 = rect->y;
+			region->x2 = rect->x + rect->w - 1;
+			region->y2 = rect->y + rect->h - 1;
+			dirty = 1;
+			continue;
+		}
+		if (rect->x < region->x1)
+		{
+			region->x1 = rect->x;
+		}
+		if (rect->y < region->y1)
+		{
+			region->y1 = rect->y;
+		}
+		if (rect->x + rect->w - 1 > region->x2)
+		{
+			region->x2 = rect->x + rect->w - 1;
+		}
+		if (rect->y + rect->h - 1 > region->y2)
+		{
+			region->y2 = rect->y + rect->h - 1;
+		}
+	}
+
+	return dirty;
 }
 
-void clearScreenVolume(void)
+DFBResult osdRenderRegion(const OsdGraphicsInfo* info, const DFBRegion* region)
 {
+	const DFBRectangle* rect;
+	OsdLayer* layer;
+	int32_t i;
+
+	/* Check whether the screen should be black */
+	DFBTRY(primary->SetClip(primary, region));
+	if (info->drawBlack == 1)
+	{
+		DFBTRY(primary->SetColor(primary, 0x00, 0x00, 0x00, 0xff));
+	}
+	else
+	{
+		DFBTRY(primary->SetColor(primary, 0x00, 0x00, 0x00, 0x00));
+	}
+	DFBTRY(primary->FillRectangle(primary, region->x1, region->y1, region->x2 - region->x1 + 1, region->y2 - region->y1 + 1));
+
+	/* layers overlapping region are blitted again, only layers whose inputs changed are rendered */
+	for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+	{
+		rect = &elementRects[i];
+		layer = &layers[i];
+		if (!osdElementVisible(i, info))
+		{
+			/* EPG is read from cache again when grid is opened */
+			if (i == OSD_ELEMENT_EPG)
+			{
+				layer->valid = 0;
+			}
+			continue;
+		}
+		if (rect->x > region->x2 || rect->y > region->y2 || rect->x + rect->w - 1 < region->x1 || rect->y + rect->h - 1 < region->y1)
+		{
+			continue;
+		}
+
+		if (!layer->valid || osdElementChanged(i, info, &layer->renderedInfo))
+		{
+			DFBTRY(osdRenderLayer(i, info));
+			layer->renderedInfo = *info;
+			layer->valid = 1;
+			layer->renderCount++;
+		}
+
+		DFBTRY(primary->Blit(primary, layer->surface, &layer->source, rect->x, rect->y));
+		layer->compositeCount++;
+	}
+
+	return primary->SetClip(primary, NULL);
+}
+
+DFBResult osdRenderLayer(OsdElement element, const OsdGraphicsInfo* info)
+{
+	OsdLayer* layer = &layers[element];
+	IDirectFBSurface* surface = layer->surface;
+
+	switch (element)
+	{
+		case OSD_ELEMENT_EPG:
+			return osdEpgRender(layer, info);
+
+		case OSD_ELEMENT_CHANNEL:
+			/* draw channel rectangle */
+			DFBTRY(surface->SetColor(surface, 0x00, 0x8c, 0x44, 0xff));
+			DFBTRY(surface->FillRectangle(surface, 0, 0, layer->source.w, layer->source.h));
+
+			DFBTRY(surface->SetColor(surface, 0x00, 0xa6, 0x51, 0xff));
+			DFBTRY(surface->FillRectangle(surface, 10, 10, layer->source.w - 20, layer->source.h - 20));
+
+			/* draw channel number */
+			return osdDrawNumber(surface, OSD_FONT_LARGE, info->channelNumber, layer->source.w - 110, layer->source.h - 50);
+
+		case OSD_ELEMENT_INFO:
+			/* draw info rectangle */
+			DFBTRY(surface->SetColor(surface, 0x00, 0xa6, 0x51, 0xff));
+			DFBTRY(surface->FillRectangle(surface, 0, 0, layer->source.w, layer->source.h));
+
+			/* draw audio and video pid */
+			DFBTRY(osdDrawText(surface, OSD_TEXT_AUDIO_PID, 30, 50));
+			DFBTRY(osdDrawNumber(surface, OSD_FONT_SMALL, info->audioPid, 30 + texts[OSD_TEXT_AUDIO_PID].rect.w, 50));
+			DFBTRY(osdDrawText(surface, OSD_TEXT_VIDEO_PID, 30, 100));
+			DFBTRY(osdDrawNumber(surface, OSD_FONT_SMALL, info->videoPid, 30 + texts[OSD_TEXT_VIDEO_PID].rect.w, 100));
+
+			/* draw teletext if the channel has it */
+			if (info->hasTeletext == 1)
+			{
+				return osdDrawText(surface, OSD_TEXT_TELETEXT, 450, 50);
+			}
+			return osdDrawText(surface, OSD_TEXT_NO_TELETEXT, 450, 50);
+
+		case OSD_ELEMENT_EVENT:
+			/* draw name and genre rectangle */
+			DFBTRY(surface->SetColor(surface, 0x00, 0xa6, 0x51, 0xff));
+			DFBTRY(surface->FillRectangle(surface, 0, 0, layer->source.w, layer->source.h));
+
+			/* draw text for name and genre, event strings are not in atlas */
+			DFBTRY(surface->SetFont(surface, fonts[OSD_FONT_SMALL].font));
+			DFBTRY(surface->SetColor(surface, 0x00, 0x00, 0x00, 0xff));
+			DFBTRY(surface->DrawString(surface, stringPoolGet(info->eventName) + 1, -1, 30, 50, DSTF_LEFT));
+			return surface->DrawString(surface, stringPoolGet(info->eventGenre), -1, 30, 100, DSTF_LEFT);
+
+		case OSD_ELEMENT_VOLUME:
+			/* logo of current level is taken from atlas as it is */
+			layer->surface = volumeAtlas;
+			layer->source = volumeRects[info->volume];
+			return DFB_OK;
+
+		case OSD_ELEMENT_RADIO:
+			layer->surface = fonts[texts[OSD_TEXT_RADIO].size].atlas;
+			layer->source = texts[OSD_TEXT_RADIO].rect;
+			return DFB_OK;
+
+		case OSD_ELEMENT_SCRAMBLED:
+			/* service can not be decoded, shown instead of a black screen */
+			layer->surface = fonts[texts[OSD_TEXT_SCRAMBLED].size].atlas;
+			layer->source = texts[OSD_TEXT_SCRAMBLED].rect;
+			return DFB_OK;
+
+		default:
+			return DFB_OK;
+	}
+}
+
+DFBResult osdEpgRender(OsdLayer* layer, const OsdGraphicsInfo* info)
+{
+	const OsdGraphicsInfo* shown = &layer->renderedInfo;
+	DFBRectangle source;
+	int32_t width = elementRects[OSD_ELEMENT_EPG].w;
+	int32_t areaWidth = width - OSD_EPG_NAME_WIDTH;
+	int32_t rowShift = (int32_t)info->epgFirstService - (int32_t)shown->epgFirstService;
+	int32_t shift = osdEpgX(info->epgStartTime, shown->epgStartTime) - OSD_EPG_NAME_WIDTH;
+	int32_t edge;
+	int32_t shownEdge;
+	int32_t row;
+
+	if (epgSurface == NULL)
+	{
+		DFBTRY(osdEpgInit());
+	}
+	layer->surface = epgSurface;
+	layer->source = elementRects[OSD_ELEMENT_EPG];
+	layer->source.x = 0;
+	layer->source.y = 0;
+
+	/* grid that was closed, or moved by as much as it shows, is drawn completely */
+	if (!layer->valid || (rowShift != 0 && shift != 0) || abs(rowShift) >= epgRows || abs(shift) >= areaWidth)
+	{
+		epgFullRenderCount++;
+		DFBTRY(osdEpgDrawRuler(info));
+		for (row = 0; row < epgRows; row++)
+		{
+			DFBTRY(osdEpgDrawRow(info, row, 0, width - 1));
+		}
+		return DFB_OK;
+	}
+	epgScrollCount++;
+
+	/* content that stays visible is moved inside grid surface, copied as it is */
+	DFBTRY(epgSurface->SetBlittingFlags(epgSurface, DSBLIT_NOFX));
+	if (rowShift != 0)
+	{
+		source.x = 0;
+		source.y = OSD_EPG_HEADER_HEIGHT + ((rowShift > 0) ? rowShift * OSD_EPG_ROW_HEIGHT : 0);
+		source.w = width;
+		source.h = (epgRows - abs(rowShift)) * OSD_EPG_ROW_HEIGHT;
+		DFBTRY(epgSurface->Blit(epgSurface, epgSurface, &source, 0,
+		                        OSD_EPG_HEADER_HEIGHT + ((rowShift > 0) ? 0 : -rowShift * OSD_EPG_ROW_HEIGHT)));
+	}
+	else
+	{
+		source.x = OSD_EPG_NAME_WIDTH + ((shift > 0) ? shift : 0);
+		source.y = OSD_EPG_HEADER_HEIGHT;
+		source.w = areaWidth - abs(shift);
+		source.h = epgRows * OSD_EPG_ROW_HEIGHT;
+		DFBTRY(epgSurface->Blit(epgSurface, epgSurface, &source, OSD_EPG_NAME_WIDTH + ((shift > 0) ? 0 : -shift),
+		                        OSD_EPG_HEADER_HEIGHT));
+	}
+	DFBTRY(epgSurface->SetBlittingFlags(epgSurface, DSBLIT_BLEND_ALPHACHANNEL));
+
+	/* only uncovered rows are drawn */
+	if (rowShift != 0)
+	{
+		for (row = (rowShift > 0) ? epgRows - rowShift : 0; row < ((rowShift > 0) ? epgRows : -rowShift); row++)
+		{
+			DFBTRY(osdEpgDrawRow(info, row, 0, width - 1));
+		}
+		return DFB_OK;
+	}
+
+	/* only uncovered strip is drawn, and cells whose name sat at or moves to the left edge */
+	DFBTRY(osdEpgDrawRuler(info));
+	for (row = 0; row < epgRows; row++)
+	{
+		edge = osdEpgEdgeCell(info, row, info->epgStartTime);
+		shownEdge = osdEpgEdgeCell(info, row, shown->epgStartTime);
+		if (shownEdge > edge)
+		{
+			edge = shownEdge;
+		}
+
+		if (shift > 0)
+		{
+			if (edge >= OSD_EPG_NAME_WIDTH)
+			{
+				DFBTRY(osdEpgDrawRow(info, row, OSD_EPG_NAME_WIDTH, edge));
+			}
+			DFBTRY(osdEpgDrawRow(info, row, width - shift, width - 1));
+		}
+		else
+		{
+			DFBTRY(osdEpgDrawRow(info, row, OSD_EPG_NAME_WIDTH, (edge > OSD_EPG_NAME_WIDTH - shift - 1) ? edge : OSD_EPG_NAME_WIDTH - shift - 1));
+		}
+	}
+
+	return DFB_OK;
+}
+
+DFBResult osdEpgInit(void)
+{
+	DFBSurfaceDescription epgDesc;
+	DFBResult result;
+	int32_t i;
+
+	epgDesc.flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+	epgDesc.width = elementRects[OSD_ELEMENT_EPG].w;
+	epgDesc.height = elementRects[OSD_ELEMENT_EPG].h;
+	epgDesc.pixelformat = DSPF_ARGB;
+	result = dfbInterface->CreateSurface(dfbInterface, &epgDesc, &epgSurface);
+	if (result != DFB_OK)
+	{
+		printf("\n%s : ERROR Cannot create EPG grid surface\n", __FUNCTION__);
+		epgSurface = NULL;
+		return result;
+	}
+
+	/* names are kept in fixed slots, one font height tall */
+	epgDesc.width = OSD_EPG_CELL_COLUMNS * OSD_EPG_CELL_WIDTH;
+	epgDesc.height = (OSD_EPG_CELL_SLOTS + OSD_EPG_CELL_COLUMNS - 1) / OSD_EPG_CELL_COLUMNS * fonts[OSD_FONT_SMALL].height;
+	result = dfbInterface->CreateSurface(dfbInterface, &epgDesc, &epgCellAtlas);
+	if (result != DFB_OK)
+	{
+		printf("\n%s : ERROR Cannot create EPG cell atlas\n", __FUNCTION__);
+		epgCellAtlas = NULL;
+		osdEpgDeinit();
+		return result;
+	}
+	DFBTRY(epgSurface->SetBlittingFlags(epgSurface, DSBLIT_BLEND_ALPHACHANNEL));
+	DFBTRY(epgCellAtlas->SetFont(epgCellAtlas, fonts[OSD_FONT_SMALL].font));
+	DFBTRY(epgCellAtlas->SetColor(epgCellAtlas, 0xff, 0xff, 0xff, 0xff));
+
+	/* all slots start unused in least recently used list */
+	for (i = 0; i < OSD_EPG_CELL_BUCKETS; i++)
+	{
+		epgCellBuckets[i] = -1;
+	}
+	for (i = 0; i < OSD_EPG_CELL_SLOTS; i++)
+	{
+		epgCells[i].used = 0;
+		epgCells[i].hashNext = -1;
+		epgCells[i].older = i - 1;
+		epgCells[i].newer = (i + 1 < OSD_EPG_CELL_SLOTS) ? i + 1 : -1;
+	}
+	epgCellOldest = 0;
+	epgCellNewest = OSD_EPG_CELL_SLOTS - 1;
+
+	return DFB_OK;
+}
+
+void osdEpgDeinit(void)
+{
+	if (epgCellAtlas != NULL)
+	{
+		epgCellAtlas->Release(epgCellAtlas);
+		epgCellAtlas = NULL;
+	}
+	if (epgSurface != NULL)
+	{
+		epgSurface->Release(epgSurface);
+		epgSurface = NULL;
+	}
+}
+
+DFBResult osdEpgDrawRuler(const OsdGraphicsInfo* info)
+{
+	OsdFont* osdFont = &fonts[OSD_FONT_SMALL];
+	char label[8];
+	uint32_t labelTime;
+	int32_t width = elementRects[OSD_ELEMENT_EPG].w;
+	int32_t x;
+
+	DFBTRY(epgSurface->SetColor(epgSurface, 0x00, 0x8c, 0x44, 0xff));
+	DFBTRY(epgSurface->FillRectangle(epgSurface, 0, 0, width, OSD_EPG_HEADER_HEIGHT));
+
+	/* labels at whole and half hours of broadcast clock, few strings are drawn directly */
+	DFBTRY(epgSurface->SetFont(epgSurface, osdFont->font));
+	DFBTRY(epgSurface->SetColor(epgSurface, 0x00, 0x00, 0x00, 0xff));
+	labelTime = info->epgStartTime + OSD_EPG_RULER_SECONDS - 1;
+	labelTime -= labelTime % OSD_EPG_RULER_SECONDS;
+	for (x = osdEpgX(labelTime, info->epgStartTime); x < width; labelTime += OSD_EPG_RULER_SECONDS, x = osdEpgX(labelTime, info->epgStartTime))
+	{
+		snprintf(label, sizeof(label), "%02u:%02u", (labelTime / 3600) % 24, (labelTime / 60) % 60);
+		DFBTRY(epgSurface->FillRectangle(epgSurface, x, OSD_EPG_HEADER_HEIGHT - 8, 2, 8));
+		DFBTRY(epgSurface->DrawString(epgSurface, label, -1, x + 6, (OSD_EPG_HEADER_HEIGHT - osdFont->height) / 2 + osdFont->ascender, DSTF_LEFT));
+	}
+
+	return DFB_OK;
+}
+
+DFBResult osdEpgDrawRow(const OsdGraphicsInfo* info, int32_t row, int32_t x1, int32_t x2)
+{
+	OsdFont* osdFont = &fonts[OSD_FONT_SMALL];
+	EpgCacheEvent events[OSD_EPG_ROW_EVENTS];
+	DFBRectangle source;
+	DFBRegion clip;
+	uint16_t serviceId = 0;
+	uint16_t count;
+	uint16_t i;
+	int32_t y = OSD_EPG_HEADER_HEIGHT + row * OSD_EPG_ROW_HEIGHT;
+	int32_t left;
+	int32_t right;
+	int32_t textX;
+	int16_t slot;
+
+	count = epgCacheCopyEvents(info->epgFirstService + row, &serviceId, info->epgStartTime, info->epgStartTime + epgWindowSeconds,
+	                           events, OSD_EPG_ROW_EVENTS);
+	epgRowDrawCount++;
+
+	/* everything is clipped to requested columns, cells keep their place in the whole row */
+	clip.x1 = x1;
+	clip.y1 = y;
+	clip.x2 = x2;
+	clip.y2 = y + OSD_EPG_ROW_HEIGHT - 1;
+	DFBTRY(epgSurface->SetClip(epgSurface, &clip));
+	DFBTRY(epgSurface->SetColor(epgSurface, 0x10, 0x10, 0x10, 0xff));
+	DFBTRY(epgSurface->FillRectangle(epgSurface, x1, y, x2 - x1 + 1, OSD_EPG_ROW_HEIGHT));
+
+	/* rows below last cached service stay empty, service_id 0 is never used */
+	if (serviceId == 0)
+	{
+		return epgSurface->SetClip(epgSurface, NULL);
+	}
+
+	if (x1 < OSD_EPG_NAME_WIDTH)
+	{
+		DFBTRY(epgSurface->SetColor(epgSurface, 0x00, 0xa6, 0x51, 0xff));
+		DFBTRY(epgSurface->FillRectangle(epgSurface, 0, y + 1, OSD_EPG_NAME_WIDTH - 1, OSD_EPG_ROW_HEIGHT - 2));
+		DFBTRY(osdDrawNumber(epgSurface, OSD_FONT_SMALL, serviceId, 10, y + (OSD_EPG_ROW_HEIGHT - osdFont->height) / 2 + osdFont->ascender));
+	}
+
+	clip.x1 = (x1 > OSD_EPG_NAME_WIDTH) ? x1 : OSD_EPG_NAME_WIDTH;
+	if (clip.x1 > x2)
+	{
+		return epgSurface->SetClip(epgSurface, NULL);
+	}
+	DFBTRY(epgSurface->SetClip(epgSurface, &clip));
+	DFBTRY(epgSurface->SetColor(epgSurface, 0x1e, 0x32, 0x28, 0xff));
+
+	for (i = 0; i < count; i++)
+	{
+		left = osdEpgX(events[i].startTime, info->epgStartTime);
+		right = osdEpgX(events[i].startTime + events[i].duration, info->epgStartTime);
+		if (right <= clip.x1 || left > x2)
+		{
+			continue;
+		}
+		DFBTRY(epgSurface->FillRectangle(epgSurface, left + 1, y + 1, right - left - 2, OSD_EPG_ROW_HEIGHT - 2));
+
+		/* name of event that began before window starts at left edge */
+		textX = ((left > OSD_EPG_NAME_WIDTH) ? left : OSD_EPG_NAME_WIDTH) + 6;
+		slot = osdEpgCell(serviceId, &events[i]);
+		source.x = (slot % OSD_EPG_CELL_COLUMNS) * OSD_EPG_CELL_WIDTH;
+		source.y = (slot / OSD_EPG_CELL_COLUMNS) * osdFont->height;
+		source.w = (epgCells[slot].width < right - 6 - textX) ? epgCells[slot].width : right - 6 - textX;
+		source.h = osdFont->height;
+		if (source.w > 0)
+		{
+			DFBTRY(epgSurface->Blit(epgSurface, epgCellAtlas, &source, textX, y + (OSD_EPG_ROW_HEIGHT - osdFont->height) / 2));
+		}
+	}
+
+	return epgSurface->SetClip(epgSurface, NULL);
+}
+
+int32_t osdEpgEdgeCell(const OsdGraphicsInfo* info, int32_t row, uint32_t utcTime)
+{
+	EpgCacheEvent event;
+	uint16_t serviceId;
+	int32_t last;
+
+	if (epgCacheCopyEvents(info->epgFirstService + row, &serviceId, utcTime, utcTime + 1, &event, 1) == 0)
+	{
+		return OSD_EPG_NAME_WIDTH - 1;
+	}
+
+	last = osdEpgX(event.startTime + event.duration, info->epgStartTime) - 1;
+	return (last < elementRects[OSD_ELEMENT_EPG].w - 1) ? last : elementRects[OSD_ELEMENT_EPG].w - 1;
+}
+
+int16_t osdEpgCell(uint16_t serviceId, const EpgCacheEvent* event)
+{
+	OsdFont* osdFont = &fonts[OSD_FONT_SMALL];
+	OsdEpgCell* cell;
+	DFBRegion clip;
+	char name[OSD_EPG_NAME_LENGTH];
+	const char* text;
+	uint32_t bucket = ((uint32_t)serviceId * 31 + event->eventId) & (OSD_EPG_CELL_BUCKETS - 1);
+	int16_t* link;
+	int16_t slot;
+
+	for (slot = epgCellBuckets[bucket]; slot >= 0; slot = epgCells[slot].hashNext)
+	{
+		cell = &epgCells[slot];
+		if (cell->serviceId == serviceId && cell->eventId == event->eventId && cell->startTime == event->startTime &&
+		    cell->nameOffset == event->nameOffset)
+		{
+			break;
+		}
+	}
+
+	if (slot >= 0)
+	{
+		epgCellHitCount++;
+	}
+	else
+	{
+		/* least recently used slot gets the new name */
+		slot = epgCellOldest;
+		cell = &epgCells[slot];
+		if (cell->used)
+		{
+			link = &epgCellBuckets[((uint32_t)cell->serviceId * 31 + cell->eventId) & (OSD_EPG_CELL_BUCKETS - 1)];
+			while (*link != slot)
+			{
+				link = &epgCells[*link].hashNext;
+			}
+			*link = cell->hashNext;
+			epgCellEvictCount++;
+		}
+		epgCellMissCount++;
+
+		cell->serviceId = serviceId;
+		cell->eventId = event->eventId;
+		cell->startTime = event->startTime;
+		cell->nameOffset = event->nameOffset;
+		cell->used = 1;
+		cell->hashNext = epgCellBuckets[bucket];
+		epgCellBuckets[bucket] = slot;
+
+		/* first bytes below 0x20 select DVB character table */
+		epgCacheCopyString(event->nameOffset, name, sizeof(name));
+		for (text = name; *text != '\0' && (uint8_t)*text < 0x20; text++);
+
+		clip.x1 = (slot % OSD_EPG_CELL_COLUMNS) * OSD_EPG_CELL_WIDTH;
+		clip.y1 = (slot / OSD_EPG_CELL_COLUMNS) * osdFont->height;
+		clip.x2 = clip.x1 + OSD_EPG_CELL_WIDTH - 1;
+		clip.y2 = clip.y1 + osdFont->height - 1;
+		epgCellAtlas->SetClip(epgCellAtlas, &clip);
+		epgCellAtlas->Clear(epgCellAtlas, 0x00, 0x00, 0x00, 0x00);
+		epgCellAtlas->DrawString(epgCellAtlas, text, -1, clip.x1, clip.y1, DSTF_TOPLEFT);
+		epgCellAtlas->SetClip(epgCellAtlas, NULL);
+		osdFont->font->GetStringWidth(osdFont->font, text, -1, &cell->width);
+		if (cell->width > OSD_EPG_CELL_WIDTH)
+		{
+			cell->width = OSD_EPG_CELL_WIDTH;
+		}
+	}
+
+	/* slot becomes most recently used */
+	if (slot != epgCellNewest)
+	{
+		epgCells[cell->newer].older = cell->older;
+		if (cell->older >= 0)
+		{
+			epgCells[cell->older].newer = cell->newer;
+		}
+		else
+		{
+			epgCellOldest = cell->newer;
+		}
+		cell->older = epgCellNewest;
+		cell->newer = -1;
+		epgCells[epgCellNewest].newer = slot;
+		epgCellNewest = slot;
+	}
+
+	return slot;
+}
+
+int32_t osdEpgX(uint32_t utcTime, uint32_t startTime)
+{
+	return OSD_EPG_NAME_WIDTH + (int32_t)((int64_t)(utcTime / OSD_EPG_SECOND_PIXELS) - (int64_t)(startTime / OSD_EPG_SECOND_PIXELS));
+}
+
+DFBResult osdFontsInit(void)
+{
+	DFBFontDescription fontDesc;
+	DFBSurfaceDescription atlasDesc;
+	DFBResult result;
+	OsdFont* osdFont;
+	char glyph[2] = {0};
+	int32_t width;
+	int32_t x;
+	int32_t i;
+	int32_t j;
+
+	for (i = 0; i < OSD_FONT_COUNT; i++)
+	{
+		osdFont = &fonts[i];
+
+		fontDesc.flags = DFDESC_HEIGHT;
+		fontDesc.height = osdFont->height;
+		result = dfbInterface->CreateFont(dfbInterface, OSD_FONT_PATH, &fontDesc, &osdFont->font);
+		if (result != DFB_OK)
+		{
+			printf("\n%s : ERROR Cannot create font of height %d\n", __FUNCTION__, osdFont->height);
+			return result;
+		}
+		fontCreateCount++;
+		osdFont->font->GetAscender(osdFont->font, &osdFont->ascender);
+
+		/* atlas layout: digits, then fixed strings of this size, side by side */
+		x = 0;
+		for (j = 0; j < OSD_GLYPH_DIGIT_COUNT; j++)
+		{
+			glyph[0] = OSD_GLYPH_DIGITS[j];
+			osdFont->font->GetStringWidth(osdFont->font, glyph, 1, &width);
+			osdFont->digits[j].x = x;
+			osdFont->digits[j].y = 0;
+			osdFont->digits[j].w = width;
+			osdFont->digits[j].h = osdFont->height;
+			x += width;
+		}
+		for (j = 0; j < OSD_TEXT_COUNT; j++)
+		{
+			if ((int32_t)texts[j].size != i)
+			{
+				continue;
+			}
+			osdFont->font->GetStringWidth(osdFont->font, texts[j].text, -1, &width);
+			texts[j].rect.x = x;
+			texts[j].rect.y = 0;
+			texts[j].rect.w = width;
+			texts[j].rect.h = osdFont->height;
+			x += width;
+		}
+
+		atlasDesc.flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+		atlasDesc.width = x;
+		atlasDesc.height = osdFont->height;
+		atlasDesc.pixelformat = DSPF_ARGB;
+		result = dfbInterface->CreateSurface(dfbInterface, &atlasDesc, &osdFont->atlas);
+		if (result != DFB_OK)
+		{
+			printf("\n%s : ERROR Cannot create glyph atlas\n", __FUNCTION__);
+			return result;
+		}
+
+		/* glyphs are rasterized once, frames only blit them */
+		osdFont->atlas->Clear(osdFont->atlas, 0x00, 0x00, 0x00, 0x00);
+		osdFont->atlas->SetFont(osdFont->atlas, osdFont->font);
+		osdFont->atlas->SetColor(osdFont->atlas, 0x00, 0x00, 0x00, 0xff);
+		for (j = 0; j < OSD_GLYPH_DIGIT_COUNT; j++)
+		{
+			glyph[0] = OSD_GLYPH_DIGITS[j];
+			osdFont->atlas->DrawString(osdFont->atlas, glyph, 1, osdFont->digits[j].x, 0, DSTF_TOPLEFT);
+		}
+		for (j = 0; j < OSD_TEXT_COUNT; j++)
+		{
+			if ((int32_t)texts[j].size == i)
+			{
+				osdFont->atlas->SetColor(osdFont->atlas, texts[j].red, texts[j].green, texts[j].blue, 0xff);
+				osdFont->atlas->DrawString(osdFont->atlas, texts[j].text, -1, texts[j].rect.x, 0, DSTF_TOPLEFT);
+			}
+		}
+	}
+
+	return DFB_OK;
+}
+
+DFBResult osdVolumeAtlasInit(void)
+{
+	IDirectFBImageProvider* providers[OSD_VOLUME_LEVELS] = {NULL};
+	DFBSurfaceDescription imageDesc;
+	DFBSurfaceDescription atlasDesc;
+	DFBResult result = DFB_OK;
+	char volumePicture[50];
+	int32_t x = 0;
+	int32_t i;
+
+	atlasDesc.flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+	atlasDesc.width = 0;
+	atlasDesc.height = 0;
+	atlasDesc.pixelformat = DSPF_ARGB;
+
+	/* sizes of all logos are needed before atlas is created */
+	for (i = 0; i < OSD_VOLUME_LEVELS; i++)
+	{
+		sprintf(volumePicture, "volume_%d.png", i);
+		result = dfbInterface->CreateImageProvider(dfbInterface, volumePicture, &providers[i]);
+		if (result != DFB_OK)
+		{
+			printf("\n%s : ERROR Cannot open %s\n", __FUNCTION__, volumePicture);
+			providers[i] = NULL;
+			break;
+		}
+		providers[i]->GetSurfaceDescription(providers[i], &imageDesc);
+
+		volumeRects[i].x = x;
+		volumeRects[i].y = 0;
+		volumeRects[i].w = imageDesc.width;
+		volumeRects[i].h = imageDesc.height;
+		x += imageDesc.width;
+		if (imageDesc.height > atlasDesc.height)
+		{
+			atlasDesc.height = imageDesc.height;
+		}
+	}
+	atlasDesc.width = x;
+
+	if (result == DFB_OK)
+	{
+		result = dfbInterface->CreateSurface(dfbInterface, &atlasDesc, &volumeAtlas);
+		if (result != DFB_OK)
+		{
+			printf("\n%s : ERROR Cannot create volume atlas\n", __FUNCTION__);
+			volumeAtlas = NULL;
+		}
+	}
+
+	if (result == DFB_OK)
+	{
+		volumeAtlas->Clear(volumeAtlas, 0x00, 0x00, 0x00, 0x00);
+		for (i = 0; i < OSD_VOLUME_LEVELS && result == DFB_OK; i++)
+		{
+			result = providers[i]->RenderTo(providers[i], volumeAtlas, &volumeRects[i]);
+			imageDecodeCount++;
+		}
+	}
+
+	for (i = 0; i < OSD_VOLUME_LEVELS; i++)
+	{
+		if (providers[i] != NULL)
+		{
+			providers[i]->Release(providers[i]);
+		}
+	}
+
+	return result;
+}
+
+void osdVolumeAtlasDeinit(void)
+{
+	if (volumeAtlas != NULL)
+	{
+		volumeAtlas->Release(volumeAtlas);
+		volumeAtlas = NULL;
+	}
+}
+
+uint64_t osdRssKb(void)
+{
+	FILE* statm;
+	unsigned long size;
+	unsigned long resident;
+
+	statm = fopen("/proc/self/statm", "r");
+	if (statm == NULL)
+	{
+		return 0;
+	}
+	if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+	{
+		resident = 0;
+	}
+	fclose(statm);
+
+	return (uint64_t)resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void osdFontsDeinit(void)
+{
+	int32_t i;
+
+	for (i = 0; i < OSD_FONT_COUNT; i++)
+	{
+		if (fonts[i].atlas != NULL)
+		{
+			fonts[i].atlas->Release(fonts[i].atlas);
+			fonts[i].atlas = NULL;
+		}
+		if (fonts[i].font != NULL)
+		{
+			fonts[i].font->Release(fonts[i].font);
+			fonts[i].font = NULL;
+		}
+	}
+}
+
+DFBResult osdDrawText(IDirectFBSurface* surface, OsdText text, int32_t x, int32_t y)
+{
+	OsdFont* osdFont = &fonts[texts[text].size];
+
+	return surface->Blit(surface, osdFont->atlas, &texts[text].rect, x, y - osdFont->ascender);
+}
+
+DFBResult osdDrawNumber(IDirectFBSurface* surface, OsdFontSize size, int32_t value, int32_t x, int32_t y)
+{
+	OsdFont* osdFont = &fonts[size];
+	uint8_t digits[12];
+	uint32_t magnitude;
+	int32_t count = 0;
+	DFBResult result;
+
+	magnitude = (value < 0) ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+	do
+	{
+		digits[count++] = magnitude % 10;
+		magnitude /= 10;
+	}
+	while (magnitude != 0);
+	if (value < 0)
+	{
+		/* minus is last glyph of atlas */
+		digits[count++] = OSD_GLYPH_DIGIT_COUNT - 1;
+	}
+
+	while (count > 0)
+	{
+		count--;
+		result = surface->Blit(surface, osdFont->atlas, &osdFont->digits[digits[count]], x, y - osdFont->ascender);
+		if (result != DFB_OK)
+		{
+			return result;
+		}
+		x += osdFont->digits[digits[count]].w;
+	}
+
+	return DFB_OK;
+}
+
+uint64_t osdTimeUs(void)
+{
+	struct timespec timeSpec;
+
+	clock_gettime(CLOCK_MONOTONIC, &timeSpec);
+	return (uint64_t)timeSpec.tv_sec * 1000000 + timeSpec.tv_nsec / 1000;
+}
+
+void printOsdRenderStats(void)
+{
+	int32_t i;
+
+	printf("\n********************OSD RENDER********************\n");
+	printf("frames rendered          |      %u\n", frameCount);
+	if (frameCount != 0)
+	{
+		printf("avg render time          |      %llu us\n", (unsigned long long)(renderTimeSumUs / frameCount));
+	}
+	printf("max render time          |      %llu us\n", (unsigned long long)renderTimeMaxUs);
+	printf("frames skipped           |      %u\n", frameSkipCount);
+	printf("wakeups                  |      %u\n", wakeupCount);
+	if (latencyCount != 0)
+	{
+		printf("avg change to flip       |      %llu us\n", (unsigned long long)(latencySumUs / latencyCount));
+	}
+	printf("max change to flip       |      %llu us\n", (unsigned long long)latencyMaxUs);
+	printf("OSD info snapshots       |      %u\n", __atomic_load_n(&snapshotCount, __ATOMIC_RELAXED));
+	printf("snapshot retries         |      %u\n", __atomic_load_n(&snapshotRetryCount, __ATOMIC_RELAXED));
+	printf("pixels touched           |      %llu\n", (unsigned long long)pixelsTouched);
+	if (osdTimeUs() > startTimeUs && startTimeUs != 0)
+	{
+		printf("pixels per second        |      %llu\n", (unsigned long long)(pixelsTouched * 1000000 / (osdTimeUs() - startTimeUs)));
+	}
+	printf("fonts created            |      %u\n", fontCreateCount);
+	printf("images decoded           |      %u\n", imageDecodeCount);
+	printf("RSS at OSD start         |      %llu kB\n", (unsigned long long)startRssKb);
+	printf("RSS now                  |      %llu kB\n", (unsigned long long)osdRssKb());
+	for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+	{
+		printf("%-25s|      %u renders, %u composites\n", layers[i].name, layers[i].renderCount, layers[i].compositeCount);
+	}
+	printf("EPG full renders         |      %u\n", epgFullRenderCount);
+	printf("EPG scrolls              |      %u\n", epgScrollCount);
+	printf("EPG rows drawn           |      %u\n", epgRowDrawCount);
+	printf("EPG cell hits            |      %u\n", epgCellHitCount);
+	printf("EPG cell misses          |      %u (%u evicted)\n", epgCellMissCount, epgCellEvictCount);
+	printf("\n********************OSD RENDER********************\n");
+}
+
+OsdGraphicsError OsdDeinit(void)
+{
+	/* Thread join */
+	pthread_mutex_lock(&osdMutex);
+	threadExit = 1;
+	pthread_cond_signal(&osdCond);
+	pthread_cond_broadcast(&osdIdleCond);
+	pthread_mutex_unlock(&osdMutex);
+	if (pthread_join(osdThread, NULL))
+	{
+		printf("\n%s : Error! Pthread join failed!\n", __FUNCTION__);
+		return OSD_ERROR;
+	}
+
+	printOsdRenderStats();
+
+	/* hide callbacks must not run after OSD is gone */
+	timerDelete(timerIdProgram);
+	timerDelete(timerIdVolume);
+	timerIdProgram = TIMER_SERVICE_INVALID_ID;
+	timerIdVolume = TIMER_SERVICE_INVALID_ID;
+
+	/* Release allocated DirectFB memory */
+	osdLayersDeinit();
+	osdEpgDeinit();
+	osdVolumeAtlasDeinit();
+	osdFontsDeinit();
+	primary->Release(primary);
+	dfbInterface->Release(dfbInterface);
+
+	return OSD_NO_ERROR;
+}
+
+OsdGraphicsInfo* OsdInfoWriteBegin(void)
+{
+	pthread_mutex_lock(&osdInfoWriteMutex);
+
+	/* odd sequence has to be visible before any field changes */
+	__atomic_store_n(&osdInfoSequence, osdInfoSequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return &OsdInfo;
+}
+
+void OsdInfoWriteEnd(void)
+{
+	osdInfoWriteFinish();
+	OsdNotify();
+}
+
+void osdInfoWriteFinish(void)
+{
+	__atomic_store_n(&osdInfoSequence, osdInfoSequence + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&osdInfoWriteMutex);
+}
+
+void OsdInfoSnapshot(OsdGraphicsInfo* info)
+{
+	uint32_t begin;
+	uint32_t end;
+
+	while (1)
+	{
+		begin = __atomic_load_n(&osdInfoSequence, __ATOMIC_ACQUIRE);
+		if ((begin & 1) == 0)
+		{
+			memcpy(info, &OsdInfo, sizeof(OsdGraphicsInfo));
+
+			/* copy has to be complete before sequence is checked again */
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			end = __atomic_load_n(&osdInfoSequence, __ATOMIC_RELAXED);
+			if (begin == end)
+			{
+				break;
+			}
+		}
+
+		/* writer sections are a few stores, give writer the CPU instead of spinning */
+		__atomic_fetch_add(&snapshotRetryCount, 1, __ATOMIC_RELAXED);
+		sched_yield();
+	}
+
+	__atomic_fetch_add(&snapshotCount, 1, __ATOMIC_RELAXED);
+}
+
+void OsdNotify(void)
+{
+	pthread_mutex_lock(&osdMutex);
+	if (!osdChanged)
+	{
+		changeTimeUs = osdTimeUs();
+	}
+	osdChanged = 1;
+	pthread_cond_signal(&osdCond);
+	pthread_mutex_unlock(&osdMutex);
+}
+
+void OsdWaitIdle(void)
+{
+	pthread_mutex_lock(&osdMutex);
+	while ((osdChanged || !osdIdle) && threadExit == 0)
+	{
+		pthread_cond_wait(&osdIdleCond, &osdMutex);
+	}
+	pthread_mutex_unlock(&osdMutex);
+}
+
+OsdGraphicsError OsdDumpFrame(const char* fileName)
+{
+#ifdef OSD_BACKEND_SOFT
+	if (osdSoftDumpSurface(primary, fileName) != DFB_OK)
+	{
+		return OSD_ERROR;
+	}
+	return OSD_NO_ERROR;
+#else
+	printf("\n%s : ERROR screen can be written only by software backend\n", __FUNCTION__);
+	return OSD_ERROR;
+#endif
+}
+
+void clearScreenProgram(void* arg)
+{
+	OsdGraphicsInfo* osd = OsdInfoWriteBegin();
+
+	/* Reset the timer and clear the info banner from the screen */
+	osd->draw = 0;
+	osd->timerSetProgram = 0;
+	OsdInfoWriteEnd();
+}
+
+void clearScreenVolume(void* arg)
+{
+	OsdGraphicsInfo* osd = OsdInfoWriteBegin();
+
 	/* Reset the timer and clear the volume logo from the screen */
-	OsdInfo.drawVolume = 0;
-	OsdInfo.timerSetVolume = 0;
+	osd->drawVolume = 0;
+	osd->timerSetVolume = 0;
+	OsdInfoWriteEnd();
 }
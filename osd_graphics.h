@@ -1,6 +1,8 @@
 #ifndef __OSD_GRAPHICS_H__
 #define __OSD_GRAPHICS_H__
 
+#include "string_pool.h"
+
 #include <stdint.h>
 
 /**
@@ -23,14 +25,18 @@ typedef struct _OsdGraphicsInfo
 	uint8_t volume;
 	uint8_t isMuted;
 	uint8_t hasTeletext;
-	char eventGenre[50];
-	char eventName[50];
+	StringHandle eventGenre;
+	StringHandle eventName;
 	uint8_t drawBlack;
 	uint8_t draw;
 	uint8_t drawRadio;
+	uint8_t drawScrambled;
 	uint8_t drawVolume;
 	uint8_t timerSetVolume;
 	uint8_t timerSetProgram;
+	uint8_t drawEpg;
+	uint16_t epgFirstService;                   /* EPG cache index of service in top row of EPG grid */
+	uint32_t epgStartTime;                      /* UTC time at left edge of EPG grid */
 }OsdGraphicsInfo;
 
 /**
@@ -48,10 +54,44 @@ OsdGraphicsError OsdInit(void);
 OsdGraphicsError OsdDeinit(void);
 
 /**
- * @brief - Returns the pointer to the OSD info.
+ * @brief - Starts change of OSD info, writers are serialized but the OSD thread is never blocked.
+ *
+ * Fields are changed through returned pointer until OsdInfoWriteEnd(), the OSD thread sees
+ * either all or none of them. Nothing that can block may be called in between.
  *
- * @return - Pointer to the OSD info.
+ * @return - Pointer to the OSD info, valid until OsdInfoWriteEnd().
+ */
+OsdGraphicsInfo* OsdInfoWriteBegin(void);
+
+/**
+ * @brief - Publishes changes made since OsdInfoWriteBegin() and wakes OSD thread.
+ */
+void OsdInfoWriteEnd(void);
+
+/**
+ * @brief - Copies OSD info, copy never mixes fields of two writes.
+ *
+ * @param [out] info - Consistent copy of OSD info
+ */
+void OsdInfoSnapshot(OsdGraphicsInfo* info);
+
+/**
+ * @brief - Wakes OSD thread, OsdInfoWriteEnd() does it after every change.
+ */
+void OsdNotify(void);
+
+/**
+ * @brief - Waits until OSD thread has put every notified change on screen.
+ */
+void OsdWaitIdle(void);
+
+/**
+ * @brief - Writes what the screen shows to PNG file, only with software backend (OSD_BACKEND=soft).
+ *
+ * @param [in] fileName - PNG file name
+ *
+ * @return - OSD error code.
  */
-OsdGraphicsInfo* getOsdInfo(void);
+OsdGraphicsError OsdDumpFrame(const char* fileName);
 
 #endif
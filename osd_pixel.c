@@ -0,0 +1,584 @@
+#include "osd_pixel.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OSD_PIXEL_X86
+#include <immintrin.h>
+#endif
+
+/* NEON kernels are built when the toolchain enables NEON (-mfpu=neon on ARMv7) */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OSD_PIXEL_NEON
+#include <arm_neon.h>
+#if defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+#define OSD_PIXEL_BENCH_ROUNDS  10          /* Full screen passes per measured kernel */
+
+/**
+ * @brief - Blends one ARGB pixel over another with alpha of source, exact for alpha 0 and 255.
+ */
+static inline uint32_t pixelBlend(uint32_t source, uint32_t destination);
+
+/**
+ * @brief - Portable kernels.
+ */
+static void scalarFill(uint32_t* destination, uint32_t count, uint32_t color);
+static void scalarFillBlend(uint32_t* destination, uint32_t count, uint32_t color);
+static void scalarBlend(uint32_t* destination, const uint32_t* source, uint32_t count);
+
+#ifdef OSD_PIXEL_X86
+/**
+ * @brief - SSE2 kernels, 4 pixels per step.
+ */
+static void sse2Fill(uint32_t* destination, uint32_t count, uint32_t color);
+static void sse2FillBlend(uint32_t* destination, uint32_t count, uint32_t color);
+static void sse2Blend(uint32_t* destination, const uint32_t* source, uint32_t count);
+
+/**
+ * @brief - AVX2 kernels, 8 pixels per step.
+ */
+static void avx2Fill(uint32_t* destination, uint32_t count, uint32_t color);
+static void avx2FillBlend(uint32_t* destination, uint32_t count, uint32_t color);
+static void avx2Blend(uint32_t* destination, const uint32_t* source, uint32_t count);
+#endif
+
+#ifdef OSD_PIXEL_NEON
+/**
+ * @brief - NEON kernels, 8 pixels per step deinterleaved into channels.
+ */
+static void neonFill(uint32_t* destination, uint32_t count, uint32_t color);
+static void neonFillBlend(uint32_t* destination, uint32_t count, uint32_t color);
+static void neonBlend(uint32_t* destination, const uint32_t* source, uint32_t count);
+#endif
+
+/**
+ * @brief - Checks if CPU can run the kernels.
+ */
+static uint8_t osdPixelSupported(const OsdPixelKernels* kernels);
+
+/**
+ * @brief - Returns Mpixels/s of kernel run over full screen.
+ */
+static double osdPixelMeasure(const OsdPixelKernels* kernels, uint8_t kernel, uint32_t* destination, const uint32_t* source);
+
+static const OsdPixelKernels scalarKernels = {"scalar", scalarFill, scalarFillBlend, scalarBlend};
+#ifdef OSD_PIXEL_X86
+static const OsdPixelKernels sse2Kernels = {"sse2", sse2Fill, sse2FillBlend, sse2Blend};
+static const OsdPixelKernels avx2Kernels = {"avx2", avx2Fill, avx2FillBlend, avx2Blend};
+#endif
+#ifdef OSD_PIXEL_NEON
+static const OsdPixelKernels neonKernels = {"neon", neonFill, neonFillBlend, neonBlend};
+#endif
+
+/* Implementations built into this binary, slowest first */
+static const OsdPixelKernels* kernelTable[] =
+{
+	&scalarKernels,
+#ifdef OSD_PIXEL_X86
+	&sse2Kernels,
+	&avx2Kernels,
+#endif
+#ifdef OSD_PIXEL_NEON
+	&neonKernels,
+#endif
+};
+
+static const OsdPixelKernels* selectedKernels = NULL;
+
+const OsdPixelKernels* osdPixelKernels(void)
+{
+	const char* forced;
+	uint32_t i;
+
+	if (selectedKernels != NULL)
+	{
+		return selectedKernels;
+	}
+
+	selectedKernels = &scalarKernels;
+	for (i = 0; i < sizeof(kernelTable) / sizeof(kernelTable[0]); i++)
+	{
+		if (osdPixelSupported(kernelTable[i]))
+		{
+			selectedKernels = kernelTable[i];
+		}
+	}
+
+	forced = getenv("OSD_PIXEL_KERNELS");
+	if (forced != NULL)
+	{
+		for (i = 0; i < sizeof(kernelTable) / sizeof(kernelTable[0]); i++)
+		{
+			if (strcmp(forced, kernelTable[i]->name) == 0 && osdPixelSupported(kernelTable[i]))
+			{
+				selectedKernels = kernelTable[i];
+				break;
+			}
+		}
+		if (i == sizeof(kernelTable) / sizeof(kernelTable[0]))
+		{
+			printf("\n%s : ERROR pixel kernels %s not supported, using %s\n", __FUNCTION__, forced, selectedKernels->name);
+		}
+	}
+
+	return selectedKernels;
+}
+
+void printOsdPixelBenchmark(void)
+{
+	const uint32_t count = OSD_PIXEL_BENCH_WIDTH * OSD_PIXEL_BENCH_HEIGHT;
+	uint32_t* source;
+	uint32_t* destination;
+	uint32_t* reference;
+	uint8_t kernel;
+	uint32_t i;
+	static const char* kernelNames[3] = {"fill", "fill blend", "blend"};
+
+	source = (uint32_t*)malloc(count * sizeof(uint32_t));
+	destination = (uint32_t*)malloc(count * sizeof(uint32_t));
+	reference = (uint32_t*)malloc(count * sizeof(uint32_t));
+	if (source == NULL || destination == NULL || reference == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		free(source);
+		free(destination);
+		free(reference);
+		return;
+	}
+
+	/* alpha runs through every value, so opaque and transparent fast paths are a small share */
+	for (i = 0; i < count; i++)
+	{
+		source[i] = ((i * 7) & 0xff) << 24 | (i * 2654435761u >> 8);
+	}
+
+	printf("\n********************OSD PIXEL KERNELS********************\n");
+	printf("selected                 |      %s\n", osdPixelKernels()->name);
+	printf("screen                   |      %ux%u\n", OSD_PIXEL_BENCH_WIDTH, OSD_PIXEL_BENCH_HEIGHT);
+	for (kernel = 0; kernel < 3; kernel++)
+	{
+		for (i = 0; i < sizeof(kernelTable) / sizeof(kernelTable[0]); i++)
+		{
+			if (!osdPixelSupported(kernelTable[i]))
+			{
+				continue;
+			}
+			printf("%-10s %-13s |      %.0f Mpixels/s\n", kernelNames[kernel], kernelTable[i]->name,
+			       osdPixelMeasure(kernelTable[i], kernel, destination, source));
+
+			/* every implementation has to give the pixels of scalar one */
+			if (i == 0)
+			{
+				memcpy(reference, destination, count * sizeof(uint32_t));
+			}
+			else if (memcmp(reference, destination, count * sizeof(uint32_t)) != 0)
+			{
+				printf("\n%s : ERROR %s %s differs from scalar\n", __FUNCTION__, kernelNames[kernel], kernelTable[i]->name);
+			}
+		}
+	}
+	printf("\n********************OSD PIXEL KERNELS********************\n");
+
+	free(source);
+	free(destination);
+	free(reference);
+}
+
+double osdPixelMeasure(const OsdPixelKernels* kernels, uint8_t kernel, uint32_t* destination, const uint32_t* source)
+{
+	const uint32_t count = OSD_PIXEL_BENCH_WIDTH * OSD_PIXEL_BENCH_HEIGHT;
+	struct timespec start;
+	struct timespec end;
+	double seconds;
+	uint32_t round;
+	uint32_t row;
+
+	/* same start content for every implementation, rows are passed like surface rows */
+	for (row = 0; row < count; row++)
+	{
+		destination[row] = 0xff204060 + row;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (round = 0; round < OSD_PIXEL_BENCH_ROUNDS; round++)
+	{
+		for (row = 0; row < OSD_PIXEL_BENCH_HEIGHT; row++)
+		{
+			switch (kernel)
+			{
+				case 0:
+					kernels->fill(destination + row * OSD_PIXEL_BENCH_WIDTH, OSD_PIXEL_BENCH_WIDTH, 0xff00a651);
+					break;
+				case 1:
+					kernels->fillBlend(destination + row * OSD_PIXEL_BENCH_WIDTH, OSD_PIXEL_BENCH_WIDTH, 0x8000a651);
+					break;
+				default:
+					kernels->blend(destination + row * OSD_PIXEL_BENCH_WIDTH, source + row * OSD_PIXEL_BENCH_WIDTH,
+					               OSD_PIXEL_BENCH_WIDTH);
+					break;
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	return seconds > 0 ? (double)count * OSD_PIXEL_BENCH_ROUNDS / seconds / 1e6 : 0;
+}
+
+uint8_t osdPixelSupported(const OsdPixelKernels* kernels)
+{
+#ifdef OSD_PIXEL_X86
+	if (kernels == &sse2Kernels)
+	{
+		return __builtin_cpu_supports("sse2") != 0;
+	}
+	if (kernels == &avx2Kernels)
+	{
+		return __builtin_cpu_supports("avx2") != 0;
+	}
+#endif
+#if defined(OSD_PIXEL_NEON) && defined(__arm__)
+	if (kernels == &neonKernels)
+	{
+		return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+	}
+#endif
+	return 1;
+}
+
+uint32_t pixelBlend(uint32_t source, uint32_t destination)
+{
+	uint32_t alpha = source >> 24;
+	uint32_t inverse = 255 - alpha;
+	uint32_t redBlue;
+	uint32_t alphaGreen;
+
+	/* t = s * a + d * (255 - a) + 128, t / 255 is (t + (t >> 8)) >> 8, two channels per multiply */
+	redBlue = (source & 0x00ff00ff) * alpha + (destination & 0x00ff00ff) * inverse + 0x00800080;
+	redBlue = ((redBlue + ((redBlue >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+	alphaGreen = ((source >> 8) & 0x00ff00ff) * alpha + ((destination >> 8) & 0x00ff00ff) * inverse + 0x00800080;
+	alphaGreen = (alphaGreen + ((alphaGreen >> 8) & 0x00ff00ff)) & 0xff00ff00;
+
+	return alphaGreen | redBlue;
+}
+
+void scalarFill(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		destination[i] = color;
+	}
+}
+
+void scalarFillBlend(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		destination[i] = pixelBlend(color, destination[i]);
+	}
+}
+
+void scalarBlend(uint32_t* destination, const uint32_t* source, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		/* logos are mostly fully opaque or fully transparent */
+		if ((source[i] >> 24) == 0xff)
+		{
+			destination[i] = source[i];
+		}
+		else if ((source[i] >> 24) != 0)
+		{
+			destination[i] = pixelBlend(source[i], destination[i]);
+		}
+	}
+}
+
+#ifdef OSD_PIXEL_X86
+__attribute__((target("sse2")))
+void sse2Fill(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	__m128i value = _mm_set1_epi32((int32_t)color);
+	uint32_t i = 0;
+
+	for (; i + 16 <= count; i += 16)
+	{
+		_mm_storeu_si128((__m128i*)(destination + i), value);
+		_mm_storeu_si128((__m128i*)(destination + i + 4), value);
+		_mm_storeu_si128((__m128i*)(destination + i + 8), value);
+		_mm_storeu_si128((__m128i*)(destination + i + 12), value);
+	}
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_si128((__m128i*)(destination + i), value);
+	}
+	scalarFill(destination + i, count - i, color);
+}
+
+__attribute__((target("sse2")))
+void sse2FillBlend(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i colorWide = _mm_unpacklo_epi8(_mm_set1_epi32((int32_t)color), zero);
+	__m128i alpha = _mm_set1_epi16((int16_t)(color >> 24));
+	__m128i inverse = _mm_set1_epi16((int16_t)(255 - (color >> 24)));
+	__m128i sourceTerm = _mm_add_epi16(_mm_mullo_epi16(colorWide, alpha), _mm_set1_epi16(128));
+	__m128i pixels;
+	__m128i low;
+	__m128i high;
+	uint32_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		pixels = _mm_loadu_si128((const __m128i*)(destination + i));
+		low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), inverse), sourceTerm);
+		high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), inverse), sourceTerm);
+		low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+	}
+	scalarFillBlend(destination + i, count - i, color);
+}
+
+__attribute__((target("sse2")))
+void sse2Blend(uint32_t* destination, const uint32_t* source, uint32_t count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i alphaMask = _mm_set1_epi32((int32_t)0xff000000);
+	__m128i max = _mm_set1_epi16(255);
+	__m128i round = _mm_set1_epi16(128);
+	__m128i sourcePixels;
+	__m128i destinationPixels;
+	__m128i sourceAlpha;
+	__m128i low;
+	__m128i high;
+	__m128i alphaLow;
+	__m128i alphaHigh;
+	uint32_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		sourcePixels = _mm_loadu_si128((const __m128i*)(source + i));
+		sourceAlpha = _mm_and_si128(sourcePixels, alphaMask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(sourceAlpha, alphaMask)) == 0xffff)
+		{
+			_mm_storeu_si128((__m128i*)(destination + i), sourcePixels);
+			continue;
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(sourceAlpha, zero)) == 0xffff)
+		{
+			continue;
+		}
+
+		destinationPixels = _mm_loadu_si128((const __m128i*)(destination + i));
+		low = _mm_unpacklo_epi8(sourcePixels, zero);
+		high = _mm_unpackhi_epi8(sourcePixels, zero);
+		alphaLow = _mm_shufflehi_epi16(_mm_shufflelo_epi16(low, 0xff), 0xff);
+		alphaHigh = _mm_shufflehi_epi16(_mm_shufflelo_epi16(high, 0xff), 0xff);
+
+		/* 16 bit lanes do not overflow, t is at most 255 * 255 + 128 */
+		low = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(low, alphaLow),
+		                    _mm_mullo_epi16(_mm_unpacklo_epi8(destinationPixels, zero), _mm_sub_epi16(max, alphaLow))), round);
+		high = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(high, alphaHigh),
+		                     _mm_mullo_epi16(_mm_unpackhi_epi8(destinationPixels, zero), _mm_sub_epi16(max, alphaHigh))), round);
+		low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+	}
+	scalarBlend(destination + i, source + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void avx2Fill(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	__m256i value = _mm256_set1_epi32((int32_t)color);
+	uint32_t i = 0;
+
+	for (; i + 32 <= count; i += 32)
+	{
+		_mm256_storeu_si256((__m256i*)(destination + i), value);
+		_mm256_storeu_si256((__m256i*)(destination + i + 8), value);
+		_mm256_storeu_si256((__m256i*)(destination + i + 16), value);
+		_mm256_storeu_si256((__m256i*)(destination + i + 24), value);
+	}
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_si256((__m256i*)(destination + i), value);
+	}
+	scalarFill(destination + i, count - i, color);
+}
+
+__attribute__((target("avx2")))
+void avx2FillBlend(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i colorWide = _mm256_unpacklo_epi8(_mm256_set1_epi32((int32_t)color), zero);
+	__m256i alpha = _mm256_set1_epi16((int16_t)(color >> 24));
+	__m256i inverse = _mm256_set1_epi16((int16_t)(255 - (color >> 24)));
+	__m256i sourceTerm = _mm256_add_epi16(_mm256_mullo_epi16(colorWide, alpha), _mm256_set1_epi16(128));
+	__m256i pixels;
+	__m256i low;
+	__m256i high;
+	uint32_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		pixels = _mm256_loadu_si256((const __m256i*)(destination + i));
+		low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), inverse), sourceTerm);
+		high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), inverse), sourceTerm);
+		low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_packus_epi16(low, high));
+	}
+	scalarFillBlend(destination + i, count - i, color);
+}
+
+__attribute__((target("avx2")))
+void avx2Blend(uint32_t* destination, const uint32_t* source, uint32_t count)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i alphaMask = _mm256_set1_epi32((int32_t)0xff000000);
+	__m256i max = _mm256_set1_epi16(255);
+	__m256i round = _mm256_set1_epi16(128);
+	__m256i sourcePixels;
+	__m256i destinationPixels;
+	__m256i sourceAlpha;
+	__m256i low;
+	__m256i high;
+	__m256i alphaLow;
+	__m256i alphaHigh;
+	uint32_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		sourcePixels = _mm256_loadu_si256((const __m256i*)(source + i));
+		sourceAlpha = _mm256_and_si256(sourcePixels, alphaMask);
+		if ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi32(sourceAlpha, alphaMask)) == 0xffffffff)
+		{
+			_mm256_storeu_si256((__m256i*)(destination + i), sourcePixels);
+			continue;
+		}
+		if (_mm256_testz_si256(sourceAlpha, sourceAlpha))
+		{
+			continue;
+		}
+
+		/* unpack and pack work inside 128 bit halves, pixel order is kept */
+		destinationPixels = _mm256_loadu_si256((const __m256i*)(destination + i));
+		low = _mm256_unpacklo_epi8(sourcePixels, zero);
+		high = _mm256_unpackhi_epi8(sourcePixels, zero);
+		alphaLow = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(low, 0xff), 0xff);
+		alphaHigh = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(high, 0xff), 0xff);
+
+		low = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(low, alphaLow),
+		                       _mm256_mullo_epi16(_mm256_unpacklo_epi8(destinationPixels, zero), _mm256_sub_epi16(max, alphaLow))), round);
+		high = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(high, alphaHigh),
+		                        _mm256_mullo_epi16(_mm256_unpackhi_epi8(destinationPixels, zero), _mm256_sub_epi16(max, alphaHigh))), round);
+		low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_packus_epi16(low, high));
+	}
+	scalarBlend(destination + i, source + i, count - i);
+}
+#endif /* OSD_PIXEL_X86 */
+
+#ifdef OSD_PIXEL_NEON
+void neonFill(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	uint32x4_t value = vdupq_n_u32(color);
+	uint32_t i = 0;
+
+	for (; i + 16 <= count; i += 16)
+	{
+		vst1q_u32(destination + i, value);
+		vst1q_u32(destination + i + 4, value);
+		vst1q_u32(destination + i + 8, value);
+		vst1q_u32(destination + i + 12, value);
+	}
+	for (; i + 4 <= count; i += 4)
+	{
+		vst1q_u32(destination + i, value);
+	}
+	scalarFill(destination + i, count - i, color);
+}
+
+void neonFillBlend(uint32_t* destination, uint32_t count, uint32_t color)
+{
+	uint8x8_t inverse = vdup_n_u8((uint8_t)(255 - (color >> 24)));
+	uint16x8_t sourceTerm[4];
+	uint8x8x4_t pixels;
+	uint16x8_t value;
+	uint8_t channel;
+	uint32_t i = 0;
+
+	/* vld4 splits 8 pixels into one register per byte of pixel */
+	for (channel = 0; channel < 4; channel++)
+	{
+		sourceTerm[channel] = vdupq_n_u16((uint16_t)(((color >> (8 * channel)) & 0xff) * (color >> 24) + 128));
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		pixels = vld4_u8((const uint8_t*)(destination + i));
+		for (channel = 0; channel < 4; channel++)
+		{
+			value = vmlal_u8(sourceTerm[channel], pixels.val[channel], inverse);
+			pixels.val[channel] = vshrn_n_u16(vsraq_n_u16(value, value, 8), 8);
+		}
+		vst4_u8((uint8_t*)(destination + i), pixels);
+	}
+	scalarFillBlend(destination + i, count - i, color);
+}
+
+void neonBlend(uint32_t* destination, const uint32_t* source, uint32_t count)
+{
+	uint16x8_t round = vdupq_n_u16(128);
+	uint8x8x4_t sourcePixels;
+	uint8x8x4_t destinationPixels;
+	uint8x8_t alpha;
+	uint8x8_t inverse;
+	uint16x8_t value;
+	uint64_t alphaBits;
+	uint8_t channel;
+	uint32_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		sourcePixels = vld4_u8((const uint8_t*)(source + i));
+		alpha = sourcePixels.val[3];
+		alphaBits = vget_lane_u64(vreinterpret_u64_u8(alpha), 0);
+		if (alphaBits == 0xffffffffffffffffULL)
+		{
+			vst4_u8((uint8_t*)(destination + i), sourcePixels);
+			continue;
+		}
+		if (alphaBits == 0)
+		{
+			continue;
+		}
+
+		destinationPixels = vld4_u8((const uint8_t*)(destination + i));
+		inverse = vmvn_u8(alpha);
+		for (channel = 0; channel < 4; channel++)
+		{
+			value = vmlal_u8(vmlal_u8(round, sourcePixels.val[channel], alpha), destinationPixels.val[channel], inverse);
+			destinationPixels.val[channel] = vshrn_n_u16(vsraq_n_u16(value, value, 8), 8);
+		}
+		vst4_u8((uint8_t*)(destination + i), destinationPixels);
+	}
+	scalarBlend(destination + i, source + i, count - i);
+}
+#endif /* OSD_PIXEL_NEON */
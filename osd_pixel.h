@@ -0,0 +1,37 @@
+#ifndef __OSD_PIXEL_H__
+#define __OSD_PIXEL_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define OSD_PIXEL_BENCH_WIDTH   1920        /* Benchmark buffer, one full HD screen */
+#define OSD_PIXEL_BENCH_HEIGHT  1080
+
+/**
+ * @brief - ARGB8888 pixel kernels of one instruction set, every implementation gives the same pixels.
+ *
+ * Blending is source over: out = (source * alpha + destination * (255 - alpha)) / 255 on all four channels.
+ */
+typedef struct _OsdPixelKernels
+{
+	const char* name;
+	void (*fill)(uint32_t* destination, uint32_t count, uint32_t color);
+	void (*fillBlend)(uint32_t* destination, uint32_t count, uint32_t color);
+	void (*blend)(uint32_t* destination, const uint32_t* source, uint32_t count);
+}OsdPixelKernels;
+
+/**
+ * @brief - Returns fastest kernels the CPU supports, selected on first call.
+ *
+ * Environment variable OSD_PIXEL_KERNELS (scalar, sse2, avx2, neon) forces a supported implementation.
+ *
+ * @return - Kernels, never NULL
+ */
+const OsdPixelKernels* osdPixelKernels(void);
+
+/**
+ * @brief - Measures every supported implementation on a full HD buffer and prints Mpixels/s.
+ */
+void printOsdPixelBenchmark(void);
+
+#endif /* __OSD_PIXEL_H__ */
@@ -0,0 +1,816 @@
+#include "osd_soft.h"
+#include "osd_pixel.h"
+
+#ifdef OSD_BACKEND_SOFT
+
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+
+#define OSD_SOFT_GLYPH_FIRST    ' '
+#define OSD_SOFT_GLYPH_LAST     '~'
+#define OSD_SOFT_GLYPH_WIDTH    5
+#define OSD_SOFT_GLYPH_HEIGHT   7
+#define OSD_SOFT_CELL_WIDTH     6           /* Glyph and one column of spacing */
+#define OSD_SOFT_CELL_HEIGHT    8
+
+/* Pixels in memory are 32 bit ARGB words, libpng has to deliver bytes in matching order */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define OSD_SOFT_PNG_FORMAT     PNG_FORMAT_ARGB
+#else
+#define OSD_SOFT_PNG_FORMAT     PNG_FORMAT_BGRA
+#endif
+
+/**
+ * @brief - Surface, DirectFB interface is first member so thiz is cast back to it.
+ */
+typedef struct _OsdSoftSurface
+{
+	IDirectFBSurface iface;
+	uint32_t* pixels;                           /* Drawing buffer, back buffer of flipping surface */
+	uint32_t* frontPixels;                      /* Shown buffer, NULL if surface is not flipping */
+	int32_t width;
+	int32_t height;
+	uint32_t color;                             /* ARGB of SetColor() */
+	DFBRegion clip;
+	DFBSurfaceDrawingFlags drawingFlags;
+	DFBSurfaceBlittingFlags blittingFlags;
+	struct _OsdSoftFont* font;
+}OsdSoftSurface;
+
+/**
+ * @brief - Bitmap font scaled to requested height.
+ */
+typedef struct _OsdSoftFont
+{
+	IDirectFBFont iface;
+	int32_t height;
+	int32_t scale;                              /* Screen pixels per glyph pixel */
+}OsdSoftFont;
+
+/**
+ * @brief - Image decoded when provider is created.
+ */
+typedef struct _OsdSoftImageProvider
+{
+	IDirectFBImageProvider iface;
+	uint32_t* pixels;
+	int32_t width;
+	int32_t height;
+}OsdSoftImageProvider;
+
+/* 5x7 glyphs of printable ASCII, one byte per row, bit 4 is left column */
+static const uint8_t glyphs[OSD_SOFT_GLYPH_LAST - OSD_SOFT_GLYPH_FIRST + 1][OSD_SOFT_GLYPH_HEIGHT] =
+{
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},    /* ' ' */
+	{0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},    /* '!' */
+	{0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00},    /* '"' */
+	{0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a},    /* '#' */
+	{0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04},    /* '$' */
+	{0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},    /* '%' */
+	{0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d},    /* '&' */
+	{0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00},    /* ''' */
+	{0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},    /* '(' */
+	{0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},    /* ')' */
+	{0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00},    /* asterisk */
+	{0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00},    /* '+' */
+	{0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08},    /* ',' */
+	{0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00},    /* '-' */
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c},    /* '.' */
+	{0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},    /* slash */
+	{0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e},    /* '0' */
+	{0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e},    /* '1' */
+	{0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f},    /* '2' */
+	{0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e},    /* '3' */
+	{0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02},    /* '4' */
+	{0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e},    /* '5' */
+	{0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e},    /* '6' */
+	{0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},    /* '7' */
+	{0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e},    /* '8' */
+	{0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c},    /* '9' */
+	{0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00},    /* ':' */
+	{0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08},    /* ';' */
+	{0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},    /* '<' */
+	{0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00},    /* '=' */
+	{0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},    /* '>' */
+	{0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},    /* '?' */
+	{0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e},    /* '@' */
+	{0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11},    /* 'A' */
+	{0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e},    /* 'B' */
+	{0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e},    /* 'C' */
+	{0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c},    /* 'D' */
+	{0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f},    /* 'E' */
+	{0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10},    /* 'F' */
+	{0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f},    /* 'G' */
+	{0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11},    /* 'H' */
+	{0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e},    /* 'I' */
+	{0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c},    /* 'J' */
+	{0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},    /* 'K' */
+	{0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f},    /* 'L' */
+	{0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11},    /* 'M' */
+	{0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},    /* 'N' */
+	{0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e},    /* 'O' */
+	{0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10},    /* 'P' */
+	{0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d},    /* 'Q' */
+	{0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11},    /* 'R' */
+	{0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e},    /* 'S' */
+	{0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},    /* 'T' */
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e},    /* 'U' */
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04},    /* 'V' */
+	{0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a},    /* 'W' */
+	{0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11},    /* 'X' */
+	{0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04},    /* 'Y' */
+	{0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f},    /* 'Z' */
+	{0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e},    /* '[' */
+	{0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},    /* backslash */
+	{0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e},    /* ']' */
+	{0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00},    /* '^' */
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f},    /* '_' */
+	{0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00},    /* '`' */
+	{0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f},    /* 'a' */
+	{0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e},    /* 'b' */
+	{0x00, 0x00, 0x0e, 0x10, 0x10, 0x11, 0x0e},    /* 'c' */
+	{0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f},    /* 'd' */
+	{0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e},    /* 'e' */
+	{0x06, 0x09, 0x08, 0x1c, 0x08, 0x08, 0x08},    /* 'f' */
+	{0x00, 0x0f, 0x11, 0x11, 0x0f, 0x01, 0x0e},    /* 'g' */
+	{0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11},    /* 'h' */
+	{0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x0e},    /* 'i' */
+	{0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0c},    /* 'j' */
+	{0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12},    /* 'k' */
+	{0x0c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e},    /* 'l' */
+	{0x00, 0x00, 0x1a, 0x15, 0x15, 0x11, 0x11},    /* 'm' */
+	{0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11},    /* 'n' */
+	{0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e},    /* 'o' */
+	{0x00, 0x00, 0x1e, 0x11, 0x1e, 0x10, 0x10},    /* 'p' */
+	{0x00, 0x00, 0x0d, 0x13, 0x0f, 0x01, 0x01},    /* 'q' */
+	{0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10},    /* 'r' */
+	{0x00, 0x00, 0x0e, 0x10, 0x0e, 0x01, 0x1e},    /* 's' */
+	{0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06},    /* 't' */
+	{0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0d},    /* 'u' */
+	{0x00, 0x00, 0x11, 0x11, 0x11, 0x0a, 0x04},    /* 'v' */
+	{0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0a},    /* 'w' */
+	{0x00, 0x00, 0x11, 0x0a, 0x04, 0x0a, 0x11},    /* 'x' */
+	{0x00, 0x00, 0x11, 0x11, 0x0f, 0x01, 0x0e},    /* 'y' */
+	{0x00, 0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f},    /* 'z' */
+	{0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02},    /* '{' */
+	{0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},    /* '|' */
+	{0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08},    /* '}' */
+	{0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00},    /* '~' */
+};
+
+/**
+ * @brief - IDirectFB functions.
+ */
+static DFBResult softRelease(IDirectFB* thiz);
+static DFBResult softSetCooperativeLevel(IDirectFB* thiz, DFBCooperativeLevel level);
+static DFBResult softCreateSurface(IDirectFB* thiz, const DFBSurfaceDescription* desc, IDirectFBSurface** interface);
+static DFBResult softCreateFont(IDirectFB* thiz, const char* fileName, const DFBFontDescription* desc, IDirectFBFont** interface);
+static DFBResult softCreateImageProvider(IDirectFB* thiz, const char* fileName, IDirectFBImageProvider** interface);
+
+/**
+ * @brief - IDirectFBSurface functions.
+ */
+static DFBResult surfaceRelease(IDirectFBSurface* thiz);
+static DFBResult surfaceGetSize(IDirectFBSurface* thiz, int* width, int* height);
+static DFBResult surfaceSetColor(IDirectFBSurface* thiz, u8 r, u8 g, u8 b, u8 a);
+static DFBResult surfaceSetClip(IDirectFBSurface* thiz, const DFBRegion* clip);
+static DFBResult surfaceSetDrawingFlags(IDirectFBSurface* thiz, DFBSurfaceDrawingFlags flags);
+static DFBResult surfaceSetBlittingFlags(IDirectFBSurface* thiz, DFBSurfaceBlittingFlags flags);
+static DFBResult surfaceSetFont(IDirectFBSurface* thiz, IDirectFBFont* font);
+static DFBResult surfaceClear(IDirectFBSurface* thiz, u8 r, u8 g, u8 b, u8 a);
+static DFBResult surfaceFillRectangle(IDirectFBSurface* thiz, int x, int y, int w, int h);
+static DFBResult surfaceDrawString(IDirectFBSurface* thiz, const char* text, int bytes, int x, int y, DFBSurfaceTextFlags flags);
+static DFBResult surfaceBlit(IDirectFBSurface* thiz, IDirectFBSurface* source, const DFBRectangle* sourceRect, int x, int y);
+static DFBResult surfaceFlip(IDirectFBSurface* thiz, const DFBRegion* region, DFBSurfaceFlipFlags flags);
+static DFBResult surfaceLock(IDirectFBSurface* thiz, DFBSurfaceLockFlags flags, void** pointer, int* pitch);
+static DFBResult surfaceUnlock(IDirectFBSurface* thiz);
+
+/**
+ * @brief - IDirectFBFont functions.
+ */
+static DFBResult fontRelease(IDirectFBFont* thiz);
+static DFBResult fontGetHeight(IDirectFBFont* thiz, int* height);
+static DFBResult fontGetAscender(IDirectFBFont* thiz, int* ascender);
+static DFBResult fontGetStringWidth(IDirectFBFont* thiz, const char* text, int bytes, int* width);
+
+/**
+ * @brief - IDirectFBImageProvider functions.
+ */
+static DFBResult providerRelease(IDirectFBImageProvider* thiz);
+static DFBResult providerGetSurfaceDescription(IDirectFBImageProvider* thiz, DFBSurfaceDescription* desc);
+static DFBResult providerRenderTo(IDirectFBImageProvider* thiz, IDirectFBSurface* destination, const DFBRectangle* destinationRect);
+
+/**
+ * @brief - Clips rectangle to clip region of surface.
+ *
+ * @return - 0 if nothing is left
+ */
+static uint8_t softClipRectangle(const OsdSoftSurface* surface, int32_t* x, int32_t* y, int32_t* w, int32_t* h);
+
+/**
+ * @brief - Fills clipped rectangle with color, blended if requested.
+ */
+static void softFill(OsdSoftSurface* surface, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color, uint8_t blend);
+
+DFBResult osdSoftCreate(IDirectFB** interface)
+{
+	IDirectFB* dfb;
+
+	dfb = (IDirectFB*)calloc(1, sizeof(IDirectFB));
+	if (dfb == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		return DFB_FAILURE;
+	}
+
+	dfb->Release = softRelease;
+	dfb->SetCooperativeLevel = softSetCooperativeLevel;
+	dfb->CreateSurface = softCreateSurface;
+	dfb->CreateFont = softCreateFont;
+	dfb->CreateImageProvider = softCreateImageProvider;
+
+	*interface = dfb;
+	return DFB_OK;
+}
+
+DFBResult osdSoftDumpSurface(IDirectFBSurface* surface, const char* fileName)
+{
+	OsdSoftSurface* soft = (OsdSoftSurface*)surface;
+	png_image image;
+
+	memset(&image, 0x0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	image.width = soft->width;
+	image.height = soft->height;
+	image.format = OSD_SOFT_PNG_FORMAT;
+
+	if (!png_image_write_to_file(&image, fileName, 0, soft->frontPixels != NULL ? soft->frontPixels : soft->pixels,
+	                             soft->width * 4, NULL))
+	{
+		printf("\n%s : ERROR Cannot write %s: %s\n", __FUNCTION__, fileName, image.message);
+		return DFB_FAILURE;
+	}
+
+	return DFB_OK;
+}
+
+/* headless build does not link DirectFB library */
+DFBResult DirectFBErrorFatal(const char* message, DFBResult error)
+{
+	fprintf(stderr, "%s: error %d\n", message, error);
+	return error;
+}
+
+DFBResult softRelease(IDirectFB* thiz)
+{
+	free(thiz);
+	return DFB_OK;
+}
+
+DFBResult softSetCooperativeLevel(IDirectFB* thiz, DFBCooperativeLevel level)
+{
+	return DFB_OK;
+}
+
+DFBResult softCreateSurface(IDirectFB* thiz, const DFBSurfaceDescription* desc, IDirectFBSurface** interface)
+{
+	OsdSoftSurface* surface;
+	uint8_t primary = (desc->flags & DSDESC_CAPS) && (desc->caps & DSCAPS_PRIMARY);
+	uint8_t flipping = (desc->flags & DSDESC_CAPS) && (desc->caps & DSCAPS_FLIPPING);
+
+	surface = (OsdSoftSurface*)calloc(1, sizeof(OsdSoftSurface));
+	if (surface == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		return DFB_FAILURE;
+	}
+
+	surface->width = primary ? OSD_SOFT_SCREEN_WIDTH : 0;
+	surface->height = primary ? OSD_SOFT_SCREEN_HEIGHT : 0;
+	if (desc->flags & DSDESC_WIDTH)
+	{
+		surface->width = desc->width;
+	}
+	if (desc->flags & DSDESC_HEIGHT)
+	{
+		surface->height = desc->height;
+	}
+	if (surface->width <= 0 || surface->height <= 0)
+	{
+		printf("\n%s : ERROR surface size %dx%d\n", __FUNCTION__, surface->width, surface->height);
+		free(surface);
+		return DFB_FAILURE;
+	}
+
+	surface->pixels = (uint32_t*)calloc((size_t)surface->width * surface->height, sizeof(uint32_t));
+	if (flipping)
+	{
+		surface->frontPixels = (uint32_t*)calloc((size_t)surface->width * surface->height, sizeof(uint32_t));
+	}
+	if (surface->pixels == NULL || (flipping && surface->frontPixels == NULL))
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		free(surface->pixels);
+		free(surface->frontPixels);
+		free(surface);
+		return DFB_FAILURE;
+	}
+
+	surface->clip.x1 = 0;
+	surface->clip.y1 = 0;
+	surface->clip.x2 = surface->width - 1;
+	surface->clip.y2 = surface->height - 1;
+	surface->color = 0xffffffff;
+
+	surface->iface.Release = surfaceRelease;
+	surface->iface.GetSize = surfaceGetSize;
+	surface->iface.SetColor = surfaceSetColor;
+	surface->iface.SetClip = surfaceSetClip;
+	surface->iface.SetDrawingFlags = surfaceSetDrawingFlags;
+	surface->iface.SetBlittingFlags = surfaceSetBlittingFlags;
+	surface->iface.SetFont = surfaceSetFont;
+	surface->iface.Clear = surfaceClear;
+	surface->iface.FillRectangle = surfaceFillRectangle;
+	surface->iface.DrawString = surfaceDrawString;
+	surface->iface.Blit = surfaceBlit;
+	surface->iface.Flip = surfaceFlip;
+	surface->iface.Lock = surfaceLock;
+	surface->iface.Unlock = surfaceUnlock;
+
+	*interface = &surface->iface;
+	return DFB_OK;
+}
+
+DFBResult softCreateFont(IDirectFB* thiz, const char* fileName, const DFBFontDescription* desc, IDirectFBFont** interface)
+{
+	OsdSoftFont* font;
+
+	/* font file is not read, built in bitmap font is used for every file */
+	font = (OsdSoftFont*)calloc(1, sizeof(OsdSoftFont));
+	if (font == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		return DFB_FAILURE;
+	}
+
+	font->height = (desc != NULL && (desc->flags & DFDESC_HEIGHT)) ? desc->height : 24;
+	font->scale = font->height / OSD_SOFT_CELL_HEIGHT;
+	if (font->scale < 1)
+	{
+		font->scale = 1;
+	}
+
+	font->iface.Release = fontRelease;
+	font->iface.GetHeight = fontGetHeight;
+	font->iface.GetAscender = fontGetAscender;
+	font->iface.GetStringWidth = fontGetStringWidth;
+
+	*interface = &font->iface;
+	return DFB_OK;
+}
+
+DFBResult softCreateImageProvider(IDirectFB* thiz, const char* fileName, IDirectFBImageProvider** interface)
+{
+	OsdSoftImageProvider* provider;
+	png_image image;
+
+	memset(&image, 0x0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&image, fileName))
+	{
+		printf("\n%s : ERROR Cannot read %s: %s\n", __FUNCTION__, fileName, image.message);
+		return DFB_FAILURE;
+	}
+	image.format = OSD_SOFT_PNG_FORMAT;
+
+	provider = (OsdSoftImageProvider*)calloc(1, sizeof(OsdSoftImageProvider));
+	if (provider != NULL)
+	{
+		provider->pixels = (uint32_t*)malloc(PNG_IMAGE_SIZE(image));
+	}
+	if (provider == NULL || provider->pixels == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		png_image_free(&image);
+		free(provider);
+		return DFB_FAILURE;
+	}
+
+	/* image is decoded once here, RenderTo() only copies */
+	if (!png_image_finish_read(&image, NULL, provider->pixels, 0, NULL))
+	{
+		printf("\n%s : ERROR Cannot decode %s: %s\n", __FUNCTION__, fileName, image.message);
+		free(provider->pixels);
+		free(provider);
+		return DFB_FAILURE;
+	}
+	provider->width = image.width;
+	provider->height = image.height;
+
+	provider->iface.Release = providerRelease;
+	provider->iface.GetSurfaceDescription = providerGetSurfaceDescription;
+	provider->iface.RenderTo = providerRenderTo;
+
+	*interface = &provider->iface;
+	return DFB_OK;
+}
+
+DFBResult surfaceRelease(IDirectFBSurface* thiz)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+
+	free(surface->pixels);
+	free(surface->frontPixels);
+	free(surface);
+	return DFB_OK;
+}
+
+DFBResult surfaceGetSize(IDirectFBSurface* thiz, int* width, int* height)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+
+	*width = surface->width;
+	*height = surface->height;
+	return DFB_OK;
+}
+
+DFBResult surfaceSetColor(IDirectFBSurface* thiz, u8 r, u8 g, u8 b, u8 a)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+
+	surface->color = ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+	return DFB_OK;
+}
+
+DFBResult surfaceSetClip(IDirectFBSurface* thiz, const DFBRegion* clip)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+
+	surface->clip.x1 = 0;
+	surface->clip.y1 = 0;
+	surface->clip.x2 = surface->width - 1;
+	surface->clip.y2 = surface->height - 1;
+	if (clip == NULL)
+	{
+		return DFB_OK;
+	}
+
+	surface->clip.x1 = (clip->x1 > 0) ? clip->x1 : 0;
+	surface->clip.y1 = (clip->y1 > 0) ? clip->y1 : 0;
+	surface->clip.x2 = (clip->x2 < surface->width - 1) ? clip->x2 : surface->width - 1;
+	surface->clip.y2 = (clip->y2 < surface->height - 1) ? clip->y2 : surface->height - 1;
+	return DFB_OK;
+}
+
+DFBResult surfaceSetDrawingFlags(IDirectFBSurface* thiz, DFBSurfaceDrawingFlags flags)
+{
+	((OsdSoftSurface*)thiz)->drawingFlags = flags;
+	return DFB_OK;
+}
+
+DFBResult surfaceSetBlittingFlags(IDirectFBSurface* thiz, DFBSurfaceBlittingFlags flags)
+{
+	((OsdSoftSurface*)thiz)->blittingFlags = flags;
+	return DFB_OK;
+}
+
+DFBResult surfaceSetFont(IDirectFBSurface* thiz, IDirectFBFont* font)
+{
+	((OsdSoftSurface*)thiz)->font = (OsdSoftFont*)font;
+	return DFB_OK;
+}
+
+DFBResult surfaceClear(IDirectFBSurface* thiz, u8 r, u8 g, u8 b, u8 a)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+	int32_t x = 0;
+	int32_t y = 0;
+	int32_t w = surface->width;
+	int32_t h = surface->height;
+
+	if (softClipRectangle(surface, &x, &y, &w, &h))
+	{
+		softFill(surface, x, y, w, h, ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b, 0);
+	}
+	return DFB_OK;
+}
+
+DFBResult surfaceFillRectangle(IDirectFBSurface* thiz, int x, int y, int w, int h)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+	int32_t fillX = x;
+	int32_t fillY = y;
+	int32_t fillW = w;
+	int32_t fillH = h;
+
+	if (softClipRectangle(surface, &fillX, &fillY, &fillW, &fillH))
+	{
+		softFill(surface, fillX, fillY, fillW, fillH, surface->color, (surface->drawingFlags & DSDRAW_BLEND) != 0);
+	}
+	return DFB_OK;
+}
+
+DFBResult surfaceDrawString(IDirectFBSurface* thiz, const char* text, int bytes, int x, int y, DFBSurfaceTextFlags flags)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+	OsdSoftFont* font = surface->font;
+	const uint8_t* glyph;
+	int32_t length;
+	int32_t top;
+	int32_t i;
+	int32_t row;
+	int32_t column;
+	int32_t runStart;
+	int32_t runX;
+	int32_t runY;
+	int32_t runW;
+	int32_t runH;
+
+	if (font == NULL)
+	{
+		printf("\n%s : ERROR no font set\n", __FUNCTION__);
+		return DFB_FAILURE;
+	}
+
+	length = (bytes < 0) ? (int32_t)strlen(text) : bytes;
+	top = (flags & DSTF_TOP) ? y : y - OSD_SOFT_GLYPH_HEIGHT * font->scale;
+
+	for (i = 0; i < length; i++)
+	{
+		if (text[i] >= OSD_SOFT_GLYPH_FIRST && text[i] <= OSD_SOFT_GLYPH_LAST)
+		{
+			glyph = glyphs[text[i] - OSD_SOFT_GLYPH_FIRST];
+		}
+		else
+		{
+			glyph = glyphs['?' - OSD_SOFT_GLYPH_FIRST];
+		}
+
+		/* horizontal runs of set glyph pixels are filled as one scaled rectangle */
+		for (row = 0; row < OSD_SOFT_GLYPH_HEIGHT; row++)
+		{
+			column = 0;
+			while (column < OSD_SOFT_GLYPH_WIDTH)
+			{
+				if (!(glyph[row] & (0x10 >> column)))
+				{
+					column++;
+					continue;
+				}
+				runStart = column;
+				while (column < OSD_SOFT_GLYPH_WIDTH && (glyph[row] & (0x10 >> column)))
+				{
+					column++;
+				}
+
+				runX = x + (i * OSD_SOFT_CELL_WIDTH + runStart) * font->scale;
+				runY = top + row * font->scale;
+				runW = (column - runStart) * font->scale;
+				runH = font->scale;
+				if (softClipRectangle(surface, &runX, &runY, &runW, &runH))
+				{
+					softFill(surface, runX, runY, runW, runH, surface->color, (surface->color >> 24) != 0xff);
+				}
+			}
+		}
+	}
+
+	return DFB_OK;
+}
+
+DFBResult surfaceBlit(IDirectFBSurface* thiz, IDirectFBSurface* source, const DFBRectangle* sourceRect, int x, int y)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+	OsdSoftSurface* sourceSurface = (OsdSoftSurface*)source;
+	const OsdPixelKernels* kernels = osdPixelKernels();
+	const uint32_t* sourceRow;
+	uint32_t* destinationRow;
+	int32_t sourceX = 0;
+	int32_t sourceY = 0;
+	int32_t w = sourceSurface->width;
+	int32_t h = sourceSurface->height;
+	int32_t destinationX = x;
+	int32_t destinationY = y;
+	int32_t row;
+	int32_t step;
+
+	if (sourceRect != NULL)
+	{
+		sourceX = sourceRect->x;
+		sourceY = sourceRect->y;
+		w = sourceRect->w;
+		h = sourceRect->h;
+	}
+
+	/* clipping at destination moves source origin by the same amount */
+	if (!softClipRectangle(surface, &destinationX, &destinationY, &w, &h))
+	{
+		return DFB_OK;
+	}
+	sourceX += destinationX - x;
+	sourceY += destinationY - y;
+	if (sourceX < 0 || sourceY < 0 || sourceX + w > sourceSurface->width || sourceY + h > sourceSurface->height)
+	{
+		printf("\n%s : ERROR source rectangle outside of surface\n", __FUNCTION__);
+		return DFB_FAILURE;
+	}
+
+	/* scrolling inside one surface copies rows in direction that does not overwrite source */
+	row = 0;
+	step = 1;
+	if (sourceSurface == surface && destinationY > sourceY)
+	{
+		row = h - 1;
+		step = -1;
+	}
+
+	for (; row >= 0 && row < h; row += step)
+	{
+		sourceRow = sourceSurface->pixels + (size_t)(sourceY + row) * sourceSurface->width + sourceX;
+		destinationRow = surface->pixels + (size_t)(destinationY + row) * surface->width + destinationX;
+		if (surface->blittingFlags & DSBLIT_BLEND_ALPHACHANNEL)
+		{
+			kernels->blend(destinationRow, sourceRow, w);
+		}
+		else
+		{
+			memmove(destinationRow, sourceRow, w * sizeof(uint32_t));
+		}
+	}
+
+	return DFB_OK;
+}
+
+DFBResult surfaceFlip(IDirectFBSurface* thiz, const DFBRegion* region, DFBSurfaceFlipFlags flags)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+	int32_t x = 0;
+	int32_t y = 0;
+	int32_t w = surface->width;
+	int32_t h = surface->height;
+	int32_t row;
+
+	if (surface->frontPixels == NULL)
+	{
+		return DFB_OK;
+	}
+
+	if (region != NULL)
+	{
+		x = (region->x1 > 0) ? region->x1 : 0;
+		y = (region->y1 > 0) ? region->y1 : 0;
+		w = ((region->x2 < surface->width - 1) ? region->x2 : surface->width - 1) - x + 1;
+		h = ((region->y2 < surface->height - 1) ? region->y2 : surface->height - 1) - y + 1;
+	}
+
+	/* back buffer is copied, not swapped, so it keeps the complete frame */
+	for (row = y; row < y + h && w > 0; row++)
+	{
+		memcpy(surface->frontPixels + (size_t)row * surface->width + x, surface->pixels + (size_t)row * surface->width + x,
+		       w * sizeof(uint32_t));
+	}
+
+	return DFB_OK;
+}
+
+DFBResult surfaceLock(IDirectFBSurface* thiz, DFBSurfaceLockFlags flags, void** pointer, int* pitch)
+{
+	OsdSoftSurface* surface = (OsdSoftSurface*)thiz;
+
+	*pointer = surface->pixels;
+	*pitch = surface->width * sizeof(uint32_t);
+	return DFB_OK;
+}
+
+DFBResult surfaceUnlock(IDirectFBSurface* thiz)
+{
+	return DFB_OK;
+}
+
+DFBResult fontRelease(IDirectFBFont* thiz)
+{
+	free(thiz);
+	return DFB_OK;
+}
+
+DFBResult fontGetHeight(IDirectFBFont* thiz, int* height)
+{
+	*height = ((OsdSoftFont*)thiz)->height;
+	return DFB_OK;
+}
+
+DFBResult fontGetAscender(IDirectFBFont* thiz, int* ascender)
+{
+	*ascender = OSD_SOFT_GLYPH_HEIGHT * ((OsdSoftFont*)thiz)->scale;
+	return DFB_OK;
+}
+
+DFBResult fontGetStringWidth(IDirectFBFont* thiz, const char* text, int bytes, int* width)
+{
+	int32_t length = (bytes < 0) ? (int32_t)strlen(text) : bytes;
+
+	*width = length * OSD_SOFT_CELL_WIDTH * ((OsdSoftFont*)thiz)->scale;
+	return DFB_OK;
+}
+
+DFBResult providerRelease(IDirectFBImageProvider* thiz)
+{
+	OsdSoftImageProvider* provider = (OsdSoftImageProvider*)thiz;
+
+	free(provider->pixels);
+	free(provider);
+	return DFB_OK;
+}
+
+DFBResult providerGetSurfaceDescription(IDirectFBImageProvider* thiz, DFBSurfaceDescription* desc)
+{
+	OsdSoftImageProvider* provider = (OsdSoftImageProvider*)thiz;
+
+	memset(desc, 0x0, sizeof(DFBSurfaceDescription));
+	desc->flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+	desc->width = provider->width;
+	desc->height = provider->height;
+	desc->pixelformat = DSPF_ARGB;
+	return DFB_OK;
+}
+
+DFBResult providerRenderTo(IDirectFBImageProvider* thiz, IDirectFBSurface* destination, const DFBRectangle* destinationRect)
+{
+	OsdSoftImageProvider* provider = (OsdSoftImageProvider*)thiz;
+	OsdSoftSurface* surface = (OsdSoftSurface*)destination;
+	DFBRectangle rect = {0, 0, surface->width, surface->height};
+	int32_t x;
+	int32_t y;
+
+	if (destinationRect != NULL)
+	{
+		rect = *destinationRect;
+	}
+	if (rect.x < 0 || rect.y < 0 || rect.x + rect.w > surface->width || rect.y + rect.h > surface->height)
+	{
+		printf("\n%s : ERROR destination rectangle outside of surface\n", __FUNCTION__);
+		return DFB_FAILURE;
+	}
+
+	/* image is scaled to destination rectangle, nearest pixel */
+	for (y = 0; y < rect.h; y++)
+	{
+		for (x = 0; x < rect.w; x++)
+		{
+			surface->pixels[(size_t)(rect.y + y) * surface->width + rect.x + x] =
+				provider->pixels[(size_t)(y * provider->height / rect.h) * provider->width + x * provider->width / rect.w];
+		}
+	}
+
+	return DFB_OK;
+}
+
+uint8_t softClipRectangle(const OsdSoftSurface* surface, int32_t* x, int32_t* y, int32_t* w, int32_t* h)
+{
+	int32_t x2 = *x + *w - 1;
+	int32_t y2 = *y + *h - 1;
+
+	if (*x < surface->clip.x1)
+	{
+		*x = surface->clip.x1;
+	}
+	if (*y < surface->clip.y1)
+	{
+		*y = surface->clip.y1;
+	}
+	if (x2 > surface->clip.x2)
+	{
+		x2 = surface->clip.x2;
+	}
+	if (y2 > surface->clip.y2)
+	{
+		y2 = surface->clip.y2;
+	}
+
+	*w = x2 - *x + 1;
+	*h = y2 - *y + 1;
+	return *w > 0 && *h > 0;
+}
+
+void softFill(OsdSoftSurface* surface, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color, uint8_t blend)
+{
+	const OsdPixelKernels* kernels = osdPixelKernels();
+	uint32_t* row;
+	int32_t j;
+
+	for (j = 0; j < h; j++)
+	{
+		row = surface->pixels + (size_t)(y + j) * surface->width + x;
+		if (blend)
+		{
+			kernels->fillBlend(row, w, color);
+		}
+		else
+		{
+			kernels->fill(row, w, color);
+		}
+	}
+}
+
+#endif /* OSD_BACKEND_SOFT */
@@ -0,0 +1,35 @@
+#ifndef __OSD_SOFT_H__
+#define __OSD_SOFT_H__
+
+#include <directfb.h>
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define OSD_SOFT_SCREEN_WIDTH   1920        /* Size of primary surface, there is no display to ask */
+#define OSD_SOFT_SCREEN_HEIGHT  1080
+
+/**
+ * @brief - Creates software implementation of the DirectFB interfaces used by OSD.
+ *
+ * Surfaces are ARGB8888 buffers in memory, a flipping primary surface has a front and a back buffer.
+ * Fonts are a built in 5x7 bitmap font scaled to the requested height, images are PNG files decoded
+ * with libpng. No display, no DirectFB library and no font files are needed.
+ *
+ * @param [out] interface - DirectFB interface
+ *
+ * @return - DirectFB result
+ */
+DFBResult osdSoftCreate(IDirectFB** interface);
+
+/**
+ * @brief - Writes surface to PNG file, front buffer of flipping surface is written.
+ *
+ * @param [in] surface - Surface created by osdSoftCreate() interface
+ * @param [in] fileName - PNG file name
+ *
+ * @return - DirectFB result
+ */
+DFBResult osdSoftDumpSurface(IDirectFBSurface* surface, const char* fileName);
+
+#endif /* __OSD_SOFT_H__ */
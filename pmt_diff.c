@@ -0,0 +1,171 @@
+#include "pmt_diff.h"
+
+/* Statistics */
+static uint32_t diffCount = 0;
+static uint32_t noneCount = 0;
+static uint32_t videoCount = 0;
+static uint32_t audioCount = 0;
+static uint32_t pcrCount = 0;
+static uint32_t caCount = 0;
+static uint32_t descriptorCount = 0;
+static uint32_t streamsCount = 0;
+
+/**
+ * @brief - Finds elementary stream with pid.
+ *
+ * @return - Elementary info, NULL if pid is not in PMT
+ */
+static const PmtElementaryInfo* pmtFindElementaryInfo(const PmtTable* pmtTable, uint16_t elementaryPid);
+
+void pmtSelectStreams(const PmtTable* pmtTable, PmtSelection* selection)
+{
+	const PmtElementaryInfo* elementaryInfo;
+	uint8_t i;
+
+	selection->videoPid = -1;
+	selection->audioPid = -1;
+	selection->videoType = 0;
+	selection->audioType = 0;
+	selection->hasTeletext = 0;
+	selection->hasCaDescriptor = pmtTable->pmtHeader.hasCaDescriptor;
+
+	for (i = 0; i < pmtTable->elementaryInfoCount; i++)
+	{
+		elementaryInfo = &pmtTable->pmtElementaryInfoArray[i];
+		if (((elementaryInfo->streamType == 0x1) || (elementaryInfo->streamType == 0x2) || (elementaryInfo->streamType == 0x1b))
+		    && (selection->videoPid == -1))
+		{
+			selection->videoPid = elementaryInfo->elementaryPid;
+			selection->videoType = elementaryInfo->streamType;
+		}
+		else if (((elementaryInfo->streamType == 0x3) || (elementaryInfo->streamType == 0x4))
+		         && (selection->audioPid == -1))
+		{
+			selection->audioPid = elementaryInfo->elementaryPid;
+			selection->audioType = elementaryInfo->streamType;
+		}
+
+		if (elementaryInfo->teletext == 1)
+		{
+			selection->hasTeletext = 1;
+		}
+		if (elementaryInfo->hasCaDescriptor)
+		{
+			selection->hasCaDescriptor = 1;
+		}
+	}
+}
+
+uint8_t pmtDiff(const PmtTable* oldTable, const PmtTable* newTable)
+{
+	PmtSelection oldSelection;
+	PmtSelection newSelection;
+	const PmtElementaryInfo* oldInfo;
+	uint8_t diff = PMT_DIFF_NONE;
+	uint8_t i;
+
+	diffCount++;
+
+	if (oldTable == NULL)
+	{
+		/* nothing is played yet, everything is new */
+		diff = PMT_DIFF_RESTART_MASK | PMT_DIFF_PCR;
+		videoCount++;
+		audioCount++;
+		caCount++;
+		pcrCount++;
+		return diff;
+	}
+
+	pmtSelectStreams(oldTable, &oldSelection);
+	pmtSelectStreams(newTable, &newSelection);
+
+	if (oldSelection.videoPid != newSelection.videoPid || oldSelection.videoType != newSelection.videoType)
+	{
+		diff |= PMT_DIFF_VIDEO;
+		videoCount++;
+	}
+	if (oldSelection.audioPid != newSelection.audioPid || oldSelection.audioType != newSelection.audioType)
+	{
+		diff |= PMT_DIFF_AUDIO;
+		audioCount++;
+	}
+	if (oldTable->pmtHeader.pcrPid != newTable->pmtHeader.pcrPid)
+	{
+		diff |= PMT_DIFF_PCR;
+		pcrCount++;
+	}
+	if (oldSelection.hasCaDescriptor != newSelection.hasCaDescriptor ||
+	    oldTable->pmtHeader.caSystemId != newTable->pmtHeader.caSystemId)
+	{
+		diff |= PMT_DIFF_CA;
+		caCount++;
+	}
+
+	/* streams of new version are looked up in old one, a stream missing in new version changes the count */
+	if (oldTable->elementaryInfoCount != newTable->elementaryInfoCount)
+	{
+		diff |= PMT_DIFF_STREAMS;
+	}
+	if (oldTable->pmtHeader.programInfoLength != newTable->pmtHeader.programInfoLength)
+	{
+		diff |= PMT_DIFF_DESCRIPTORS;
+	}
+	for (i = 0; i < newTable->elementaryInfoCount; i++)
+	{
+		oldInfo = pmtFindElementaryInfo(oldTable, newTable->pmtElementaryInfoArray[i].elementaryPid);
+		if (oldInfo == NULL || oldInfo->streamType != newTable->pmtElementaryInfoArray[i].streamType)
+		{
+			diff |= PMT_DIFF_STREAMS;
+		}
+		else if (oldInfo->esInfoLength != newTable->pmtElementaryInfoArray[i].esInfoLength ||
+		         oldInfo->teletext != newTable->pmtElementaryInfoArray[i].teletext)
+		{
+			diff |= PMT_DIFF_DESCRIPTORS;
+		}
+	}
+
+	if (diff & PMT_DIFF_STREAMS)
+	{
+		streamsCount++;
+	}
+	if (diff & PMT_DIFF_DESCRIPTORS)
+	{
+		descriptorCount++;
+	}
+	if (diff == PMT_DIFF_NONE)
+	{
+		noneCount++;
+	}
+
+	return diff;
+}
+
+void printPmtDiffStats(void)
+{
+	printf("\n********************PMT CHANGES********************\n");
+	printf("PMT versions compared    |      %u\n", diffCount);
+	printf("nothing relevant         |      %u\n", noneCount);
+	printf("video changed            |      %u\n", videoCount);
+	printf("audio changed            |      %u\n", audioCount);
+	printf("PCR pid changed          |      %u\n", pcrCount);
+	printf("CA signalling changed    |      %u\n", caCount);
+	printf("descriptors changed      |      %u\n", descriptorCount);
+	printf("other streams changed    |      %u\n", streamsCount);
+	printf("\n********************PMT CHANGES********************\n");
+}
+
+const PmtElementaryInfo* pmtFindElementaryInfo(const PmtTable* pmtTable, uint16_t elementaryPid)
+{
+	uint8_t i;
+
+	for (i = 0; i < pmtTable->elementaryInfoCount; i++)
+	{
+		if (pmtTable->pmtElementaryInfoArray[i].elementaryPid == elementaryPid)
+		{
+			return &pmtTable->pmtElementaryInfoArray[i];
+		}
+	}
+
+	return NULL;
+}
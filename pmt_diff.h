@@ -0,0 +1,57 @@
+#ifndef __PMT_DIFF_H__
+#define __PMT_DIFF_H__
+
+#include "tables.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Changes between two PMT versions, combined as bit mask */
+#define PMT_DIFF_NONE           0x00            /* Nothing relevant for playback */
+#define PMT_DIFF_VIDEO          0x01            /* Pid or stream type of selected video changed */
+#define PMT_DIFF_AUDIO          0x02            /* Pid or stream type of selected audio changed */
+#define PMT_DIFF_PCR            0x04            /* PCR pid changed */
+#define PMT_DIFF_CA             0x08            /* CA descriptor added or removed, scrambling has to be checked again */
+#define PMT_DIFF_DESCRIPTORS    0x10            /* Only descriptors of streams changed, e.g. teletext */
+#define PMT_DIFF_STREAMS        0x20            /* Streams that are not played were added or removed */
+
+/* Streams that have to be recreated because of a change */
+#define PMT_DIFF_RESTART_MASK   (PMT_DIFF_VIDEO | PMT_DIFF_AUDIO | PMT_DIFF_CA)
+
+/**
+ * @brief Structure that defines elementary streams played from one PMT version
+ */
+typedef struct _PmtSelection
+{
+	int16_t videoPid;                           /* -1 if none */
+	int16_t audioPid;                           /* -1 if none */
+	uint8_t videoType;
+	uint8_t audioType;
+	uint8_t hasTeletext;
+	uint8_t hasCaDescriptor;                    /* Program level or any elementary stream level CA descriptor */
+}PmtSelection;
+
+/**
+ * @brief Selects first video (MPEG-1/2, H.264) and first audio (MPEG-1/2) stream of PMT
+ *
+ * @param [in] pmtTable - PMT table
+ * @param [out] selection - Selected streams
+ */
+void pmtSelectStreams(const PmtTable* pmtTable, PmtSelection* selection);
+
+/**
+ * @brief Compares two versions of PMT of one program and classifies the change
+ *
+ * @param [in] oldTable - PMT version played so far, NULL if none
+ * @param [in] newTable - New PMT version
+ * @return Bit mask of PMT_DIFF_ flags, PMT_DIFF_NONE if nothing relevant changed
+ */
+uint8_t pmtDiff(const PmtTable* oldTable, const PmtTable* newTable);
+
+/**
+ * @brief Prints number of classified PMT changes
+ */
+void printPmtDiffStats(void);
+
+#endif /* __PMT_DIFF_H__ */
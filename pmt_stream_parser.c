@@ -0,0 +1,388 @@
+#include "pmt_stream_parser.h"
+
+#define CRC32_POLYNOMIAL    0x04C11DB7
+
+static uint32_t crcTable[256];
+static uint8_t crcTableReady = 0;
+
+/**
+ * @brief - Starts new section at current byte.
+ */
+static void pmtStreamParserStart(PmtStreamParser* parser);
+
+/**
+ * @brief - Consumes bytes of current section, stops at section end.
+ *
+ * @return - Number of consumed bytes
+ */
+static uint32_t pmtStreamParserFeedBytes(PmtStreamParser* parser, const uint8_t* data, uint32_t length);
+
+/**
+ * @brief - Checks header, decides if section is parsed or skipped.
+ */
+static void pmtStreamParserHeaderDone(PmtStreamParser* parser);
+
+/**
+ * @brief - Reports complete elementary stream loop entry.
+ */
+static void pmtStreamParserEntryDone(PmtStreamParser* parser);
+
+/**
+ * @brief - Checks CRC of complete section.
+ */
+static void pmtStreamParserEnd(PmtStreamParser* parser);
+
+/**
+ * @brief - Drops section in progress, reported streams are revoked.
+ */
+static void pmtStreamParserAbort(PmtStreamParser* parser);
+
+void pmtStreamParserInit(PmtStreamParser* parser, uint16_t pid, uint16_t programNumber, const PmtStreamParserOps* ops)
+{
+	parser->pid = pid;
+	parser->programNumber = programNumber;
+	parser->skipVersion = 0xFF;
+	parser->lastContinuityCounter = 0xFF;
+	parser->state = PMT_STREAM_IDLE;
+	parser->ops = ops;
+}
+
+void pmtStreamParserFeedPacket(PmtStreamParser* parser, const uint8_t* packet)
+{
+	uint16_t pid;
+	uint8_t adaptationFieldControl;
+	uint8_t continuityCounter;
+	uint32_t offset = 4;
+	uint8_t pointer;
+
+	if (parser->ops == NULL || packet[0] != TS_SYNC_BYTE)
+	{
+		return;
+	}
+
+	pid = (uint16_t) (((packet[1] & 0x1F) << 8) + packet[2]);
+	if (pid != parser->pid)
+	{
+		return;
+	}
+
+	/* transport_error_indicator */
+	if (packet[1] & 0x80)
+	{
+		pmtStreamParserAbort(parser);
+		return;
+	}
+
+	/* counter is not incremented by packets without payload */
+	adaptationFieldControl = (packet[3] >> 4) & 0x03;
+	if (!(adaptationFieldControl & 0x01))
+	{
+		return;
+	}
+
+	continuityCounter = packet[3] & 0x0F;
+	if (parser->lastContinuityCounter != 0xFF)
+	{
+		if (continuityCounter == parser->lastContinuityCounter)
+		{
+			/* duplicate packet */
+			return;
+		}
+		if (continuityCounter != ((parser->lastContinuityCounter + 1) & 0x0F))
+		{
+			/* lost packet, section in progress can never be completed */
+			pmtStreamParserAbort(parser);
+		}
+	}
+	parser->lastContinuityCounter = continuityCounter;
+
+	if (adaptationFieldControl & 0x02)
+	{
+		offset += 1 + packet[4];
+	}
+	if (offset >= TS_PACKET_SIZE)
+	{
+		return;
+	}
+
+	if (!(packet[1] & 0x40))
+	{
+		/* continuation of section started in previous packet */
+		if (parser->state != PMT_STREAM_IDLE)
+		{
+			pmtStreamParserFeedBytes(parser, packet + offset, TS_PACKET_SIZE - offset);
+		}
+		return;
+	}
+
+	/* payload_unit_start_indicator, pointer_field gives start of new section */
+	pointer = packet[offset];
+	offset++;
+	if (offset + pointer >= TS_PACKET_SIZE)
+	{
+		pmtStreamParserAbort(parser);
+		return;
+	}
+
+	if (parser->state != PMT_STREAM_IDLE)
+	{
+		pmtStreamParserFeedBytes(parser, packet + offset, pointer);
+
+		/* section_length said previous section goes on */
+		if (parser->state != PMT_STREAM_IDLE)
+		{
+			pmtStreamParserAbort(parser);
+		}
+	}
+	offset += pointer;
+
+	/* several sections can follow each other until stuffing */
+	while (offset < TS_PACKET_SIZE && packet[offset] != 0xFF)
+	{
+		pmtStreamParserStart(parser);
+		offset += pmtStreamParserFeedBytes(parser, packet + offset, TS_PACKET_SIZE - offset);
+
+		/* section continues in next packet, or was aborted and rest of payload is unusable */
+		if (parser->state != PMT_STREAM_IDLE || parser->position != parser->esLoopEnd + 4)
+		{
+			break;
+		}
+	}
+}
+
+uint32_t pmtStreamParserCrc32(uint32_t crc, const uint8_t* data, uint32_t length)
+{
+	uint32_t value;
+	uint32_t i;
+	uint8_t bit;
+
+	if (!crcTableReady)
+	{
+		for (i = 0; i < 256; i++)
+		{
+			value = i << 24;
+			for (bit = 0; bit < 8; bit++)
+			{
+				value = (value & 0x80000000) ? (value << 1) ^ CRC32_POLYNOMIAL : (value << 1);
+			}
+			crcTable[i] = value;
+		}
+		crcTableReady = 1;
+	}
+
+	for (i = 0; i < length; i++)
+	{
+		crc = (crc << 8) ^ crcTable[((crc >> 24) ^ data[i]) & 0xFF];
+	}
+
+	return crc;
+}
+
+void printPmtStreamParserStats(const char* name, const PmtStreamParser* parser)
+{
+	printf("\n********************PMT STREAM PARSER %s********************\n", name);
+	printf("pid                      |      %d\n", parser->pid);
+	printf("sections completed       |      %u\n", parser->sectionCount);
+	printf("crc errors               |      %u\n", parser->crcErrorCount);
+	printf("sections aborted         |      %u\n", parser->abortCount);
+	printf("streams reported early   |      %u\n", parser->emittedTotal);
+	printf("\n********************PMT STREAM PARSER %s********************\n", name);
+}
+
+void pmtStreamParserStart(PmtStreamParser* parser)
+{
+	parser->state = PMT_STREAM_HEADER;
+	parser->position = 0;
+	parser->esLoopEnd = 0;
+	parser->crc = 0xFFFFFFFF;
+	parser->entryUsed = 0;
+	parser->entrySize = 0;
+	parser->emittedCount = 0;
+}
+
+uint32_t pmtStreamParserFeedBytes(PmtStreamParser* parser, const uint8_t* data, uint32_t length)
+{
+	uint32_t used = 0;
+	uint32_t count;
+	uint32_t wanted;
+
+	while (used < length && parser->state != PMT_STREAM_IDLE)
+	{
+		switch (parser->state)
+		{
+			case PMT_STREAM_HEADER:
+				wanted = PMT_STREAM_PARSER_HEADER_SIZE - parser->position;
+				count = (length - used < wanted) ? length - used : wanted;
+				memcpy(parser->header + parser->position, data + used, count);
+				break;
+			case PMT_STREAM_PROGRAM_INFO:
+			case PMT_STREAM_ES_LOOP:
+				if (parser->state == PMT_STREAM_PROGRAM_INFO)
+				{
+					wanted = parser->pmtHeader.programInfoLength - parser->entryUsed;
+				}
+				else
+				{
+					/* size of entry is known after its first 5 bytes */
+					wanted = (parser->entrySize != 0 ? parser->entrySize : 5) - parser->entryUsed;
+				}
+				count = (length - used < wanted) ? length - used : wanted;
+				memcpy(parser->entry + parser->entryUsed, data + used, count);
+				parser->entryUsed += count;
+				break;
+			default:
+				/* CRC and skipped section */
+				wanted = parser->esLoopEnd + 4 - parser->position;
+				count = (length - used < wanted) ? length - used : wanted;
+				break;
+		}
+
+		if (parser->state != PMT_STREAM_SKIP)
+		{
+			parser->crc = pmtStreamParserCrc32(parser->crc, data + used, count);
+		}
+		parser->position += count;
+		used += count;
+
+		switch (parser->state)
+		{
+			case PMT_STREAM_HEADER:
+				if (parser->position == PMT_STREAM_PARSER_HEADER_SIZE)
+				{
+					pmtStreamParserHeaderDone(parser);
+				}
+				break;
+			case PMT_STREAM_PROGRAM_INFO:
+				if (parser->entryUsed == parser->pmtHeader.programInfoLength)
+				{
+					parsePmtProgramInfo(parser->entry, &parser->pmtHeader);
+					parser->ops->header(&parser->pmtHeader);
+					parser->entryUsed = 0;
+					parser->state = (parser->position < parser->esLoopEnd) ? PMT_STREAM_ES_LOOP : PMT_STREAM_CRC;
+				}
+				break;
+			case PMT_STREAM_ES_LOOP:
+				if (parser->entrySize == 0 && parser->entryUsed == 5)
+				{
+					parser->entrySize = 5 + ((((parser->entry[3] << 8) + parser->entry[4])) & 0x0FFF);
+					if (parser->position - 5 + parser->entrySize > parser->esLoopEnd)
+					{
+						pmtStreamParserAbort(parser);
+						break;
+					}
+				}
+				if (parser->entrySize != 0 && parser->entryUsed == parser->entrySize)
+				{
+					pmtStreamParserEntryDone(parser);
+				}
+				break;
+			case PMT_STREAM_CRC:
+				if (parser->position == parser->esLoopEnd + 4)
+				{
+					pmtStreamParserEnd(parser);
+				}
+				break;
+			case PMT_STREAM_SKIP:
+				if (parser->position == parser->esLoopEnd + 4)
+				{
+					parser->state = PMT_STREAM_IDLE;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	return used;
+}
+
+void pmtStreamParserHeaderDone(PmtStreamParser* parser)
+{
+	uint16_t sectionLength;
+
+	sectionLength = (uint16_t) (((parser->header[1] << 8) + parser->header[2]) & 0x0FFF);
+	if (parser->header[0] != 0x02 || sectionLength < 13 || sectionLength > 1021)
+	{
+		pmtStreamParserAbort(parser);
+		return;
+	}
+
+	parsePmtHeader(parser->header, &parser->pmtHeader);
+	parser->esLoopEnd = 3 + sectionLength - 4;
+	if (PMT_STREAM_PARSER_HEADER_SIZE + parser->pmtHeader.programInfoLength > parser->esLoopEnd)
+	{
+		pmtStreamParserAbort(parser);
+		return;
+	}
+
+	/* PMT pid can be shared by several programs, confirmed version is not parsed again */
+	if (parser->pmtHeader.programNumber != parser->programNumber || !parser->pmtHeader.currentNextIndicator ||
+	    parser->pmtHeader.versionNumber == parser->skipVersion)
+	{
+		parser->state = PMT_STREAM_SKIP;
+		return;
+	}
+
+	if (parser->pmtHeader.programInfoLength != 0)
+	{
+		parser->state = PMT_STREAM_PROGRAM_INFO;
+		return;
+	}
+
+	parsePmtProgramInfo(parser->entry, &parser->pmtHeader);
+	parser->ops->header(&parser->pmtHeader);
+	parser->state = (parser->position < parser->esLoopEnd) ? PMT_STREAM_ES_LOOP : PMT_STREAM_CRC;
+}
+
+void pmtStreamParserEntryDone(PmtStreamParser* parser)
+{
+	PmtElementaryInfo elementaryInfo;
+
+	parsePmtElementaryInfo(parser->entry, &elementaryInfo);
+	parser->ops->elementaryStream(&elementaryInfo);
+	parser->emittedCount++;
+	parser->emittedTotal++;
+
+	parser->entryUsed = 0;
+	parser->entrySize = 0;
+	if (parser->position == parser->esLoopEnd)
+	{
+		parser->state = PMT_STREAM_CRC;
+	}
+}
+
+void pmtStreamParserEnd(PmtStreamParser* parser)
+{
+	parser->state = PMT_STREAM_IDLE;
+	parser->sectionCount++;
+
+	if (parser->crc == 0)
+	{
+		parser->skipVersion = parser->pmtHeader.versionNumber;
+		parser->ops->sectionEnd(1);
+	}
+	else
+	{
+		parser->crcErrorCount++;
+		parser->ops->sectionEnd(0);
+	}
+}
+
+void pmtStreamParserAbort(PmtStreamParser* parser)
+{
+	PmtStreamState state = parser->state;
+
+	parser->state = PMT_STREAM_IDLE;
+	if (state == PMT_STREAM_IDLE || state == PMT_STREAM_SKIP)
+	{
+		return;
+	}
+
+	parser->abortCount++;
+
+	/* header was reported, everything reported after it is revoked */
+	if (state != PMT_STREAM_HEADER && state != PMT_STREAM_PROGRAM_INFO)
+	{
+		parser->ops->sectionEnd(0);
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef __PMT_STREAM_PARSER_H__
+#define __PMT_STREAM_PARSER_H__
+
+#include "tables.h"
+#include "ts_monitor.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PMT_STREAM_PARSER_HEADER_SIZE   12              /* table_id to program_info_length */
+#define PMT_STREAM_PARSER_ENTRY_SIZE    1024            /* Program info or elementary stream loop entry, max section is 1024 bytes */
+#define PMT_STREAM_PARSER_NO_PID        TS_MAX_PID      /* Pid of parser that gets no packets */
+
+/**
+ * @brief Enumeration of PMT stream parser states
+ */
+typedef enum _PmtStreamState
+{
+	PMT_STREAM_IDLE = 0,                        /* Waiting for payload_unit_start_indicator */
+	PMT_STREAM_HEADER,
+	PMT_STREAM_PROGRAM_INFO,
+	PMT_STREAM_ES_LOOP,
+	PMT_STREAM_CRC,
+	PMT_STREAM_SKIP                             /* Section of other program or already confirmed version */
+}PmtStreamState;
+
+/**
+ * @brief Structure that defines notifications of PMT stream parser
+ *
+ * Called from thread that feeds packets. Elementary streams are reported as soon as
+ * their loop entry is complete, section end confirms or revokes all of them.
+ */
+typedef struct _PmtStreamParserOps
+{
+	void (*header)(const PmtTableHeader* pmtHeader);                    /* Header and program info descriptors complete */
+	void (*elementaryStream)(const PmtElementaryInfo* elementaryInfo);  /* Loop entry complete, not yet confirmed */
+	void (*sectionEnd)(uint8_t crcOk);                                  /* 0 for CRC error or lost packet */
+}PmtStreamParserOps;
+
+/**
+ * @brief Structure that defines resumable PMT parser of one pid
+ */
+typedef struct _PmtStreamParser
+{
+	const PmtStreamParserOps* ops;
+	uint16_t pid;
+	uint16_t programNumber;                     /* Sections of other programs on same pid are skipped */
+	uint8_t skipVersion;                        /* Version confirmed last, its repetitions are skipped, 0xFF for none */
+	uint8_t lastContinuityCounter;              /* 0xFF for none */
+	PmtStreamState state;
+	uint16_t position;                          /* Bytes of current section consumed */
+	uint16_t esLoopEnd;                         /* Position of CRC */
+	uint32_t crc;                               /* Running CRC of consumed bytes, 0 at end of valid section */
+	uint8_t header[PMT_STREAM_PARSER_HEADER_SIZE];
+	PmtTableHeader pmtHeader;
+	uint8_t entry[PMT_STREAM_PARSER_ENTRY_SIZE];
+	uint16_t entryUsed;
+	uint16_t entrySize;                         /* 0 while elementary stream entry size is not known yet */
+	uint8_t emittedCount;                       /* Elementary streams reported from current section */
+	uint32_t sectionCount;                      /* Statistics */
+	uint32_t crcErrorCount;
+	uint32_t abortCount;
+	uint32_t emittedTotal;
+}PmtStreamParser;
+
+/**
+ * @brief Initializes parser for PMT of one program, statistics are kept
+ *
+ * @param [out] parser - PMT stream parser
+ * @param [in] pid - PMT pid, PMT_STREAM_PARSER_NO_PID to stop parsing
+ * @param [in] programNumber - Program number of PMT
+ * @param [in] ops - Notifications
+ */
+void pmtStreamParserInit(PmtStreamParser* parser, uint16_t pid, uint16_t programNumber, const PmtStreamParserOps* ops);
+
+/**
+ * @brief Feeds one TS packet, packets of other pids are ignored
+ *
+ * @param [in] parser - PMT stream parser
+ * @param [in] packet - TS packet
+ */
+void pmtStreamParserFeedPacket(PmtStreamParser* parser, const uint8_t* packet);
+
+/**
+ * @brief Computes MPEG-2 CRC32 of PSI section, 0 over whole section including CRC means it is valid
+ *
+ * @param [in] crc - CRC of previous bytes, 0xFFFFFFFF for first byte
+ * @param [in] data - Bytes
+ * @param [in] length - Number of bytes
+ * @return CRC
+ */
+uint32_t pmtStreamParserCrc32(uint32_t crc, const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Prints parser statistics
+ *
+ * @param [in] name - Parser name
+ * @param [in] parser - PMT stream parser
+ */
+void printPmtStreamParserStats(const char* name, const PmtStreamParser* parser);
+
+#endif /* __PMT_STREAM_PARSER_H__ */
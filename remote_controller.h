@@ -29,6 +29,10 @@
 #define KEYCODE_VOL_UP 63
 #define KEYCODE_VOL_DOWN 64
 #define KEYCODE_MUTE 60
+#define KEYCODE_UP 103
+#define KEYCODE_DOWN 108
+#define KEYCODE_LEFT 105
+#define KEYCODE_RIGHT 106
 
 /* Input event values for 'EV_KEY' type */
 #define EV_VALUE_RELEASE    0
@@ -0,0 +1,1141 @@
+#include "filter_scheduler.h"
+#include "section_queue.h"
+#include "ts_monitor.h"
+#include "pmt_stream_parser.h"
+#include "channel_map.h"
+#include "string_pool.h"
+#include "epg_cache.h"
+#include "heap_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define SECTION_BENCH_SLOTS         4           /* Same as DEMUX_FILTER_SLOTS of TV_App */
+#define SECTION_BENCH_PIDS          16          /* Background PMT pids, more than slots */
+#define SECTION_BENCH_TICK_MS       10          /* Same as SCHEDULER_TICK_MS of TV_App */
+#define SECTION_BENCH_ROUNDS        2           /* Every background request gets a slot at least this many times */
+#define SECTION_BENCH_SECTIONS      2000000
+#define SECTION_BENCH_WAIT_MS       100
+#define SECTION_BENCH_PACKETS       10000000
+#define SECTION_BENCH_BURST         1024        /* Packets per monitor call, multiple of 16 per pid keeps CC continuous */
+#define SECTION_BENCH_BURST_PIDS    8
+#define SECTION_BENCH_NO_PCR        (-1LL)
+#define SECTION_BENCH_PMT_PID       0x20
+#define SECTION_BENCH_PMT_PROGRAM   5
+#define SECTION_BENCH_POINTER       10          /* Tail of previous section before PMT in first packet */
+#define SECTION_BENCH_MAX_PACKETS   8
+#define SECTION_BENCH_EPG_PATH      "/tmp/section_bench_epg.db"
+#define SECTION_BENCH_STRINGS       (STRING_POOL_MAX_STRINGS + 1000)    /* Interned until pool is full */
+#define SECTION_BENCH_NAME_UPDATES  30000       /* Event name changes, 200 bytes each fill EPG pool more than once */
+
+/**
+ * @brief - Section filter of local demux stand-in.
+ */
+typedef struct _StandInFilter
+{
+	uint8_t used;
+	uint16_t pid;
+	uint8_t tableId;
+}StandInFilter;
+
+/**
+ * @brief - Local demux stand-in with configurable number of section filters and simulated clock.
+ */
+typedef struct _StandInDemux
+{
+	StandInFilter filters[FILTER_SCHEDULER_MAX_SLOTS];
+	uint8_t slotCount;
+	uint8_t usedCount;
+	uint8_t maxUsedCount;
+	uint32_t setCount;
+	uint32_t freeCount;
+	uint32_t refusedCount;                      /* Set filter calls with all filters in use */
+	uint32_t badFreeCount;                      /* Free filter calls with handle that is not set */
+	uint16_t failPid;                           /* Set filter of this pid fails, TS_MAX_PID for none */
+	uint32_t failedCount;
+	uint64_t timeMs;
+}StandInDemux;
+
+/**
+ * @brief - Background request as seen by scheduler test.
+ */
+typedef struct _BenchRequest
+{
+	int32_t requestId;
+	uint8_t active;
+	uint32_t grants;
+	uint64_t grantTimeMs;
+	uint64_t maxHoldMs;
+}BenchRequest;
+
+/**
+ * @brief - Shared state of section queue stress test.
+ */
+typedef struct _BenchQueue
+{
+	SectionQueue sectionQueue;
+	uint32_t sections;
+	uint64_t fullCount;                         /* Pushes retried because queue was full */
+}BenchQueue;
+
+/**
+ * @brief - Live PMT as seen by PMT stream parser test, same selection and revoke as early PMT of stream controller.
+ */
+typedef struct _BenchPmt
+{
+	int16_t videoPid;                           /* -1 while not known */
+	int16_t audioPid;
+	uint32_t headerCount;
+	uint32_t streamCount;
+	uint32_t confirmCount;
+	uint32_t revokeCount;
+}BenchPmt;
+
+static StandInDemux standIn;
+static BenchPmt benchPmt;
+
+/**
+ * @brief - Stand-in demux operations, handle is filter index.
+ */
+static int32_t standInSetFilter(uint16_t pid, uint8_t tableId, uint32_t* filterHandle);
+static int32_t standInFreeFilter(uint32_t filterHandle);
+static uint64_t standInGetTimeMs(void);
+
+static const DemuxFilterOps standInOps =
+{
+	standInSetFilter,
+	standInFreeFilter,
+	standInGetTimeMs
+};
+
+/**
+ * @brief - PMT stream parser notifications, recorded in benchPmt.
+ */
+static void benchPmtHeader(const PmtTableHeader* pmtHeader);
+static void benchPmtElementaryStream(const PmtElementaryInfo* elementaryInfo);
+static void benchPmtSectionEnd(uint8_t crcOk);
+
+static const PmtStreamParserOps benchPmtOps =
+{
+	benchPmtHeader,
+	benchPmtElementaryStream,
+	benchPmtSectionEnd
+};
+
+/**
+ * @brief - Runs filter scheduler on stand-in demux with more background pids than slots,
+ *          checks priority preemption, quantum rotation and wait statistics.
+ *
+ * @return - 0 if all checks passed
+ */
+static int32_t benchScheduler(uint8_t slots, uint32_t pids);
+
+/**
+ * @brief - Producer thread pushes sections at full speed while consumer checks their order and content.
+ *
+ * @return - 0 if every section arrived once, in order and untorn
+ */
+static int32_t benchQueue(uint32_t sections);
+
+/**
+ * @brief - Section queue producer, plays demux callback.
+ */
+static void* benchQueueProducer(void* params);
+
+/**
+ * @brief - Writes section whose length and content derive from sequence number.
+ *
+ * @return - Section size
+ */
+static uint32_t benchSectionBuild(uint8_t* buffer, uint32_t sequence);
+
+/**
+ * @brief - Feeds crafted packets to TS monitor, checks CC error counting, PCR interval and jitter,
+ *          sliding window rates and measures time per packet.
+ *
+ * @return - 0 if all checks passed
+ */
+static int32_t benchMonitor(uint32_t packets);
+
+/**
+ * @brief - Writes TS packet with payload, adaptation field is added for discontinuity_indicator or PCR.
+ *
+ * @param packet - Packet buffer
+ * @param pid - Pid
+ * @param cc - continuity_counter
+ * @param discontinuity - discontinuity_indicator
+ * @param pcr - PCR in 27 MHz units, SECTION_BENCH_NO_PCR for none
+ */
+static void benchPacketBuild(uint8_t* packet, uint16_t pid, uint8_t cc, uint8_t discontinuity, int64_t pcr);
+
+/**
+ * @brief - Feeds live PMT packets to PMT stream parser, checks section split over packets with pointer_field,
+ *          revoke on lost packet and CRC error and skipping of confirmed version.
+ *
+ * @return - 0 if all checks passed
+ */
+static int32_t benchPmtParser(void);
+
+/**
+ * @brief - Writes PMT section with video, audio and teletext stream, descriptors make it longer than one packet.
+ *
+ * @return - Section size
+ */
+static uint32_t benchPmtBuild(uint8_t* buffer, uint8_t version);
+
+/**
+ * @brief - Splits section into TS packets of PMT pid, first one starts with pointer_field.
+ *
+ * @param packets - Packet buffer of SECTION_BENCH_MAX_PACKETS packets
+ * @param section - Section
+ * @param size - Section size
+ * @param cc - continuity_counter of first packet, returns counter of next packet
+ *
+ * @return - Number of packets
+ */
+static uint32_t benchPmtPacketize(uint8_t* packets, const uint8_t* section, uint32_t size, uint8_t* cc);
+
+/**
+ * @brief - Runs string pool, channel map and EPG cache past the points where they used to allocate,
+ *          checks that no heap allocation is done after start up.
+ *
+ * @return - 0 if all checks passed
+ */
+static int32_t benchSteadyState(void);
+
+/**
+ * @brief - Returns monotonic time in microseconds.
+ */
+static uint64_t benchTimeUs(void);
+
+/**
+ * @brief - Prints failed check.
+ *
+ * @return - 1 if check failed
+ */
+static uint32_t benchCheck(uint8_t ok, const char* check);
+
+/*
+ * Host test of section filtering and section handling, built without TDP API (make section_bench).
+ *
+ * Usage: section_bench                         (both tests with defaults)
+ *        section_bench scheduler [slots] [pids]
+ *        section_bench queue [sections]
+ *        section_bench monitor [packets]
+ *        section_bench pmt
+ *        section_bench heap
+ */
+int main(int argc, char *argv[])
+{
+	uint8_t slots = SECTION_BENCH_SLOTS;
+	uint32_t pids = SECTION_BENCH_PIDS;
+	uint32_t sections = SECTION_BENCH_SECTIONS;
+	uint32_t packets = SECTION_BENCH_PACKETS;
+	int32_t result = 0;
+
+	if (argc > 1 && strcmp(argv[1], "queue") == 0)
+	{
+		if (argc > 2)
+		{
+			sections = (uint32_t)strtoul(argv[2], NULL, 10);
+		}
+		return benchQueue(sections);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "monitor") == 0)
+	{
+		if (argc > 2)
+		{
+			packets = (uint32_t)strtoul(argv[2], NULL, 10);
+		}
+		return benchMonitor(packets);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "pmt") == 0)
+	{
+		return benchPmtParser();
+	}
+
+	if (argc > 1 && strcmp(argv[1], "heap") == 0)
+	{
+		return benchSteadyState();
+	}
+
+	if (argc > 1 && strcmp(argv[1], "scheduler") == 0)
+	{
+		if (argc > 2)
+		{
+			slots = (uint8_t)strtoul(argv[2], NULL, 10);
+		}
+		if (argc > 3)
+		{
+			pids = (uint32_t)strtoul(argv[3], NULL, 10);
+		}
+		return benchScheduler(slots, pids);
+	}
+
+	result |= benchScheduler(slots, pids);
+	result |= benchQueue(sections);
+	result |= benchMonitor(packets);
+	result |= benchPmtParser();
+	result |= benchSteadyState();
+
+	return result;
+}
+
+int32_t benchScheduler(uint8_t slots, uint32_t pids)
+{
+	BenchRequest requests[FILTER_SCHEDULER_MAX_REQUESTS];
+	FilterWaitStats backgroundStats;
+	FilterWaitStats liveStats;
+	FilterWaitStats presentStats;
+	FilterWaitStats regrantStats;
+	uint32_t backgroundSlots;
+	uint64_t durationMs;
+	uint64_t waitBoundMs;
+	uint64_t maxHoldMs = 0;
+	uint32_t minGrants = 0xFFFFFFFF;
+	uint32_t failures = 0;
+	uint32_t activeCount;
+	uint32_t liveLost = 0;
+	int32_t liveId;
+	int32_t presentId;
+	uint32_t i;
+
+	/* live PMT, EIT p/f and at least one rotating background slot */
+	if (slots < 3 || slots > FILTER_SCHEDULER_MAX_SLOTS || pids <= slots || pids + 2 > FILTER_SCHEDULER_MAX_REQUESTS)
+	{
+		printf("\n%s : ERROR slots must be 3 to %d and pids more than slots, at most %d\n", __FUNCTION__,
+		       FILTER_SCHEDULER_MAX_SLOTS, FILTER_SCHEDULER_MAX_REQUESTS - 2);
+		return -1;
+	}
+
+	memset(&standIn, 0x0, sizeof(standIn));
+	memset(requests, 0x0, sizeof(requests));
+	standIn.slotCount = slots;
+	standIn.failPid = TS_MAX_PID;
+	if (filterSchedulerInit(&standInOps, slots, FILTER_SCHEDULER_QUANTUM_MS) != FS_NO_ERROR)
+	{
+		return -1;
+	}
+
+	/* background PMTs take all slots, the rest wait */
+	for (i = 0; i < pids; i++)
+	{
+		filterSchedulerAdd(0x0100 + i, 0x02, FILTER_PRIORITY_BACKGROUND, &requests[i].requestId);
+	}
+	failures += benchCheck(standIn.usedCount == slots, "background requests take all slots");
+
+	/* live PMT and EIT p/f get slots at once, background requests are preempted */
+	filterSchedulerAdd(0x0000, 0x00, FILTER_PRIORITY_LIVE, &liveId);
+	filterSchedulerAdd(0x0012, 0x4E, FILTER_PRIORITY_PRESENT_FOLLOWING, &presentId);
+	filterSchedulerGetStats(0x02, &backgroundStats);
+	failures += benchCheck(filterSchedulerIsActive(liveId) && filterSchedulerIsActive(presentId), "live and p/f granted on add");
+	failures += benchCheck(backgroundStats.preemptCount == 2, "two background requests preempted");
+	failures += benchCheck(standIn.usedCount == slots, "slot count kept after preemption");
+
+	for (i = 0; i < pids; i++)
+	{
+		requests[i].active = filterSchedulerIsActive(requests[i].requestId);
+		requests[i].grants = requests[i].active;
+	}
+
+	/* every background request has to get its quantum, round by round */
+	backgroundSlots = slots - 2;
+	durationMs = (uint64_t)SECTION_BENCH_ROUNDS * ((pids + backgroundSlots - 1) / backgroundSlots) * FILTER_SCHEDULER_QUANTUM_MS;
+	while (standIn.timeMs < durationMs)
+	{
+		standIn.timeMs += SECTION_BENCH_TICK_MS;
+		filterSchedulerTick();
+
+		if (!filterSchedulerIsActive(liveId) || !filterSchedulerIsActive(presentId))
+		{
+			liveLost++;
+		}
+
+		activeCount = 0;
+		for (i = 0; i < pids; i++)
+		{
+			if (filterSchedulerIsActive(requests[i].requestId))
+			{
+				activeCount++;
+				if (!requests[i].active)
+				{
+					requests[i].active = 1;
+					requests[i].grants++;
+					requests[i].grantTimeMs = standIn.timeMs;
+				}
+				if (standIn.timeMs - requests[i].grantTimeMs > requests[i].maxHoldMs)
+				{
+					requests[i].maxHoldMs = standIn.timeMs - requests[i].grantTimeMs;
+				}
+			}
+			else
+			{
+				requests[i].active = 0;
+			}
+		}
+		if (activeCount != backgroundSlots)
+		{
+			failures += benchCheck(0, "background requests fill free slots");
+			break;
+		}
+	}
+
+	for (i = 0; i < pids; i++)
+	{
+		if (requests[i].grants < minGrants)
+		{
+			minGrants = requests[i].grants;
+		}
+		if (requests[i].maxHoldMs > maxHoldMs)
+		{
+			maxHoldMs = requests[i].maxHoldMs;
+		}
+	}
+	failures += benchCheck(liveLost == 0, "live and p/f never preempted");
+	failures += benchCheck(minGrants >= SECTION_BENCH_ROUNDS, "every background request rotated in");
+	failures += benchCheck(maxHoldMs <= FILTER_SCHEDULER_QUANTUM_MS, "background slot held at most one quantum");
+
+	/* a waiting request is served after every request ahead of it had its quantum */
+	waitBoundMs = ((pids + backgroundSlots - 1) / backgroundSlots) * (FILTER_SCHEDULER_QUANTUM_MS + SECTION_BENCH_TICK_MS);
+	filterSchedulerGetStats(0x02, &backgroundStats);
+	filterSchedulerGetStats(0x00, &liveStats);
+	filterSchedulerGetStats(0x4E, &presentStats);
+	failures += benchCheck(backgroundStats.maxWaitMs > 0 && backgroundStats.maxWaitMs <= waitBoundMs, "background wait within rotation bound");
+	failures += benchCheck(backgroundStats.grantCount == standIn.setCount - 2, "background grants counted");
+	failures += benchCheck(liveStats.grantCount == 1 && liveStats.maxWaitMs == 0, "live request did not wait");
+	failures += benchCheck(presentStats.grantCount == 1 && presentStats.maxWaitMs == 0, "p/f request did not wait");
+
+	/* slots of removed requests go to background */
+	filterSchedulerRemove(liveId);
+	filterSchedulerRemove(presentId);
+	activeCount = 0;
+	for (i = 0; i < pids; i++)
+	{
+		activeCount += filterSchedulerIsActive(requests[i].requestId);
+	}
+	failures += benchCheck(activeCount == slots, "freed slots granted to background");
+
+	/* demux refuses filter of live request, slot taken for it goes back to preempted background request */
+	filterSchedulerGetStats(0x02, &backgroundStats);
+	standIn.failPid = 0x0011;
+	filterSchedulerAdd(0x0011, 0x00, FILTER_PRIORITY_LIVE, &liveId);
+	activeCount = 0;
+	for (i = 0; i < pids; i++)
+	{
+		activeCount += filterSchedulerIsActive(requests[i].requestId);
+	}
+	filterSchedulerGetStats(0x02, &regrantStats);
+	failures += benchCheck(!filterSchedulerIsActive(liveId) && standIn.failedCount == 1, "refused live request waits");
+	failures += benchCheck(activeCount == slots && standIn.usedCount == slots, "preempted request granted again on set filter error");
+	failures += benchCheck(regrantStats.preemptCount == backgroundStats.preemptCount, "regrant is not counted as preemption");
+	standIn.failPid = TS_MAX_PID;
+	standIn.timeMs += SECTION_BENCH_TICK_MS;
+	filterSchedulerTick();
+	failures += benchCheck(filterSchedulerIsActive(liveId), "live request granted once demux accepts it");
+	filterSchedulerRemove(liveId);
+
+	printf("\n********************SCHEDULER BENCH********************\n");
+	printf("slots                    |      %u\n", slots);
+	printf("background pids          |      %u\n", pids);
+	printf("simulated time           |      %llu ms\n", (unsigned long long)durationMs);
+	printf("background grants        |      %u\n", backgroundStats.grantCount);
+	printf("background preemptions   |      %u\n", backgroundStats.preemptCount);
+	printf("min grants per pid       |      %u\n", minGrants);
+	printf("max slot hold            |      %llu ms\n", (unsigned long long)maxHoldMs);
+	printf("avg background wait      |      %llu ms\n", (unsigned long long)(backgroundStats.totalWaitMs / backgroundStats.grantCount));
+	printf("max background wait      |      %llu ms (bound %llu ms)\n", (unsigned long long)backgroundStats.maxWaitMs,
+	       (unsigned long long)waitBoundMs);
+	printf("max demux filters used   |      %u / %u\n", standIn.maxUsedCount, slots);
+	printf("refused set filter       |      %u\n", standIn.refusedCount);
+	printf("failed checks            |      %u\n", failures);
+	printf("\n********************SCHEDULER BENCH********************\n");
+	printFilterSchedulerStats();
+
+	filterSchedulerDeinit();
+	failures += benchCheck(standIn.usedCount == 0 && standIn.setCount == standIn.freeCount, "all filters freed on deinit");
+	failures += benchCheck(standIn.refusedCount == 0 && standIn.badFreeCount == 0, "demux filters used within slot count");
+
+	return failures ? 1 : 0;
+}
+
+int32_t benchQueue(uint32_t sections)
+{
+	static BenchQueue queue;
+	static uint8_t expected[SECTION_QUEUE_SLOT_SIZE];
+	pthread_t producer;
+	const uint8_t* section;
+	uint64_t startUs;
+	uint64_t totalUs;
+	uint64_t consumedBytes = 0;
+	uint32_t consumed = 0;
+	uint32_t outOfOrder = 0;
+	uint32_t torn = 0;
+	uint32_t wakeups = 0;
+	uint32_t emptyWakeups = 0;
+	uint32_t timeouts = 0;
+	int semaphoreValue = 0;
+	uint32_t sequence;
+	uint32_t size;
+	uint32_t failures = 0;
+
+	memset(&queue, 0x0, sizeof(queue));
+	queue.sections = sections;
+	if (sectionQueueInit(&queue.sectionQueue) != SQ_NO_ERROR)
+	{
+		return -1;
+	}
+
+	startUs = benchTimeUs();
+	if (pthread_create(&producer, NULL, benchQueueProducer, &queue))
+	{
+		printf("\n%s : ERROR pthread_create() fail\n", __FUNCTION__);
+		sectionQueueDeinit(&queue.sectionQueue);
+		return -1;
+	}
+
+	/* consumer side as in stream controller thread, every section is compared with what producer built */
+	while (consumed < sections)
+	{
+		if (sectionQueueWait(&queue.sectionQueue, SECTION_BENCH_WAIT_MS) != SQ_NO_ERROR)
+		{
+			/* producer pushes without pause, a long silence means a lost wake up */
+			timeouts++;
+			if (timeouts > 10)
+			{
+				break;
+			}
+			continue;
+		}
+		wakeups++;
+		if (sectionQueueFront(&queue.sectionQueue) == NULL)
+		{
+			emptyWakeups++;
+		}
+
+		while ((section = sectionQueueFront(&queue.sectionQueue)) != NULL)
+		{
+			sequence = ((uint32_t)section[3] << 24) | ((uint32_t)section[4] << 16) | ((uint32_t)section[5] << 8) | section[6];
+			if (sequence != consumed)
+			{
+				outOfOrder++;
+			}
+			size = benchSectionBuild(expected, consumed);
+			if (memcmp(section, expected, size) != 0)
+			{
+				torn++;
+			}
+			consumedBytes += size;
+			consumed++;
+			sectionQueueRelease(&queue.sectionQueue);
+		}
+	}
+	pthread_join(producer, NULL);
+	totalUs = benchTimeUs() - startUs;
+
+	failures += benchCheck(consumed == sections, "every section consumed");
+	failures += benchCheck(queue.sectionQueue.pushedCount == sections, "every section pushed once");
+	failures += benchCheck(outOfOrder == 0, "sections consumed in push order");
+	failures += benchCheck(torn == 0, "no section overwritten while queued");
+	failures += benchCheck(sectionQueueFront(&queue.sectionQueue) == NULL, "queue empty at end");
+
+	/* producer posts only after consumer cleared the wake up flag in a wait, semaphore never builds up */
+	sem_getvalue(&queue.sectionQueue.available, &semaphoreValue);
+	failures += benchCheck(queue.sectionQueue.wakeupCount <= wakeups + timeouts + 1, "at most one wake up posted per consumer wait");
+	failures += benchCheck(semaphoreValue <= 1, "semaphore count bounded");
+
+	printf("\n********************QUEUE BENCH********************\n");
+	printf("sections                 |      %u\n", sections);
+	printf("consumed                 |      %u\n", consumed);
+	printf("bytes                    |      %llu\n", (unsigned long long)consumedBytes);
+	printf("total time               |      %llu us\n", (unsigned long long)totalUs);
+	printf("sections per second      |      %llu\n", (unsigned long long)(totalUs ? (uint64_t)consumed * 1000000 / totalUs : 0));
+	printf("consumer wakeups         |      %u\n", wakeups);
+	printf("empty wakeups            |      %u\n", emptyWakeups);
+	printf("wake ups posted          |      %u\n", queue.sectionQueue.wakeupCount);
+	printf("pushes on full queue     |      %llu\n", (unsigned long long)queue.fullCount);
+	printf("out of order             |      %u\n", outOfOrder);
+	printf("torn                     |      %u\n", torn);
+	printf("failed checks            |      %u\n", failures);
+	printf("\n********************QUEUE BENCH********************\n");
+	printSectionQueueStats(&queue.sectionQueue);
+
+	sectionQueueDeinit(&queue.sectionQueue);
+
+	return failures ? 1 : 0;
+}
+
+void* benchQueueProducer(void* params)
+{
+	static uint8_t buffer[SECTION_QUEUE_SLOT_SIZE];
+	BenchQueue* queue = (BenchQueue*)params;
+	uint32_t sequence;
+
+	/* demux callback drops sections on full queue, here they are pushed again so every one can be checked */
+	for (sequence = 0; sequence < queue->sections; sequence++)
+	{
+		benchSectionBuild(buffer, sequence);
+		while (sectionQueuePush(&queue->sectionQueue, buffer) == SQ_FULL)
+		{
+			queue->fullCount++;
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+uint32_t benchSectionBuild(uint8_t* buffer, uint32_t sequence)
+{
+	uint32_t sectionLength;
+	uint32_t i;
+
+	/* mostly short sections, every 64th one fills the whole slot */
+	sectionLength = (sequence % 64 == 63) ? SECTION_QUEUE_SLOT_SIZE - 3 : 4 + (sequence * 7919) % 1024;
+
+	buffer[0] = 0x4E;
+	buffer[1] = 0xB0 | ((sectionLength >> 8) & 0x0F);
+	buffer[2] = sectionLength & 0xFF;
+	buffer[3] = (sequence >> 24) & 0xFF;
+	buffer[4] = (sequence >> 16) & 0xFF;
+	buffer[5] = (sequence >> 8) & 0xFF;
+	buffer[6] = sequence & 0xFF;
+	for (i = 7; i < sectionLength + 3; i++)
+	{
+		buffer[i] = (uint8_t)(sequence * 31 + i);
+	}
+
+	return sectionLength + 3;
+}
+
+int32_t benchMonitor(uint32_t packets)
+{
+	static uint8_t burst[SECTION_BENCH_BURST * TS_PACKET_SIZE];
+	uint8_t packet[TS_PACKET_SIZE];
+	TsPidStats pidStats;
+	TsPcrStats pcrStats;
+	uint64_t timeUs;
+	uint64_t startUs;
+	uint64_t totalUs;
+	uint64_t nsPerPacket;
+	uint32_t ccErrors;
+	uint32_t fed;
+	uint32_t i;
+	uint32_t j;
+	uint32_t failures = 0;
+
+	/* continuity_counter: one duplicate is allowed, second one and a gap are errors, signalled discontinuity is not */
+	static const uint8_t ccSequence[] = {0, 1, 2, 2, 2, 3, 5, 6};
+	tsMonitorInit();
+	timeUs = 10000000;
+	for (i = 0; i < sizeof(ccSequence); i++)
+	{
+		benchPacketBuild(packet, 0x100, ccSequence[i], 0, SECTION_BENCH_NO_PCR);
+		tsMonitorProcessPackets(packet, 1, timeUs);
+	}
+	benchPacketBuild(packet, 0x100, 12, 1, SECTION_BENCH_NO_PCR);
+	tsMonitorProcessPackets(packet, 1, timeUs);
+	benchPacketBuild(packet, 0x100, 13, 0, SECTION_BENCH_NO_PCR);
+	tsMonitorProcessPackets(packet, 1, timeUs);
+	tsMonitorGetPidStats(0x100, &pidStats);
+	failures += benchCheck(pidStats.packetCount == sizeof(ccSequence) + 2, "every packet counted");
+	failures += benchCheck(pidStats.ccErrorCount == 2, "second duplicate and gap are CC errors, discontinuity is not");
+	ccErrors = pidStats.ccErrorCount;
+
+	/* PCR every 30 ms on time, one PCR arrives 50 ms after previous one while PCR advanced 40 ms */
+	tsMonitorSetPcrPid(0x101);
+	for (i = 0; i < 10; i++)
+	{
+		benchPacketBuild(packet, 0x101, i & 0x0F, 0, (int64_t)i * 30 * 27000);
+		tsMonitorProcessPackets(packet, 1, timeUs + i * 30000);
+	}
+	benchPacketBuild(packet, 0x101, 10, 0, (int64_t)(9 * 30 + 40) * 27000);
+	tsMonitorProcessPackets(packet, 1, timeUs + 9 * 30000 + 50000);
+	tsMonitorGetPcrStats(&pcrStats);
+	failures += benchCheck(pcrStats.pcrCount == 11, "every PCR counted");
+	failures += benchCheck(pcrStats.lastIntervalUs == 50000 && pcrStats.maxIntervalUs == 50000, "PCR interval measured");
+	failures += benchCheck(pcrStats.avgIntervalUs == (9 * 30000 + 50000) / 10, "PCR average interval");
+	failures += benchCheck(pcrStats.intervalErrorCount == 1, "only interval over 40 ms is an error");
+	failures += benchCheck(pcrStats.lastJitterUs == 10000 && pcrStats.maxJitterUs == 10000, "PCR jitter is arrival minus PCR interval");
+	failures += benchCheck(pcrStats.discontinuityCount == 0, "no PCR discontinuity");
+
+	/* 100 packets per second for 7 seconds, rate covers complete seconds of window only */
+	tsMonitorInit();
+	for (i = 0; i < 7; i++)
+	{
+		for (j = 0; j < 100; j++)
+		{
+			benchPacketBuild(packet, 0x102, j & 0x0F, 0, SECTION_BENCH_NO_PCR);
+			tsMonitorProcessPackets(packet, 1, timeUs + i * 1000000 + j * 10000);
+		}
+		tsMonitorGetPidStats(0x102, &pidStats);
+		if (i == 0)
+		{
+			failures += benchCheck(pidStats.packetRate == 0, "no rate before first complete second");
+		}
+	}
+	failures += benchCheck(pidStats.packetRate == 100, "packet rate over sliding window");
+	failures += benchCheck(pidStats.bitRate == 100 * TS_PACKET_SIZE * 8, "bit rate over sliding window");
+
+	/* 8 pids in turn, burst holds 128 packets per pid so CC stays continuous from burst to burst */
+	tsMonitorInit();
+	tsMonitorSetPcrPid(0x200);
+	for (i = 0; i < SECTION_BENCH_BURST; i++)
+	{
+		j = i / SECTION_BENCH_BURST_PIDS;
+		benchPacketBuild(burst + i * TS_PACKET_SIZE, 0x200 + i % SECTION_BENCH_BURST_PIDS, j & 0x0F, 0,
+		                 (i % SECTION_BENCH_BURST_PIDS == 0 && j % 16 == 0) ? (int64_t)j * 27000 : SECTION_BENCH_NO_PCR);
+	}
+	startUs = benchTimeUs();
+	for (fed = 0; fed < packets; fed += SECTION_BENCH_BURST)
+	{
+		tsMonitorProcessPackets(burst, SECTION_BENCH_BURST, timeUs + fed);
+	}
+	totalUs = benchTimeUs() - startUs;
+	nsPerPacket = fed ? totalUs * 1000 / fed : 0;
+	for (i = 0; i < SECTION_BENCH_BURST_PIDS; i++)
+	{
+		tsMonitorGetPidStats(0x200 + i, &pidStats);
+		failures += benchCheck(pidStats.ccErrorCount == 0, "no CC error in continuous stream");
+	}
+
+	printf("\n********************MONITOR BENCH********************\n");
+	printf("cc errors                |      %u\n", ccErrors);
+	printf("pcr interval avg/max     |      %u / %u us\n", pcrStats.avgIntervalUs, pcrStats.maxIntervalUs);
+	printf("pcr jitter max           |      %u us\n", pcrStats.maxJitterUs);
+	printf("packets                  |      %u\n", fed);
+	printf("total time               |      %llu us\n", (unsigned long long)totalUs);
+	printf("time per packet          |      %llu ns\n", (unsigned long long)nsPerPacket);
+	printf("failed checks            |      %u\n", failures);
+	printf("\n********************MONITOR BENCH********************\n");
+
+	return failures ? 1 : 0;
+}
+
+void benchPacketBuild(uint8_t* packet, uint16_t pid, uint8_t cc, uint8_t discontinuity, int64_t pcr)
+{
+	uint64_t base;
+	uint16_t extension;
+
+	memset(packet, 0xFF, TS_PACKET_SIZE);
+	packet[0] = TS_SYNC_BYTE;
+	packet[1] = (pid >> 8) & 0x1F;
+	packet[2] = pid & 0xFF;
+	packet[3] = 0x10 | (cc & 0x0F);
+
+	if (!discontinuity && pcr == SECTION_BENCH_NO_PCR)
+	{
+		return;
+	}
+
+	/* adaptation field with flags, PCR takes 6 more bytes */
+	packet[3] |= 0x20;
+	packet[4] = (pcr == SECTION_BENCH_NO_PCR) ? 1 : 7;
+	packet[5] = (discontinuity ? 0x80 : 0x00) | ((pcr == SECTION_BENCH_NO_PCR) ? 0x00 : 0x10);
+	if (pcr != SECTION_BENCH_NO_PCR)
+	{
+		base = (uint64_t)pcr / 300;
+		extension = (uint16_t)(pcr % 300);
+		packet[6] = (base >> 25) & 0xFF;
+		packet[7] = (base >> 17) & 0xFF;
+		packet[8] = (base >> 9) & 0xFF;
+		packet[9] = (base >> 1) & 0xFF;
+		packet[10] = ((base & 0x01) << 7) | 0x7E | ((extension >> 8) & 0x01);
+		packet[11] = extension & 0xFF;
+	}
+}
+
+int32_t benchPmtParser(void)
+{
+	static PmtStreamParser parser;
+	static uint8_t packets[SECTION_BENCH_MAX_PACKETS * TS_PACKET_SIZE];
+	uint8_t section[PMT_STREAM_PARSER_ENTRY_SIZE];
+	uint32_t packetCount;
+	uint32_t size;
+	uint32_t i;
+	uint8_t cc = 0;
+	uint32_t failures = 0;
+
+	memset(&benchPmt, 0x0, sizeof(benchPmt));
+	benchPmt.videoPid = -1;
+	benchPmt.audioPid = -1;
+	memset(&parser, 0x0, sizeof(parser));
+	pmtStreamParserInit(&parser, SECTION_BENCH_PMT_PID, SECTION_BENCH_PMT_PROGRAM, &benchPmtOps);
+
+	/* version 3 split over packets, first packet starts with tail of previous section */
+	size = benchPmtBuild(section, 3);
+	packetCount = benchPmtPacketize(packets, section, size, &cc);
+	failures += benchCheck(packetCount > 2, "PMT section spans three packets");
+	pmtStreamParserFeedPacket(&parser, packets);
+	failures += benchCheck(benchPmt.headerCount == 1 && benchPmt.videoPid == 0x101, "video reported from first packet");
+	failures += benchCheck(benchPmt.confirmCount == 0, "section not confirmed before CRC");
+	for (i = 1; i < packetCount; i++)
+	{
+		pmtStreamParserFeedPacket(&parser, packets + i * TS_PACKET_SIZE);
+	}
+	failures += benchCheck(benchPmt.streamCount == 3 && benchPmt.audioPid == 0x102, "all streams reported");
+	failures += benchCheck(benchPmt.confirmCount == 1 && benchPmt.revokeCount == 0, "split section confirmed");
+
+	/* repetition of confirmed version is skipped without notifications */
+	packetCount = benchPmtPacketize(packets, section, size, &cc);
+	for (i = 0; i < packetCount; i++)
+	{
+		pmtStreamParserFeedPacket(&parser, packets + i * TS_PACKET_SIZE);
+	}
+	failures += benchCheck(benchPmt.headerCount == 1 && benchPmt.streamCount == 3, "confirmed version skipped");
+	failures += benchCheck(benchPmt.confirmCount == 1, "skipped version not confirmed again");
+
+	/* version 4, middle packet is lost */
+	size = benchPmtBuild(section, 4);
+	packetCount = benchPmtPacketize(packets, section, size, &cc);
+	pmtStreamParserFeedPacket(&parser, packets);
+	for (i = 2; i < packetCount; i++)
+	{
+		pmtStreamParserFeedPacket(&parser, packets + i * TS_PACKET_SIZE);
+	}
+	failures += benchCheck(benchPmt.headerCount == 2, "new version parsed");
+	failures += benchCheck(benchPmt.revokeCount == 1 && parser.abortCount == 1, "CC gap revokes section");
+	failures += benchCheck(benchPmt.videoPid == -1 && benchPmt.audioPid == -1, "reported streams rolled back on CC gap");
+
+	/* version 4 with broken CRC */
+	section[size - 1] ^= 0x01;
+	packetCount = benchPmtPacketize(packets, section, size, &cc);
+	for (i = 0; i < packetCount; i++)
+	{
+		pmtStreamParserFeedPacket(&parser, packets + i * TS_PACKET_SIZE);
+	}
+	failures += benchCheck(benchPmt.revokeCount == 2 && parser.crcErrorCount == 1, "CRC error revokes section");
+	failures += benchCheck(benchPmt.videoPid == -1 && benchPmt.audioPid == -1, "reported streams rolled back on CRC error");
+	failures += benchCheck(benchPmt.confirmCount == 1, "section with CRC error not confirmed");
+
+	/* version that failed is not skipped, good repetition is confirmed */
+	section[size - 1] ^= 0x01;
+	packetCount = benchPmtPacketize(packets, section, size, &cc);
+	for (i = 0; i < packetCount; i++)
+	{
+		pmtStreamParserFeedPacket(&parser, packets + i * TS_PACKET_SIZE);
+	}
+	failures += benchCheck(benchPmt.confirmCount == 2 && parser.skipVersion == 4, "failed version parsed again and confirmed");
+	failures += benchCheck(benchPmt.videoPid == 0x101 && benchPmt.audioPid == 0x102, "streams reported again");
+
+	printf("\n********************PMT PARSER BENCH********************\n");
+	printf("section size             |      %u\n", size);
+	printf("packets per section      |      %u\n", packetCount);
+	printf("headers reported         |      %u\n", benchPmt.headerCount);
+	printf("streams reported         |      %u\n", benchPmt.streamCount);
+	printf("sections confirmed       |      %u\n", benchPmt.confirmCount);
+	printf("sections revoked         |      %u\n", benchPmt.revokeCount);
+	printf("failed checks            |      %u\n", failures);
+	printf("\n********************PMT PARSER BENCH********************\n");
+	printPmtStreamParserStats("BENCH", &parser);
+
+	return failures ? 1 : 0;
+}
+
+uint32_t benchPmtBuild(uint8_t* buffer, uint8_t version)
+{
+	/* stream type, pid, descriptor tag and descriptor length of each elementary stream */
+	static const uint16_t streams[3][4] =
+	{
+		{0x02, 0x101, 0x52, 40},
+		{0x03, 0x102, 0x0A, 200},
+		{0x06, 0x103, 0x56, 150}
+	};
+	uint32_t position = 12;
+	uint32_t sectionLength;
+	uint32_t crc;
+	uint32_t i;
+
+	/* program info: one private data descriptor */
+	buffer[position++] = 0x0F;
+	buffer[position++] = 4;
+	memset(buffer + position, 0x11, 4);
+	position += 4;
+
+	for (i = 0; i < 3; i++)
+	{
+		buffer[position++] = (uint8_t)streams[i][0];
+		buffer[position++] = 0xE0 | ((streams[i][1] >> 8) & 0x1F);
+		buffer[position++] = streams[i][1] & 0xFF;
+		buffer[position++] = 0xF0 | (((streams[i][3] + 2) >> 8) & 0x0F);
+		buffer[position++] = (streams[i][3] + 2) & 0xFF;
+		buffer[position++] = (uint8_t)streams[i][2];
+		buffer[position++] = (uint8_t)streams[i][3];
+		memset(buffer + position, 0x20 + i, streams[i][3]);
+		position += streams[i][3];
+	}
+
+	sectionLength = position + 4 - 3;
+	buffer[0] = 0x02;
+	buffer[1] = 0xB0 | ((sectionLength >> 8) & 0x0F);
+	buffer[2] = sectionLength & 0xFF;
+	buffer[3] = (SECTION_BENCH_PMT_PROGRAM >> 8) & 0xFF;
+	buffer[4] = SECTION_BENCH_PMT_PROGRAM & 0xFF;
+	buffer[5] = 0xC1 | ((version & 0x1F) << 1);
+	buffer[6] = 0;
+	buffer[7] = 0;
+	buffer[8] = 0xE1;
+	buffer[9] = 0x01;
+	buffer[10] = 0xF0;
+	buffer[11] = 6;
+
+	crc = pmtStreamParserCrc32(0xFFFFFFFF, buffer, position);
+	buffer[position++] = (crc >> 24) & 0xFF;
+	buffer[position++] = (crc >> 16) & 0xFF;
+	buffer[position++] = (crc >> 8) & 0xFF;
+	buffer[position++] = crc & 0xFF;
+
+	return position;
+}
+
+uint32_t benchPmtPacketize(uint8_t* packets, const uint8_t* section, uint32_t size, uint8_t* cc)
+{
+	uint8_t* packet;
+	uint32_t offset;
+	uint32_t count;
+	uint32_t used = 0;
+	uint32_t packetCount = 0;
+
+	while (used < size && packetCount < SECTION_BENCH_MAX_PACKETS)
+	{
+		packet = packets + packetCount * TS_PACKET_SIZE;
+		memset(packet, 0xFF, TS_PACKET_SIZE);
+		packet[0] = TS_SYNC_BYTE;
+		packet[1] = (SECTION_BENCH_PMT_PID >> 8) & 0x1F;
+		packet[2] = SECTION_BENCH_PMT_PID & 0xFF;
+		packet[3] = 0x10 | *cc;
+		*cc = (*cc + 1) & 0x0F;
+		offset = 4;
+
+		if (packetCount == 0)
+		{
+			packet[1] |= 0x40;
+			packet[offset++] = SECTION_BENCH_POINTER;
+			memset(packet + offset, 0xAB, SECTION_BENCH_POINTER);
+			offset += SECTION_BENCH_POINTER;
+		}
+
+		count = (size - used < TS_PACKET_SIZE - offset) ? size - used : TS_PACKET_SIZE - offset;
+		memcpy(packet + offset, section + used, count);
+		used += count;
+		packetCount++;
+	}
+
+	return packetCount;
+}
+
+void benchPmtHeader(const PmtTableHeader* pmtHeader)
+{
+	(void)pmtHeader;
+	benchPmt.headerCount++;
+}
+
+void benchPmtElementaryStream(const PmtElementaryInfo* elementaryInfo)
+{
+	benchPmt.streamCount++;
+	if (elementaryInfo->streamType == 0x02 && benchPmt.videoPid == -1)
+	{
+		benchPmt.videoPid = elementaryInfo->elementaryPid;
+	}
+	else if (elementaryInfo->streamType == 0x03 && benchPmt.audioPid == -1)
+	{
+		benchPmt.audioPid = elementaryInfo->elementaryPid;
+	}
+}
+
+void benchPmtSectionEnd(uint8_t crcOk)
+{
+	if (crcOk)
+	{
+		benchPmt.confirmCount++;
+		return;
+	}
+
+	/* as earlyPmtSectionEnd(), streams reported from section are rolled back */
+	benchPmt.revokeCount++;
+	benchPmt.videoPid = -1;
+	benchPmt.audioPid = -1;
+}
+
+int32_t benchSteadyState(void)
+{
+	static PatServiceInfo services[CHANNEL_MAP_MAX_SERVICES];
+	PatTable patTable;
+	HeapStats mark;
+	StringHandle first = STRING_HANDLE_EMPTY;
+	StringHandle handle;
+	const EpgCacheEvent* event;
+	char name[256];
+	uint64_t allocations;
+	uint32_t interned = 0;
+	uint32_t rejected = 0;
+	uint32_t i;
+	uint32_t failures = 0;
+
+	memset(&patTable, 0x0, sizeof(patTable));
+	patTable.patServiceInfoArray = services;
+	for (i = 0; i < CHANNEL_MAP_MAX_SERVICES; i++)
+	{
+		services[i].programNumber = i;
+		services[i].pid = 0x100 + i;
+	}
+	patTable.serviceInfoCount = 10;
+	patTable.serviceInfoCapacity = CHANNEL_MAP_MAX_SERVICES;
+
+	/* start up, as in stream controller before steady state mark */
+	unlink(SECTION_BENCH_EPG_PATH);
+	if (stringPoolInit() != STRING_POOL_NO_ERROR || channelMapInit(&patTable) != CM_NO_ERROR ||
+	    epgCacheOpen(SECTION_BENCH_EPG_PATH) != EPG_CACHE_NO_ERROR)
+	{
+		return -1;
+	}
+	heapStatsGet(&mark);
+	failures += benchCheck(mark.allocations != 0, "heap counting wrappers linked");
+
+	/* string pool: new chunks and more strings than hash table holds */
+	for (i = 0; i < SECTION_BENCH_STRINGS; i++)
+	{
+		snprintf(name, sizeof(name), "event name %u of a long running steady state", i);
+		handle = stringPoolIntern(name, strlen(name));
+		if (handle == STRING_HANDLE_EMPTY)
+		{
+			rejected++;
+			continue;
+		}
+		if (i == 0)
+		{
+			first = handle;
+		}
+		interned++;
+	}
+	failures += benchCheck(interned == STRING_POOL_MAX_STRINGS, "pool holds strings up to its limit");
+	failures += benchCheck(rejected == SECTION_BENCH_STRINGS - interned, "full pool rejects new strings");
+	failures += benchCheck(strcmp(stringPoolGet(first), "event name 0 of a long running steady state") == 0, "first string intact");
+
+	/* channel map: PAT grows to its largest size and shrinks again */
+	for (i = 1; i <= CHANNEL_MAP_MAX_SERVICES; i++)
+	{
+		patTable.serviceInfoCount = (i % 2) ? i : CHANNEL_MAP_MAX_SERVICES + 1 - i;
+		failures += benchCheck(channelMapUpdatePat(&patTable) == CM_NO_ERROR, "PAT update");
+	}
+	failures += benchCheck(channelMapGetCount() == patTable.serviceInfoCount, "channel map follows PAT");
+
+	/* EPG cache: renamed event fills string pool until it is compacted */
+	for (i = 0; i < SECTION_BENCH_NAME_UPDATES; i++)
+	{
+		memset(name, 'a' + i % 26, 200);
+		snprintf(name + 200, sizeof(name) - 200, "%u", i);
+		if (epgCacheAddEvent(1, 1, 0, 1800, 4, name) != EPG_CACHE_NO_ERROR)
+		{
+			break;
+		}
+	}
+	failures += benchCheck(i == SECTION_BENCH_NAME_UPDATES, "renamed event stored after pool compaction");
+	event = epgCacheGetEvent(1, 0);
+	failures += benchCheck(event != NULL && strcmp(epgCacheGetString(event->nameOffset), name) == 0, "last name kept by compaction");
+
+	allocations = heapStatsAllocationsSince(&mark);
+	failures += benchCheck(allocations == 0, "no heap allocation in steady state");
+
+	printf("\n********************STEADY STATE BENCH********************\n");
+	printf("interned strings         |      %u\n", interned);
+	printf("rejected strings         |      %u\n", rejected);
+	printf("PAT updates              |      %u\n", CHANNEL_MAP_MAX_SERVICES);
+	printf("event name updates       |      %u\n", SECTION_BENCH_NAME_UPDATES);
+	printf("steady state allocations |      %llu\n", (unsigned long long)allocations);
+	printf("failed checks            |      %u\n", failures);
+	printf("\n********************STEADY STATE BENCH********************\n");
+	printEpgCacheStats();
+	printStringPoolStats();
+
+	epgCacheClose();
+	channelMapDeinit();
+	stringPoolDeinit();
+	unlink(SECTION_BENCH_EPG_PATH);
+
+	return failures ? 1 : 0;
+}
+
+uint64_t benchTimeUs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+uint32_t benchCheck(uint8_t ok, const char* check)
+{
+	if (!ok)
+	{
+		printf("\n%s : ERROR check failed: %s\n", __FUNCTION__, check);
+		return 1;
+	}
+
+	return 0;
+}
+
+int32_t standInSetFilter(uint16_t pid, uint8_t tableId, uint32_t* filterHandle)
+{
+	uint8_t i;
+
+	if (pid == standIn.failPid)
+	{
+		standIn.failedCount++;
+		return -1;
+	}
+
+	for (i = 0; i < standIn.slotCount; i++)
+	{
+		if (!standIn.filters[i].used)
+		{
+			break;
+		}
+	}
+	if (i == standIn.slotCount)
+	{
+		standIn.refusedCount++;
+		return -1;
+	}
+
+	standIn.filters[i].used = 1;
+	standIn.filters[i].pid = pid;
+	standIn.filters[i].tableId = tableId;
+	standIn.usedCount++;
+	standIn.setCount++;
+	if (standIn.usedCount > standIn.maxUsedCount)
+	{
+		standIn.maxUsedCount = standIn.usedCount;
+	}
+	*filterHandle = i;
+
+	return 0;
+}
+
+int32_t standInFreeFilter(uint32_t filterHandle)
+{
+	if (filterHandle >= standIn.slotCount || !standIn.filters[filterHandle].used)
+	{
+		standIn.badFreeCount++;
+		return -1;
+	}
+
+	standIn.filters[filterHandle].used = 0;
+	standIn.usedCount--;
+	standIn.freeCount++;
+
+	return 0;
+}
+
+uint64_t standInGetTimeMs(void)
+{
+	return standIn.timeMs;
+}
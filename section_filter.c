@@ -0,0 +1,79 @@
+#include "section_filter.h"
+
+void sectionFilterInit(SectionFilter* sectionFilter, uint8_t tableId)
+{
+	memset(sectionFilter, 0x0, sizeof(SectionFilter));
+
+	/* table_id */
+	sectionFilter->value[0] = tableId;
+	sectionFilter->mask[0] = 0xFF;
+}
+
+void sectionFilterSetTableIdExtension(SectionFilter* sectionFilter, uint16_t tableIdExtension)
+{
+	/* table_id_extension - section bytes 3 and 4 */
+	sectionFilter->value[1] = (uint8_t) (tableIdExtension >> 8);
+	sectionFilter->mask[1] = 0xFF;
+	sectionFilter->value[2] = (uint8_t) (tableIdExtension & 0xFF);
+	sectionFilter->mask[2] = 0xFF;
+}
+
+void sectionFilterSetVersionNotEqual(SectionFilter* sectionFilter, uint8_t versionNumber)
+{
+	/* version_number - section byte 5, bits 5..1 */
+	sectionFilter->value[3] = (uint8_t) ((versionNumber & 0x1F) << 1);
+	sectionFilter->mask[3] = 0x3E;
+	sectionFilter->mode[3] = 0x3E;
+}
+
+void sectionFilterSetSectionNumber(SectionFilter* sectionFilter, uint8_t sectionNumber)
+{
+	/* section_number - section byte 6 */
+	sectionFilter->value[4] = sectionNumber;
+	sectionFilter->mask[4] = 0xFF;
+}
+
+uint8_t sectionFilterMatch(SectionFilter* sectionFilter, const uint8_t* sectionBuffer)
+{
+	uint8_t i = 0;
+	uint8_t sectionByte = 0;
+	uint8_t difference = 0;
+	uint8_t notEqual = 0;
+	uint8_t checkNotEqual = 0;
+
+	for (i = 0; i < SECTION_FILTER_SIZE; i++)
+	{
+		/* skip section_length bytes */
+		sectionByte = (i == 0) ? sectionBuffer[0] : sectionBuffer[i + 2];
+		difference = (sectionByte ^ sectionFilter->value[i]) & sectionFilter->mask[i];
+
+		if (difference & ~sectionFilter->mode[i])
+		{
+			break;
+		}
+
+		if (sectionFilter->mask[i] & sectionFilter->mode[i])
+		{
+			checkNotEqual = 1;
+			notEqual |= difference & sectionFilter->mode[i];
+		}
+	}
+
+	if (i == SECTION_FILTER_SIZE && (!checkNotEqual || notEqual))
+	{
+		sectionFilter->sectionsPassed++;
+		return 1;
+	}
+
+	/* section_length plus table_id and section_length fields */
+	sectionFilter->sectionsDropped++;
+	sectionFilter->bytesDropped += (((sectionBuffer[1] << 8) + sectionBuffer[2]) & 0x0FFF) + 3;
+
+	return 0;
+}
+
+void printSectionFilterStats(const char* name, const SectionFilter* sectionFilter)
+{
+	printf("%-8s filter | passed: %u | dropped: %u | bytes not parsed: %u\n", name,
+	       sectionFilter->sectionsPassed, sectionFilter->sectionsDropped, sectionFilter->bytesDropped);
+}
@@ -0,0 +1,77 @@
+#ifndef __SECTION_FILTER_H__
+#define __SECTION_FILTER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SECTION_FILTER_SIZE 8       /* Number of filtered section bytes (table_id and 7 bytes after section_length) */
+
+/**
+ * @brief Structure that defines software section filter
+ *
+ * Works like Linux DVB dmx_sct_filter_params: filter byte 0 is compared to table_id,
+ * filter bytes 1..7 are compared to section bytes 3..9 (section_length is skipped).
+ * Bits set in mask are compared, bits cleared in mode must be equal to value and
+ * bits set in mode must differ from value in at least one position.
+ */
+typedef struct _SectionFilter
+{
+	uint8_t value[SECTION_FILTER_SIZE];
+	uint8_t mask[SECTION_FILTER_SIZE];
+	uint8_t mode[SECTION_FILTER_SIZE];
+	uint32_t sectionsPassed;                    /* Number of sections that matched the filter */
+	uint32_t sectionsDropped;                   /* Number of sections dropped before parsing */
+	uint32_t bytesDropped;                      /* Number of section bytes that were not parsed */
+}SectionFilter;
+
+/**
+ * @brief Initializes filter to match only table id
+ *
+ * @param [out] sectionFilter - Section filter
+ * @param [in]  tableId - Table id to match
+ */
+void sectionFilterInit(SectionFilter* sectionFilter, uint8_t tableId);
+
+/**
+ * @brief Sets table_id_extension (program number, service id, transport stream id) to match
+ *
+ * @param [out] sectionFilter - Section filter
+ * @param [in]  tableIdExtension - Table id extension to match
+ */
+void sectionFilterSetTableIdExtension(SectionFilter* sectionFilter, uint16_t tableIdExtension);
+
+/**
+ * @brief Sets version number which is not accepted anymore (section passes only when version changes)
+ *
+ * @param [out] sectionFilter - Section filter
+ * @param [in]  versionNumber - Version number of already received table
+ */
+void sectionFilterSetVersionNotEqual(SectionFilter* sectionFilter, uint8_t versionNumber);
+
+/**
+ * @brief Sets section number to match
+ *
+ * @param [out] sectionFilter - Section filter
+ * @param [in]  sectionNumber - Section number to match
+ */
+void sectionFilterSetSectionNumber(SectionFilter* sectionFilter, uint8_t sectionNumber);
+
+/**
+ * @brief Checks section against filter and updates filter counters
+ *
+ * @param [in, out] sectionFilter - Section filter
+ * @param [in]      sectionBuffer - Buffer that contains table section
+ * @return 1 if section should be parsed, 0 if it should be dropped
+ */
+uint8_t sectionFilterMatch(SectionFilter* sectionFilter, const uint8_t* sectionBuffer);
+
+/**
+ * @brief Prints filter counters
+ *
+ * @param [in] name - Filter name
+ * @param [in] sectionFilter - Section filter
+ */
+void printSectionFilterStats(const char* name, const SectionFilter* sectionFilter);
+
+#endif /* __SECTION_FILTER_H__ */
@@ -0,0 +1,133 @@
+#include "section_queue.h"
+
+#include <errno.h>
+#include <time.h>
+
+SectionQueueError sectionQueueInit(SectionQueue* sectionQueue)
+{
+	if (sectionQueue == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return SQ_ERROR;
+	}
+
+	sectionQueue->writeIndex = 0;
+	sectionQueue->readIndex = 0;
+	sectionQueue->wakeupPending = 0;
+	sectionQueue->pushedCount = 0;
+	sectionQueue->wakeupCount = 0;
+	sectionQueue->droppedCount = 0;
+	sectionQueue->maxDepth = 0;
+
+	if (sem_init(&sectionQueue->available, 0, 0))
+	{
+		printf("\n%s : ERROR sem_init() fail\n", __FUNCTION__);
+		return SQ_ERROR;
+	}
+
+	return SQ_NO_ERROR;
+}
+
+void sectionQueueDeinit(SectionQueue* sectionQueue)
+{
+	sem_destroy(&sectionQueue->available);
+}
+
+SectionQueueError sectionQueuePush(SectionQueue* sectionQueue, const uint8_t* sectionBuffer)
+{
+	uint32_t writeIndex = sectionQueue->writeIndex;
+	uint32_t readIndex = __atomic_load_n(&sectionQueue->readIndex, __ATOMIC_ACQUIRE);
+	uint32_t sectionSize;
+
+	if (writeIndex - readIndex >= SECTION_QUEUE_SLOT_COUNT)
+	{
+		sectionQueue->droppedCount++;
+		return SQ_FULL;
+	}
+
+	/* section_length plus table_id and section_length fields */
+	sectionSize = (((sectionBuffer[1] << 8) + sectionBuffer[2]) & 0x0FFF) + 3;
+	if (sectionSize > SECTION_QUEUE_SLOT_SIZE)
+	{
+		sectionSize = SECTION_QUEUE_SLOT_SIZE;
+	}
+	memcpy(sectionQueue->slots[writeIndex & (SECTION_QUEUE_SLOT_COUNT - 1)], sectionBuffer, sectionSize);
+
+	/* slot content must be visible before the new write index, which must be visible before wake up check */
+	__atomic_store_n(&sectionQueue->writeIndex, writeIndex + 1, __ATOMIC_SEQ_CST);
+
+	sectionQueue->pushedCount++;
+	if (writeIndex + 1 - readIndex > sectionQueue->maxDepth)
+	{
+		sectionQueue->maxDepth = writeIndex + 1 - readIndex;
+	}
+
+	/* consumer that did not see this section yet gets one wake up for all of them */
+	if (!__atomic_exchange_n(&sectionQueue->wakeupPending, 1, __ATOMIC_SEQ_CST))
+	{
+		sectionQueue->wakeupCount++;
+		sem_post(&sectionQueue->available);
+	}
+
+	return SQ_NO_ERROR;
+}
+
+SectionQueueError sectionQueueWait(SectionQueue* sectionQueue, uint32_t timeoutMs)
+{
+	struct timespec waitTime;
+
+	clock_gettime(CLOCK_REALTIME, &waitTime);
+	waitTime.tv_sec += timeoutMs / 1000;
+	waitTime.tv_nsec += (timeoutMs % 1000) * 1000000;
+	if (waitTime.tv_nsec >= 1000000000)
+	{
+		waitTime.tv_sec++;
+		waitTime.tv_nsec -= 1000000000;
+	}
+
+	/* sections pushed before wake up flag was cleared are taken without waiting */
+	__atomic_store_n(&sectionQueue->wakeupPending, 0, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&sectionQueue->writeIndex, __ATOMIC_SEQ_CST) != sectionQueue->readIndex)
+	{
+		return SQ_NO_ERROR;
+	}
+
+	while (sem_timedwait(&sectionQueue->available, &waitTime))
+	{
+		if (errno != EINTR)
+		{
+			return SQ_TIMEOUT;
+		}
+	}
+
+	return SQ_NO_ERROR;
+}
+
+const uint8_t* sectionQueueFront(SectionQueue* sectionQueue)
+{
+	uint32_t readIndex = sectionQueue->readIndex;
+	uint32_t writeIndex = __atomic_load_n(&sectionQueue->writeIndex, __ATOMIC_ACQUIRE);
+
+	if (readIndex == writeIndex)
+	{
+		return NULL;
+	}
+
+	return sectionQueue->slots[readIndex & (SECTION_QUEUE_SLOT_COUNT - 1)];
+}
+
+void sectionQueueRelease(SectionQueue* sectionQueue)
+{
+	/* slot is handed back to producer only after consumer is done reading it */
+	__atomic_store_n(&sectionQueue->readIndex, sectionQueue->readIndex + 1, __ATOMIC_RELEASE);
+}
+
+void printSectionQueueStats(SectionQueue* sectionQueue)
+{
+	printf("\n********************SECTION QUEUE********************\n");
+	printf("pushed                   |      %u\n", sectionQueue->pushedCount);
+	printf("consumer wake ups posted |      %u\n", sectionQueue->wakeupCount);
+	printf("dropped (queue full)     |      %u\n", sectionQueue->droppedCount);
+	printf("max depth                |      %u / %d\n", sectionQueue->maxDepth, SECTION_QUEUE_SLOT_COUNT);
+	printf("\n********************SECTION QUEUE********************\n");
+}
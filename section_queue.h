@@ -0,0 +1,104 @@
+#ifndef __SECTION_QUEUE_H__
+#define __SECTION_QUEUE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <semaphore.h>
+
+#define SECTION_QUEUE_SLOT_SIZE     4096    /* Max private section size */
+#define SECTION_QUEUE_SLOT_COUNT    32      /* Number of queued sections, must be power of 2 */
+
+/**
+ * @brief Enumeration of section queue error codes
+ */
+typedef enum _SectionQueueError
+{
+	SQ_NO_ERROR = 0,
+	SQ_ERROR,
+	SQ_FULL,
+	SQ_EMPTY,
+	SQ_TIMEOUT
+}SectionQueueError;
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of raw sections
+ *
+ * Producer (demux callback) only copies section and publishes write index,
+ * it never blocks and never takes a mutex. Consumer (stream controller thread)
+ * reads sections in arrival order and publishes read index after it is done
+ * with the slot. Producer posts semaphore only when consumer may be waiting,
+ * one wake up covers all sections pushed until consumer waits again.
+ */
+typedef struct _SectionQueue
+{
+	uint8_t slots[SECTION_QUEUE_SLOT_COUNT][SECTION_QUEUE_SLOT_SIZE];
+	uint32_t writeIndex;                        /* Written only by producer */
+	uint32_t readIndex;                         /* Written only by consumer */
+	sem_t available;
+	uint32_t wakeupPending;                     /* Set by producer when it posts semaphore, cleared by consumer before it waits */
+	uint32_t pushedCount;                       /* Written only by producer */
+	uint32_t wakeupCount;                       /* Written only by producer, semaphore posts */
+	uint32_t droppedCount;                      /* Written only by producer, sections lost because queue was full */
+	uint32_t maxDepth;                          /* Written only by producer */
+}SectionQueue;
+
+/**
+ * @brief Initializes empty section queue
+ *
+ * @param [out] sectionQueue - Section queue
+ * @return section queue error code
+ */
+SectionQueueError sectionQueueInit(SectionQueue* sectionQueue);
+
+/**
+ * @brief Deinitializes section queue
+ *
+ * @param [in] sectionQueue - Section queue
+ */
+void sectionQueueDeinit(SectionQueue* sectionQueue);
+
+/**
+ * @brief Copies section to queue, producer side
+ *
+ * @param [in] sectionQueue - Section queue
+ * @param [in] sectionBuffer - Buffer that contains table section
+ * @return SQ_NO_ERROR, SQ_FULL if section was dropped
+ */
+SectionQueueError sectionQueuePush(SectionQueue* sectionQueue, const uint8_t* sectionBuffer);
+
+/**
+ * @brief Waits until a section is available, consumer side
+ *
+ * Consumer is expected to take all queued sections after each wait. Rarely the wait
+ * returns with empty queue, for a wake up whose sections were already taken.
+ *
+ * @param [in] sectionQueue - Section queue
+ * @param [in] timeoutMs - Max wait time
+ * @return SQ_NO_ERROR if section is available, SQ_TIMEOUT otherwise
+ */
+SectionQueueError sectionQueueWait(SectionQueue* sectionQueue, uint32_t timeoutMs);
+
+/**
+ * @brief Returns oldest queued section without removing it, consumer side
+ *
+ * @param [in] sectionQueue - Section queue
+ * @return pointer to section or NULL if queue is empty
+ */
+const uint8_t* sectionQueueFront(SectionQueue* sectionQueue);
+
+/**
+ * @brief Releases oldest queued section slot back to producer, consumer side
+ *
+ * @param [in] sectionQueue - Section queue
+ */
+void sectionQueueRelease(SectionQueue* sectionQueue);
+
+/**
+ * @brief Prints queue counters
+ *
+ * @param [in] sectionQueue - Section queue
+ */
+void printSectionQueueStats(SectionQueue* sectionQueue);
+
+#endif /* __SECTION_QUEUE_H__ */
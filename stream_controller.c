@@ -1,15 +1,35 @@
 #include "stream_controller.h"
 
 
-/* Pointers to PAT, PMT  and EIT table structures */
+/* Pointers to PAT, PMT  and EIT table structures of current versions, used by stream controller thread */
 static PatTable *patTable;
 static PmtTable *pmtTable;
 static EitTable *eitTable;
 
-/* Buffer for arrived EIT table info */
+/* Buffer for arrived EIT table info, part of current PAT version */
 static eitBufferElement *eitBuffer;
 static int32_t eitBufferSize = 0;
 
+/* Arenas of current table versions, other threads acquire PAT arena before reading it */
+static TableArena *patArena = NULL;
+static TableArena *pmtArena = NULL;
+static TableArena *eitArena = NULL;
+static TableArena *backgroundArena = NULL;
+
+/* Live PMT decoded from TS packets as they arrive, streams are started before demux delivers whole section */
+static PmtStreamParser livePmtParser;
+static EarlyPmt earlyPmt;                               /* Written by packet thread */
+static pthread_mutex_t earlyPmtMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t earlyVideoStarted = 0;                   /* Running stream was created from unconfirmed PMT */
+static uint8_t earlyAudioStarted = 0;
+static uint64_t earlyStartTimeUs = 0;
+static uint32_t earlyStartCount = 0;                    /* Zaps whose streams were started early */
+static uint32_t earlyRollbackCount = 0;
+static uint64_t earlyLeadSumUs = 0;                     /* Time won over waiting for whole PMT section */
+
+/* Heap counters when start up finished */
+static HeapStats steadyStateHeapStats;
+
 static pthread_cond_t statusCondition = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t statusMutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -17,13 +37,64 @@ static pthread_mutex_t statusMutex = PTHREAD_MUTEX_INITIALIZER;
 static int32_t sectionReceivedCallback(uint8_t *buffer);
 static int32_t tunerStatusCallback(t_LockStatus status);
 static ProgramTypeCallback programType = NULL;
+static ScramblingCallback scramblingNotify = NULL;
 
 /* TDP API handles */
 static uint32_t playerHandle = 0;
 static uint32_t sourceHandle = 0;
 static uint32_t streamHandleA = 0;
 static uint32_t streamHandleV = 0;
-static uint32_t filterHandle = 0;
+
+/* Filter scheduler request ids */
+static int32_t patRequestId = -1;
+static int32_t pmtRequestId = -1;
+static int32_t eitRequestId = -1;
+static int32_t tdtRequestId = -1;
+
+/* Background PMT acquisition of all services in PAT */
+static BackgroundPmt *backgroundPmt;
+static int32_t backgroundPmtCount = 0;
+
+/* Time of last service state update */
+static uint64_t serviceStateTimeUs = 0;
+
+/* Broadcast clock acquisition and EPG cache sync times */
+static uint64_t tdtTimeUs = 0;
+static uint64_t epgSyncTimeUs = 0;
+static TdtTable tdtTable;
+
+/* Transport stream of tuned frequency from channel database, valid until next channelDbStore() */
+static const ChannelDbTransportStream* dbTransportStream = NULL;
+
+/* Stream types of running streams */
+static uint8_t currentVideoType = 0;
+static uint8_t currentAudioType = 0;
+
+/* Scrambling of watched service when its streams were last started */
+static ScramblingState currentScrambling = SCRAMBLING_UNKNOWN;
+
+/* Cold start timing, monotonic times */
+static uint64_t bootTimeUs = 0;
+static uint64_t lockTimeUs = 0;
+static uint64_t firstStreamTimeUs = 0;                  /* First Player_Stream_Create() */
+static uint64_t livePmtTimeUs = 0;                      /* Streams of first live PMT running */
+static uint8_t lastServiceResumed = 0;
+static uint32_t streamRecreateCount = 0;                /* Running stream replaced by one with other pid or type */
+static uint32_t speculationRecreateCount = 0;           /* Replacements done by first live PMT */
+
+/* New PAT version, channel map and background acquisition follow it in stream controller loop */
+static uint8_t patUpdatePending = 0;
+static uint8_t patIndexMoved = 0;                       /* Watched service got other channel number */
+static uint32_t patUpdateCount = 0;
+static uint32_t patServicesAdded = 0;
+static uint32_t patServicesRemoved = 0;
+
+/* New version of live PMT while service is watched, applied by stream controller thread */
+static uint8_t pmtUpdatePending = 0;
+static uint8_t pmtUpdateDiff = PMT_DIFF_NONE;           /* Changes of all versions since last apply */
+static uint32_t pmtUpdateCount = 0;
+static uint32_t pmtUpdateQuietCount = 0;                /* Updates applied without touching streams */
+static uint32_t pmtUpdateGlitchCount = 0;               /* Streams removed or recreated by updates */
 
 /* Thread exit flag */
 static uint8_t threadExit = 0;
@@ -37,15 +108,32 @@ static ChannelInfo currentChannel;
 static bool isInitialized = false;
 
 /* EIT table event name and genre temporary holders */
-static char eventName[128];
-static char eventGenre[128];
+static StringHandle eventName = STRING_HANDLE_EMPTY;
+static StringHandle eventGenre = STRING_HANDLE_EMPTY;
+
+/* Present event name of watched service from EPG cache, interned by stream controller thread */
+static StringHandle cachedEventName = STRING_HANDLE_EMPTY;
+static uint16_t watchedServiceId = 0;
 
 static struct timespec lockStatusWaitTime;
 static struct timeval now;
 static pthread_t scThread;
 
-static pthread_cond_t demuxCond = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t demuxMutex = PTHREAD_MUTEX_INITIALIZER;
+/* Sections queued by demux callback, consumed by stream controller thread */
+static SectionQueue sectionQueue;
+
+/* Software section filters, applied before parsing */
+static SectionFilter patFilter;
+static SectionFilter pmtFilter;
+static SectionFilter eitFilter;
+
+/* Table arrival flags, used only by stream controller thread */
+static uint8_t patReceived = 0;
+static uint8_t pmtReceived = 0;
+static uint8_t eitReceived = 0;
+
+/* Channel whose PMT did not arrive in time, started from stream controller loop when it does */
+static int32_t pmtLateChannel = -1;
 
 /**
  * @brief - Stream controller main thread function
@@ -63,22 +151,297 @@ static void* streamControllerTask();
  */
 static void startChannel(int32_t channelNumber);
 
+/**
+ * @brief - Starts streams of channel from its live PMT and sets filter of its present event.
+ *
+ * @param channelNumber - Desired channel number.
+ */
+static void startChannelPmtReceived(int32_t channelNumber);
+
+/**
+ * @brief - Creates audio and video streams of channel from current PMT table.
+ *
+ * @param channelNumber - Desired channel number.
+ */
+static void startStreams(int32_t channelNumber);
+
+/**
+ * @brief - Starts channel from channel database before live tables arrive.
+ *
+ * @param channelNumber - Desired channel number.
+ */
+static void startChannelFromDb(int32_t channelNumber);
+
+/**
+ * @brief - Resumes last watched service, creates its streams right away if speculative start is enabled.
+ */
+static void startLastService(void);
+
+/**
+ * @brief - Stores channel as last watched service.
+ *
+ * @param channelNumber - Channel number.
+ */
+static void saveLastService(int32_t channelNumber);
+
+/**
+ * @brief - Prints time from stream controller start to tuner lock, first stream and live PMT.
+ */
+static void printColdStartStats(void);
+
+/**
+ * @brief - Applies new version of live PMT, only streams whose pid or type changed are recreated.
+ */
+static void applyPmtUpdate(void);
+
+/**
+ * @brief - Prints number of live PMT updates and playback interruptions caused by them.
+ */
+static void printPmtUpdateStats(void);
+
+/**
+ * @brief - Copies stored PMTs of transport stream into channel map.
+ *
+ * @param transportStream - Stored transport stream
+ */
+static void seedChannelMap(const ChannelDbTransportStream* transportStream);
+
+/**
+ * @brief - Processes queued sections until live PMT arrives, streams are started early from PMT packets.
+ *
+ * @param channelNumber - Channel number.
+ * @param timeoutMs - Max wait time
+ *
+ * @return - SC_ERROR if PMT did not arrive in time or thread exits
+ */
+static StreamControllerError waitForPmt(int32_t channelNumber, uint32_t timeoutMs);
+
+/**
+ * @brief - Starts streams of elementary streams decoded from PMT packets, rolls back revoked ones.
+ */
+static void serviceEarlyPmt(void);
+
+/**
+ * @brief - Removes streams started from PMT whose CRC failed.
+ */
+static void rollbackEarlyStreams(void);
+
+/**
+ * @brief - PMT stream parser notifications, run in packet thread with earlyPmtMutex held.
+ */
+static void earlyPmtHeader(const PmtTableHeader* pmtHeader);
+static void earlyPmtElementaryStream(const PmtElementaryInfo* elementaryInfo);
+static void earlyPmtSectionEnd(uint8_t crcOk);
+
+/**
+ * @brief - Processes queued sections and background work until the table arrival flag is set.
+ *
+ * @param received - Table arrival flag
+ * @param timeoutMs - Max wait time
+ *
+ * @return - SC_ERROR if table did not arrive in time or thread exits
+ */
+static StreamControllerError waitForTable(uint8_t* received, uint32_t timeoutMs);
+
+/**
+ * @brief - Waits for queued sections and processes all of them in arrival order.
+ *
+ * @param timeoutMs - Max wait time for first section
+ */
+static void processSections(uint32_t timeoutMs);
+
+/**
+ * @brief - Filters and parses one section, runs in stream controller thread.
+ *
+ * @param buffer - Buffer that contains table section
+ */
+static void sectionProcess(const uint8_t* buffer);
+
+/**
+ * @brief - Returns next channel in direction, skipping off-air services if enabled.
+ *
+ * @param channel - Current channel
+ * @param direction - 1 for up, -1 for down
+ *
+ * @return - Next channel
+ */
+static int16_t nextChannel(int16_t channel, int8_t direction);
+
+/**
+ * @brief - Adds background PMT filter requests for services in PAT whose PMT is not in channel map yet.
+ */
+static void startBackgroundAcquisition();
+
+/**
+ * @brief - Removes filter requests of background PMTs that already arrived.
+ */
+static void serviceBackgroundAcquisition();
+
+/**
+ * @brief - Removes all background PMT filter requests.
+ */
+static void stopBackgroundAcquisition();
+
+/**
+ * @brief - Finds service in PAT.
+ *
+ * @param table - PAT table
+ * @param serviceProgramNumber - Program number of service
+ *
+ * @return - Index of service in PAT, -1 if not found
+ */
+static int32_t patFindService(const PatTable* table, uint16_t serviceProgramNumber);
+
+/**
+ * @brief - Compares new PAT version with current one, moves watched service to its new channel number.
+ *
+ * @param oldTable - PAT version in use
+ * @param newTable - New PAT version
+ */
+static void patVersionChanged(const PatTable* oldTable, const PatTable* newTable);
+
+/**
+ * @brief - Updates channel map and background PMT acquisition after PAT version change.
+ */
+static void applyPatUpdate(void);
+
+/**
+ * @brief - Prints number of PAT versions and services added or removed by them.
+ */
+static void printPatUpdateStats(void);
+
+/**
+ * @brief - Opens arena of new table version and allocates table structure from it.
+ *
+ * @param arena - Opened arena
+ * @param size - Size of table structure
+ *
+ * @return - Zeroed table structure or NULL
+ */
+static void* tableVersionOpen(TableArena** arena, uint32_t size);
+
+/**
+ * @brief - Opens arena of new PAT version with room for given number of services.
+ *
+ * @param arena - Opened arena
+ * @param serviceInfoCount - Number of services, from countPatServiceInfos()
+ *
+ * @return - PAT version or NULL
+ */
+static PatGeneration* patGenerationOpen(TableArena** arena, uint8_t serviceInfoCount);
+
+/**
+ * @brief - Opens arena of new PMT version with room for given number of elementary streams.
+ *
+ * @param arena - Opened arena
+ * @param elementaryInfoCount - Number of elementary streams, from countPmtElementaryInfos()
+ *
+ * @return - PMT table or NULL
+ */
+static PmtTable* pmtVersionOpen(TableArena** arena, uint8_t elementaryInfoCount);
+
+/**
+ * @brief - Opens arena of new EIT version with room for given number of events.
+ *
+ * @param arena - Opened arena
+ * @param eventInfoCount - Number of events, from countEitEventInfos()
+ *
+ * @return - EIT table or NULL
+ */
+static EitTable* eitVersionOpen(TableArena** arena, uint8_t eventInfoCount);
+
+/**
+ * @brief - Allocates EIT info buffer of parsed PAT and makes it current PAT version.
+ *          Present events of services still in PAT are carried over from previous version.
+ *
+ * @param arena - Open arena of PAT version
+ */
+static void patGenerationPublish(TableArena* arena);
+
+/**
+ * @brief - Allocates table arenas and empty table versions used until first tables arrive.
+ *
+ * @return - Stream controller error code
+ */
+static StreamControllerError tablesInit(void);
+
+/**
+ * @brief - Retires all table versions, reports arenas still in use and frees arenas.
+ */
+static void tablesDeinit(void);
+
+/**
+ * @brief - Demux operations used by filter scheduler.
+ */
+static int32_t demuxSetFilter(uint16_t pid, uint8_t tableId, uint32_t* filterHandle);
+static int32_t demuxFreeFilter(uint32_t filterHandle);
+static uint64_t getTimeMs(void);
+
+/**
+ * @brief - Returns monotonic time in microseconds.
+ */
+static uint64_t getTimeUs(void);
+
+/**
+ * @brief - Copies name of event that runs at given time from EPG cache, safe to call from any thread.
+ *
+ * @param serviceId - service_id
+ * @param utcTime - UTC time
+ * @param buffer - Copied name
+ * @param size - Size of buffer
+ *
+ * @return - 1 if service has event at given time
+ */
+static uint8_t copyCachedPresentName(uint16_t serviceId, uint32_t utcTime, char* buffer, uint32_t size);
+
+/**
+ * @brief - Interns present event name of watched service from EPG cache, runs in stream controller thread.
+ */
+static void updateCachedEventName(void);
+
 /* Holds user input */
 static InputConfig inputConfigFromApp;
 
+static const DemuxFilterOps demuxFilterOps =
+{
+	demuxSetFilter,
+	demuxFreeFilter,
+	getTimeMs
+};
+
+static const PmtStreamParserOps earlyPmtOps =
+{
+	earlyPmtHeader,
+	earlyPmtElementaryStream,
+	earlyPmtSectionEnd
+};
+
 StreamControllerError streamControllerInit(InputConfig inputConfig)
 {
+	/* get user config on init */
+	inputConfigFromApp = inputConfig;
+	if (inputConfigFromApp.filterSlots == 0)
+	{
+		inputConfigFromApp.filterSlots = DEMUX_FILTER_SLOTS;
+	}
+	/* set initial channel to user config */
+	programNumber = inputConfigFromApp.programNumber;
+
+	/* strings are interned only by stream controller thread from now on */
+	if (stringPoolInit() != STRING_POOL_NO_ERROR)
+	{
+		printf("\n%s : ERROR stringPoolInit() fail\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+	/* TODO: Genre not implemented yet */
+	eventGenre = stringPoolIntern("Genre not implemented yet!", strlen("Genre not implemented yet!"));
+
 	if (pthread_create(&scThread, NULL, &streamControllerTask, NULL))
 	{
 		printf("Error creating input event task!\n");
 		return SC_THREAD_ERROR;
 	}
 
-	/* get user config on init */
-	inputConfigFromApp = inputConfig;
-	/* set initial channel to user config */
-	programNumber = inputConfigFromApp.programNumber;
-
 	/* set default volume */
 	setVolume(5);
 
@@ -87,6 +450,8 @@ StreamControllerError streamControllerInit(InputConfig inputConfig)
 
 StreamControllerError streamControllerDeinit()
 {
+	uint64_t steadyStateAllocations;
+
 	if (!isInitialized)
 	{
 		printf("\n%s : ERROR streamControllerDeinit() fail, module is not initialized!\n", __FUNCTION__);
@@ -100,8 +465,15 @@ StreamControllerError streamControllerDeinit()
 		return SC_THREAD_ERROR;
 	}
 
-	/* free demux filter */
-	Demux_Free_Filter(playerHandle, filterHandle);
+	printColdStartStats();
+	printPmtStreamParserStats("LIVE", &livePmtParser);
+	printPatUpdateStats();
+	printPmtUpdateStats();
+	printFilterSchedulerStats();
+	printSectionQueueStats(&sectionQueue);
+
+	/* free demux filters */
+	filterSchedulerDeinit();
 
 	/* remove audio stream */
 	Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
@@ -118,28 +490,41 @@ StreamControllerError streamControllerDeinit()
 	/* deinitialize tuner device */
 	Tuner_Deinit();
 
+	printSectionFilterCounters();
+
+	/* deinit below only frees, taken before it so frees of start up memory are not mixed in */
+	steadyStateAllocations = heapStatsAllocationsSince(&steadyStateHeapStats);
+
 	/* free allocated memory */
-	free(patTable);
-	free(pmtTable);
-	free(eitTable);
-	free(eitBuffer);
+	sectionQueueDeinit(&sectionQueue);
+	channelMapDeinit();
+	channelDbClose();
+	printEpgCacheStats();
+	epgCacheClose();
+	printStringPoolStats();
+	stringPoolDeinit();
+	printTableArenaStats();
+	tablesDeinit();
+
+	/* table versions change without heap allocations, everything allocated at start up is freed by now */
+	printHeapStats("steady state", &steadyStateHeapStats);
 
 	/* set isInitialized flag */
 	isInitialized = false;
 
+	/* string pool, channel map and EPG compaction buffers are allocated at start up, any other allocation is a regression */
+	if (steadyStateAllocations != 0)
+	{
+		printf("\n%s : ERROR %llu heap allocations in steady state\n", __FUNCTION__, (unsigned long long)steadyStateAllocations);
+		return SC_ERROR;
+	}
+
 	return SC_NO_ERROR;
 }
 
 StreamControllerError channelUp()
 {
-	if (programNumber >= patTable->serviceInfoCount - 2)
-	{
-		programNumber = 0;
-	}
-	else
-	{
-		programNumber++;
-	}
+	programNumber = nextChannel(programNumber, 1);
 
 	/* set flag to start current channel */
 	changeChannel = true;
@@ -149,14 +534,7 @@ StreamControllerError channelUp()
 
 StreamControllerError channelDown()
 {
-	if (programNumber <= 0)
-	{
-		programNumber = patTable->serviceInfoCount - 2;
-	}
-	else
-	{
-		programNumber--;
-	}
+	programNumber = nextChannel(programNumber, -1);
 
 	/* set flag to start current channel */
 	changeChannel = true;
@@ -164,6 +542,44 @@ StreamControllerError channelDown()
 	return SC_NO_ERROR;
 }
 
+int16_t nextChannel(int16_t channel, int8_t direction)
+{
+	TableArena* arena;
+	int16_t channelCount;
+	int16_t i;
+
+	/* called from application thread, PAT version is kept until next channel is found */
+	arena = tableArenaAcquire(&patArena);
+	if (arena == NULL)
+	{
+		return channel;
+	}
+	channelCount = ((PatGeneration*)arena->root)->patTable.serviceInfoCount - 1;
+
+	for (i = 0; i < channelCount; i++)
+	{
+		channel += direction;
+		if (channel >= channelCount)
+		{
+			channel = 0;
+		}
+		else if (channel < 0)
+		{
+			channel = channelCount - 1;
+		}
+
+		/* channel map is indexed like PAT, entry 0 is network information table */
+		if (!inputConfigFromApp.skipDeadServices || channelMapGetServiceState(channel + 1) != SERVICE_STATE_OFF_AIR)
+		{
+			break;
+		}
+		printf("\n%s : skipping off-air channel %d\n", __FUNCTION__, channel + 1);
+	}
+	tableArenaRelease(arena);
+
+	return channel;
+}
+
 StreamControllerError getChannelInfo(ChannelInfo* channelInfo)
 {
 	if (channelInfo == NULL)
@@ -176,7 +592,8 @@ StreamControllerError getChannelInfo(ChannelInfo* channelInfo)
 	channelInfo->audioPid = currentChannel.audioPid;
 	channelInfo->videoPid = currentChannel.videoPid;
 	channelInfo->hasTeletext = currentChannel.hasTeletext;
-	strcpy(channelInfo->eventName, eventName);
+	channelInfo->eventName = eventName;
+	channelInfo->eventGenre = eventGenre;
 
 	return SC_NO_ERROR;
 }
@@ -187,262 +604,1252 @@ StreamControllerError getChannelInfo(ChannelInfo* channelInfo)
  */
 void startChannel(int32_t channelNumber)
 {
-	/* free PAT table filter */
-	Demux_Free_Filter(playerHandle, filterHandle);
+	/* PAT entries are sized exactly, channel entered by number or from old PAT may not exist */
+	if (channelNumber < 0 || channelNumber + 1 >= patTable->serviceInfoCount)
+	{
+		printf("\n%s : ERROR channel %d not in PAT\n", __FUNCTION__, channelNumber + 1);
+		return;
+	}
+
+	/* PMT and EIT of previously watched service are not needed anymore */
+	if (pmtRequestId != -1)
+	{
+		filterSchedulerRemove(pmtRequestId);
+		pmtRequestId = -1;
+	}
+	if (eitRequestId != -1)
+	{
+		filterSchedulerRemove(eitRequestId);
+		eitRequestId = -1;
+	}
 
-	/* set demux filter for receive PMT table of program */
-	if(Demux_Set_Filter(playerHandle, patTable->patServiceInfoArray[channelNumber + 1].pid, 0x02, &filterHandle))
+	/* accept only PMT of selected program, PMT pid can be shared by several programs */
+	sectionFilterInit(&pmtFilter, 0x02);
+	sectionFilterSetTableIdExtension(&pmtFilter, patTable->patServiceInfoArray[channelNumber + 1].programNumber);
+
+	/* name of previous run is shown until present event of service arrives */
+	watchedServiceId = patTable->patServiceInfoArray[channelNumber + 1].programNumber;
+	updateCachedEventName();
+
+	pmtReceived = 0;
+	pmtLateChannel = -1;
+	pmtUpdatePending = 0;
+	pmtUpdateDiff = PMT_DIFF_NONE;
+
+	/* PMT packets are decoded as they arrive, streams can start before demux delivers whole section */
+	pthread_mutex_lock(&earlyPmtMutex);
+	pmtStreamParserInit(&livePmtParser, patTable->patServiceInfoArray[channelNumber + 1].pid,
+	                    patTable->patServiceInfoArray[channelNumber + 1].programNumber, &earlyPmtOps);
+	memset(&earlyPmt, 0x0, sizeof(EarlyPmt));
+	earlyPmt.videoPid = -1;
+	earlyPmt.audioPid = -1;
+	pthread_mutex_unlock(&earlyPmtMutex);
+	earlyStartTimeUs = 0;
+
+	/* set demux filter for receive PMT table of program, it stays set as live PMT monitor */
+	if(filterSchedulerAdd(patTable->patServiceInfoArray[channelNumber + 1].pid, 0x02, FILTER_PRIORITY_LIVE, &pmtRequestId))
 	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+		printf("\n%s : ERROR filterSchedulerAdd() fail\n", __FUNCTION__);
 		return;
 	}
 
 	/* wait for a PMT table to be parsed*/
-	pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
+	if (waitForPmt(channelNumber, PMT_TIMEOUT_MS) != SC_NO_ERROR)
+	{
+		printf("\n%s : ERROR PMT parse timeout exceeded!\n", __FUNCTION__);
+		pmtLateChannel = channelNumber;
+		return;
+	}
+
+	startChannelPmtReceived(channelNumber);
+	if (eitRequestId == -1)
+	{
+		return;
+	}
+
+	/* wait for a EIT table to be parsed, channel runs without present event if it does not come */
+	if (waitForTable(&eitReceived, EIT_TIMEOUT_MS) != SC_NO_ERROR)
 	{
-		printf("\n%s : ERROR Lock timeout exceeded!\n", __FUNCTION__);
-		streamControllerDeinit();
+		printf("\n%s : ERROR EIT parse timeout exceeded!\n", __FUNCTION__);
+		return;
 	}
-	pthread_mutex_unlock(&demuxMutex);
+
+	printf("\nParsed EIT table!\n");
+}
+
+void startChannelPmtReceived(int32_t channelNumber)
+{
+	uint32_t recreateCount;
 
 	printf("\nParsed PMT table!\n");
 
-	/* free PMT table filter */
-	Demux_Free_Filter(playerHandle, filterHandle);
+	recreateCount = streamRecreateCount;
+	startStreams(channelNumber);
+
+	/* streams started from PMT packets are confirmed by whole section */
+	if (earlyStartTimeUs != 0)
+	{
+		earlyLeadSumUs += getTimeUs() - earlyStartTimeUs;
+	}
+	earlyVideoStarted = 0;
+	earlyAudioStarted = 0;
+
+	/* first live PMT validates streams started before it */
+	if (livePmtTimeUs == 0)
+	{
+		livePmtTimeUs = getTimeUs();
+		speculationRecreateCount = streamRecreateCount - recreateCount;
+		printColdStartStats();
+	}
+	saveLastService(channelNumber);
+
+	/* EIT table parsing */
+	/* accept only present event section of selected service */
+	sectionFilterInit(&eitFilter, 0x4E);
+	sectionFilterSetTableIdExtension(&eitFilter, patTable->patServiceInfoArray[channelNumber + 1].programNumber);
+	sectionFilterSetSectionNumber(&eitFilter, 0);
+
+	eitReceived = 0;
+
+	/* set demux filter for receive EIT  actual TS present/following table of program */
+	if(filterSchedulerAdd(0x0012, 0x4E, FILTER_PRIORITY_PRESENT_FOLLOWING, &eitRequestId))
+	{
+		printf("\n%s : ERROR filterSchedulerAdd() fail\n", __FUNCTION__);
+	}
+}
+
+/* Creates streams of channel from PMT table in pmtTable
+ * Streams whose pids did not change are left running
+ */
+void startStreams(int32_t channelNumber)
+{
+	ScramblingState scrambling;
+	PmtSelection selection;
+	uint8_t scrambled;
+
+	channelMapSetPmt(pmtTable);
+
+	/* CA descriptors and packet scrambling bits decide if service can be decoded at all */
+	channelMapUpdateServiceStates(getTimeUs());
+	scrambling = channelMapGetScrambling(channelNumber + 1);
+	currentScrambling = scrambling;
+
+	/* only packets seen scrambled stop playback, CA descriptor alone may be a clear or simulcrypt service */
+	scrambled = (scrambling == SCRAMBLING_SCRAMBLED);
+	if (scrambling == SCRAMBLING_CA_SIGNALLED)
+	{
+		printf("\n%s : service %d signals CA, trying to play\n", __FUNCTION__, channelNumber + 1);
+	}
+
+	/* PCR of watched service is checked by transport stream monitor */
+	tsMonitorSetPcrPid(pmtTable->pmtHeader.pcrPid);
 
 	/* Get audio and video pids */
-	int16_t audioPid = -1;
-	int16_t videoPid = -1;
-	uint8_t i = 0;
-	for (i = 0; i < pmtTable->elementaryInfoCount; i++)
+	pmtSelectStreams(pmtTable, &selection);
+	int16_t audioPid = selection.audioPid;
+	int16_t videoPid = selection.videoPid;
+	uint8_t audioType = selection.audioType;
+	uint8_t videoType = selection.videoType;
+	currentChannel.hasTeletext = selection.hasTeletext;
+
+	/* scrambled service gets no streams instead of a black screen, previous streams are stopped */
+	if (scrambled)
 	{
-		if (((pmtTable->pmtElementaryInfoArray[i].streamType == 0x1) || (pmtTable->pmtElementaryInfoArray[i].streamType == 0x2) || (pmtTable->pmtElementaryInfoArray[i].streamType == 0x1b))
-		    && (videoPid == -1))
-		{
-			videoPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
-		}
-		else if (((pmtTable->pmtElementaryInfoArray[i].streamType == 0x3) || (pmtTable->pmtElementaryInfoArray[i].streamType == 0x4))
-		         && (audioPid == -1))
+		printf("\n%s : service %d is scrambled, streams are not created\n", __FUNCTION__, channelNumber + 1);
+		if (streamHandleV != 0)
 		{
-			audioPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
+			Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
+			streamHandleV = 0;
 		}
-
-		/* check for teletext */
-		if(pmtTable->pmtElementaryInfoArray[i].teletext == 1)
+		if (streamHandleA != 0)
 		{
-			currentChannel.hasTeletext = 1;
+			Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
+			streamHandleA = 0;
 		}
 	}
 
-	if (videoPid != -1)
+	if (videoPid != -1 && !scrambled)
 	{
-		/* remove previous video stream */
-		if (streamHandleV != 0)
+		/* stream already started with the same pid and type, e.g. speculatively, is kept */
+		if (streamHandleV == 0 || videoPid != currentChannel.videoPid || videoType != currentVideoType)
 		{
-			Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
+			/* remove previous video stream */
+			if (streamHandleV != 0)
+			{
+				Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
+				streamHandleV = 0;
+				streamRecreateCount++;
+			}
+
+			/* create video stream */
+			if(Player_Stream_Create(playerHandle, sourceHandle, videoPid, VIDEO_TYPE_MPEG2, &streamHandleV))
+			{
+				printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
+				streamControllerDeinit();
+			}
+			else if (firstStreamTimeUs == 0)
+			{
+				firstStreamTimeUs = getTimeUs();
+			}
+		}
+	}
+
+	if (programType != NULL)
+	{
+		programType(videoPid);
+	}
+	if (scramblingNotify != NULL)
+	{
+		scramblingNotify(scrambled);
+	}
+
+	if (audioPid != -1 && !scrambled)
+	{
+		if (streamHandleA == 0 || audioPid != currentChannel.audioPid || audioType != currentAudioType)
+		{
+			/* remove previos audio stream */
+			if (streamHandleA != 0)
+			{
+				Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
+				streamHandleA = 0;
+				streamRecreateCount++;
+			}
+
+			/* create audio stream */
+			if(Player_Stream_Create(playerHandle, sourceHandle, audioPid, AUDIO_TYPE_MPEG_AUDIO, &streamHandleA))
+			{
+				printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
+				streamControllerDeinit();
+			}
+			else if (firstStreamTimeUs == 0)
+			{
+				firstStreamTimeUs = getTimeUs();
+			}
+		}
+	}
+
+	/* store current channel info */
+	currentChannel.programNumber = channelNumber + 1;
+	currentChannel.audioPid = audioPid;
+	currentChannel.videoPid = videoPid;
+	currentAudioType = audioType;
+	currentVideoType = videoType;
+}
+
+void* streamControllerTask()
+{
+	bootTimeUs = getTimeUs();
+	gettimeofday(&now,NULL);
+	lockStatusWaitTime.tv_sec = now.tv_sec+10;
+
+	/* all table memory comes from arenas, allocated once here */
+	if(tablesInit() != SC_NO_ERROR)
+	{
+		printf("\n%s : ERROR tablesInit() fail\n", __FUNCTION__);
+		return (void*) SC_ERROR;
+	}
+
+	/* reset transport stream statistics */
+	tsMonitorInit();
+
+	/* initialize queue for sections from demux callback */
+	if(sectionQueueInit(&sectionQueue) != SQ_NO_ERROR)
+	{
+		printf("\n%s : ERROR sectionQueueInit() fail\n", __FUNCTION__);
+		tablesDeinit();
+		return (void*) SC_ERROR;
+	}
+
+	/* initialize tuner device */
+	if(Tuner_Init())
+	{
+		printf("\n%s : ERROR Tuner_Init() fail\n", __FUNCTION__);
+		tablesDeinit();
+		return (void*) SC_ERROR;
+	}
+
+	/* register tuner status callback */
+	if(Tuner_Register_Status_Callback(tunerStatusCallback))
+	{
+		printf("\n%s : ERROR Tuner_Register_Status_Callback() fail\n", __FUNCTION__);
+	}
+
+	/* lock to frequency */
+	if(!Tuner_Lock_To_Frequency(inputConfigFromApp.frequency, inputConfigFromApp.bandwidth, inputConfigFromApp.module))
+	{
+		printf("\n%s: INFO Tuner_Lock_To_Frequency(): %d Hz - success!\n",__FUNCTION__,inputConfigFromApp.frequency);
+	}
+	else
+	{
+		printf("\n%s: ERROR Tuner_Lock_To_Frequency(): %d Hz - fail!\n",__FUNCTION__,inputConfigFromApp.frequency);
+		tablesDeinit();
+		Tuner_Deinit();
+		return (void*) SC_ERROR;
+	}
+
+	/* wait for tuner to lock */
+	pthread_mutex_lock(&statusMutex);
+	if(ETIMEDOUT == pthread_cond_timedwait(&statusCondition, &statusMutex, &lockStatusWaitTime))
+	{
+		printf("\n%s : ERROR Lock timeout exceeded!\n",__FUNCTION__);
+		tablesDeinit();
+		Tuner_Deinit();
+		return (void*) SC_ERROR;
+	}
+	pthread_mutex_unlock(&statusMutex);
+	lockTimeUs = getTimeUs();
+
+	/* initialize player */
+	if(Player_Init(&playerHandle))
+	{
+		printf("\n%s : ERROR Player_Init() fail\n", __FUNCTION__);
+		tablesDeinit();
+		Tuner_Deinit();
+		return (void*) SC_ERROR;
+	}
+
+	/* open source */
+	if(Player_Source_Open(playerHandle, &sourceHandle))
+	{
+		printf("\n%s : ERROR Player_Source_Open() fail\n", __FUNCTION__);
+		tablesDeinit();
+		Player_Deinit(playerHandle);
+		Tuner_Deinit();
+		return (void*) SC_ERROR;
+	}
+
+	/* initialize filter scheduler with number of available demux section filters */
+	if(filterSchedulerInit(&demuxFilterOps, inputConfigFromApp.filterSlots, FILTER_SCHEDULER_QUANTUM_MS))
+	{
+		printf("\n%s : ERROR filterSchedulerInit() fail\n", __FUNCTION__);
+	}
+
+	/* last watched service is resumed, speculatively before any table arrives */
+	startLastService();
+
+	/* channel remembered from previous run is started before PAT and PMT arrive */
+	channelDbOpen(CHANNEL_DB_PATH);
+	dbTransportStream = channelDbFindByFrequency(inputConfigFromApp.frequency);
+	if (dbTransportStream != NULL && inputConfigFromApp.speculativeStart)
+	{
+		startChannelFromDb(programNumber);
+	}
+
+	/* EPG of previous run is shown until EIT sections come round again */
+	epgCacheOpen(EPG_CACHE_PATH);
+
+	/* broadcast clock ages out EPG cache */
+	if(filterSchedulerAdd(0x0014, 0x70, FILTER_PRIORITY_BACKGROUND, &tdtRequestId))
+	{
+		printf("\n%s : ERROR filterSchedulerAdd() fail\n", __FUNCTION__);
+	}
+
+	/* set PAT pid and tableID to demultiplexer, PAT stays monitored */
+	sectionFilterInit(&patFilter, 0x00);
+	if(filterSchedulerAdd(0x0000, 0x00, FILTER_PRIORITY_LIVE, &patRequestId))
+	{
+		printf("\n%s : ERROR filterSchedulerAdd() fail\n", __FUNCTION__);
+	}
+
+	/* register section filter callback */
+	if(Demux_Register_Section_Filter_Callback(sectionReceivedCallback))
+	{
+		printf("\n%s : ERROR Demux_Register_Section_Filter_Callback() fail\n", __FUNCTION__);
+	}
+
+	/* wait for a PAT table to be parsed, there are no channels without it */
+	if (waitForTable(&patReceived, PAT_TIMEOUT_MS) != SC_NO_ERROR)
+	{
+		printf("\n%s : ERROR PAT parse timeout exceeded!\n", __FUNCTION__);
+		filterSchedulerDeinit();
+		Player_Source_Close(playerHandle, sourceHandle);
+		Player_Deinit(playerHandle);
+		Tuner_Deinit();
+		sectionQueueDeinit(&sectionQueue);
+		channelMapDeinit();
+		channelDbClose();
+		epgCacheClose();
+		tablesDeinit();
+		return (void*) SC_ERROR;
+	}
+
+	/* channel map gets PMT of every service as it arrives */
+	if (channelMapInit(patTable) != CM_NO_ERROR)
+	{
+		printf("\n%s : ERROR channelMapInit() fail\n", __FUNCTION__);
+	}
+
+	/* channel from config or last service record may not exist anymore */
+	if (programNumber + 1 >= patTable->serviceInfoCount)
+	{
+		printf("\n%s : channel %d not in PAT, starting first channel\n", __FUNCTION__, programNumber + 1);
+		programNumber = 0;
+	}
+
+	/* live PAT confirms or corrects channel database */
+	dbTransportStream = channelDbFindByTransportStreamId(patTable->patHeader.transportStreamId);
+	if (dbTransportStream != NULL)
+	{
+		seedChannelMap(dbTransportStream);
+	}
+	else
+	{
+		printf("\n%s : transport stream %d not in channel database\n", __FUNCTION__, patTable->patHeader.transportStreamId);
+	}
+	dbTransportStream = NULL;
+
+	/* start current channel, channel keys start one when PAT gets services */
+	if (patTable->serviceInfoCount > 1)
+	{
+		startChannel(programNumber);
+	}
+	else
+	{
+		printf("\n%s : ERROR PAT has no services\n", __FUNCTION__);
+	}
+
+	/* PMTs of other services are acquired in free filter slots */
+	startBackgroundAcquisition();
+
+	/* set isInitialized flag */
+	isInitialized = true;
+
+	/* no heap allocations are expected from now on */
+	heapStatsGet(&steadyStateHeapStats);
+
+	while(!threadExit)
+	{
+		if (changeChannel)
+		{
+			changeChannel = false;
+			startChannel(programNumber);
+		}
+
+		processSections(SCHEDULER_TICK_MS);
+		if (pmtLateChannel != -1 && pmtReceived)
+		{
+			startChannelPmtReceived(pmtLateChannel);
+			pmtLateChannel = -1;
+		}
+		if (patUpdatePending)
+		{
+			applyPatUpdate();
+		}
+		if (pmtUpdatePending)
+		{
+			applyPmtUpdate();
+		}
+		serviceBackgroundAcquisition();
+		filterSchedulerTick();
+
+		/* join PMT pids with packet level activity once per second */
+		if (getTimeUs() - serviceStateTimeUs >= 1000000)
+		{
+			serviceStateTimeUs = getTimeUs();
+			channelMapUpdateServiceStates(serviceStateTimeUs);
+
+			/* packets of watched service found scrambled or clear again, streams follow */
+			if (pmtLateChannel == -1 && currentChannel.programNumber != 0 &&
+			    (channelMapGetScrambling(currentChannel.programNumber) == SCRAMBLING_SCRAMBLED) != (currentScrambling == SCRAMBLING_SCRAMBLED))
+			{
+				startStreams(currentChannel.programNumber - 1);
+			}
+
+			/* written only if live tables differ from stored ones */
+			channelDbStore(inputConfigFromApp.frequency, patTable);
+
+			/* TDT filter is set again only once per refresh period */
+			if (tdtRequestId == -1 && serviceStateTimeUs - tdtTimeUs >= EPG_CACHE_CLOCK_REFRESH_S * 1000000ULL)
+			{
+				filterSchedulerAdd(0x0014, 0x70, FILTER_PRIORITY_BACKGROUND, &tdtRequestId);
+			}
+
+			/* cached present event changes with broadcast clock */
+			updateCachedEventName();
+
+			if (serviceStateTimeUs - epgSyncTimeUs >= EPG_CACHE_SYNC_PERIOD_S * 1000000ULL)
+			{
+				epgSyncTimeUs = serviceStateTimeUs;
+				epgCacheSync();
+			}
+		}
+	}
+}
+
+void startChannelFromDb(int32_t channelNumber)
+{
+	TableArena* arena;
+	PatGeneration* generation;
+	PmtTable* storedPmt;
+
+	generation = patGenerationOpen(&arena, dbTransportStream->serviceCount);
+	if (generation == NULL)
+	{
+		return;
+	}
+	channelDbToPatTable(dbTransportStream, &generation->patTable);
+	patGenerationPublish(arena);
+
+	if (channelMapInit(patTable) != CM_NO_ERROR)
+	{
+		printf("\n%s : ERROR channelMapInit() fail\n", __FUNCTION__);
+		return;
+	}
+	seedChannelMap(dbTransportStream);
+
+	storedPmt = pmtVersionOpen(&arena, CHANNEL_DB_MAX_ES);
+	if (storedPmt == NULL)
+	{
+		return;
+	}
+	if (channelDbToPmtTable(dbTransportStream, channelNumber + 1, storedPmt) != CDB_NO_ERROR)
+	{
+		printf("\n%s : PMT of channel %d not in channel database\n", __FUNCTION__, channelNumber + 1);
+		tableArenaDiscard(arena);
+		return;
+	}
+	tableArenaPublish(&pmtArena, arena);
+	pmtTable = storedPmt;
+
+	printf("\n%s : starting channel %d from channel database\n", __FUNCTION__, channelNumber + 1);
+	startStreams(channelNumber);
+}
+
+void startLastService(void)
+{
+	ChannelDbLastService lastService;
+
+	if (channelDbLoadLastService(&lastService) != CDB_NO_ERROR || lastService.frequency != inputConfigFromApp.frequency)
+	{
+		return;
+	}
+	programNumber = lastService.channelNumber;
+	lastServiceResumed = 1;
+
+	if (!inputConfigFromApp.speculativeStart)
+	{
+		return;
+	}
+
+	/* pids are validated when live PMT arrives, streams are recreated only if they changed */
+	printf("\n%s : speculative start of channel %d\n", __FUNCTION__, lastService.channelNumber + 1);
+	if (lastService.videoPid != -1)
+	{
+		if(Player_Stream_Create(playerHandle, sourceHandle, lastService.videoPid, VIDEO_TYPE_MPEG2, &streamHandleV))
+		{
+			printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
+			streamHandleV = 0;
+		}
+	}
+	if (programType != NULL)
+	{
+		programType(lastService.videoPid);
+	}
+	if (lastService.audioPid != -1)
+	{
+		if(Player_Stream_Create(playerHandle, sourceHandle, lastService.audioPid, AUDIO_TYPE_MPEG_AUDIO, &streamHandleA))
+		{
+			printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
+			streamHandleA = 0;
+		}
+	}
+	if ((streamHandleV != 0 || streamHandleA != 0) && firstStreamTimeUs == 0)
+	{
+		firstStreamTimeUs = getTimeUs();
+	}
+
+	currentChannel.programNumber = lastService.channelNumber + 1;
+	currentChannel.videoPid = lastService.videoPid;
+	currentChannel.audioPid = lastService.audioPid;
+	currentVideoType = lastService.videoStreamType;
+	currentAudioType = lastService.audioStreamType;
+}
+
+void saveLastService(int32_t channelNumber)
+{
+	ChannelDbLastService lastService;
+
+	memset(&lastService, 0x0, sizeof(ChannelDbLastService));
+	lastService.frequency = inputConfigFromApp.frequency;
+	lastService.transportStreamId = patTable->patHeader.transportStreamId;
+	lastService.channelNumber = channelNumber;
+	lastService.programNumber = patTable->patServiceInfoArray[channelNumber + 1].programNumber;
+	lastService.videoPid = currentChannel.videoPid;
+	lastService.audioPid = currentChannel.audioPid;
+	lastService.videoStreamType = currentVideoType;
+	lastService.audioStreamType = currentAudioType;
+
+	channelDbStoreLastService(&lastService);
+}
+
+void applyPmtUpdate(void)
+{
+	PmtSelection selection;
+	uint32_t recreateCount;
+	uint8_t diff = pmtUpdateDiff;
+
+	pmtUpdatePending = 0;
+	pmtUpdateDiff = PMT_DIFF_NONE;
+	pmtUpdateCount++;
+
+	if (diff & PMT_DIFF_RESTART_MASK)
+	{
+		printf("\n%s : PMT version %d changes played streams (0x%02x)\n", __FUNCTION__, pmtTable->pmtHeader.versionNumber, diff);
+
+		/* startStreams() keeps every stream whose pid and type are unchanged */
+		recreateCount = streamRecreateCount;
+		startStreams(currentChannel.programNumber - 1);
+		pmtUpdateGlitchCount += streamRecreateCount - recreateCount;
+		if (diff & PMT_DIFF_CA)
+		{
+			/* scrambled service loses its streams, they are counted as interrupted */
+			pmtUpdateGlitchCount += (streamHandleV == 0 && currentChannel.videoPid != -1) + (streamHandleA == 0 && currentChannel.audioPid != -1);
+		}
+		return;
+	}
+
+	/* nothing played changed, streams keep running */
+	channelMapSetPmt(pmtTable);
+	if (diff & PMT_DIFF_PCR)
+	{
+		tsMonitorSetPcrPid(pmtTable->pmtHeader.pcrPid);
+	}
+	if (diff & PMT_DIFF_DESCRIPTORS)
+	{
+		pmtSelectStreams(pmtTable, &selection);
+		currentChannel.hasTeletext = selection.hasTeletext;
+	}
+	pmtUpdateQuietCount++;
+}
+
+int32_t patFindService(const PatTable* table, uint16_t serviceProgramNumber)
+{
+	int32_t i;
+
+	for (i = 0; i < table->serviceInfoCount; i++)
+	{
+		if (table->patServiceInfoArray[i].programNumber == serviceProgramNumber)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void patVersionChanged(const PatTable* oldTable, const PatTable* newTable)
+{
+	uint16_t watchedProgramNumber = 0;
+	uint16_t watchedPid = 0;
+	int32_t watchedIndex;
+	int32_t i;
+
+	for (i = 0; i < newTable->serviceInfoCount; i++)
+	{
+		if (patFindService(oldTable, newTable->patServiceInfoArray[i].programNumber) == -1)
+		{
+			patServicesAdded++;
+		}
+	}
+	for (i = 0; i < oldTable->serviceInfoCount; i++)
+	{
+		if (patFindService(newTable, oldTable->patServiceInfoArray[i].programNumber) == -1)
+		{
+			patServicesRemoved++;
+		}
+	}
+	patUpdateCount++;
+	patUpdatePending = 1;
+
+	printf("\n%s : PAT version %d, %d services\n", __FUNCTION__, newTable->patHeader.versionNumber, newTable->serviceInfoCount);
+
+	/* nothing watched yet */
+	if (currentChannel.programNumber <= 0 || currentChannel.programNumber >= oldTable->serviceInfoCount)
+	{
+		return;
+	}
+	watchedProgramNumber = oldTable->patServiceInfoArray[currentChannel.programNumber].programNumber;
+	watchedPid = oldTable->patServiceInfoArray[currentChannel.programNumber].pid;
+
+	watchedIndex = patFindService(newTable, watchedProgramNumber);
+	if (watchedIndex <= 0)
+	{
+		printf("\n%s : watched service %d removed from PAT, starting first channel\n", __FUNCTION__, watchedProgramNumber);
+		programNumber = 0;
+		changeChannel = true;
+		return;
+	}
+
+	if (watchedIndex != currentChannel.programNumber)
+	{
+		/* channel number chosen by user meanwhile is not overwritten */
+		if (!changeChannel)
+		{
+			programNumber = watchedIndex - 1;
+		}
+		currentChannel.programNumber = watchedIndex;
+		patIndexMoved = 1;
+	}
+
+	if (newTable->patServiceInfoArray[watchedIndex].pid != watchedPid)
+	{
+		/* live PMT filter follows new pid, startStreams() keeps streams whose pids did not change */
+		changeChannel = true;
+	}
+}
+
+void applyPatUpdate(void)
+{
+	patUpdatePending = 0;
+
+	if (channelMapUpdatePat(patTable) != CM_NO_ERROR)
+	{
+		printf("\n%s : ERROR channelMapUpdatePat() fail\n", __FUNCTION__);
+	}
+
+	if (patIndexMoved)
+	{
+		patIndexMoved = 0;
+		saveLastService(currentChannel.programNumber - 1);
+	}
+
+	/* channel map kept PMTs of services whose PMT pid did not change, only the rest is requested again */
+	stopBackgroundAcquisition();
+	startBackgroundAcquisition();
+}
+
+void printPatUpdateStats(void)
+{
+	printf("\n********************PAT UPDATES********************\n");
+	printf("PAT versions applied     |      %u\n", patUpdateCount);
+	printf("services added           |      %u\n", patServicesAdded);
+	printf("services removed         |      %u\n", patServicesRemoved);
+	printf("\n********************PAT UPDATES********************\n");
+}
+
+void printPmtUpdateStats(void)
+{
+	printf("\n********************LIVE PMT UPDATES********************\n");
+	printf("PMT versions applied     |      %u\n", pmtUpdateCount);
+	printf("applied without restart  |      %u\n", pmtUpdateQuietCount);
+	printf("streams interrupted      |      %u\n", pmtUpdateGlitchCount);
+	printf("\n********************LIVE PMT UPDATES********************\n");
+	printPmtDiffStats();
+}
+
+void printColdStartStats(void)
+{
+	printf("\n********************COLD START********************\n");
+	printf("mode                     |      %s\n", inputConfigFromApp.speculativeStart ? "speculative" : "live tables");
+	printf("last service resumed     |      %s\n", lastServiceResumed ? "yes" : "no");
+	printf("tuner lock               |      %llu ms\n", (unsigned long long)(lockTimeUs - bootTimeUs) / 1000);
+	printf("early stream starts      |      %u\n", earlyStartCount);
+	printf("early start rollbacks    |      %u\n", earlyRollbackCount);
+	if (earlyStartCount != 0)
+	{
+		printf("avg lead over PMT        |      %llu us\n", (unsigned long long)(earlyLeadSumUs / earlyStartCount));
+	}
+	if (firstStreamTimeUs != 0)
+	{
+		printf("first stream created     |      %llu ms\n", (unsigned long long)(firstStreamTimeUs - bootTimeUs) / 1000);
+	}
+	if (livePmtTimeUs != 0)
+	{
+		/* same as first stream time of a boot without speculation */
+		printf("live PMT applied         |      %llu ms\n", (unsigned long long)(livePmtTimeUs - bootTimeUs) / 1000);
+		printf("streams recreated by PMT |      %u\n", speculationRecreateCount);
+	}
+	printf("\n********************COLD START********************\n");
+}
+
+void seedChannelMap(const ChannelDbTransportStream* transportStream)
+{
+	PmtTable storedPmt;
+	PmtElementaryInfo storedEs[CHANNEL_DB_MAX_ES];
+	uint16_t i;
+
+	storedPmt.pmtElementaryInfoArray = storedEs;
+	storedPmt.elementaryInfoCapacity = CHANNEL_DB_MAX_ES;
+
+	for (i = 0; i < transportStream->serviceCount; i++)
+	{
+		/* services no longer in PAT are not found in channel map and are skipped */
+		if (channelDbToPmtTable(transportStream, i, &storedPmt) == CDB_NO_ERROR)
+		{
+			channelMapSetPmt(&storedPmt);
+		}
+	}
+}
+
+void* tableVersionOpen(TableArena** arena, uint32_t size)
+{
+	void* table;
+
+	*arena = tableArenaOpen();
+	if (*arena == NULL)
+	{
+		return NULL;
+	}
+
+	table = tableArenaAlloc(*arena, size);
+	if (table == NULL)
+	{
+		tableArenaDiscard(*arena);
+		*arena = NULL;
+	}
+
+	return table;
+}
+
+PatGeneration* patGenerationOpen(TableArena** arena, uint8_t serviceInfoCount)
+{
+	PatGeneration* generation;
+
+	/* table and its entries are one allocation, entries follow the table */
+	generation = (PatGeneration*)tableVersionOpen(arena, sizeof(PatGeneration) + serviceInfoCount * sizeof(PatServiceInfo));
+	if (generation != NULL)
+	{
+		generation->patTable.patServiceInfoArray = (PatServiceInfo*)(generation + 1);
+		generation->patTable.serviceInfoCapacity = serviceInfoCount;
+	}
+
+	return generation;
+}
+
+PmtTable* pmtVersionOpen(TableArena** arena, uint8_t elementaryInfoCount)
+{
+	PmtTable* table;
+
+	table = (PmtTable*)tableVersionOpen(arena, sizeof(PmtTable) + elementaryInfoCount * sizeof(PmtElementaryInfo));
+	if (table != NULL)
+	{
+		table->pmtElementaryInfoArray = (PmtElementaryInfo*)(table + 1);
+		table->elementaryInfoCapacity = elementaryInfoCount;
+	}
+
+	return table;
+}
+
+EitTable* eitVersionOpen(TableArena** arena, uint8_t eventInfoCount)
+{
+	EitTable* table;
+
+	table = (EitTable*)tableVersionOpen(arena, sizeof(EitTable) + eventInfoCount * sizeof(EitEventInfo));
+	if (table != NULL)
+	{
+		table->eitEventInfoArray = (EitEventInfo*)(table + 1);
+		table->eventInfoCapacity = eventInfoCount;
+	}
+
+	return table;
+}
+
+void patGenerationPublish(TableArena* arena)
+{
+	PatGeneration* generation = (PatGeneration*)arena->root;
+	int32_t i;
+	int32_t j;
+
+	/* EIT info buffer of new PAT version starts empty */
+	generation->eitBuffer = (eitBufferElement*)tableArenaAlloc(arena, generation->patTable.serviceInfoCount * sizeof(eitBufferElement));
+	generation->eitBufferSize = (generation->eitBuffer != NULL) ? generation->patTable.serviceInfoCount : 0;
+
+	/* buffer is filled from its start, removed services leave no gaps */
+	for (i = 0, j = 0; i < eitBufferSize && j < generation->eitBufferSize; i++)
+	{
+		if (eitBuffer[i].programNumber != 0 && patFindService(&generation->patTable, eitBuffer[i].programNumber) != -1)
+		{
+			generation->eitBuffer[j++] = eitBuffer[i];
+		}
+	}
+
+	tableArenaPublish(&patArena, arena);
+	patTable = &generation->patTable;
+	eitBuffer = generation->eitBuffer;
+	eitBufferSize = generation->eitBufferSize;
+}
+
+StreamControllerError tablesInit(void)
+{
+	TableArena* arena;
+
+	if (tableArenaInit() != TABLE_ARENA_NO_ERROR)
+	{
+		return SC_ERROR;
+	}
+
+	if (patGenerationOpen(&arena, 0) == NULL)
+	{
+		tablesDeinit();
+		return SC_ERROR;
+	}
+	patGenerationPublish(arena);
+
+	pmtTable = pmtVersionOpen(&arena, 0);
+	if (pmtTable == NULL)
+	{
+		tablesDeinit();
+		return SC_ERROR;
+	}
+	tableArenaPublish(&pmtArena, arena);
+
+	eitTable = eitVersionOpen(&arena, 0);
+	if (eitTable == NULL)
+	{
+		tablesDeinit();
+		return SC_ERROR;
+	}
+	tableArenaPublish(&eitArena, arena);
+
+	return SC_NO_ERROR;
+}
+
+void tablesDeinit(void)
+{
+	tableArenaPublish(&patArena, NULL);
+	tableArenaPublish(&pmtArena, NULL);
+	tableArenaPublish(&eitArena, NULL);
+	tableArenaPublish(&backgroundArena, NULL);
+
+	patTable = NULL;
+	pmtTable = NULL;
+	eitTable = NULL;
+	eitBuffer = NULL;
+	eitBufferSize = 0;
+	backgroundPmt = NULL;
+	backgroundPmtCount = 0;
+
+	/* all versions are retired, arena still in use is held by a reader that never gave it back */
+	printTableArenaLeakReport();
+	tableArenaDeinit();
+}
+
+StreamControllerError waitForPmt(int32_t channelNumber, uint32_t timeoutMs)
+{
+	uint64_t deadlineMs = getTimeMs() + timeoutMs;
+
+	while (!pmtReceived)
+	{
+		if (threadExit || getTimeMs() >= deadlineMs)
+		{
+			return SC_ERROR;
+		}
+		processSections(SCHEDULER_TICK_MS);
+		if (!pmtReceived && inputConfigFromApp.speculativeStart)
+		{
+			serviceEarlyPmt();
+		}
+		serviceBackgroundAcquisition();
+		filterSchedulerTick();
+	}
+
+	return SC_NO_ERROR;
+}
+
+void serviceEarlyPmt(void)
+{
+	EarlyPmt early;
+
+	pthread_mutex_lock(&earlyPmtMutex);
+	early = earlyPmt;
+	earlyPmt.pending = 0;
+	earlyPmt.failed = 0;
+	pthread_mutex_unlock(&earlyPmtMutex);
+
+	if (early.failed)
+	{
+		rollbackEarlyStreams();
+	}
+
+	/* scrambled service gets its streams only from whole PMT */
+	if (!early.pending || early.scrambled)
+	{
+		return;
+	}
+
+	if (early.videoPid != -1 && (streamHandleV == 0 || early.videoPid != currentChannel.videoPid || early.videoType != currentVideoType))
+	{
+		if (streamHandleV != 0)
+		{
+			Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
+			streamHandleV = 0;
+		}
+		if (Player_Stream_Create(playerHandle, sourceHandle, early.videoPid, VIDEO_TYPE_MPEG2, &streamHandleV))
+		{
+			printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
 			streamHandleV = 0;
 		}
-
-		/* create video stream */
-		if(Player_Stream_Create(playerHandle, sourceHandle, videoPid, VIDEO_TYPE_MPEG2, &streamHandleV))
+		else
 		{
-			printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
-			streamControllerDeinit();
+			earlyVideoStarted = 1;
+			currentChannel.videoPid = early.videoPid;
+			currentVideoType = early.videoType;
+			if (programType != NULL)
+			{
+				programType(early.videoPid);
+			}
 		}
 	}
 
-	programType(videoPid);
-
-	if (audioPid != -1)
+	if (early.audioPid != -1 && (streamHandleA == 0 || early.audioPid != currentChannel.audioPid || early.audioType != currentAudioType))
 	{
-		/* remove previos audio stream */
 		if (streamHandleA != 0)
 		{
 			Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
 			streamHandleA = 0;
 		}
-
-		/* create audio stream */
-		if(Player_Stream_Create(playerHandle, sourceHandle, audioPid, AUDIO_TYPE_MPEG_AUDIO, &streamHandleA))
+		if (Player_Stream_Create(playerHandle, sourceHandle, early.audioPid, AUDIO_TYPE_MPEG_AUDIO, &streamHandleA))
 		{
 			printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
-			streamControllerDeinit();
+			streamHandleA = 0;
+		}
+		else
+		{
+			earlyAudioStarted = 1;
+			currentChannel.audioPid = early.audioPid;
+			currentAudioType = early.audioType;
 		}
 	}
 
-	/* store current channel info */
-	currentChannel.programNumber = channelNumber + 1;
-	currentChannel.audioPid = audioPid;
-	currentChannel.videoPid = videoPid;
+	if ((earlyVideoStarted || earlyAudioStarted) && earlyStartTimeUs == 0)
+	{
+		earlyStartTimeUs = getTimeUs();
+		earlyStartCount++;
+		if (firstStreamTimeUs == 0)
+		{
+			firstStreamTimeUs = earlyStartTimeUs;
+		}
+	}
+}
 
-	/* EIT table parsing */
-	/* set demux filter for receive EIT  actual TS present/following table of program */
-	if(Demux_Set_Filter(playerHandle, 0x0012, 0x4E, &filterHandle))
+void rollbackEarlyStreams(void)
+{
+	if (!earlyVideoStarted && !earlyAudioStarted)
 	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
 		return;
 	}
 
-	/* wait for a EIT table to be parsed*/
-	pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
+	printf("\n%s : PMT section failed CRC, removing streams started from it\n", __FUNCTION__);
+	if (earlyVideoStarted && streamHandleV != 0)
 	{
-		printf("\n%s : ERROR EIT parse timeout exceeded!\n", __FUNCTION__);
+		Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
+		streamHandleV = 0;
+		currentChannel.videoPid = -1;
+	}
+	if (earlyAudioStarted && streamHandleA != 0)
+	{
+		Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
+		streamHandleA = 0;
+		currentChannel.audioPid = -1;
 	}
-	pthread_mutex_unlock(&demuxMutex);
+	earlyVideoStarted = 0;
+	earlyAudioStarted = 0;
+	earlyRollbackCount++;
 
-	printf("\nParsed EIT table!\n");
+	/* zap is counted again if next section starts streams early */
+	if (earlyStartTimeUs != 0)
+	{
+		earlyStartTimeUs = 0;
+		earlyStartCount--;
+	}
 }
 
-void* streamControllerTask()
+void earlyPmtHeader(const PmtTableHeader* pmtHeader)
 {
-	gettimeofday(&now,NULL);
-	lockStatusWaitTime.tv_sec = now.tv_sec+10;
+	earlyPmt.scrambled = pmtHeader->hasCaDescriptor;
+}
 
-	/* allocate memory for PAT table section */
-	patTable=(PatTable*)malloc(sizeof(PatTable));
-	if(patTable==NULL)
+void earlyPmtElementaryStream(const PmtElementaryInfo* elementaryInfo)
+{
+	/* same selection as startStreams(), first video and first audio stream */
+	if (((elementaryInfo->streamType == 0x1) || (elementaryInfo->streamType == 0x2) || (elementaryInfo->streamType == 0x1b))
+	    && (earlyPmt.videoPid == -1))
 	{
-		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
-		return (void*) SC_ERROR;
+		earlyPmt.videoPid = elementaryInfo->elementaryPid;
+		earlyPmt.videoType = elementaryInfo->streamType;
+		earlyPmt.scrambled |= elementaryInfo->hasCaDescriptor;
+		earlyPmt.pending = 1;
 	}
-	memset(patTable, 0x0, sizeof(PatTable));
-
-	/* allocate memory for PMT table section */
-	pmtTable=(PmtTable*)malloc(sizeof(PmtTable));
-	if(pmtTable==NULL)
+	else if (((elementaryInfo->streamType == 0x3) || (elementaryInfo->streamType == 0x4))
+	         && (earlyPmt.audioPid == -1))
 	{
-		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
-		return (void*) SC_ERROR;
+		earlyPmt.audioPid = elementaryInfo->elementaryPid;
+		earlyPmt.audioType = elementaryInfo->streamType;
+		earlyPmt.scrambled |= elementaryInfo->hasCaDescriptor;
+		earlyPmt.pending = 1;
 	}
-	memset(pmtTable, 0x0, sizeof(PmtTable));
+}
 
-	/* allocate memory for EIT table section */
-	eitTable=(EitTable*)malloc(sizeof(EitTable));
-	if(eitTable==NULL)
+void earlyPmtSectionEnd(uint8_t crcOk)
+{
+	if (crcOk)
 	{
-		printf("\n%s : ERROR Cannot allocate memory for an EIT table\n", __FUNCTION__);
-		return (void*) SC_ERROR;
+		earlyPmt.confirmed = 1;
+		return;
 	}
-	memset(eitTable, 0x0, sizeof(EitTable));
 
-	/* initialize tuner device */
-	if(Tuner_Init())
-	{
-		printf("\n%s : ERROR Tuner_Init() fail\n", __FUNCTION__);
-		free(patTable);
-		free(pmtTable);
-		free(eitTable);
-		free(eitBuffer);
-		return (void*) SC_ERROR;
-	}
+	/* next section starts from scratch */
+	earlyPmt.videoPid = -1;
+	earlyPmt.audioPid = -1;
+	earlyPmt.scrambled = 0;
+	earlyPmt.pending = 0;
+	earlyPmt.failed = 1;
+}
 
-	/* register tuner status callback */
-	if(Tuner_Register_Status_Callback(tunerStatusCallback))
-	{
-		printf("\n%s : ERROR Tuner_Register_Status_Callback() fail\n", __FUNCTION__);
-	}
+StreamControllerError waitForTable(uint8_t* received, uint32_t timeoutMs)
+{
+	uint64_t deadlineMs = getTimeMs() + timeoutMs;
 
-	/* lock to frequency */
-	if(!Tuner_Lock_To_Frequency(inputConfigFromApp.frequency, inputConfigFromApp.bandwidth, inputConfigFromApp.module))
-	{
-		printf("\n%s: INFO Tuner_Lock_To_Frequency(): %d Hz - success!\n",__FUNCTION__,inputConfigFromApp.frequency);
-	}
-	else
+	while (!*received)
 	{
-		printf("\n%s: ERROR Tuner_Lock_To_Frequency(): %d Hz - fail!\n",__FUNCTION__,inputConfigFromApp.frequency);
-		free(patTable);
-		free(pmtTable);
-		free(eitTable);
-		free(eitBuffer);
-		Tuner_Deinit();
-		return (void*) SC_ERROR;
+		if (threadExit || getTimeMs() >= deadlineMs)
+		{
+			return SC_ERROR;
+		}
+		processSections(SCHEDULER_TICK_MS);
+		serviceBackgroundAcquisition();
+		filterSchedulerTick();
 	}
 
-	/* wait for tuner to lock */
-	pthread_mutex_lock(&statusMutex);
-	if(ETIMEDOUT == pthread_cond_timedwait(&statusCondition, &statusMutex, &lockStatusWaitTime))
+	return SC_NO_ERROR;
+}
+
+void processSections(uint32_t timeoutMs)
+{
+	const uint8_t* section;
+
+	if (sectionQueueWait(&sectionQueue, timeoutMs) != SQ_NO_ERROR)
 	{
-		printf("\n%s : ERROR Lock timeout exceeded!\n",__FUNCTION__);
-		free(patTable);
-		free(pmtTable);
-		free(eitTable);
-		free(eitBuffer);
-		Tuner_Deinit();
-		return (void*) SC_ERROR;
+		return;
 	}
-	pthread_mutex_unlock(&statusMutex);
 
-	/* initialize player */
-	if(Player_Init(&playerHandle))
+	while ((section = sectionQueueFront(&sectionQueue)) != NULL)
 	{
-		printf("\n%s : ERROR Player_Init() fail\n", __FUNCTION__);
-		free(patTable);
-		free(pmtTable);
-		free(eitTable);
-		free(eitBuffer);
-		Tuner_Deinit();
-		return (void*) SC_ERROR;
+		sectionProcess(section);
+		sectionQueueRelease(&sectionQueue);
 	}
+}
 
-	/* open source */
-	if(Player_Source_Open(playerHandle, &sourceHandle))
+void startBackgroundAcquisition()
+{
+	const ChannelMapEntry* entry;
+	TableArena* arena;
+	int32_t i;
+
+	backgroundPmtCount = patTable->serviceInfoCount;
+	backgroundPmt = (BackgroundPmt*)tableVersionOpen(&arena, backgroundPmtCount * sizeof(BackgroundPmt));
+	if (backgroundPmt == NULL)
 	{
-		printf("\n%s : ERROR Player_Source_Open() fail\n", __FUNCTION__);
-		free(patTable);
-		free(pmtTable);
-		free(eitTable);
-		free(eitBuffer);
-		Player_Deinit(playerHandle);
-		Tuner_Deinit();
-		return (void*) SC_ERROR;
+		backgroundPmtCount = 0;
+		return;
 	}
+	tableArenaPublish(&backgroundArena, arena);
 
-	/* set PAT pid and tableID to demultiplexer */
-	if(Demux_Set_Filter(playerHandle, 0x00, 0x00, &filterHandle))
+	for (i = 0; i < backgroundPmtCount; i++)
 	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+		backgroundPmt[i].requestId = -1;
+
+		/* program number 0 is network information table pid */
+		if (patTable->patServiceInfoArray[i].programNumber == 0)
+		{
+			backgroundPmt[i].received = 1;
+			continue;
+		}
+
+		/* channel map is indexed like PAT, PMT kept over PAT update is not requested again */
+		entry = channelMapGetEntry(i);
+		if (entry != NULL && entry->pmtValid)
+		{
+			backgroundPmt[i].received = 1;
+			continue;
+		}
+
+		sectionFilterInit(&backgroundPmt[i].sectionFilter, 0x02);
+		sectionFilterSetTableIdExtension(&backgroundPmt[i].sectionFilter, patTable->patServiceInfoArray[i].programNumber);
+
+		if (filterSchedulerAdd(patTable->patServiceInfoArray[i].pid, 0x02, FILTER_PRIORITY_BACKGROUND, &backgroundPmt[i].requestId))
+		{
+			printf("\n%s : ERROR filterSchedulerAdd() fail\n", __FUNCTION__);
+		}
 	}
+}
 
-	/* register section filter callback */
-	if(Demux_Register_Section_Filter_Callback(sectionReceivedCallback))
+void stopBackgroundAcquisition()
+{
+	int32_t i;
+
+	for (i = 0; i < backgroundPmtCount; i++)
 	{
-		printf("\n%s : ERROR Demux_Register_Section_Filter_Callback() fail\n", __FUNCTION__);
+		if (backgroundPmt[i].requestId != -1)
+		{
+			filterSchedulerRemove(backgroundPmt[i].requestId);
+			backgroundPmt[i].requestId = -1;
+		}
 	}
+	backgroundPmtCount = 0;
+}
+
+void serviceBackgroundAcquisition()
+{
+	int32_t i;
 
-	pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
+	for (i = 0; i < backgroundPmtCount; i++)
 	{
-		printf("\n%s:ERROR Lock timeout exceeded!\n", __FUNCTION__);
-		free(patTable);
-		free(pmtTable);
-		free(eitTable);
-		free(eitBuffer);
-		Player_Deinit(playerHandle);
-		Tuner_Deinit();
-		return (void*) SC_ERROR;
+		if (backgroundPmt[i].received && backgroundPmt[i].requestId != -1)
+		{
+			filterSchedulerRemove(backgroundPmt[i].requestId);
+			backgroundPmt[i].requestId = -1;
+		}
 	}
-	pthread_mutex_unlock(&demuxMutex);
+}
+
+int32_t demuxSetFilter(uint16_t pid, uint8_t tableId, uint32_t* filterHandle)
+{
+	return Demux_Set_Filter(playerHandle, pid, tableId, filterHandle);
+}
 
-	/* start current channel */
-	startChannel(programNumber);
+int32_t demuxFreeFilter(uint32_t filterHandle)
+{
+	return Demux_Free_Filter(playerHandle, filterHandle);
+}
 
-	/* set isInitialized flag */
-	isInitialized = true;
+uint64_t getTimeMs(void)
+{
+	return getTimeUs() / 1000;
+}
 
-	while(!threadExit)
+uint64_t getTimeUs(void)
+{
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000 + time.tv_nsec / 1000;
+}
+
+void tsPacketsReceived(const uint8_t* packets, uint32_t count)
+{
+	uint32_t i;
+
+	tsMonitorProcessPackets(packets, count, getTimeUs());
+
+	/* live PMT is decoded packet by packet, ahead of demux section delivery */
+	pthread_mutex_lock(&earlyPmtMutex);
+	for (i = 0; i < count; i++)
 	{
-		if (changeChannel)
-		{
-			changeChannel = false;
-			startChannel(programNumber);
-		}
+		pmtStreamParserFeedPacket(&livePmtParser, packets + i * TS_PACKET_SIZE);
 	}
+	pthread_mutex_unlock(&earlyPmtMutex);
 }
 
 void changeChannelExtern(int16_t channelNumber)
 {
+	/* numeric key entry may name a channel that is not in PAT */
+	if (channelNumber < 1 || channelNumber > getNumberOfChannels())
+	{
+		printf("\n%s : channel %d does not exist\n", __FUNCTION__, channelNumber);
+		return;
+	}
+
 	programNumber = channelNumber - 1;
 	changeChannel = true;
 }
@@ -450,61 +1857,174 @@ void changeChannelExtern(int16_t channelNumber)
 int32_t sectionReceivedCallback(uint8_t *buffer)
 {
 	uint8_t tableId = *buffer;
-	//int i;
+
+	/* only copy, parsing is done in stream controller thread */
+	if(tableId == 0x00 || tableId == 0x02 || tableId == 0x4E || tableId == 0x70)
+	{
+		sectionQueuePush(&sectionQueue, buffer);
+	}
+
+	return 0;
+}
+
+void sectionProcess(const uint8_t *buffer)
+{
+	uint8_t tableId = *buffer;
+	TableArena* arena;
+	PatGeneration* generation;
+	PmtTable* pmtVersion;
+	EitTable* eitVersion;
+	int i;
 
 	if(tableId==0x00)
 	{
 		//printf("\n%s -----PAT TABLE ARRIVED-----\n",__FUNCTION__);
+		if(!sectionFilterMatch(&patFilter, buffer))
+		{
+			return;
+		}
 
-		if(parsePatTable(buffer,patTable)==TABLES_PARSE_OK)
+		/* new version is parsed into its own arena, readers of current one are not disturbed */
+		/* section_length gives number of services, table is allocated once with exactly that room */
+		generation = patGenerationOpen(&arena, countPatServiceInfos(buffer));
+		if(generation == NULL)
 		{
-			//printPatTable(patTable);
-			pthread_mutex_lock(&demuxMutex);
-			pthread_cond_signal(&demuxCond);
-			pthread_mutex_unlock(&demuxMutex);
+			return;
 		}
 
-		/* allocating memory for EIT info buffer */
-		eitBufferSize = patTable->serviceInfoCount;
-		eitBuffer = malloc(eitBufferSize * sizeof(eitBufferElement));
+		if(parsePatTable(buffer,&generation->patTable)==TABLES_PARSE_OK)
+		{
+			//printPatTable(&generation->patTable);
 
-		//memset(eitBuffer->programNumber, 0, sizeof(eitBuffer));
+			/* PAT repetitions with the same version are dropped from now on */
+			sectionFilterSetVersionNotEqual(&patFilter, generation->patTable.patHeader.versionNumber);
 
-		/* init eitBuffer */
-		int i;
-		for(i = 0; i < eitBufferSize; i++)
+			/* services are compared while previous version is still current */
+			if(patReceived)
+			{
+				patVersionChanged(patTable, &generation->patTable);
+			}
+			patGenerationPublish(arena);
+			patReceived = 1;
+		}
+		else
 		{
-			eitBuffer[i].programNumber = 0;
+			tableArenaDiscard(arena);
 		}
 	}
 	else if (tableId==0x02)
 	{
 		//printf("\n%s -----PMT TABLE ARRIVED-----\n",__FUNCTION__);
+		if(!sectionFilterMatch(&pmtFilter, buffer))
+		{
+			/* PMT of other service acquired in background */
+			for(i = 0; i < backgroundPmtCount; i++)
+			{
+				if(!backgroundPmt[i].received && sectionFilterMatch(&backgroundPmt[i].sectionFilter, buffer))
+				{
+					/* background PMT is only copied to channel map, its arena is freed right away */
+					pmtVersion = pmtVersionOpen(&arena, countPmtElementaryInfos(buffer));
+					if(pmtVersion != NULL)
+					{
+						if(parsePmtTable(buffer, pmtVersion) == TABLES_PARSE_OK)
+						{
+							channelMapSetPmt(pmtVersion);
+							backgroundPmt[i].received = 1;
+						}
+						tableArenaDiscard(arena);
+					}
+					break;
+				}
+			}
+			return;
+		}
+
+		pmtVersion = pmtVersionOpen(&arena, countPmtElementaryInfos(buffer));
+		if(pmtVersion == NULL)
+		{
+			return;
+		}
 
-		if(parsePmtTable(buffer,pmtTable)==TABLES_PARSE_OK)
+		if(parsePmtTable(buffer,pmtVersion)==TABLES_PARSE_OK)
 		{
-			//printPmtTable(pmtTable);
-			pthread_mutex_lock(&demuxMutex);
-			pthread_cond_signal(&demuxCond);
-			pthread_mutex_unlock(&demuxMutex);
+			//printPmtTable(pmtVersion);
+
+			/* new version of watched service is compared with played one while both are available */
+			if(pmtReceived)
+			{
+				pmtUpdateDiff |= pmtDiff(pmtTable, pmtVersion);
+				pmtUpdatePending = 1;
+			}
+			tableArenaPublish(&pmtArena, arena);
+			pmtTable = pmtVersion;
+
+			/* live PMT is parsed again only when its version changes */
+			sectionFilterSetVersionNotEqual(&pmtFilter, pmtTable->pmtHeader.versionNumber);
+			pmtReceived = 1;
+		}
+		else
+		{
+			tableArenaDiscard(arena);
 		}
 	}
 	else if (tableId==0x4E)
 	{
 		//printf("\n%s -----EIT TABLE ARRIVED-----\n",__FUNCTION__);
-		if(parseEitTable(buffer,eitTable)==TABLES_PARSE_OK)
+		if(!sectionFilterMatch(&eitFilter, buffer))
+		{
+			return;
+		}
+
+		eitVersion = eitVersionOpen(&arena, countEitEventInfos(buffer));
+		if(eitVersion == NULL)
+		{
+			return;
+		}
+
+		if(parseEitTable(buffer,eitVersion)==TABLES_PARSE_OK)
 		{
-			//printEitTable(eitTable);
+			//printEitTable(eitVersion);
+			tableArenaPublish(&eitArena, arena);
+			eitTable = eitVersion;
+
+			/* present event is parsed again only when it changes */
+			sectionFilterSetVersionNotEqual(&eitFilter, eitTable->eitHeader.versionNumber);
 
 			/* filling EIT info buffer with arrived event data */
 			eitBufferFilling(eitTable);
 
-			pthread_mutex_lock(&demuxMutex);
-			pthread_cond_signal(&demuxCond);
-			pthread_mutex_unlock(&demuxMutex);
+			/* EPG cache keeps events over reboots */
+			for(i = 0; i < eitTable->eventInfoCount; i++)
+			{
+				epgCacheAddEvent(eitTable->eitHeader.serviceId, eitTable->eitEventInfoArray[i].eventId,
+				                 dvbTimeToUtc(eitTable->eitEventInfoArray[i].startTime),
+				                 dvbDurationToSeconds(eitTable->eitEventInfoArray[i].duration),
+				                 eitTable->eitEventInfoArray[i].runningStatus,
+				                 stringPoolGet(eitTable->eitEventInfoArray[i].shortEventDescriptor.eventName));
+			}
+
+			eitReceived = 1;
+		}
+		else
+		{
+			tableArenaDiscard(arena);
+		}
+	}
+	else if (tableId==0x70)
+	{
+		if(parseTdtTable(buffer, &tdtTable) == TABLES_PARSE_OK)
+		{
+			epgCacheSetBroadcastTime(dvbTimeToUtc(tdtTable.utcTime));
+
+			/* slot is given back until next refresh */
+			if (tdtRequestId != -1)
+			{
+				filterSchedulerRemove(tdtRequestId);
+				tdtRequestId = -1;
+			}
+			tdtTimeUs = getTimeUs();
 		}
 	}
-	return 0;
 }
 
 int32_t tunerStatusCallback(t_LockStatus status)
@@ -524,36 +2044,107 @@ int32_t tunerStatusCallback(t_LockStatus status)
 }
 
 
-eitBufferElement* eitTableGet()
+StreamControllerError eitTableGet(eitBufferElement* eitInfo)
 {
+	StringHandle cachedName;
+	TableArena* arena;
+	PatGeneration* generation;
+	int16_t channelIndex = currentChannel.programNumber;
 	int i;
+
+	if (eitInfo == NULL)
+	{
+		return SC_ERROR;
+	}
+
+	/* called from application thread, PAT version is kept until search is done */
+	arena = tableArenaAcquire(&patArena);
+	if (arena == NULL)
+	{
+		return SC_ERROR;
+	}
+	generation = (PatGeneration*)arena->root;
+
+	/* before first PAT or after PAT shrank watched channel is not in this version */
+	if (channelIndex < 0 || channelIndex >= generation->patTable.serviceInfoCount)
+	{
+		tableArenaRelease(arena);
+		return SC_ERROR;
+	}
+
 	printf("\n\nTrazi INFO za kanal\n");
 	printf("\n\n--------------------------------------\n");
-	for(i = 0; i < eitBufferSize; i++)
+	for(i = 0; i < generation->eitBufferSize; i++)
 	{
-		printf("eitBuffer[%d].programNumber:%d\n", i, eitBuffer[i].programNumber);
-		printf("eitBuffer[%d].name:%s\n\n", i, eitBuffer[i].name);
+		printf("eitBuffer[%d].programNumber:%d\n", i, generation->eitBuffer[i].programNumber);
+		printf("eitBuffer[%d].name:%s\n\n", i, stringPoolGet(generation->eitBuffer[i].name));
 	}
 	printf("\n\n--------------------------------------\n");
 
-	for(i = 0; i < eitBufferSize; i++)
+	/* EPG cache of previous run until present event of current service arrives, only stream controller thread interns */
+	cachedName = __atomic_load_n(&cachedEventName, __ATOMIC_ACQUIRE);
+	if (cachedName != STRING_HANDLE_EMPTY)
+	{
+		eventName = cachedName;
+	}
+
+	for(i = 0; i < generation->eitBufferSize; i++)
 	{
-		if(eitBuffer[i].programNumber == patTable->patServiceInfoArray[currentChannel.programNumber].programNumber)
+		if(generation->eitBuffer[i].programNumber == generation->patTable.patServiceInfoArray[channelIndex].programNumber)
 		{
 			/* found searched info */
-			//printf("\n\nNumber:%d\n", eitBuffer[i].programNumber);
-			//printf("Name:%s", eitBuffer[i].name);
+			//printf("\n\nNumber:%d\n", generation->eitBuffer[i].programNumber);
+			//printf("Name:%s", stringPoolGet(generation->eitBuffer[i].name));
+
+			/* Puting info in temporary holder */
+			eventName = generation->eitBuffer[i].name;
+		}
+	}
+
+	/* info is copied, PAT version may be freed as soon as it is released */
+	eitInfo->programNumber = generation->patTable.patServiceInfoArray[channelIndex].programNumber;
+	eitInfo->name = eventName;
+	eitInfo->genre = eventGenre;
+	tableArenaRelease(arena);
 
-			/* Clean eventName and eventGenre buffers */
-			memset(eventName, '\0', sizeof(eventName));
-			//memset(eventGenre, '\0', sizeof(eventGenre));
+	return SC_NO_ERROR;
+}
+
+uint8_t copyCachedPresentName(uint16_t serviceId, uint32_t utcTime, char* buffer, uint32_t size)
+{
+	EpgCacheEvent event;
+	uint16_t cachedServiceId;
+	uint16_t serviceCount = epgCacheGetServiceCount();
+	uint16_t i;
 
-			/* Puting info in temporary buffer */
-			strcpy(eventName, eitBuffer[i].name);
+	/* events and names are copied under cache lock, pointers into cache are valid only in stream controller thread */
+	for (i = 0; i < serviceCount; i++)
+	{
+		cachedServiceId = 0;
+		if (epgCacheCopyEvents(i, &cachedServiceId, utcTime, utcTime + 1, &event, 1) == 1 && cachedServiceId == serviceId)
+		{
+			epgCacheCopyString(event.nameOffset, buffer, size);
+			return 1;
+		}
+		if (cachedServiceId == serviceId)
+		{
+			break;
 		}
 	}
 
-	return eitBuffer;
+	return 0;
+}
+
+void updateCachedEventName(void)
+{
+	char name[CACHED_NAME_LENGTH];
+	StringHandle handle = STRING_HANDLE_EMPTY;
+
+	if (copyCachedPresentName(watchedServiceId, epgCacheGetBroadcastTime(), name, sizeof(name)))
+	{
+		handle = stringPoolIntern(name, strlen(name));
+	}
+	__atomic_store_n(&cachedEventName, handle, __ATOMIC_RELEASE);
 }
 
 void eitBufferFilling(EitTable* eitTableElement)
@@ -561,13 +2152,19 @@ void eitBufferFilling(EitTable* eitTableElement)
 	int i;
 	int infoFound = 0;
 
+	/* only present event is kept */
+	if(eitTable->eventInfoCount == 0)
+	{
+		return;
+	}
+
 	for(i = 0; i < eitBufferSize; i++)
 	{
 		if(eitBuffer[i].programNumber == eitTable->eitHeader.serviceId)
 		{
 			if(eitTable->eitEventInfoArray[0].runningStatus == 4)
 			{
-				strcpy(eitBuffer[i].name, eitTable->eitEventInfoArray[0].shortEventDescriptor.eventName);
+				eitBuffer[i].name = eitTable->eitEventInfoArray[0].shortEventDescriptor.eventName;
 				/* TODO: Genre not implemented yet */
 			}
 
@@ -582,7 +2179,7 @@ void eitBufferFilling(EitTable* eitTableElement)
 			if(eitBuffer[i].programNumber == 0)
 			{
 				eitBuffer[i].programNumber = eitTable->eitHeader.serviceId;
-				strcpy(eitBuffer[i].name, eitTable->eitEventInfoArray[0].shortEventDescriptor.eventName);
+				eitBuffer[i].name = eitTable->eitEventInfoArray[0].shortEventDescriptor.eventName;
 				/* TODO: Genre not implemented yet */
 				break;
 			}
@@ -605,6 +2202,21 @@ StreamControllerError registerProgramTypeCallback(ProgramTypeCallback programTyp
 	}
 }
 
+StreamControllerError registerScramblingCallback(ScramblingCallback scramblingCallback)
+{
+	if (scramblingCallback == NULL)
+	{
+		printf("Error registring scrambling callback!\n");
+		return SC_ERROR;
+	}
+	else
+	{
+		printf("scrambling callback function registered!\n");
+		scramblingNotify = scramblingCallback;
+		return SC_NO_ERROR;
+	}
+}
+
 void setVolume(uint8_t volume)
 {
 	Player_Volume_Set(playerHandle, volume * VOLUME_SCALE);
@@ -612,5 +2224,28 @@ void setVolume(uint8_t volume)
 
 uint8_t getNumberOfChannels()
 {
-	return patTable->serviceInfoCount - 1;
-}
\ No newline at end of file
+	TableArena* arena;
+	uint8_t channelCount = 0;
+
+	arena = tableArenaAcquire(&patArena);
+	if (arena != NULL)
+	{
+		/* entry 0 is network information table, empty PAT before first one arrives has none */
+		if (((PatGeneration*)arena->root)->patTable.serviceInfoCount > 1)
+		{
+			channelCount = ((PatGeneration*)arena->root)->patTable.serviceInfoCount - 1;
+		}
+		tableArenaRelease(arena);
+	}
+
+	return channelCount;
+}
+
+void printSectionFilterCounters()
+{
+	printf("\n********************SECTION FILTERS********************\n");
+	printSectionFilterStats("PAT", &patFilter);
+	printSectionFilterStats("PMT", &pmtFilter);
+	printSectionFilterStats("EIT", &eitFilter);
+	printf("\n********************SECTION FILTERS********************\n");
+}
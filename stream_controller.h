@@ -3,7 +3,17 @@
 
 #include "tables.h"
 #include "tdp_api.h"
-#include "tables.h"
+#include "section_filter.h"
+#include "filter_scheduler.h"
+#include "section_queue.h"
+#include "ts_monitor.h"
+#include "channel_map.h"
+#include "channel_db.h"
+#include "epg_cache.h"
+#include "table_arena.h"
+#include "heap_stats.h"
+#include "pmt_stream_parser.h"
+#include "pmt_diff.h"
 #include "pthread.h"
 
 #include <stdio.h>
@@ -12,8 +22,15 @@
 #include <errno.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
 
 #define VOLUME_SCALE 160400000
+#define DEMUX_FILTER_SLOTS 4            /* Default number of demux section filters */
+#define SCHEDULER_TICK_MS 10            /* Stream controller loop period */
+#define PAT_TIMEOUT_MS 5000             /* No PAT after tuner lock, stream controller gives up */
+#define PMT_TIMEOUT_MS 2000             /* Late PMT still starts streams from stream controller loop */
+#define EIT_TIMEOUT_MS 2500             /* Present/following repeats at least every 2 s, channel runs without it */
+#define CACHED_NAME_LENGTH 256          /* Event name copied from EPG cache */
 
 /**
  * @brief Structure that defines user config file parameters
@@ -24,6 +41,9 @@ typedef struct _Config
 	uint32_t bandwidth;     /* Can be smaller... */
 	t_Module module;        /* enum */
 	uint16_t programNumber;
+	uint8_t filterSlots;    /* Number of demux section filters, 0 for default */
+	uint8_t skipDeadServices;   /* P+/P- skip services whose elementary pids carry no packets */
+	uint8_t speculativeStart;   /* Start streams of last watched service before PAT and PMT arrive */
 }InputConfig;
 
 /**
@@ -45,8 +65,8 @@ typedef struct _ChannelInfo
 	int16_t audioPid;
 	int16_t videoPid;
 	int16_t hasTeletext;
-	char eventName[128];
-	char eventGenre[128];
+	StringHandle eventName;
+	StringHandle eventGenre;
 }ChannelInfo;
 
 /**
@@ -55,10 +75,45 @@ typedef struct _ChannelInfo
 typedef struct _eitBufferElement
 {
 	int16_t programNumber;
-	char name[128];
-	char genre[128];
+	StringHandle name;
+	StringHandle genre;
 }eitBufferElement;
 
+/**
+ * @brief Structure that defines audio and video of live PMT known before whole section arrived
+ */
+typedef struct _EarlyPmt
+{
+	int16_t videoPid;                           /* -1 while not known */
+	int16_t audioPid;
+	uint8_t videoType;
+	uint8_t audioType;
+	uint8_t scrambled;                          /* CA descriptor seen so far */
+	uint8_t pending;                            /* Pids changed since stream controller looked */
+	uint8_t failed;                             /* CRC error or lost packet, pids are revoked */
+	uint8_t confirmed;                          /* CRC ok */
+}EarlyPmt;
+
+/**
+ * @brief Structure that defines tables of one PAT version, allocated from one arena
+ */
+typedef struct _PatGeneration
+{
+	PatTable patTable;
+	eitBufferElement* eitBuffer;                /* One element per PAT service, from the same arena */
+	int32_t eitBufferSize;
+}PatGeneration;
+
+/**
+ * @brief Structure that defines PMT of a service acquired in background
+ */
+typedef struct _BackgroundPmt
+{
+	SectionFilter sectionFilter;
+	int32_t requestId;
+	uint8_t received;
+}BackgroundPmt;
+
 /**
  * @brief Initializes stream controller module
  *
@@ -107,6 +162,17 @@ typedef void (*ProgramTypeCallback)(int16_t type);
  */
 StreamControllerError registerProgramTypeCallback(ProgramTypeCallback programTypeCallback);
 
+typedef void (*ScramblingCallback)(uint8_t scrambled);
+
+/**
+ * @brief - Scrambled service callback, called on every channel start
+ *
+ * @param [in] scramblingCallback - pointer to function that gets 1 for scrambled service, 0 otherwise
+ *
+ * @return - Stream controller error
+ */
+StreamControllerError registerScramblingCallback(ScramblingCallback scramblingCallback);
+
 /**
  * @brief - Returns total number of channels.
  *
@@ -126,9 +192,11 @@ void changeChannelExtern(int16_t channelNumber);
 /**
  * @brief - Gets EIT info by current channel
  *
- * @return - eitBufferElement
+ * @param eitInfo - Copied EIT info of current channel
+ *
+ * @return - Stream controller error code
  */
-eitBufferElement* eitTableGet();
+StreamControllerError eitTableGet(eitBufferElement* eitInfo);
 
 /**
  * @brief - Fills or refreshes local buffer with current channel EIT info
@@ -148,4 +216,24 @@ void eitBufferFilling(EitTable* eitTableElement);
  */
 void setVolume(uint8_t volume);
 
+/**
+ * @brief - Software demux path entry, receives raw transport stream packets
+ *
+ * Called by platform glue that exposes the multiplex (or by a TS file replay),
+ * runs on every packet so it has to stay cheap.
+ *
+ * @param packets - Buffer that contains whole TS packets
+ * @param count - Number of packets in buffer
+ *
+ * @return - void
+ */
+void tsPacketsReceived(const uint8_t* packets, uint32_t count);
+
+/**
+ * @brief - Prints software section filter counters (sections dropped before parsing)
+ *
+ * @return - void
+ */
+void printSectionFilterCounters();
+
 #endif /* __STREAM_CONTROLLER_H__ */
@@ -0,0 +1,220 @@
+#include "string_pool.h"
+
+/**
+ * @brief Hash table entry, hash is kept to skip most string compares
+ */
+typedef struct _StringPoolEntry
+{
+	uint32_t hash;
+	StringHandle handle;                        /* STRING_HANDLE_EMPTY for free entry */
+}StringPoolEntry;
+
+static char* chunkMemory = NULL;                /* All chunks in one block */
+static char* chunks[STRING_POOL_MAX_CHUNKS];
+static uint32_t chunkCount = 0;                 /* Chunks in use */
+static uint32_t chunkUsed = 0;                  /* Used bytes of last chunk */
+
+static StringPoolEntry* hashTable = NULL;
+static uint32_t hashSize = 0;
+static uint32_t stringCount = 0;
+
+/* Statistics */
+static uint32_t internCount = 0;
+static uint64_t internedBytes = 0;              /* Bytes that would be stored without interning */
+static uint32_t storedBytes = 0;
+static uint32_t droppedCount = 0;               /* Strings not interned because pool was full */
+
+/**
+ * @brief - FNV-1a hash of string.
+ */
+static uint32_t stringPoolHash(const char* string, uint32_t length);
+
+/**
+ * @brief - Copies string to arena and returns its handle.
+ */
+static StringHandle stringPoolStore(const char* string, uint32_t length);
+
+StringPoolError stringPoolInit(void)
+{
+	uint32_t i;
+
+	stringPoolDeinit();
+
+	hashTable = (StringPoolEntry*)calloc(STRING_POOL_HASH_SIZE, sizeof(StringPoolEntry));
+	if (hashTable == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		return STRING_POOL_ERROR;
+	}
+	hashSize = STRING_POOL_HASH_SIZE;
+
+	/* pages of unused chunks are not touched until strings are stored in them */
+	chunkMemory = (char*)malloc(STRING_POOL_MAX_CHUNKS * STRING_POOL_CHUNK_SIZE);
+	if (chunkMemory == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		free(hashTable);
+		hashTable = NULL;
+		hashSize = 0;
+		return STRING_POOL_ERROR;
+	}
+	for (i = 0; i < STRING_POOL_MAX_CHUNKS; i++)
+	{
+		chunks[i] = chunkMemory + i * STRING_POOL_CHUNK_SIZE;
+	}
+	chunkCount = 1;
+
+	/* offset 0 of chunk 0 is empty string, handle 0 */
+	chunks[0][0] = '\0';
+	chunkUsed = 1;
+
+	return STRING_POOL_NO_ERROR;
+}
+
+void stringPoolDeinit(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < STRING_POOL_MAX_CHUNKS; i++)
+	{
+		chunks[i] = NULL;
+	}
+	free(chunkMemory);
+	chunkMemory = NULL;
+	chunkCount = 0;
+	chunkUsed = 0;
+
+	free(hashTable);
+	hashTable = NULL;
+	hashSize = 0;
+	stringCount = 0;
+	internCount = 0;
+	internedBytes = 0;
+	storedBytes = 0;
+	droppedCount = 0;
+}
+
+StringHandle stringPoolIntern(const char* string, uint32_t length)
+{
+	uint32_t hash;
+	uint32_t index;
+	StringHandle handle;
+	const char* stored;
+
+	if (string == NULL || length == 0 || hashTable == NULL || length >= STRING_POOL_CHUNK_SIZE)
+	{
+		return STRING_HANDLE_EMPTY;
+	}
+
+	internCount++;
+	internedBytes += length + 1;
+
+	hash = stringPoolHash(string, length);
+	for (index = hash & (hashSize - 1); hashTable[index].handle != STRING_HANDLE_EMPTY; index = (index + 1) & (hashSize - 1))
+	{
+		if (hashTable[index].hash == hash)
+		{
+			stored = stringPoolGet(hashTable[index].handle);
+			if (strncmp(stored, string, length) == 0 && stored[length] == '\0')
+			{
+				return hashTable[index].handle;
+			}
+		}
+	}
+
+	/* hash table is not grown, load factor is kept under one half by string limit */
+	handle = (stringCount < STRING_POOL_MAX_STRINGS) ? stringPoolStore(string, length) : STRING_HANDLE_EMPTY;
+	if (handle == STRING_HANDLE_EMPTY)
+	{
+		if (droppedCount == 0)
+		{
+			printf("\n%s : ERROR string pool is full\n", __FUNCTION__);
+		}
+		droppedCount++;
+		return STRING_HANDLE_EMPTY;
+	}
+
+	hashTable[index].hash = hash;
+	hashTable[index].handle = handle;
+	stringCount++;
+
+	return handle;
+}
+
+const char* stringPoolGet(StringHandle handle)
+{
+	uint32_t chunk = handle >> 16;
+	char* base;
+
+	if (chunk >= STRING_POOL_MAX_CHUNKS)
+	{
+		return "";
+	}
+
+	base = __atomic_load_n(&chunks[chunk], __ATOMIC_ACQUIRE);
+	if (base == NULL)
+	{
+		return "";
+	}
+
+	return base + (handle & 0xFFFF);
+}
+
+uint32_t stringPoolGetMemoryUsage(void)
+{
+	return (chunkMemory != NULL ? STRING_POOL_MAX_CHUNKS * STRING_POOL_CHUNK_SIZE : 0) + hashSize * sizeof(StringPoolEntry);
+}
+
+void printStringPoolStats(void)
+{
+	printf("\n********************STRING POOL********************\n");
+	printf("interned strings         |      %u\n", internCount);
+	printf("unique strings           |      %u\n", stringCount);
+	printf("bytes without interning  |      %llu\n", (unsigned long long)internedBytes);
+	printf("stored bytes             |      %u\n", storedBytes);
+	printf("dropped, pool full       |      %u\n", droppedCount);
+	printf("memory (chunks + hash)   |      %u\n", stringPoolGetMemoryUsage());
+	printf("\n********************STRING POOL********************\n");
+}
+
+uint32_t stringPoolHash(const char* string, uint32_t length)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t i;
+
+	for (i = 0; i < length; i++)
+	{
+		hash ^= (uint8_t)string[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+StringHandle stringPoolStore(const char* string, uint32_t length)
+{
+	StringHandle handle;
+	char* chunk;
+
+	/* strings never span chunks, rest of full chunk is left unused */
+	if (chunkUsed + length + 1 > STRING_POOL_CHUNK_SIZE)
+	{
+		if (chunkCount == STRING_POOL_MAX_CHUNKS)
+		{
+			return STRING_HANDLE_EMPTY;
+		}
+
+		chunkCount++;
+		chunkUsed = 0;
+	}
+
+	chunk = chunks[chunkCount - 1];
+	memcpy(chunk + chunkUsed, string, length);
+	chunk[chunkUsed + length] = '\0';
+
+	handle = ((chunkCount - 1) << 16) | chunkUsed;
+	chunkUsed += length + 1;
+	storedBytes += length + 1;
+
+	return handle;
+}
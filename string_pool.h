@@ -0,0 +1,74 @@
+#ifndef __STRING_POOL_H__
+#define __STRING_POOL_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_POOL_CHUNK_SIZE      (64 * 1024)     /* Size of one arena chunk, max string length */
+#define STRING_POOL_MAX_CHUNKS      32              /* All chunks are allocated by stringPoolInit() */
+#define STRING_POOL_HASH_SIZE       65536           /* Number of hash buckets, power of 2, allocated by stringPoolInit() */
+#define STRING_POOL_MAX_STRINGS     (STRING_POOL_HASH_SIZE / 2) /* Load factor is kept under one half */
+#define STRING_HANDLE_EMPTY         0               /* Handle of empty string */
+
+/**
+ * @brief Handle of interned string, chunk index in upper 16 bits and offset in lower 16 bits
+ */
+typedef uint32_t StringHandle;
+
+/**
+ * @brief Enumeration of string pool error codes
+ */
+typedef enum _StringPoolError
+{
+	STRING_POOL_NO_ERROR = 0,
+	STRING_POOL_ERROR
+}StringPoolError;
+
+/**
+ * @brief Initializes empty string pool, allocates all chunks and the hash table
+ *
+ * Interning never allocates, a full pool returns STRING_HANDLE_EMPTY.
+ *
+ * @return string pool error code
+ */
+StringPoolError stringPoolInit(void);
+
+/**
+ * @brief Frees all strings, handles are invalid afterwards
+ */
+void stringPoolDeinit(void);
+
+/**
+ * @brief Returns handle of string, same content always gets the same handle
+ *
+ * Only one thread may intern, strings of returned handles can be read from any thread.
+ *
+ * @param [in] string - String, does not need to be null terminated
+ * @param [in] length - String length
+ * @return string handle, STRING_HANDLE_EMPTY for empty string or if pool is full
+ */
+StringHandle stringPoolIntern(const char* string, uint32_t length);
+
+/**
+ * @brief Returns null terminated string of handle
+ *
+ * @param [in] handle - String handle
+ * @return string, never NULL
+ */
+const char* stringPoolGet(StringHandle handle);
+
+/**
+ * @brief Returns number of bytes allocated by pool (chunks and hash table)
+ *
+ * @return number of bytes
+ */
+uint32_t stringPoolGetMemoryUsage(void);
+
+/**
+ * @brief Prints pool statistics
+ */
+void printStringPoolStats(void);
+
+#endif /* __STRING_POOL_H__ */
@@ -0,0 +1,252 @@
+#include "table_arena.h"
+
+static uint8_t* arenaMemory = NULL;
+static TableArena arenas[TABLE_ARENA_COUNT];
+static uint32_t generationCount = 0;
+
+/* Statistics */
+static uint32_t publishCount = 0;
+static uint32_t discardCount = 0;
+static uint32_t freeCount = 0;
+static uint32_t openFailCount = 0;
+static uint32_t allocFailCount = 0;
+static uint32_t peakUsed = 0;
+static uint32_t peakArenas = 0;
+
+/**
+ * @brief - Frees retired arenas whose readers are done.
+ */
+static void tableArenaCollect(void);
+
+TableArenaError tableArenaInit(void)
+{
+	uint32_t i;
+
+	tableArenaDeinit();
+
+	arenaMemory = (uint8_t*)malloc(TABLE_ARENA_COUNT * TABLE_ARENA_SIZE);
+	if (arenaMemory == NULL)
+	{
+		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		return TABLE_ARENA_ERROR;
+	}
+
+	memset(arenas, 0x0, sizeof(arenas));
+	for (i = 0; i < TABLE_ARENA_COUNT; i++)
+	{
+		arenas[i].memory = arenaMemory + i * TABLE_ARENA_SIZE;
+	}
+
+	return TABLE_ARENA_NO_ERROR;
+}
+
+void tableArenaDeinit(void)
+{
+	free(arenaMemory);
+	arenaMemory = NULL;
+	memset(arenas, 0x0, sizeof(arenas));
+	generationCount = 0;
+	publishCount = 0;
+	discardCount = 0;
+	freeCount = 0;
+	openFailCount = 0;
+	allocFailCount = 0;
+	peakUsed = 0;
+	peakArenas = 0;
+}
+
+TableArena* tableArenaOpen(void)
+{
+	TableArena* arena = NULL;
+	uint32_t inUse = 0;
+	uint32_t i;
+
+	if (arenaMemory == NULL)
+	{
+		return NULL;
+	}
+
+	tableArenaCollect();
+
+	for (i = 0; i < TABLE_ARENA_COUNT; i++)
+	{
+		if (arenas[i].state != TABLE_ARENA_FREE)
+		{
+			inUse++;
+		}
+		else if (arena == NULL)
+		{
+			arena = &arenas[i];
+		}
+	}
+
+	if (arena == NULL)
+	{
+		printf("\n%s : ERROR all table arenas are in use\n", __FUNCTION__);
+		openFailCount++;
+		return NULL;
+	}
+
+	arena->used = 0;
+	arena->root = NULL;
+	arena->generation = ++generationCount;
+	arena->state = TABLE_ARENA_OPEN;
+
+	if (inUse + 1 > peakArenas)
+	{
+		peakArenas = inUse + 1;
+	}
+
+	return arena;
+}
+
+void* tableArenaAlloc(TableArena* arena, uint32_t size)
+{
+	uint32_t aligned = (size + TABLE_ARENA_ALIGN - 1) & ~(TABLE_ARENA_ALIGN - 1);
+	void* memory;
+
+	if (arena == NULL || arena->state != TABLE_ARENA_OPEN)
+	{
+		printf("\n%s : ERROR arena is not open\n", __FUNCTION__);
+		return NULL;
+	}
+
+	if (aligned > TABLE_ARENA_SIZE - arena->used)
+	{
+		printf("\n%s : ERROR table arena is full, %u bytes requested\n", __FUNCTION__, size);
+		allocFailCount++;
+		return NULL;
+	}
+
+	memory = arena->memory + arena->used;
+	memset(memory, 0x0, aligned);
+	arena->used += aligned;
+
+	if (arena->root == NULL)
+	{
+		arena->root = memory;
+	}
+	if (arena->used > peakUsed)
+	{
+		peakUsed = arena->used;
+	}
+
+	return memory;
+}
+
+void tableArenaPublish(TableArena** current, TableArena* arena)
+{
+	TableArena* previous = *current;
+
+	if (arena != NULL)
+	{
+		arena->state = TABLE_ARENA_PUBLISHED;
+		publishCount++;
+	}
+
+	/* table is complete before readers can see it */
+	__atomic_store_n(current, arena, __ATOMIC_SEQ_CST);
+
+	if (previous != NULL)
+	{
+		previous->state = TABLE_ARENA_RETIRED;
+	}
+}
+
+void tableArenaDiscard(TableArena* arena)
+{
+	if (arena == NULL || arena->state != TABLE_ARENA_OPEN)
+	{
+		return;
+	}
+
+	arena->state = TABLE_ARENA_FREE;
+	discardCount++;
+}
+
+TableArena* tableArenaAcquire(TableArena** current)
+{
+	TableArena* arena;
+
+	for (;;)
+	{
+		arena = __atomic_load_n(current, __ATOMIC_SEQ_CST);
+		if (arena == NULL)
+		{
+			return NULL;
+		}
+
+		__atomic_fetch_add(&arena->readers, 1, __ATOMIC_SEQ_CST);
+
+		/* arena replaced in the meantime may already be freed, next try gets its successor */
+		if (__atomic_load_n(current, __ATOMIC_SEQ_CST) == arena)
+		{
+			return arena;
+		}
+
+		__atomic_fetch_sub(&arena->readers, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+void tableArenaRelease(TableArena* arena)
+{
+	if (arena != NULL)
+	{
+		__atomic_fetch_sub(&arena->readers, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+void printTableArenaStats(void)
+{
+	printf("\n********************TABLE ARENAS********************\n");
+	printf("arena size               |      %u\n", TABLE_ARENA_SIZE);
+	printf("table versions opened    |      %u\n", generationCount);
+	printf("table versions published |      %u\n", publishCount);
+	printf("table versions discarded |      %u\n", discardCount);
+	printf("arenas freed             |      %u\n", freeCount);
+	printf("peak arenas in use       |      %u / %u\n", peakArenas, TABLE_ARENA_COUNT);
+	printf("peak bytes in arena      |      %u\n", peakUsed);
+	printf("open failures            |      %u\n", openFailCount);
+	printf("allocation failures      |      %u\n", allocFailCount);
+	printf("\n********************TABLE ARENAS********************\n");
+}
+
+uint32_t printTableArenaLeakReport(void)
+{
+	static const char* stateNames[] = {"free", "open", "published", "retired"};
+	uint32_t leakCount = 0;
+	uint32_t i;
+
+	tableArenaCollect();
+
+	printf("\n********************TABLE ARENA LEAKS********************\n");
+	for (i = 0; i < TABLE_ARENA_COUNT; i++)
+	{
+		if (arenas[i].state == TABLE_ARENA_FREE)
+		{
+			continue;
+		}
+		printf("arena %u                  |      %s, generation %u, %u bytes, %u readers\n", i,
+		       stateNames[arenas[i].state], arenas[i].generation, arenas[i].used,
+		       __atomic_load_n(&arenas[i].readers, __ATOMIC_SEQ_CST));
+		leakCount++;
+	}
+	printf("arenas in use            |      %u\n", leakCount);
+	printf("\n********************TABLE ARENA LEAKS********************\n");
+
+	return leakCount;
+}
+
+void tableArenaCollect(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < TABLE_ARENA_COUNT; i++)
+	{
+		if (arenas[i].state == TABLE_ARENA_RETIRED && __atomic_load_n(&arenas[i].readers, __ATOMIC_SEQ_CST) == 0)
+		{
+			arenas[i].state = TABLE_ARENA_FREE;
+			freeCount++;
+		}
+	}
+}
@@ -0,0 +1,118 @@
+#ifndef __TABLE_ARENA_H__
+#define __TABLE_ARENA_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TABLE_ARENA_SIZE        (16 * 1024)     /* Size of one arena, holds all structures of one table version */
+#define TABLE_ARENA_COUNT       8               /* Published, retired and open arenas together */
+#define TABLE_ARENA_ALIGN       8               /* Alignment of every allocation */
+
+/**
+ * @brief Enumeration of table arena error codes
+ */
+typedef enum _TableArenaError
+{
+	TABLE_ARENA_NO_ERROR = 0,
+	TABLE_ARENA_ERROR
+}TableArenaError;
+
+/**
+ * @brief Enumeration of table arena states
+ */
+typedef enum _TableArenaState
+{
+	TABLE_ARENA_FREE = 0,
+	TABLE_ARENA_OPEN,                           /* Being filled by parser, not visible to readers */
+	TABLE_ARENA_PUBLISHED,                      /* Current table version */
+	TABLE_ARENA_RETIRED                         /* Replaced, freed when last reader is done */
+}TableArenaState;
+
+/**
+ * @brief Structure that defines arena of one table version
+ */
+typedef struct _TableArena
+{
+	uint8_t* memory;
+	uint32_t used;
+	uint32_t generation;                        /* Incremented on every open, 0 for never opened */
+	void* root;                                 /* First allocation, table the arena was opened for */
+	uint32_t readers;                           /* Changed atomically by reader threads */
+	TableArenaState state;
+}TableArena;
+
+/**
+ * @brief Allocates memory of all arenas, the only heap allocation of the module
+ *
+ * @return table arena error code
+ */
+TableArenaError tableArenaInit(void);
+
+/**
+ * @brief Frees memory of all arenas, pointers into arenas are invalid afterwards
+ */
+void tableArenaDeinit(void);
+
+/**
+ * @brief Returns empty arena for new table version, retired arenas without readers are freed first
+ *
+ * Open, allocate, publish and discard may be called only from one (writer) thread.
+ *
+ * @return arena or NULL if all arenas are in use
+ */
+TableArena* tableArenaOpen(void);
+
+/**
+ * @brief Allocates zeroed memory from open arena
+ *
+ * @param [in] arena - Open arena
+ * @param [in] size - Number of bytes
+ * @return pointer to memory or NULL if arena is full
+ */
+void* tableArenaAlloc(TableArena* arena, uint32_t size);
+
+/**
+ * @brief Makes open arena current table version, previous version is retired
+ *
+ * @param [in/out] current - Pointer to current version, read by readers
+ * @param [in] arena - Open arena, NULL only retires current version
+ */
+void tableArenaPublish(TableArena** current, TableArena* arena);
+
+/**
+ * @brief Frees open arena that was never published, e.g. after parse error
+ *
+ * @param [in] arena - Open arena
+ */
+void tableArenaDiscard(TableArena* arena);
+
+/**
+ * @brief Returns current table version and keeps it from being freed, can be called from any thread
+ *
+ * @param [in] current - Pointer to current version
+ * @return arena, to be given back with tableArenaRelease(), or NULL if there is no version
+ */
+TableArena* tableArenaAcquire(TableArena** current);
+
+/**
+ * @brief Gives back arena returned by tableArenaAcquire()
+ *
+ * @param [in] arena - Acquired arena
+ */
+void tableArenaRelease(TableArena* arena);
+
+/**
+ * @brief Prints arena statistics
+ */
+void printTableArenaStats(void);
+
+/**
+ * @brief Frees retired arenas and prints those still in use, all versions are expected to be retired
+ *
+ * @return number of arenas still in use
+ */
+uint32_t printTableArenaLeakReport(void);
+
+#endif /* __TABLE_ARENA_H__ */
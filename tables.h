@@ -1,14 +1,12 @@
 #ifndef __TABLES_H__
 #define __TABLES_H__
 
+#include "string_pool.h"
+
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 
-#define TABLES_MAX_NUMBER_OF_PIDS_IN_PAT    20      /* Max number of PMT pids in one PAT table */
-#define TABLES_MAX_NUMBER_OF_ELEMENTARY_PID 20      /* Max number of elementary pids in one PMT table */
-#define TABLES_MAX_NUMBER_OF_EVENTS_IN_EIT  20      /* Max number of events info in EIT table */
-
 /**
  * @brief Enumeration of possible tables parser error codes
  */
@@ -47,9 +45,10 @@ typedef struct _PatServiceInfo
  */
 typedef struct _PatTable
 {
-	PatHeader patHeader;                                                  /* PAT Table Header */
-	PatServiceInfo patServiceInfoArray[TABLES_MAX_NUMBER_OF_PIDS_IN_PAT]; /* Services info presented in PAT table */
-	uint8_t serviceInfoCount;                                             /* Number of services info presented in PAT table */
+	PatHeader patHeader;                        /* PAT Table Header */
+	PatServiceInfo* patServiceInfoArray;        /* Services info presented in PAT table, set by caller */
+	uint8_t serviceInfoCount;                   /* Number of services info presented in PAT table */
+	uint8_t serviceInfoCapacity;                /* Number of entries in patServiceInfoArray, see countPatServiceInfos() */
 }PatTable;
 
 /**
@@ -67,6 +66,8 @@ typedef struct _PmtTableHeader
 	uint8_t lastSectionNumber;
 	uint16_t pcrPid;
 	uint16_t programInfoLength;
+	uint16_t caSystemId;                        /* CA_system_ID of first program level CA descriptor, 0 if none */
+	uint8_t hasCaDescriptor;                    /* Program level CA descriptor present */
 }PmtTableHeader;
 
 /**
@@ -78,6 +79,7 @@ typedef struct _PmtElementaryInfo
 	uint16_t elementaryPid;
 	uint16_t esInfoLength;
 	uint8_t teletext;
+	uint8_t hasCaDescriptor;                    /* Elementary stream level CA descriptor present */
 }PmtElementaryInfo;
 
 /**
@@ -86,8 +88,9 @@ typedef struct _PmtElementaryInfo
 typedef struct _PmtTable
 {
 	PmtTableHeader pmtHeader;
-	PmtElementaryInfo pmtElementaryInfoArray[TABLES_MAX_NUMBER_OF_ELEMENTARY_PID];
+	PmtElementaryInfo* pmtElementaryInfoArray;  /* Set by caller */
 	uint8_t elementaryInfoCount;
+	uint8_t elementaryInfoCapacity;             /* Number of entries in pmtElementaryInfoArray, see countPmtElementaryInfos() */
 }PmtTable;
 
 /**
@@ -118,7 +121,7 @@ typedef struct _Short_Event_Descriptor
 	uint8_t descriptorLength;
 	uint32_t Iso639LanguageCode;
 	uint8_t eventNameLength;
-	char eventName[256];
+	StringHandle eventName;                     /* Interned event name */
 }Short_Event_Descriptor;
 
 /**
@@ -141,10 +144,21 @@ typedef struct _EitEventInfo
 typedef struct  _EitTable
 {
 	EitHeader eitHeader;
-	EitEventInfo eitEventInfoArray[TABLES_MAX_NUMBER_OF_EVENTS_IN_EIT];
+	EitEventInfo* eitEventInfoArray;            /* Set by caller */
 	uint8_t eventInfoCount;
+	uint8_t eventInfoCapacity;                  /* Number of entries in eitEventInfoArray, see countEitEventInfos() */
 }EitTable;
 
+/**
+ * @brief Structure that defines TDT table
+ */
+typedef struct _TdtTable
+{
+	uint8_t tableId;
+	uint16_t sectionLength;
+	uint8_t utcTime[5];                         /* MJD and BCD coded UTC time */
+}TdtTable;
+
 /**
  * @brief Parse EIT header
  *
@@ -172,6 +186,14 @@ ParseErrorCode parseEitEventInfo(const uint8_t* eitEventInfoBuffer, EitEventInfo
  */
 ParseErrorCode parseShortEventDescriptor(const uint8_t* shortEventDescriptorBuffer, EitEventInfo* eitEventInfo);
 
+/**
+ * @brief Returns number of events in EIT section, walks event loop up to section_length
+ *
+ * @param [in] eitSectionBuffer - Buffer that contains EIT table section
+ * @return number of events parseEitTable() needs space for
+ */
+uint8_t countEitEventInfos(const uint8_t* eitSectionBuffer);
+
 /**
  * @brief Parse EIT table
  *
@@ -207,6 +229,14 @@ ParseErrorCode parsePatHeader(const uint8_t* patHeaderBuffer, PatHeader* patHead
  */
 ParseErrorCode parsePatServiceInfo(const uint8_t* patServiceInfoBuffer, PatServiceInfo* patServiceInfo);
 
+/**
+ * @brief  Returns number of services in PAT section, computed from section_length
+ *
+ * @param  [in]   patSectionBuffer Buffer that contains PAT table section
+ * @return number of service infos parsePatTable() needs space for
+ */
+uint8_t countPatServiceInfos(const uint8_t* patSectionBuffer);
+
 /**
  * @brief  Parse PAT Table.
  *
@@ -233,6 +263,15 @@ ParseErrorCode printPatTable(PatTable* patTable);
  */
 ParseErrorCode parsePmtHeader(const uint8_t* pmtHeaderBuffer, PmtTableHeader* pmtHeader);
 
+/**
+ * @brief Parse PMT program info descriptors (CA descriptor)
+ *
+ * @param [in]  programInfoBuffer Buffer that contains program info descriptors
+ * @param [out] pmtHeader PMT table header with program info length already parsed
+ * @return tables error code
+ */
+ParseErrorCode parsePmtProgramInfo(const uint8_t* programInfoBuffer, PmtTableHeader* pmtHeader);
+
 /**
  * @brief Parse PMT elementary info
  *
@@ -242,6 +281,14 @@ ParseErrorCode parsePmtHeader(const uint8_t* pmtHeaderBuffer, PmtTableHeader* pm
  */
 ParseErrorCode parsePmtElementaryInfo(const uint8_t* pmtElementaryInfoBuffer, PmtElementaryInfo* pmtElementaryInfo);
 
+/**
+ * @brief Returns number of elementary streams in PMT section, walks elementary stream loop up to section_length
+ *
+ * @param [in]  pmtSectionBuffer Buffer that contains pmt table section
+ * @return number of elementary infos parsePmtTable() needs space for
+ */
+uint8_t countPmtElementaryInfos(const uint8_t* pmtSectionBuffer);
+
 /**
  * @brief Parse PMT table
  *
@@ -259,6 +306,31 @@ ParseErrorCode parsePmtTable(const uint8_t* pmtSectionBuffer, PmtTable* pmtTable
  */
 ParseErrorCode printPmtTable(PmtTable* pmtTable);
 
+/**
+ * @brief Parse TDT table
+ *
+ * @param [in]  tdtSectionBuffer Buffer that contains TDT table section
+ * @param [out] tdtTable TDT table
+ * @return tables error code
+ */
+ParseErrorCode parseTdtTable(const uint8_t* tdtSectionBuffer, TdtTable* tdtTable);
+
+/**
+ * @brief Converts 40 bit MJD and BCD coded time of EIT and TDT to UTC seconds since 1970
+ *
+ * @param [in] dvbTime 5 bytes, 16 bit MJD followed by BCD hours, minutes and seconds
+ * @return UTC seconds
+ */
+uint32_t dvbTimeToUtc(const uint8_t* dvbTime);
+
+/**
+ * @brief Converts 24 bit BCD coded EIT duration to seconds
+ *
+ * @param [in] dvbDuration 3 bytes, BCD hours, minutes and seconds
+ * @return duration in seconds
+ */
+uint32_t dvbDurationToSeconds(const uint8_t* dvbDuration);
+
 #endif /* __TABLES_H__ */
 
 
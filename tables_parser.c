@@ -83,6 +83,25 @@ ParseErrorCode parsePatServiceInfo(const uint8_t* patServiceInfoBuffer, PatServi
 	return TABLES_PARSE_OK;
 }
 
+uint8_t countPatServiceInfos(const uint8_t* patSectionBuffer)
+{
+	uint16_t sectionLength;
+
+	if(patSectionBuffer==NULL)
+	{
+		return 0;
+	}
+
+	/* service loop runs from last_section_number to CRC, 4 bytes per service */
+	sectionLength = (uint16_t) (((*(patSectionBuffer + 1) << 8) + *(patSectionBuffer + 2)) & 0x0FFF);
+	if(sectionLength <= 9)
+	{
+		return 0;
+	}
+
+	return (sectionLength - 9 + 3) / 4;
+}
+
 ParseErrorCode parsePatTable(const uint8_t* patSectionBuffer, PatTable* patTable)
 {
 	uint8_t * currentBufferPosition = NULL;
@@ -106,7 +125,7 @@ ParseErrorCode parsePatTable(const uint8_t* patSectionBuffer, PatTable* patTable
 
 	while(parsedLength < patTable->patHeader.sectionLength)
 	{
-		if(patTable->serviceInfoCount > TABLES_MAX_NUMBER_OF_PIDS_IN_PAT - 1)
+		if(patTable->serviceInfoCount >= patTable->serviceInfoCapacity)
 		{
 			printf("\n%s : ERROR there is not enough space in PAT structure for Service info\n", __FUNCTION__);
 			return TABLES_PARSE_ERROR;
@@ -210,7 +229,7 @@ ParseErrorCode parsePmtHeader(const uint8_t* pmtHeaderBuffer, PmtTableHeader* pm
 	higher8Bits = (uint8_t) (*(pmtHeaderBuffer + 8));
 	lower8Bits = (uint8_t) (*(pmtHeaderBuffer + 9));
 	all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-	pmtHeader->pcrPid = all16Bits & 0xFFFF;
+	pmtHeader->pcrPid = all16Bits & 0x1FFF;
 
 	/* programInfoLength */
 	higher8Bits = (uint8_t) (*(pmtHeaderBuffer + 10));
@@ -247,27 +266,81 @@ ParseErrorCode parsePmtElementaryInfo(const uint8_t* pmtElementaryInfoBuffer, Pm
 	all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
 	pmtElementaryInfo->esInfoLength = all16Bits & 0x0FFF;
 
-	const uint8_t* teletextPointer = (pmtElementaryInfoBuffer + 5);
-	uint8_t teletextTag = *teletextPointer;
+	const uint8_t* descriptorPointer = (pmtElementaryInfoBuffer + 5);
+	uint8_t descriptorTag = 0;
+
+	pmtElementaryInfo->teletext = 0;
+	pmtElementaryInfo->hasCaDescriptor = 0;
 
-	/* Checking for teletext */
-	while(teletextPointer < pmtElementaryInfoBuffer + 5 + pmtElementaryInfo->esInfoLength)
+	/* Checking for teletext and CA descriptors */
+	while(descriptorPointer < pmtElementaryInfoBuffer + 5 + pmtElementaryInfo->esInfoLength)
 	{
-		teletextTag = *teletextPointer;
-		if(teletextTag == 0x56)
+		descriptorTag = *descriptorPointer;
+		if(descriptorTag == 0x56)
 		{
 			pmtElementaryInfo->teletext = 1;
 		}
-		else
+		else if(descriptorTag == 0x09)
 		{
-			pmtElementaryInfo->teletext = 0;
+			pmtElementaryInfo->hasCaDescriptor = 1;
 		}
-		teletextPointer += 2 + *(teletextPointer + 1);
+		descriptorPointer += 2 + *(descriptorPointer + 1);
 	}
 
 	return TABLES_PARSE_OK;
 }
 
+ParseErrorCode parsePmtProgramInfo(const uint8_t* programInfoBuffer, PmtTableHeader* pmtHeader)
+{
+	const uint8_t* descriptorPointer = programInfoBuffer;
+
+	if(programInfoBuffer==NULL || pmtHeader==NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return TABLES_PARSE_ERROR;
+	}
+
+	pmtHeader->hasCaDescriptor = 0;
+	pmtHeader->caSystemId = 0;
+
+	while(descriptorPointer < programInfoBuffer + pmtHeader->programInfoLength)
+	{
+		/* CA_descriptor: tag, length, CA_system_ID, CA_PID */
+		if(*descriptorPointer == 0x09 && *(descriptorPointer + 1) >= 4 && !pmtHeader->hasCaDescriptor)
+		{
+			pmtHeader->hasCaDescriptor = 1;
+			pmtHeader->caSystemId = (uint16_t) ((*(descriptorPointer + 2) << 8) + *(descriptorPointer + 3));
+		}
+		descriptorPointer += 2 + *(descriptorPointer + 1);
+	}
+
+	return TABLES_PARSE_OK;
+}
+
+uint8_t countPmtElementaryInfos(const uint8_t* pmtSectionBuffer)
+{
+	uint16_t sectionLength;
+	uint16_t position;
+	uint16_t count = 0;
+
+	if(pmtSectionBuffer==NULL)
+	{
+		return 0;
+	}
+
+	sectionLength = (uint16_t) (((*(pmtSectionBuffer + 1) << 8) + *(pmtSectionBuffer + 2)) & 0x0FFF);
+
+	/* elementary stream loop starts after program info descriptors and ends before CRC */
+	position = 12 + ((((*(pmtSectionBuffer + 10) << 8) + *(pmtSectionBuffer + 11))) & 0x0FFF);
+	while(position + 1 < sectionLength && count < 0xFF)
+	{
+		position += 5 + ((((*(pmtSectionBuffer + position + 3) << 8) + *(pmtSectionBuffer + position + 4))) & 0x0FFF);
+		count++;
+	}
+
+	return count;
+}
+
 ParseErrorCode parsePmtTable(const uint8_t* pmtSectionBuffer, PmtTable* pmtTable)
 {
 	uint8_t * currentBufferPosition = NULL;
@@ -285,13 +358,15 @@ ParseErrorCode parsePmtTable(const uint8_t* pmtSectionBuffer, PmtTable* pmtTable
 		return TABLES_PARSE_ERROR;
 	}
 
+	parsePmtProgramInfo(pmtSectionBuffer + 12, &(pmtTable->pmtHeader));
+
 	parsedLength = 12 + pmtTable->pmtHeader.programInfoLength /*PMT header size*/ + 4 /*CRC size*/ - 3 /*Not in section length*/;
 	currentBufferPosition = (uint8_t *)(pmtSectionBuffer + 12 + pmtTable->pmtHeader.programInfoLength); /* Position after last descriptor */
 	pmtTable->elementaryInfoCount = 0; /* Number of elementary info presented in PMT table */
 
 	while(parsedLength < pmtTable->pmtHeader.sectionLength)
 	{
-		if(pmtTable->elementaryInfoCount > TABLES_MAX_NUMBER_OF_ELEMENTARY_PID - 1)
+		if(pmtTable->elementaryInfoCount >= pmtTable->elementaryInfoCapacity)
 		{
 			printf("\n%s : ERROR there is not enough space in PMT structure for elementary info\n", __FUNCTION__);
 			return TABLES_PARSE_ERROR;
@@ -432,7 +507,6 @@ ParseErrorCode parseShortEventDescriptor(const uint8_t* shortEventDescriptorBuff
 {
 	uint8_t parsedCount = 0;
 	//uint8_t currentPosition = 0;
-	uint8_t i = 0;
 
 	if(shortEventDescriptorBuffer == NULL || eitEventInfo == NULL)
 	{
@@ -441,6 +515,8 @@ ParseErrorCode parseShortEventDescriptor(const uint8_t* shortEventDescriptorBuff
 		return TABLES_PARSE_ERROR;
 	}
 
+	eitEventInfo->shortEventDescriptor.eventName = STRING_HANDLE_EMPTY;
+
 	while(parsedCount < eitEventInfo->descriptorsLoopLength)
 	{
 		if(shortEventDescriptorBuffer[parsedCount] == 0x4D)
@@ -457,13 +533,10 @@ ParseErrorCode parseShortEventDescriptor(const uint8_t* shortEventDescriptorBuff
 
 			eitEventInfo->shortEventDescriptor.eventNameLength = (uint8_t) *(shortEventDescriptorBuffer + parsedCount + 5);
 
-			while(i < eitEventInfo->shortEventDescriptor.eventNameLength)
-			{
-				eitEventInfo->shortEventDescriptor.eventName[i] = (char) *(shortEventDescriptorBuffer + parsedCount + 6 + i);
-				i++;
-			}
-			eitEventInfo->shortEventDescriptor.eventName[eitEventInfo->shortEventDescriptor.eventNameLength] = '\0';
-			//printf("\n\nEVENT NAME:%s\n", eitEventInfo->shortEventDescriptor.eventName);
+			/* repeated titles share one copy */
+			eitEventInfo->shortEventDescriptor.eventName = stringPoolIntern((const char*)(shortEventDescriptorBuffer + parsedCount + 6),
+			                                                                eitEventInfo->shortEventDescriptor.eventNameLength);
+			//printf("\n\nEVENT NAME:%s\n", stringPoolGet(eitEventInfo->shortEventDescriptor.eventName));
 			return TABLES_PARSE_OK;
 		}
 		else if(shortEventDescriptorBuffer[parsedCount] == 0x54)
@@ -477,6 +550,29 @@ ParseErrorCode parseShortEventDescriptor(const uint8_t* shortEventDescriptorBuff
 	return TABLES_PARSE_OK;
 }
 
+uint8_t countEitEventInfos(const uint8_t* eitSectionBuffer)
+{
+	uint16_t sectionLength;
+	uint16_t position = 14;
+	uint16_t count = 0;
+
+	if(eitSectionBuffer==NULL)
+	{
+		return 0;
+	}
+
+	sectionLength = (uint16_t) (((*(eitSectionBuffer + 1) << 8) + *(eitSectionBuffer + 2)) & 0x0FFF);
+
+	/* event loop ends before CRC, every event is 12 bytes followed by its descriptors */
+	while(position + 1 < sectionLength && count < 0xFF)
+	{
+		position += 12 + ((((*(eitSectionBuffer + position + 10) << 8) + *(eitSectionBuffer + position + 11))) & 0x0FFF);
+		count++;
+	}
+
+	return count;
+}
+
 ParseErrorCode parseEitTable(const uint8_t* eitSectionBuffer, EitTable* eitTable)
 {
 	uint8_t * currentBufferPosition = NULL;
@@ -500,7 +596,7 @@ ParseErrorCode parseEitTable(const uint8_t* eitSectionBuffer, EitTable* eitTable
 
 	while(parsedLength < eitTable->eitHeader.sectionLength - 1)
 	{
-		if(eitTable->eventInfoCount > TABLES_MAX_NUMBER_OF_EVENTS_IN_EIT - 1)
+		if(eitTable->eventInfoCount >= eitTable->eventInfoCapacity)
 		{
 			printf("\n%s : ERROR there is not enough space in EIT structure for event info\n", __FUNCTION__);
 			return TABLES_PARSE_ERROR;
@@ -550,7 +646,7 @@ ParseErrorCode printEitTable(EitTable* eitTable)
 		printf("descriptors_loop_length         |      %d\n",eitTable->eitEventInfoArray[i].descriptorsLoopLength);
 		printf("\tdescriptor_tag                |      %d\n",eitTable->eitEventInfoArray[i].shortEventDescriptor.descriptorTag);
 		printf("\tdescriptor_length             |      %d\n",eitTable->eitEventInfoArray[i].shortEventDescriptor.descriptorLength);
-		printf("\tevent_name                    |      %s\n",eitTable->eitEventInfoArray[i].shortEventDescriptor.eventName);
+		printf("\tevent_name                    |      %s\n",stringPoolGet(eitTable->eitEventInfoArray[i].shortEventDescriptor.eventName));
 	}
 	printf("\n********************EIT TABLE SECTION********************\n");
 
@@ -574,14 +670,63 @@ ParseErrorCode printPmtTable(PmtTable* pmtTable)
 	printf("section_number           |      %d\n",pmtTable->pmtHeader.sectionNumber);
 	printf("last_section_number      |      %d\n",pmtTable->pmtHeader.lastSectionNumber);
 	printf("program_info_legth       |      %d\n",pmtTable->pmtHeader.programInfoLength);
+	printf("ca_system_id             |      %d\n",pmtTable->pmtHeader.caSystemId);
 
 	for (i=0; i<pmtTable->elementaryInfoCount; i++)
 	{
 		printf("-----------------------------------------\n");
 		printf("stream_type              |      %d\n",pmtTable->pmtElementaryInfoArray[i].streamType);
 		printf("elementary_pid           |      %d\n",pmtTable->pmtElementaryInfoArray[i].elementaryPid);
+		printf("ca_descriptor            |      %d\n",pmtTable->pmtElementaryInfoArray[i].hasCaDescriptor);
 	}
 	printf("\n********************PMT TABLE SECTION********************\n");
 
 	return TABLES_PARSE_OK;
-}
\ No newline at end of file
+}
+
+ParseErrorCode parseTdtTable(const uint8_t* tdtSectionBuffer, TdtTable* tdtTable)
+{
+	if(tdtSectionBuffer == NULL || tdtTable == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return TABLES_PARSE_ERROR;
+	}
+
+	tdtTable->tableId = (uint8_t)*tdtSectionBuffer;
+	if (tdtTable->tableId != 0x70)
+	{
+		printf("\n%s : ERROR it is not a TDT Table\n", __FUNCTION__);
+		return TABLES_PARSE_ERROR;
+	}
+
+	/* section_length */
+	tdtTable->sectionLength = (uint16_t) (((*(tdtSectionBuffer + 1)) << 8) + (*(tdtSectionBuffer + 2))) & 0x0FFF;
+	if (tdtTable->sectionLength < 5)
+	{
+		printf("\n%s : ERROR TDT section too short\n", __FUNCTION__);
+		return TABLES_PARSE_ERROR;
+	}
+
+	/* UTC_time */
+	memcpy(tdtTable->utcTime, tdtSectionBuffer + 3, 5);
+
+	return TABLES_PARSE_OK;
+}
+
+static uint32_t bcdToBinary(uint8_t bcd)
+{
+	return (bcd >> 4) * 10 + (bcd & 0x0F);
+}
+
+uint32_t dvbTimeToUtc(const uint8_t* dvbTime)
+{
+	uint32_t mjd = (dvbTime[0] << 8) + dvbTime[1];
+
+	/* MJD 40587 is 1970-01-01 */
+	return (mjd - 40587) * 86400 + dvbDurationToSeconds(dvbTime + 2);
+}
+
+uint32_t dvbDurationToSeconds(const uint8_t* dvbDuration)
+{
+	return bcdToBinary(dvbDuration[0]) * 3600 + bcdToBinary(dvbDuration[1]) * 60 + bcdToBinary(dvbDuration[2]);
+}
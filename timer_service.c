@@ -0,0 +1,567 @@
+#include "timer_service.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+#define TIMER_SERVICE_SLOTS         (1 << TIMER_SERVICE_SLOT_BITS)
+#define TIMER_SERVICE_SLOT_MASK     (TIMER_SERVICE_SLOTS - 1)
+#define TIMER_SERVICE_MAX_TICKS     (1ULL << (TIMER_SERVICE_LEVELS * TIMER_SERVICE_SLOT_BITS))
+#define TIMER_SERVICE_TICK_US       (TIMER_SERVICE_TICK_MS * 1000ULL)
+
+/**
+ * @brief Structure that defines timer, linked into one wheel slot while armed
+ */
+typedef struct _Timer
+{
+	struct _Timer* next;
+	struct _Timer** link;                       /* Pointer that points to this timer, for unlinking in O(1) */
+	TimerCallback callback;
+	void* arg;
+	uint64_t expires;                           /* Tick of next expiry */
+	uint64_t periodTicks;                       /* 0 for one shot timer */
+	uint64_t dueUs;                             /* Monotonic time of next expiry, for lateness */
+	uint32_t sequence;                          /* Changed by start and cancel, older collected expiries are dropped */
+	uint8_t used;
+	uint8_t armed;
+}Timer;
+
+/**
+ * @brief Structure that defines expiry collected under lock and called without it
+ */
+typedef struct _TimerExpiry
+{
+	Timer* timer;
+	uint32_t sequence;
+	uint64_t dueUs;
+	uint64_t tickUs;
+}TimerExpiry;
+
+static Timer timers[TIMER_SERVICE_MAX_TIMERS];
+static Timer* wheel[TIMER_SERVICE_LEVELS][TIMER_SERVICE_SLOTS];
+static uint64_t currentTick = 0;
+static uint32_t armedCount = 0;
+static uint64_t armTick = 0;                            /* Tick and time when ticks were started */
+static uint64_t armUs = 0;
+
+static pthread_mutex_t timerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t timerThread;
+static int32_t timerFd = -1;
+static uint8_t threadExit = 0;
+
+/* Statistics */
+static uint32_t threadCreateCount = 0;
+static uint32_t timerCreateCount = 0;
+static uint64_t wakeupCount = 0;
+static uint64_t tickCount = 0;
+static uint64_t expiryCount = 0;
+static uint64_t droppedCount = 0;
+static uint64_t latenessSumUs = 0;
+static uint64_t latenessMaxUs = 0;
+static uint64_t jitterSumUs = 0;
+static uint64_t jitterMaxUs = 0;
+static uint64_t earlyCount = 0;
+
+/**
+ * @brief - Timer service thread, runs wheel on every timerfd tick and calls expired timers.
+ */
+static void* timerServiceTask(void* params);
+
+/**
+ * @brief - Advances wheel by one tick, moves expired timers to expiry list.
+ *
+ * @return - Number of expiries added
+ */
+static uint32_t timerServiceTick(TimerExpiry* expiries, uint32_t count);
+
+/**
+ * @brief - Links timer into slot of its expiry tick.
+ */
+static void wheelInsert(Timer* timer);
+
+/**
+ * @brief - Unlinks armed timer from its slot.
+ */
+static void wheelRemove(Timer* timer);
+
+/**
+ * @brief - Moves timers of current slot of level down to lower levels.
+ */
+static void wheelCascade(uint32_t level);
+
+/**
+ * @brief - Starts or stops timerfd ticks.
+ */
+static void timerServiceArm(uint8_t enable);
+
+/**
+ * @brief - Returns timer of id, NULL if id is not a created timer.
+ */
+static Timer* timerGet(TimerId timerId);
+
+/**
+ * @brief - Returns monotonic time in microseconds.
+ */
+static uint64_t timerServiceTimeUs(void);
+
+TimerServiceError timerServiceInit(void)
+{
+	memset(timers, 0x0, sizeof(timers));
+	memset(wheel, 0x0, sizeof(wheel));
+	currentTick = 0;
+	armedCount = 0;
+	threadExit = 0;
+
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (timerFd < 0)
+	{
+		printf("\n%s : ERROR timerfd_create() failed\n", __FUNCTION__);
+		return TIMER_SERVICE_ERROR;
+	}
+
+	if (pthread_create(&timerThread, NULL, timerServiceTask, NULL))
+	{
+		printf("\n%s : ERROR Cannot create timer thread\n", __FUNCTION__);
+		close(timerFd);
+		timerFd = -1;
+		return TIMER_SERVICE_ERROR;
+	}
+	threadCreateCount++;
+
+	return TIMER_SERVICE_NO_ERROR;
+}
+
+void timerServiceDeinit(void)
+{
+	struct itimerspec wakeup;
+
+	if (timerFd < 0)
+	{
+		return;
+	}
+
+	/* thread sleeps in read(), one immediate expiry wakes it */
+	pthread_mutex_lock(&timerMutex);
+	threadExit = 1;
+	memset(&wakeup, 0x0, sizeof(wakeup));
+	wakeup.it_value.tv_nsec = 1;
+	timerfd_settime(timerFd, 0, &wakeup, NULL);
+	pthread_mutex_unlock(&timerMutex);
+
+	if (pthread_join(timerThread, NULL))
+	{
+		printf("\n%s : ERROR Pthread join failed\n", __FUNCTION__);
+	}
+
+	close(timerFd);
+	timerFd = -1;
+	memset(timers, 0x0, sizeof(timers));
+	memset(wheel, 0x0, sizeof(wheel));
+	armedCount = 0;
+}
+
+TimerId timerCreate(TimerCallback callback, void* arg)
+{
+	TimerId timerId = TIMER_SERVICE_INVALID_ID;
+	uint32_t i;
+
+	pthread_mutex_lock(&timerMutex);
+	for (i = 0; i < TIMER_SERVICE_MAX_TIMERS; i++)
+	{
+		if (!timers[i].used)
+		{
+			memset(&timers[i], 0x0, sizeof(Timer));
+			timers[i].used = 1;
+			timers[i].callback = callback;
+			timers[i].arg = arg;
+			timerId = i + 1;
+			timerCreateCount++;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&timerMutex);
+
+	if (timerId == TIMER_SERVICE_INVALID_ID)
+	{
+		printf("\n%s : ERROR All %d timers are used\n", __FUNCTION__, TIMER_SERVICE_MAX_TIMERS);
+	}
+
+	return timerId;
+}
+
+void timerDelete(TimerId timerId)
+{
+	Timer* timer;
+
+	pthread_mutex_lock(&timerMutex);
+	timer = timerGet(timerId);
+	if (timer != NULL)
+	{
+		if (timer->armed)
+		{
+			wheelRemove(timer);
+			armedCount--;
+		}
+		timer->armed = 0;
+		timer->used = 0;
+		timer->sequence++;
+	}
+	pthread_mutex_unlock(&timerMutex);
+}
+
+TimerServiceError timerStart(TimerId timerId, uint32_t delayMs, uint32_t periodMs)
+{
+	struct itimerspec untilTick;
+	Timer* timer;
+	uint64_t nowUs;
+	uint64_t untilTickUs;
+	uint64_t delayUs = (uint64_t)delayMs * 1000;
+	uint64_t ticks;
+
+	pthread_mutex_lock(&timerMutex);
+	timer = timerGet(timerId);
+	if (timer == NULL || timerFd < 0)
+	{
+		pthread_mutex_unlock(&timerMutex);
+		printf("\n%s : ERROR Invalid timer %u\n", __FUNCTION__, timerId);
+		return TIMER_SERVICE_ERROR;
+	}
+
+	if (timer->armed)
+	{
+		wheelRemove(timer);
+		armedCount--;
+	}
+
+	/* time is taken before tick is read, so next tick is never assumed later than it is */
+	nowUs = timerServiceTimeUs();
+	untilTickUs = TIMER_SERVICE_TICK_US;
+	if (armedCount == 0)
+	{
+		/* first armed timer starts ticks, first tick is one whole tick from now */
+		timerServiceArm(1);
+		armTick = currentTick;
+		armUs = nowUs;
+	}
+	else if (timerfd_gettime(timerFd, &untilTick) == 0 && (untilTick.it_value.tv_sec != 0 || untilTick.it_value.tv_nsec != 0))
+	{
+		untilTickUs = (uint64_t)untilTick.it_value.tv_sec * 1000000 + untilTick.it_value.tv_nsec / 1000;
+	}
+
+	/* timer expires on first tick at or after due time, never before */
+	ticks = 1;
+	if (delayUs > untilTickUs)
+	{
+		ticks += (delayUs - untilTickUs + TIMER_SERVICE_TICK_US - 1) / TIMER_SERVICE_TICK_US;
+	}
+
+	timer->expires = currentTick + ticks;
+	timer->dueUs = nowUs + delayUs;
+	timer->periodTicks = (periodMs + TIMER_SERVICE_TICK_MS - 1) / TIMER_SERVICE_TICK_MS;
+	if (periodMs != 0 && timer->periodTicks == 0)
+	{
+		timer->periodTicks = 1;
+	}
+	timer->sequence++;
+	timer->armed = 1;
+	armedCount++;
+	wheelInsert(timer);
+	pthread_mutex_unlock(&timerMutex);
+
+	return TIMER_SERVICE_NO_ERROR;
+}
+
+TimerServiceError timerCancel(TimerId timerId)
+{
+	Timer* timer;
+
+	pthread_mutex_lock(&timerMutex);
+	timer = timerGet(timerId);
+	if (timer == NULL)
+	{
+		pthread_mutex_unlock(&timerMutex);
+		printf("\n%s : ERROR Invalid timer %u\n", __FUNCTION__, timerId);
+		return TIMER_SERVICE_ERROR;
+	}
+
+	/* ticks are stopped by timer thread when nothing is armed */
+	if (timer->armed)
+	{
+		wheelRemove(timer);
+		armedCount--;
+	}
+	timer->armed = 0;
+	timer->sequence++;
+	pthread_mutex_unlock(&timerMutex);
+
+	return TIMER_SERVICE_NO_ERROR;
+}
+
+void printTimerServiceStats(void)
+{
+	printf("\n********************TIMER SERVICE********************\n");
+	printf("threads created          |      %u\n", threadCreateCount);
+	printf("timers created           |      %u\n", timerCreateCount);
+	printf("wakeups                  |      %llu\n", (unsigned long long)wakeupCount);
+	printf("ticks                    |      %llu\n", (unsigned long long)tickCount);
+	printf("expiries                 |      %llu\n", (unsigned long long)expiryCount);
+	printf("dropped expiries         |      %llu\n", (unsigned long long)droppedCount);
+	if (expiryCount != 0)
+	{
+		printf("avg lateness             |      %llu us\n", (unsigned long long)(latenessSumUs / expiryCount));
+	}
+	printf("max lateness             |      %llu us\n", (unsigned long long)latenessMaxUs);
+	if (expiryCount != 0)
+	{
+		printf("avg tick jitter          |      %llu us\n", (unsigned long long)(jitterSumUs / expiryCount));
+	}
+	printf("max tick jitter          |      %llu us\n", (unsigned long long)jitterMaxUs);
+	printf("early expiries           |      %llu\n", (unsigned long long)earlyCount);
+	printf("\n********************TIMER SERVICE********************\n");
+}
+
+void* timerServiceTask(void* params)
+{
+	TimerExpiry expiries[TIMER_SERVICE_MAX_TIMERS];
+	TimerCallback callback;
+	void* arg;
+	uint64_t expirations;
+	uint64_t nowUs;
+	uint32_t count;
+	uint32_t i;
+	ssize_t length;
+
+	while (1)
+	{
+		length = read(timerFd, &expirations, sizeof(expirations));
+
+		pthread_mutex_lock(&timerMutex);
+		if (threadExit)
+		{
+			pthread_mutex_unlock(&timerMutex);
+			break;
+		}
+		if (length != sizeof(expirations))
+		{
+			pthread_mutex_unlock(&timerMutex);
+			if (length < 0 && errno != EINTR && errno != EAGAIN)
+			{
+				printf("\n%s : ERROR read() failed\n", __FUNCTION__);
+				break;
+			}
+			continue;
+		}
+		wakeupCount++;
+
+		/* a late wakeup processes every missed tick */
+		count = 0;
+		while (expirations-- > 0)
+		{
+			count += timerServiceTick(expiries + count, TIMER_SERVICE_MAX_TIMERS - count);
+		}
+		if (armedCount == 0)
+		{
+			timerServiceArm(0);
+		}
+		pthread_mutex_unlock(&timerMutex);
+
+		/* callbacks run without lock, so they can start and cancel timers */
+		for (i = 0; i < count; i++)
+		{
+			pthread_mutex_lock(&timerMutex);
+			if (!expiries[i].timer->used || expiries[i].timer->sequence != expiries[i].sequence)
+			{
+				pthread_mutex_unlock(&timerMutex);
+				droppedCount++;
+				continue;
+			}
+			callback = expiries[i].timer->callback;
+			arg = expiries[i].timer->arg;
+			pthread_mutex_unlock(&timerMutex);
+
+			/* lateness includes rounding up to tick, jitter is only how late the tick itself ran */
+			nowUs = timerServiceTimeUs();
+			if (nowUs > expiries[i].tickUs)
+			{
+				jitterSumUs += nowUs - expiries[i].tickUs;
+				if (nowUs - expiries[i].tickUs > jitterMaxUs)
+				{
+					jitterMaxUs = nowUs - expiries[i].tickUs;
+				}
+			}
+			if (nowUs >= expiries[i].dueUs)
+			{
+				latenessSumUs += nowUs - expiries[i].dueUs;
+				if (nowUs - expiries[i].dueUs > latenessMaxUs)
+				{
+					latenessMaxUs = nowUs - expiries[i].dueUs;
+				}
+			}
+			else
+			{
+				earlyCount++;
+			}
+			expiryCount++;
+
+			callback(arg);
+		}
+	}
+
+	return NULL;
+}
+
+uint32_t timerServiceTick(TimerExpiry* expiries, uint32_t count)
+{
+	Timer* timer;
+	Timer* next;
+	uint32_t expired = 0;
+	uint32_t level;
+
+	currentTick++;
+	tickCount++;
+
+	/* when a level wraps, next slot of level above is spread down */
+	for (level = 1; level < TIMER_SERVICE_LEVELS; level++)
+	{
+		if ((currentTick & ((1ULL << (level * TIMER_SERVICE_SLOT_BITS)) - 1)) != 0)
+		{
+			break;
+		}
+		wheelCascade(level);
+	}
+
+	timer = wheel[0][currentTick & TIMER_SERVICE_SLOT_MASK];
+	wheel[0][currentTick & TIMER_SERVICE_SLOT_MASK] = NULL;
+	while (timer != NULL)
+	{
+		next = timer->next;
+		if (timer->expires > currentTick || expired == count)
+		{
+			/* not due yet, or no room in this wakeup, goes to next tick at the latest */
+			if (timer->expires <= currentTick)
+			{
+				timer->expires = currentTick + 1;
+			}
+			wheelInsert(timer);
+			timer = next;
+			continue;
+		}
+
+		expiries[expired].timer = timer;
+		expiries[expired].sequence = timer->sequence;
+		expiries[expired].dueUs = timer->dueUs;
+		expiries[expired].tickUs = armUs + (currentTick - armTick) * TIMER_SERVICE_TICK_US;
+		expired++;
+
+		if (timer->periodTicks != 0)
+		{
+			/* period counts from due time, not from callback, so it does not drift */
+			timer->expires += timer->periodTicks;
+			timer->dueUs += timer->periodTicks * TIMER_SERVICE_TICK_US;
+			wheelInsert(timer);
+		}
+		else
+		{
+			timer->armed = 0;
+			armedCount--;
+		}
+		timer = next;
+	}
+
+	return expired;
+}
+
+void wheelInsert(Timer* timer)
+{
+	uint64_t delta = timer->expires - currentTick;
+	uint64_t slotTick = timer->expires;
+	uint32_t level;
+	Timer** slot;
+
+	for (level = 0; level < TIMER_SERVICE_LEVELS - 1; level++)
+	{
+		if (delta < (1ULL << ((level + 1) * TIMER_SERVICE_SLOT_BITS)))
+		{
+			break;
+		}
+	}
+
+	/* beyond the wheel, parked in farthest slot and placed again when it cascades */
+	if (delta >= TIMER_SERVICE_MAX_TICKS)
+	{
+		slotTick = currentTick + TIMER_SERVICE_MAX_TICKS - 1;
+	}
+
+	slot = &wheel[level][(slotTick >> (level * TIMER_SERVICE_SLOT_BITS)) & TIMER_SERVICE_SLOT_MASK];
+	timer->next = *slot;
+	if (*slot != NULL)
+	{
+		(*slot)->link = &timer->next;
+	}
+	timer->link = slot;
+	*slot = timer;
+}
+
+void wheelRemove(Timer* timer)
+{
+	*timer->link = timer->next;
+	if (timer->next != NULL)
+	{
+		timer->next->link = timer->link;
+	}
+	timer->next = NULL;
+	timer->link = NULL;
+}
+
+void wheelCascade(uint32_t level)
+{
+	uint32_t index = (currentTick >> (level * TIMER_SERVICE_SLOT_BITS)) & TIMER_SERVICE_SLOT_MASK;
+	Timer* timer = wheel[level][index];
+	Timer* next;
+
+	wheel[level][index] = NULL;
+	while (timer != NULL)
+	{
+		next = timer->next;
+		wheelInsert(timer);
+		timer = next;
+	}
+}
+
+void timerServiceArm(uint8_t enable)
+{
+	struct itimerspec tick;
+
+	memset(&tick, 0x0, sizeof(tick));
+	if (enable)
+	{
+		tick.it_value.tv_nsec = TIMER_SERVICE_TICK_MS * 1000000L;
+		tick.it_interval.tv_nsec = TIMER_SERVICE_TICK_MS * 1000000L;
+	}
+
+	/* nothing armed, thread sleeps until next timerStart() instead of ticking */
+	if (!threadExit)
+	{
+		timerfd_settime(timerFd, 0, &tick, NULL);
+	}
+}
+
+Timer* timerGet(TimerId timerId)
+{
+	if (timerId == TIMER_SERVICE_INVALID_ID || timerId > TIMER_SERVICE_MAX_TIMERS || !timers[timerId - 1].used)
+	{
+		return NULL;
+	}
+
+	return &timers[timerId - 1];
+}
+
+uint64_t timerServiceTimeUs(void)
+{
+	struct timespec timeSpec;
+
+	clock_gettime(CLOCK_MONOTONIC, &timeSpec);
+	return (uint64_t)timeSpec.tv_sec * 1000000 + timeSpec.tv_nsec / 1000;
+}
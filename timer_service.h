@@ -0,0 +1,87 @@
+#ifndef __TIMER_SERVICE_H__
+#define __TIMER_SERVICE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TIMER_SERVICE_TICK_MS           10              /* Wheel resolution, timers fire at most one tick late */
+#define TIMER_SERVICE_MAX_TIMERS        32              /* Timers are taken from a fixed table */
+#define TIMER_SERVICE_LEVELS            4               /* Wheel levels, 64 slots each, 2^24 ticks ~ 46 hours */
+#define TIMER_SERVICE_SLOT_BITS         6
+#define TIMER_SERVICE_INVALID_ID        0
+
+/**
+ * @brief Enumeration of timer service error codes
+ */
+typedef enum _TimerServiceError
+{
+	TIMER_SERVICE_NO_ERROR = 0,
+	TIMER_SERVICE_ERROR
+}TimerServiceError;
+
+/**
+ * @brief Handle of timer, TIMER_SERVICE_INVALID_ID if creation failed
+ */
+typedef uint32_t TimerId;
+
+/**
+ * @brief Timer callback, called from timer service thread
+ *
+ * Callbacks of all timers share one thread, a callback must not block.
+ */
+typedef void (*TimerCallback)(void* arg);
+
+/**
+ * @brief Starts timer service thread on a timerfd
+ *
+ * @return Timer service error code
+ */
+TimerServiceError timerServiceInit(void);
+
+/**
+ * @brief Stops timer service thread, timers are deleted
+ */
+void timerServiceDeinit(void);
+
+/**
+ * @brief Creates stopped timer
+ *
+ * @param [in] callback - Called on every expiry
+ * @param [in] arg - Passed to callback
+ * @return Timer id, TIMER_SERVICE_INVALID_ID if timer table is full
+ */
+TimerId timerCreate(TimerCallback callback, void* arg);
+
+/**
+ * @brief Deletes timer, timer is stopped first
+ *
+ * @param [in] timerId - Timer id
+ */
+void timerDelete(TimerId timerId);
+
+/**
+ * @brief Starts timer, a running timer is started again from now
+ *
+ * @param [in] timerId - Timer id
+ * @param [in] delayMs - Time to first expiry
+ * @param [in] periodMs - Time between following expiries, 0 for one shot timer
+ * @return Timer service error code
+ */
+TimerServiceError timerStart(TimerId timerId, uint32_t delayMs, uint32_t periodMs);
+
+/**
+ * @brief Stops timer, callback that is already running is not waited for
+ *
+ * @param [in] timerId - Timer id
+ * @return Timer service error code
+ */
+TimerServiceError timerCancel(TimerId timerId);
+
+/**
+ * @brief Prints expiries, thread count and lateness of timers
+ */
+void printTimerServiceStats(void);
+
+#endif /* __TIMER_SERVICE_H__ */
@@ -0,0 +1,389 @@
+#include "ts_monitor.h"
+
+#define PCR_CLOCK_HZ        27000000ULL
+#define PCR_WRAP            (((uint64_t)1 << 33) * 300)
+#define PCR_MAX_JUMP_US     1000000
+
+/**
+ * @brief Structure that defines monitor state of one pid
+ */
+typedef struct _TsPidState
+{
+	uint16_t pid;
+	uint8_t lastCc;
+	uint8_t ccValid;
+	uint8_t duplicateSeen;
+	uint32_t packetCount;
+	uint32_t ccErrorCount;
+	uint32_t window[TS_MONITOR_WINDOW_SECONDS + 1];  /* Packets per second, slot of current second included */
+}TsPidState;
+
+/* Pid to state index + 1, 0 if pid is not tracked yet */
+static uint8_t pidIndex[TS_MAX_PID];
+static TsPidState pidStates[TS_MONITOR_MAX_TRACKED_PIDS];
+static uint32_t trackedPidCount = 0;
+static uint32_t untrackedPacketCount = 0;
+static uint32_t syncErrorCount = 0;
+
+/* Sliding window position */
+static uint64_t currentSecond = 0;
+static uint32_t completeSeconds = 0;
+
+/* Pid activity and scrambling bitmaps of current and previous period */
+static uint32_t activeCurrent[TS_MAX_PID / 32];
+static uint32_t activePrevious[TS_MAX_PID / 32];
+static uint32_t scrambledCurrent[TS_MAX_PID / 32];
+static uint32_t scrambledPrevious[TS_MAX_PID / 32];
+static uint64_t activityPeriod = 0;
+static uint32_t activityPeriodsCompleted = 0;
+
+/* PCR state */
+static uint16_t pcrPid = TS_NULL_PID;
+static TsPcrStats pcrStats;
+static uint8_t pcrValid = 0;
+static uint64_t lastPcr = 0;
+static uint64_t lastPcrArrivalUs = 0;
+static uint64_t pcrIntervalSumUs = 0;
+
+/**
+ * @brief - Moves sliding window to the second of arrival time.
+ */
+static void advanceWindow(uint64_t arrivalTimeUs);
+
+/**
+ * @brief - Checks PCR in adaptation field of PCR pid packet.
+ */
+static void processPcr(const uint8_t* packet, uint64_t arrivalTimeUs);
+
+/**
+ * @brief - Computes packet rate of pid over complete seconds of sliding window.
+ */
+static uint32_t windowRate(const TsPidState* state);
+
+void tsMonitorInit(void)
+{
+	memset(pidIndex, 0x0, sizeof(pidIndex));
+	memset(pidStates, 0x0, sizeof(pidStates));
+	trackedPidCount = 0;
+	untrackedPacketCount = 0;
+	syncErrorCount = 0;
+	currentSecond = 0;
+	completeSeconds = 0;
+	memset(activeCurrent, 0x0, sizeof(activeCurrent));
+	memset(activePrevious, 0x0, sizeof(activePrevious));
+	memset(scrambledCurrent, 0x0, sizeof(scrambledCurrent));
+	memset(scrambledPrevious, 0x0, sizeof(scrambledPrevious));
+	activityPeriod = 0;
+	activityPeriodsCompleted = 0;
+	tsMonitorSetPcrPid(TS_NULL_PID);
+}
+
+void tsMonitorSetPcrPid(uint16_t pid)
+{
+	memset(&pcrStats, 0x0, sizeof(pcrStats));
+	pcrStats.pcrPid = pid;
+	pcrValid = 0;
+	pcrIntervalSumUs = 0;
+	pcrPid = pid;
+}
+
+void tsMonitorProcessPackets(const uint8_t* packets, uint32_t count, uint64_t arrivalTimeUs)
+{
+	const uint8_t* packet;
+	TsPidState* state;
+	uint32_t i;
+	uint16_t pid;
+	uint8_t adaptationFieldControl;
+	uint8_t cc;
+	uint8_t discontinuity;
+
+	advanceWindow(arrivalTimeUs);
+
+	for (i = 0; i < count; i++)
+	{
+		packet = packets + i * TS_PACKET_SIZE;
+		if (packet[0] != TS_SYNC_BYTE)
+		{
+			syncErrorCount++;
+			continue;
+		}
+
+		pid = ((packet[1] << 8) + packet[2]) & 0x1FFF;
+		activeCurrent[pid >> 5] |= 1u << (pid & 0x1F);
+		if (packet[3] & 0xC0)
+		{
+			scrambledCurrent[pid >> 5] |= 1u << (pid & 0x1F);
+		}
+
+		if (pidIndex[pid] == 0)
+		{
+			if (trackedPidCount == TS_MONITOR_MAX_TRACKED_PIDS)
+			{
+				untrackedPacketCount++;
+				continue;
+			}
+			pidStates[trackedPidCount].pid = pid;
+			pidIndex[pid] = ++trackedPidCount;
+		}
+		state = &pidStates[pidIndex[pid] - 1];
+
+		state->packetCount++;
+		state->window[currentSecond % (TS_MONITOR_WINDOW_SECONDS + 1)]++;
+
+		/* transport_error_indicator set, header can not be trusted */
+		if (packet[1] & 0x80 || pid == TS_NULL_PID)
+		{
+			continue;
+		}
+
+		adaptationFieldControl = (packet[3] >> 4) & 0x03;
+		cc = packet[3] & 0x0F;
+		discontinuity = (adaptationFieldControl & 0x02) && packet[4] > 0 && (packet[5] & 0x80);
+
+		if (state->ccValid && !discontinuity)
+		{
+			if (adaptationFieldControl & 0x01)
+			{
+				/* packet with payload: counter increments, one duplicate allowed */
+				if (cc == state->lastCc)
+				{
+					if (state->duplicateSeen)
+					{
+						state->ccErrorCount++;
+					}
+					state->duplicateSeen = 1;
+				}
+				else if (cc != ((state->lastCc + 1) & 0x0F))
+				{
+					state->ccErrorCount++;
+				}
+			}
+			else if (cc != state->lastCc)
+			{
+				/* packet without payload must not increment counter */
+				state->ccErrorCount++;
+			}
+		}
+
+		if (cc != state->lastCc)
+		{
+			state->duplicateSeen = 0;
+		}
+		state->lastCc = cc;
+		state->ccValid = 1;
+
+		if (pid == pcrPid && (adaptationFieldControl & 0x02))
+		{
+			processPcr(packet, arrivalTimeUs);
+		}
+	}
+}
+
+void advanceWindow(uint64_t arrivalTimeUs)
+{
+	uint64_t second = arrivalTimeUs / 1000000;
+	uint64_t period = second / TS_MONITOR_ACTIVITY_PERIOD_S;
+	uint32_t i;
+
+	if (period != activityPeriod)
+	{
+		/* pid that was silent for a whole period drops out of the bitmap */
+		if (period == activityPeriod + 1)
+		{
+			memcpy(activePrevious, activeCurrent, sizeof(activePrevious));
+			memcpy(scrambledPrevious, scrambledCurrent, sizeof(scrambledPrevious));
+			activityPeriodsCompleted++;
+		}
+		else
+		{
+			memset(activePrevious, 0x0, sizeof(activePrevious));
+			memset(scrambledPrevious, 0x0, sizeof(scrambledPrevious));
+			activityPeriodsCompleted = 0;
+		}
+		memset(activeCurrent, 0x0, sizeof(activeCurrent));
+		memset(scrambledCurrent, 0x0, sizeof(scrambledCurrent));
+		activityPeriod = period;
+	}
+
+	if (second == currentSecond)
+	{
+		return;
+	}
+
+	if (second < currentSecond || second - currentSecond > TS_MONITOR_WINDOW_SECONDS)
+	{
+		/* first packet or long pause, whole window is stale */
+		for (i = 0; i < trackedPidCount; i++)
+		{
+			memset(pidStates[i].window, 0x0, sizeof(pidStates[i].window));
+		}
+		completeSeconds = (currentSecond == 0) ? 0 : TS_MONITOR_WINDOW_SECONDS;
+		currentSecond = second;
+		return;
+	}
+
+	while (currentSecond < second)
+	{
+		currentSecond++;
+		if (completeSeconds < TS_MONITOR_WINDOW_SECONDS)
+		{
+			completeSeconds++;
+		}
+		for (i = 0; i < trackedPidCount; i++)
+		{
+			pidStates[i].window[currentSecond % (TS_MONITOR_WINDOW_SECONDS + 1)] = 0;
+		}
+	}
+}
+
+void processPcr(const uint8_t* packet, uint64_t arrivalTimeUs)
+{
+	uint64_t pcr;
+	uint64_t pcrDeltaUs;
+	uint64_t intervalUs;
+	int64_t jitterUs;
+
+	/* adaptation_field_length must hold flags and 6 PCR bytes, PCR_flag set */
+	if (packet[4] < 7 || !(packet[5] & 0x10))
+	{
+		return;
+	}
+
+	/* program_clock_reference_base * 300 + program_clock_reference_extension */
+	pcr = ((uint64_t)packet[6] << 25) + ((uint64_t)packet[7] << 17) + ((uint64_t)packet[8] << 9) +
+	      ((uint64_t)packet[9] << 1) + (packet[10] >> 7);
+	pcr = pcr * 300 + (((packet[10] & 0x01) << 8) + packet[11]);
+
+	pcrStats.pcrCount++;
+
+	if (pcrValid)
+	{
+		intervalUs = arrivalTimeUs - lastPcrArrivalUs;
+		pcrDeltaUs = ((pcr + PCR_WRAP - lastPcr) % PCR_WRAP) * 1000000 / PCR_CLOCK_HZ;
+
+		pcrStats.lastIntervalUs = (uint32_t)intervalUs;
+		pcrIntervalSumUs += intervalUs;
+		pcrStats.avgIntervalUs = (uint32_t)(pcrIntervalSumUs / (pcrStats.pcrCount - 1));
+		if (intervalUs > pcrStats.maxIntervalUs)
+		{
+			pcrStats.maxIntervalUs = (uint32_t)intervalUs;
+		}
+		if (intervalUs > TS_MONITOR_PCR_MAX_INTERVAL_MS * 1000)
+		{
+			pcrStats.intervalErrorCount++;
+		}
+
+		if ((packet[5] & 0x80) || pcrDeltaUs > PCR_MAX_JUMP_US)
+		{
+			pcrStats.discontinuityCount++;
+		}
+		else
+		{
+			jitterUs = (int64_t)intervalUs - (int64_t)pcrDeltaUs;
+			pcrStats.lastJitterUs = (int32_t)jitterUs;
+			if ((uint64_t)(jitterUs < 0 ? -jitterUs : jitterUs) > pcrStats.maxJitterUs)
+			{
+				pcrStats.maxJitterUs = (uint32_t)(jitterUs < 0 ? -jitterUs : jitterUs);
+			}
+		}
+	}
+
+	lastPcr = pcr;
+	lastPcrArrivalUs = arrivalTimeUs;
+	pcrValid = 1;
+}
+
+uint32_t windowRate(const TsPidState* state)
+{
+	uint32_t sum = 0;
+	uint32_t i;
+
+	if (completeSeconds == 0)
+	{
+		return 0;
+	}
+
+	for (i = 1; i <= completeSeconds; i++)
+	{
+		sum += state->window[(currentSecond - i) % (TS_MONITOR_WINDOW_SECONDS + 1)];
+	}
+
+	return sum / completeSeconds;
+}
+
+uint8_t tsMonitorIsPidActive(uint16_t pid)
+{
+	if (pid >= TS_MAX_PID)
+	{
+		return 0;
+	}
+
+	return ((activeCurrent[pid >> 5] | activePrevious[pid >> 5]) >> (pid & 0x1F)) & 0x01;
+}
+
+uint8_t tsMonitorIsPidScrambled(uint16_t pid)
+{
+	if (pid >= TS_MAX_PID)
+	{
+		return 0;
+	}
+
+	return ((scrambledCurrent[pid >> 5] | scrambledPrevious[pid >> 5]) >> (pid & 0x1F)) & 0x01;
+}
+
+uint8_t tsMonitorIsActivityValid(uint64_t nowUs)
+{
+	/* previous period was fully observed and packets are still arriving */
+	return activityPeriodsCompleted > 0 && nowUs / 1000000 / TS_MONITOR_ACTIVITY_PERIOD_S <= activityPeriod + 1;
+}
+
+uint8_t tsMonitorGetPidStats(uint16_t pid, TsPidStats* tsPidStats)
+{
+	const TsPidState* state;
+
+	if (tsPidStats == NULL || pid >= TS_MAX_PID || pidIndex[pid] == 0)
+	{
+		return 0;
+	}
+
+	state = &pidStates[pidIndex[pid] - 1];
+	tsPidStats->pid = pid;
+	tsPidStats->packetCount = state->packetCount;
+	tsPidStats->ccErrorCount = state->ccErrorCount;
+	tsPidStats->packetRate = windowRate(state);
+	tsPidStats->bitRate = tsPidStats->packetRate * TS_PACKET_SIZE * 8;
+
+	return 1;
+}
+
+void tsMonitorGetPcrStats(TsPcrStats* tsPcrStats)
+{
+	if (tsPcrStats != NULL)
+	{
+		*tsPcrStats = pcrStats;
+	}
+}
+
+void printTsMonitorStats(void)
+{
+	TsPidStats pidStats;
+	uint32_t i;
+
+	printf("\n********************TS MONITOR********************\n");
+	printf("sync errors              |      %u\n", syncErrorCount);
+	printf("untracked packets        |      %u\n", untrackedPacketCount);
+	for (i = 0; i < trackedPidCount; i++)
+	{
+		tsMonitorGetPidStats(pidStates[i].pid, &pidStats);
+		printf("pid %4d | packets: %u | cc errors: %u | %u pkt/s | %u kbit/s\n", pidStats.pid,
+		       pidStats.packetCount, pidStats.ccErrorCount, pidStats.packetRate, pidStats.bitRate / 1000);
+	}
+	printf("-----------------------------------------\n");
+	printf("pcr_pid                  |      %d\n", pcrStats.pcrPid);
+	printf("pcr count                |      %u\n", pcrStats.pcrCount);
+	printf("interval avg/max         |      %u / %u us\n", pcrStats.avgIntervalUs, pcrStats.maxIntervalUs);
+	printf("interval > %d ms         |      %u\n", TS_MONITOR_PCR_MAX_INTERVAL_MS, pcrStats.intervalErrorCount);
+	printf("jitter last/max          |      %d / %u us\n", pcrStats.lastJitterUs, pcrStats.maxJitterUs);
+	printf("discontinuities          |      %u\n", pcrStats.discontinuityCount);
+	printf("\n********************TS MONITOR********************\n");
+}
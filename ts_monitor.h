@@ -0,0 +1,111 @@
+#ifndef __TS_MONITOR_H__
+#define __TS_MONITOR_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TS_PACKET_SIZE                  188
+#define TS_SYNC_BYTE                    0x47
+#define TS_NULL_PID                     0x1FFF
+#define TS_MAX_PID                      0x2000
+#define TS_MONITOR_MAX_TRACKED_PIDS     128         /* Max number of different pids with statistics */
+#define TS_MONITOR_WINDOW_SECONDS       5           /* Length of sliding window for rates */
+#define TS_MONITOR_PCR_MAX_INTERVAL_MS  40          /* Max allowed PCR repetition interval */
+#define TS_MONITOR_ACTIVITY_PERIOD_S    2           /* Pid is active if it had a packet in the last one or two periods */
+
+/**
+ * @brief Structure that defines per pid statistics
+ */
+typedef struct _TsPidStats
+{
+	uint16_t pid;
+	uint32_t packetCount;                       /* Total number of packets */
+	uint32_t ccErrorCount;                      /* Number of continuity_counter errors */
+	uint32_t packetRate;                        /* Packets per second over sliding window */
+	uint32_t bitRate;                           /* Bits per second over sliding window */
+}TsPidStats;
+
+/**
+ * @brief Structure that defines PCR statistics of the monitored PCR pid
+ */
+typedef struct _TsPcrStats
+{
+	uint16_t pcrPid;
+	uint32_t pcrCount;                          /* Number of received PCRs */
+	uint32_t intervalErrorCount;                /* Number of intervals longer than TS_MONITOR_PCR_MAX_INTERVAL_MS */
+	uint32_t lastIntervalUs;                    /* Arrival interval between last two PCRs */
+	uint32_t maxIntervalUs;                     /* Longest arrival interval between PCRs */
+	uint32_t avgIntervalUs;                     /* Average arrival interval between PCRs */
+	int32_t lastJitterUs;                       /* Arrival interval minus PCR value interval, last PCR */
+	uint32_t maxJitterUs;                       /* Largest absolute jitter */
+	uint32_t discontinuityCount;                /* Number of PCR discontinuities (signalled or jumps) */
+}TsPcrStats;
+
+/**
+ * @brief Resets all statistics
+ */
+void tsMonitorInit(void);
+
+/**
+ * @brief Sets pid that carries PCR of the watched service, resets PCR statistics
+ *
+ * @param [in] pcrPid - PCR pid from PMT header
+ */
+void tsMonitorSetPcrPid(uint16_t pcrPid);
+
+/**
+ * @brief Processes transport stream packets, meant to run on every packet of the multiplex
+ *
+ * @param [in] packets - Buffer that contains whole TS packets
+ * @param [in] count - Number of packets in buffer
+ * @param [in] arrivalTimeUs - Monotonic arrival time of the buffer
+ */
+void tsMonitorProcessPackets(const uint8_t* packets, uint32_t count, uint64_t arrivalTimeUs);
+
+/**
+ * @brief Checks pid activity bitmap
+ *
+ * @param [in] pid - Pid
+ * @return 1 if pid carried packets in the last activity period, 0 otherwise
+ */
+uint8_t tsMonitorIsPidActive(uint16_t pid);
+
+/**
+ * @brief Checks pid scrambling bitmap
+ *
+ * @param [in] pid - Pid
+ * @return 1 if pid carried packets with transport_scrambling_control set in the last activity period, 0 otherwise
+ */
+uint8_t tsMonitorIsPidScrambled(uint16_t pid);
+
+/**
+ * @brief Checks if packets are fed long enough for pid activity to be meaningful
+ *
+ * @param [in] nowUs - Current monotonic time
+ * @return 1 if activity bitmap covers a whole period and packets still arrive, 0 otherwise
+ */
+uint8_t tsMonitorIsActivityValid(uint64_t nowUs);
+
+/**
+ * @brief Returns statistics of one pid
+ *
+ * @param [in]  pid - Pid
+ * @param [out] tsPidStats - Pid statistics
+ * @return 1 if pid was seen, 0 otherwise
+ */
+uint8_t tsMonitorGetPidStats(uint16_t pid, TsPidStats* tsPidStats);
+
+/**
+ * @brief Returns PCR statistics
+ *
+ * @param [out] tsPcrStats - PCR statistics
+ */
+void tsMonitorGetPcrStats(TsPcrStats* tsPcrStats);
+
+/**
+ * @brief Prints statistics of all seen pids and PCR
+ */
+void printTsMonitorStats(void);
+
+#endif /* __TS_MONITOR_H__ */